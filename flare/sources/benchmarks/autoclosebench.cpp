@@ -0,0 +1,150 @@
+// Times the autoclose of a corpus of synthetic cleaned drawings: 4K Toonz
+// rasters of antialiased curves, half of them broken by a small gap. Checks
+// that the closing segments are the ones computed by the sequential peeling
+// of the ink, before it was split by components.
+
+// TnzLib includes
+#include "flare/autoclose.h"
+
+// TnzCore includes
+#include "trastercm.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int drawingCount = 6, lx = 3840, ly = 2160, curveCount = 400;
+
+//! Digests of the closing segments of each drawing, from the sequential
+//! peeling. Update them if the closing is meant to change.
+const unsigned long long expectedDigests[drawingCount] = {
+    0x4c94f80ff3f7dc09ULL, 0xd5725976d7f8e439ULL, 0x4e3ea2bd1d822f50ULL,
+    0x6b70ea06d921884aULL, 0x021f0f61b0a6fce5ULL, 0xd2359515b49690abULL};
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! Draws an ink disc of radius \b r, with an antialiased border.
+void stamp(const TRasterCM32P &ras, double cx, double cy, double r) {
+  int x0 = std::max(0, (int)std::floor(cx - r - 1));
+  int y0 = std::max(0, (int)std::floor(cy - r - 1));
+  int x1 = std::min(ras->getLx() - 1, (int)std::ceil(cx + r + 1));
+  int y1 = std::min(ras->getLy() - 1, (int)std::ceil(cy + r + 1));
+
+  for (int y = y0; y <= y1; ++y)
+    for (int x = x0; x <= x1; ++x) {
+      double d = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy)) - r;
+      if (d >= 1.0) continue;
+
+      int tone        = d <= 0.0 ? 0 : int(255 * d);
+      TPixelCM32 &pix = ras->pixels(y)[x];
+      if (tone < pix.getTone()) pix = TPixelCM32(1, 0, tone);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+//! A cleaned drawing: cubic curves of 2 to 4 pixel lines.
+TRasterCM32P makeDrawing(int drawing) {
+  TRasterCM32P ras(lx, ly);
+  ras->fill(TPixelCM32());
+
+  unsigned int rnd = 12345 + drawing;
+  auto next        = [&rnd]() {
+    rnd = rnd * 1103515245 + 12345;
+    return (rnd >> 8) / double(1 << 24);
+  };
+
+  for (int c = 0; c < curveCount; ++c) {
+    double px[4], py[4];
+    px[0] = next() * lx, py[0] = next() * ly;
+    for (int k = 1; k < 4; ++k) {
+      px[k] = px[0] + (next() - 0.5) * 600;
+      py[k] = py[0] + (next() - 0.5) * 600;
+    }
+    double r      = 0.8 + next() * 1.2;
+    double gapAt  = next() < 0.5 ? next() : -1.0;
+    double gapLen = 0.01 + next() * 0.02;
+
+    for (int i = 0; i <= 2000; ++i) {
+      double t = i / 2000.0;
+      if (t > gapAt && t < gapAt + gapLen) continue;
+
+      double a = (1 - t) * (1 - t) * (1 - t), b = 3 * t * (1 - t) * (1 - t),
+             e = 3 * t * t * (1 - t), d = t * t * t;
+      stamp(ras, a * px[0] + b * px[1] + e * px[2] + d * px[3],
+            a * py[0] + b * py[1] + e * py[2] + d * py[3], r);
+    }
+  }
+
+  return ras;
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned long long digest(const std::vector<TAutocloser::Segment> &segments) {
+  unsigned long long sig = 1469598103934665603ULL;
+  for (const TAutocloser::Segment &s : segments)
+    for (int v : {s.first.x, s.first.y, s.second.x, s.second.y})
+      sig = (sig ^ (unsigned int)v) * 1099511628211ULL;
+  return sig;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  std::printf("%d cores, %d drawings %dx%d\n", QThread::idealThreadCount(),
+              drawingCount, lx, ly);
+
+  int failures = 0;
+  double total = 0;
+  for (int d = 0; d < drawingCount; ++d) {
+    TRasterCM32P ras = makeDrawing(d);
+
+    AutocloseSettings settings;
+    settings.m_closingDistance = 10 + d;
+
+    // The best of a few runs
+    std::vector<TAutocloser::Segment> segments;
+    double best = 1e9;
+    for (int run = 0; run < 3; ++run) {
+      segments.clear();
+      best = std::min(best, elapsedMs([&] {
+                        TAutocloser(ras, 1, settings).compute(segments);
+                      }));
+    }
+    total += best;
+
+    unsigned long long sig = digest(segments);
+    bool same              = (sig == expectedDigests[d]);
+    std::printf("drawing %d: %8.1f ms, %4d segments, digest %016llx%s\n", d,
+                best, (int)segments.size(), sig,
+                same ? "" : "  (values differ!)");
+    if (!same) ++failures;
+  }
+  std::printf("total: %8.1f ms\n", total);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+// Times the batch cleanup of a synthetic scanned level, in frames per second
+// at 1, 8 and 32 threads, with and without grey auto-adjust. Checks that the
+// cleaned up frames don't depend on the thread count.
+
+// TnzLib includes
+#include "flare/batchcleanupper.h"
+#include "flare/cleanupparameters.h"
+#include "flare/tcleanupper.h"
+
+// TnzCore includes
+#include "ttoonzimage.h"
+#include "trasterimage.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int frameCount = 48, lx = 1600, ly = 1200;
+const double dpi = 150.0;
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! A scanned drawing: soft pencil rings moving along the sequence on a paper
+//! whose brightness changes from frame to frame, as auto-adjust expects.
+TRasterImageP makeFrame(int frame) {
+  TRaster32P ras(lx, ly);
+  int paper = 235 + (frame * 7) % 20;
+
+  for (int y = 0; y < ly; ++y) {
+    TPixel32 *pix = ras->pixels(y);
+    for (int x = 0; x < lx; ++x) {
+      double ink = 0.0;
+      for (int ring = 0; ring < 5; ++ring) {
+        double cx = lx * (0.2 + 0.15 * ring) + 4.0 * frame;
+        double cy = ly * 0.5 + 80.0 * std::sin(0.3 * frame + ring);
+        double r  = 60.0 + 35.0 * ring;
+        double d  = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+        ink       = std::max(ink, 1.0 - std::abs(d - r) / 3.0);
+      }
+      int value = int(paper - (paper - 40) * ink + (x * 31 + y * 17) % 5);
+      pix[x]    = TPixel32(value, value, value);
+    }
+  }
+
+  TRasterImageP ri(ras);
+  ri->setDpi(dpi, dpi);
+  return ri;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns a digest of the cleaned up frames.
+unsigned long long signature(const std::vector<TToonzImageP> &images) {
+  unsigned long long sig = 1469598103934665603ULL;
+  auto mix               = [&sig](unsigned long long v) {
+    sig = (sig ^ v) * 1099511628211ULL;
+  };
+
+  for (const TToonzImageP &ti : images) {
+    if (!ti) {
+      mix(0);
+      continue;
+    }
+    TRasterCM32P ras = ti->getCMapped();
+    mix(ras->getLx()), mix(ras->getLy());
+    ras->lock();
+    for (int y = 0; y < ras->getLy(); ++y) {
+      const TPixelCM32 *pix = ras->pixels(y);
+      for (int x = 0; x < ras->getLx(); ++x) mix(pix[x].getValue());
+    }
+    ras->unlock();
+  }
+  return sig;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Cleans up \b frames with \b threadCount threads; returns the digest of the
+//! result and sets the frames per second.
+unsigned long long cleanup(const std::vector<TRasterImageP> &frames,
+                           int threadCount, double &fps) {
+  std::vector<TToonzImageP> images;
+  int index = 0;
+
+  auto source = [&](BatchCleanupper::Frame &frame) -> bool {
+    if (index == (int)frames.size()) return false;
+
+    frame.m_fid = TFrameId(index + 1);
+    // The cleanupper may replace the raster of its input: pass a copy
+    frame.m_image = TRasterImageP(frames[index]->cloneImage());
+    frame.m_first = (index++ == 0);
+    return true;
+  };
+  auto sink = [&](BatchCleanupper::Result &result) {
+    images.push_back(result.m_toonzImage);
+  };
+
+  BatchCleanupper batch(threadCount);
+  batch.setIsCleanupper(true);
+  double ms = elapsedMs([&] { batch.run(source, sink); });
+  fps       = 1000.0 * frames.size() / ms;
+
+  return signature(images);
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  std::printf("%d cores, %d frames %dx%d\n", QThread::idealThreadCount(),
+              frameCount, lx, ly);
+
+  std::vector<TRasterImageP> frames;
+  for (int f = 0; f < frameCount; ++f) frames.push_back(makeFrame(f));
+
+  CleanupParameters params;
+  params.m_lineProcessingMode = lpGrey;
+  params.m_camera.setRes(TDimension(lx, ly));
+  params.m_camera.setSize(TDimensionD(lx / dpi, ly / dpi));
+
+  TCleanupper *cl = TCleanupper::instance();
+  cl->setParameters(&params);
+  cl->setSourceDpi(TPointD(dpi, dpi));
+
+  int failures = 0;
+  for (CleanupTypes::AUTO_ADJ_MODE mode :
+       {CleanupTypes::AUTO_ADJ_NONE, CleanupTypes::AUTO_ADJ_HISTOGRAM}) {
+    params.m_autoAdjustMode = mode;
+
+    unsigned long long reference = 0;
+    for (int threadCount : {1, 8, 32}) {
+      double fps             = 0;
+      unsigned long long sig = cleanup(frames, threadCount, fps);
+      if (threadCount == 1) reference = sig;
+
+      bool same = (sig == reference);
+      std::printf("%-19s %2d threads: %6.2f fps%s\n",
+                  mode == CleanupTypes::AUTO_ADJ_NONE ? "grey"
+                                                      : "grey, auto-adjust",
+                  threadCount, fps, same ? "" : "  (values differ!)");
+      if (!same) ++failures;
+    }
+  }
+
+  cl->setParameters(0);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+// Times listing a synthetic tree of 200k image sequence frames - 20 folders
+// of 10 sequences of 1000 frames - as the file browser and the level loading
+// do: with QDir and a stat per file, as TSystem used to, and with TSystem's
+// single pass scans, first and once cached. Checks that the grouped and full
+// listings, and the frames of each sequence, are the same.
+
+// TnzCore includes
+#include "tsystem.h"
+#include "tfilepath_io.h"
+#include "tconvert.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QThread>
+
+// STD includes
+#include <chrono>
+#include <cstdio>
+#include <cwctype>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int folderCount = 20, levelCount = 10, frameCount = 1000;
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! The order of TSystem's listings: by lowercase path, then by path.
+struct CaselessFilepathLess {
+  bool operator()(const TFilePath &a, const TFilePath &b) const {
+    std::wstring aLower = a.getWideString(), bLower = b.getWideString();
+    for (wchar_t &c : aLower) c = towlower(c);
+    for (wchar_t &c : bLower) c = towlower(c);
+    return aLower < bLower ||
+           (aLower == bLower && a.getWideString() < b.getWideString());
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+//! The grouped and full listings of \b folder, as TSystem used to read them.
+void readWithQDir(TFilePathSet &groupFpSet, TFilePathSet &allFpSet,
+                  const TFilePath &folder) {
+  std::set<TFilePath, CaselessFilepathLess> fileSet_group, fileSet_all;
+
+  QStringList fil = QDir(folder.getQString())
+                        .entryList(QDir::Files | QDir::NoDotAndDotDot |
+                                   QDir::Readable);
+  for (const QString &fi : fil) {
+    TFilePath son = folder + TFilePath(fi.toStdWString());
+    fileSet_all.insert(son);
+    if (son.getDots() == "..") son = son.withFrame();
+    fileSet_group.insert(son);
+  }
+
+  groupFpSet.insert(groupFpSet.end(), fileSet_group.begin(),
+                    fileSet_group.end());
+  allFpSet.insert(allFpSet.end(), fileSet_all.begin(), fileSet_all.end());
+}
+
+//-----------------------------------------------------------------------------
+
+TFilePath folderPath(const TFilePath &root, int f) {
+  return root + ("scene_" + std::to_string(f));
+}
+
+TFilePath levelPath(const TFilePath &folder, int l) {
+  return folder + (std::string(1, char('A' + l)) + "..png");
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  TFilePath root = TSystem::getTempDir() + "dirscanbench";
+  std::printf("%d cores, %d frames in %s\n", QThread::idealThreadCount(),
+              folderCount * levelCount * frameCount,
+              root.getQString().toStdString().c_str());
+
+  int failures = 0;
+  try {
+    if (TFileStatus(root).doesExist()) TSystem::rmDirTree(root);
+
+    double create = elapsedMs([&] {
+      TSystem::mkDir(root);
+      for (int f = 0; f < folderCount; ++f) {
+        TFilePath folder = folderPath(root, f);
+        TSystem::mkDir(folder);
+        for (int l = 0; l < levelCount; ++l)
+          for (int i = 1; i <= frameCount; ++i) {
+            FILE *file = fopen(levelPath(folder, l).withFrame(i), "wb");
+            if (!file)
+              throw std::string("Cannot write in ") +
+                  folder.getQString().toStdString();
+            fclose(file);
+          }
+      }
+    });
+    std::printf("tree creation:        %8.1f ms\n", create);
+
+    // Listings of folders modified in the last 2 seconds are not cached
+    QThread::sleep(3);
+
+    std::vector<TFilePathSet> refGroups(folderCount), refAlls(folderCount);
+    double old = elapsedMs([&] {
+      for (int f = 0; f < folderCount; ++f)
+        readWithQDir(refGroups[f], refAlls[f], folderPath(root, f));
+    });
+    std::printf("QDir, stat per file:  %8.1f ms\n", old);
+
+    for (bool cached : {false, true}) {
+      std::vector<TFilePathSet> groups(folderCount), alls(folderCount);
+      double ms = elapsedMs([&] {
+        for (int f = 0; f < folderCount; ++f)
+          TSystem::readDirectory(groups[f], alls[f], folderPath(root, f));
+      });
+
+      bool same = (groups == refGroups && alls == refAlls);
+      std::printf("TSystem, %-12s %8.1f ms%s\n",
+                  cached ? "cached:" : "first scan:", ms,
+                  same ? "" : "  (values differ!)");
+      if (!same) ++failures;
+    }
+
+    // Loading the levels of a scene reads the frames of each sequence
+    bool same = true;
+    double levels = elapsedMs([&] {
+      for (int f = 0; f < folderCount; ++f)
+        for (int l = 0; l < levelCount; ++l) {
+          TFilePath level = levelPath(folderPath(root, f), l);
+
+          TFilePathSet frames;
+          TSystem::readDirectory_LevelFrames(frames, level);
+
+          TFilePathSet expected;
+          for (const TFilePath &fp : refAlls[f])
+            if (fp.getLevelNameW() == level.getLevelNameW())
+              expected.push_back(fp);
+          same = same && frames == expected;
+        }
+    });
+    std::printf("level frames, cached: %8.1f ms%s\n", levels,
+                same ? "" : "  (values differ!)");
+    if (!same) ++failures;
+
+    TFilePathSet tree;
+    double treeMs =
+        elapsedMs([&] { TSystem::readDirectoryTree(tree, root, true); });
+    std::printf("tree, cached:         %8.1f ms, %d entries\n", treeMs,
+                (int)tree.size());
+
+    TSystem::rmDirTree(root);
+  } catch (const std::string &msg) {
+    std::printf("error: %s\n", msg.c_str());
+    return 1;
+  } catch (const TException &e) {
+    std::printf("error: %s\n", ::to_string(e.getMessage()).c_str());
+    return 1;
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+// Times the evaluation of expression curves: TDoubleParam::getValue() on
+// each frame against TDoubleParam::evaluateRange() on the whole range.
+
+// TnzBase includes
+#include "tgrammar.h"
+#include "tdoubleparam.h"
+#include "tdoublekeyframe.h"
+
+// STD includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+//! Returns the time taken by f(), in nanoseconds.
+template <typename Func>
+double elapsedNs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main() {
+  const char *expressions[] = {
+      "sin(frame*18)",
+      "(frame>10) + frame",
+      "frame>10 ? frame*2 : frame+1",
+      "(2*pi/360 + 3*4) * frame + sqrt(16) * (t - 1/3)",
+      "abs(sin(frame)) * 100 + (5 > 3 ? 1 : 2) * cos(rframe*2)",
+  };
+
+  const int frameCount = 1000000;
+
+  TSyntax::Grammar grammar;
+  std::vector<double> values(frameCount);
+
+  for (const char *expression : expressions) {
+    TDoubleParamP param(new TDoubleParam(0.0));
+    param->setGrammar(&grammar);
+
+    TDoubleKeyframe kf0(0), kf1(frameCount);
+    kf0.m_type           = TDoubleKeyframe::Expression;
+    kf0.m_expressionText = expression;
+    param->setKeyframe(kf0);
+    param->setKeyframe(kf1);
+
+    double directSum = 0, rangeSum = 0;
+
+    double direct = elapsedNs([&] {
+      for (int f = 0; f < frameCount; ++f) directSum += param->getValue(f);
+    });
+    double range = elapsedNs([&] {
+      param->evaluateRange(0, frameCount - 1, values.data());
+      for (double v : values) rangeSum += v;
+    });
+
+    std::printf("%-56s getValue %6.1f ns, evaluateRange %6.1f ns%s\n",
+                expression, direct / frameCount, range / frameCount,
+                std::abs(directSum - rangeSum) <= 1e-9 * std::abs(directSum)
+                    ? ""
+                    : "  (values differ!)");
+  }
+
+  return 0;
+}
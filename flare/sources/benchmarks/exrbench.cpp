@@ -0,0 +1,175 @@
+// Times writing and reading EXR images with each compression and storage
+// type, and checks the shrunk reads of mipmapped images of odd size, which
+// are served from the mipmap levels.
+
+// TnzCore includes
+#include "tiio.h"
+#include "tproperty.h"
+#include "tpixel.h"
+#include "tsystem.h"
+#include "tconvert.h"
+#include "tfilepath_io.h"
+
+// Image includes
+#include "tnzimage.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! The written pixels: horizontal and vertical ramps, so that a pixel read
+//! from the wrong place shows up.
+TPixelF rampPixel(int x, int y, int lx, int ly) {
+  TPixelF pix;
+  pix.r = float(x) / lx;
+  pix.g = float(y) / ly;
+  pix.b = 0.5f;
+  pix.m = 1.0f;
+  return pix;
+}
+
+//-----------------------------------------------------------------------------
+
+void writeExr(const TFilePath &fp, int lx, int ly, const std::wstring &comp,
+              const std::wstring &storage) {
+  std::unique_ptr<TPropertyGroup> props(Tiio::makeWriterProperties("exr"));
+  static_cast<TEnumProperty *>(props->getProperty("Compression Type"))
+      ->setValue(comp);
+  static_cast<TEnumProperty *>(props->getProperty("Storage Type"))
+      ->setValue(storage);
+
+  std::unique_ptr<Tiio::Writer> writer(Tiio::makeWriter("exr"));
+  writer->setProperties(props.get());
+
+  FILE *file = fopen(fp, "wb");
+  if (!file) throw std::string("Cannot write ") + fp.getQString().toStdString();
+
+  TImageInfo info;
+  info.m_lx = lx, info.m_ly = ly;
+  writer->open(file, info);
+
+  std::vector<TPixelF> line(lx);
+  for (int y = 0; y < ly; ++y) {
+    for (int x = 0; x < lx; ++x) line[x] = rampPixel(x, y, lx, ly);
+    writer->writeLine((float *)line.data());
+  }
+  writer->flush();
+  fclose(file);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Reads the columns [x0, x1] of every \b shrink-th row, sampling one pixel
+//! every \b shrink; returns the largest distance from the written ramps.
+double readExr(const TFilePath &fp, int x0, int x1, int shrink) {
+  std::unique_ptr<Tiio::Reader> reader(Tiio::makeReader("exr"));
+
+  FILE *file = fopen(fp, "rb");
+  if (!file) throw std::string("Cannot read ") + fp.getQString().toStdString();
+
+  reader->open(file);
+  reader->setColorSpaceGamma(1.0);
+  int lx = reader->getImageInfo().m_lx, ly = reader->getImageInfo().m_ly;
+
+  std::vector<TPixelF> line(lx);
+  double maxError = 0;
+  for (int y = 0; y < ly; y += shrink) {
+    reader->readLine((float *)line.data(), x0, x1, shrink);
+    reader->skipLines(shrink - 1);
+
+    for (int x = x0; x <= x1; x += shrink) {
+      TPixelF expected = rampPixel(x, y, lx, ly);
+      float error      = std::max(std::max(std::abs(line[x].r - expected.r),
+                                           std::abs(line[x].g - expected.g)),
+                                  std::max(std::abs(line[x].b - expected.b),
+                                           std::abs(line[x].m - expected.m)));
+      maxError         = std::max(maxError, double(error));
+    }
+  }
+  fclose(file);
+  return maxError;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  initImageIo();
+
+  TFilePath fp = TSystem::getTempDir() + "exrbench.exr";
+
+  const std::wstring comps[]    = {L"None", L"ZIP", L"PIZ"};
+  const std::wstring storages[] = {L"Store Image as Scanlines",
+                                   L"Store Image as Tiles",
+                                   L"Store Image as Mipmapped Tiles"};
+  const char *storageNames[]    = {"scanlines", "tiles", "mipmaps"};
+
+  int failures = 0;
+  try {
+    std::printf("%d cores\n", QThread::idealThreadCount());
+
+    // Half float pixels of a 4K frame
+    const int lx = 3840, ly = 2160;
+    for (const std::wstring &comp : comps)
+      for (int s = 0; s < 3; ++s) {
+        double error = 0;
+        double write =
+            elapsedMs([&] { writeExr(fp, lx, ly, comp, storages[s]); });
+        double read =
+            elapsedMs([&] { error = readExr(fp, 0, lx - 1, 1); });
+
+        std::printf("%-4s %-9s: write %7.1f ms, read %7.1f ms, %9ld bytes%s\n",
+                    ::to_string(comp).c_str(), storageNames[s], write, read,
+                    (long)TFileStatus(fp).getSize(),
+                    error < 1e-3 ? "" : "  (values differ!)");
+        if (error >= 1e-3) ++failures;
+      }
+
+    // Shrunk reads of odd sized images come from the rounded down mipmap
+    // levels: a level pixel averages shrink written ones per side, and the
+    // last one also stands for the column and row dropped by the rounding
+    const int oddLx = 1001, oddLy = 601;
+    writeExr(fp, oddLx, oddLy, L"ZIP", storages[2]);
+    for (int shrink : {1, 2, 4, 8}) {
+      double whole      = readExr(fp, 0, oddLx - 1, shrink);
+      double lastColumn = readExr(fp, oddLx - 1, oddLx - 1, shrink);
+
+      double tolerance = 2.0 * shrink / std::min(oddLx, oddLy) + 1e-3;
+      bool ok          = whole <= tolerance && lastColumn <= tolerance;
+      std::printf("odd mipmaps, shrink %d: error %.4f, last column %.4f%s\n",
+                  shrink, whole, lastColumn, ok ? "" : "  (values differ!)");
+      if (!ok) ++failures;
+    }
+  } catch (const std::string &msg) {
+    std::printf("error: %s\n", msg.c_str());
+    return 1;
+  }
+
+  TSystem::removeFileOrLevel(fp);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+// Times the rendering of MyPaint dabs on a 4K full-color raster, in dabs per
+// second: through the batched float tiles of Raster32PMyPaintSurface, and
+// dab by dab on the 8-bit pixels as the surface used to. Strokes come as
+// tablet events, and the tiles are flushed after each one as the brush tools
+// do. Checks both against dabs rendered on a whole float raster.
+
+// TnzTools includes
+#include "mypainttoonzbrush.h"
+#include "flare/mypainthelpers.hpp"
+
+// TnzCore includes
+#include "traster.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int lx = 3840, ly = 2160;
+const int strokeCount = 12, eventCount = 300;  // 1.5 s at 200 Hz each
+const double eventTime = 0.005;
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+void readPixel32(const void *pixelPtr, float &colorR, float &colorG,
+                 float &colorB, float &colorA) {
+  const TPixel32 &pixel = *(const TPixel32 *)pixelPtr;
+  colorR                = (float)pixel.r / (float)TPixel32::maxChannelValue;
+  colorG                = (float)pixel.g / (float)TPixel32::maxChannelValue;
+  colorB                = (float)pixel.b / (float)TPixel32::maxChannelValue;
+  colorA                = (float)pixel.m / (float)TPixel32::maxChannelValue;
+}
+
+void writePixel32(void *pixelPtr, float colorR, float colorG, float colorB,
+                  float colorA) {
+  TPixel32 &pixel = *(TPixel32 *)pixelPtr;
+  pixel.r = (TPixel32::Channel)roundf(colorR * TPixel32::maxChannelValue);
+  pixel.g = (TPixel32::Channel)roundf(colorG * TPixel32::maxChannelValue);
+  pixel.b = (TPixel32::Channel)roundf(colorB * TPixel32::maxChannelValue);
+  pixel.m = (TPixel32::Channel)roundf(colorA * TPixel32::maxChannelValue);
+}
+
+void readPixelF(const void *pixelPtr, float &colorR, float &colorG,
+                float &colorB, float &colorA) {
+  const float *pixel = (const float *)pixelPtr;
+  colorR = pixel[0], colorG = pixel[1], colorB = pixel[2], colorA = pixel[3];
+}
+
+void writePixelF(void *pixelPtr, float colorR, float colorG, float colorB,
+                 float colorA) {
+  float *pixel = (float *)pixelPtr;
+  pixel[0] = colorR, pixel[1] = colorG, pixel[2] = colorB, pixel[3] = colorA;
+}
+
+//! The dabs of the old Raster32PMyPaintSurface: blended one at a time into
+//! the 8-bit pixels.
+typedef mypaint::helpers::SurfaceCustom<readPixel32, writePixel32>
+    Raster32Surface;
+
+//! The reference: dabs blended into a whole raster of float pixels.
+typedef mypaint::helpers::SurfaceCustom<readPixelF, writePixelF> FloatSurface;
+
+//-----------------------------------------------------------------------------
+
+//! Stores the dabs of a brush, on a transparent canvas.
+class RecordingSurface final : public mypaint::Surface {
+public:
+  std::vector<mypaint::Dab> m_dabs;
+
+  bool getColor(float, float, float, float &colorR, float &colorG,
+                float &colorB, float &colorA) override {
+    colorR = colorG = colorB = colorA = 0.f;
+    return true;
+  }
+  bool drawDab(const mypaint::Dab &dab) override {
+    m_dabs.push_back(dab);
+    return true;
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+//! The dabs of the tablet strokes, and where each event's dabs end.
+struct Recording {
+  std::vector<mypaint::Dab> m_dabs;
+  std::vector<int> m_eventEnds;
+};
+
+//! Plays strokes like the ones of a tablet - curves across the frame, with
+//! the pressure rising and falling along them - through a brush.
+Recording record(double radius, double hardness, double opaque) {
+  mypaint::Brush brush;
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_RADIUS_LOGARITHMIC, log(radius));
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_HARDNESS, hardness);
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_OPAQUE, opaque);
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_COLOR_H, 0.6f);
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_COLOR_S, 0.8f);
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_COLOR_V, 0.5f);
+  // As MyPaintToonzBrush: the surfaces antialias the dabs
+  brush.setBaseValue(MYPAINT_BRUSH_SETTING_ANTI_ALIASING, 0.f);
+
+  RecordingSurface surface;
+  Recording rec;
+  for (int s = 0; s < strokeCount; ++s) {
+    brush.reset();
+    brush.newStroke();
+
+    for (int e = 0; e < eventCount; ++e) {
+      double t = double(e) / (eventCount - 1);
+      double x = lx * (0.1 + 0.8 * t);
+      double y = ly * (0.5 + 0.35 * std::sin(6.2831853 * t + s));
+      double pressure =
+          std::sin(3.14159265 * t) * (0.75 + 0.25 * std::sin(40.0 * t + s));
+
+      if (e == 0) {
+        brush.setState(MYPAINT_BRUSH_STATE_X, x);
+        brush.setState(MYPAINT_BRUSH_STATE_Y, y);
+        brush.setState(MYPAINT_BRUSH_STATE_ACTUAL_X, x);
+        brush.setState(MYPAINT_BRUSH_STATE_ACTUAL_Y, y);
+        continue;
+      }
+
+      brush.strokeTo(surface, x, y, pressure, 0.0, 0.0, eventTime);
+      rec.m_eventEnds.push_back(surface.m_dabs.size());
+    }
+  }
+
+  rec.m_dabs.swap(surface.m_dabs);
+  return rec;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the largest difference between \b ras and the float reference,
+//! in 8-bit levels.
+double maxError(const TRaster32P &ras, const std::vector<float> &reference) {
+  double error = 0.0;
+  for (int y = 0; y < ly; ++y) {
+    const TPixel32 *pix = ras->pixels(y);
+    const float *ref    = &reference[y * lx * 4];
+    for (int x = 0; x < lx; ++x, ++pix, ref += 4) {
+      const int channels[] = {pix->r, pix->g, pix->b, pix->m};
+      for (int c = 0; c < 4; ++c)
+        error = std::max(
+            error, std::abs(channels[c] - ref[c] * TPixel32::maxChannelValue));
+    }
+  }
+  return error;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  std::printf("%d cores, %d strokes of %d events on %dx%d\n",
+              QThread::idealThreadCount(), strokeCount, eventCount, lx, ly);
+
+  struct BrushCase {
+    const char *m_name;
+    double m_radius, m_hardness, m_opaque;
+  } cases[] = {{"small hard", 4.0, 0.9, 1.0}, {"big soft", 150.0, 0.2, 0.04}};
+
+  int failures = 0;
+  for (const BrushCase &bc : cases) {
+    Recording rec = record(bc.m_radius, bc.m_hardness, bc.m_opaque);
+    const std::vector<mypaint::Dab> &dabs = rec.m_dabs;
+
+    std::vector<float> reference(lx * ly * 4, 0.f);
+    {
+      FloatSurface surface(reference.data(), lx, ly, 4 * sizeof(float));
+      for (const mypaint::Dab &dab : dabs) surface.drawDab(dab);
+    }
+
+    TRaster32P tiled(lx, ly), direct(lx, ly);
+    tiled->fill(TPixel32::Transparent);
+    direct->fill(TPixel32::Transparent);
+
+    double tiledMs = elapsedMs([&] {
+      Raster32PMyPaintSurface surface(tiled);
+      int d = 0;
+      for (int end : rec.m_eventEnds) {
+        for (; d < end; ++d) surface.drawDab(dabs[d]);
+        surface.flush();
+      }
+    });
+
+    double directMs = elapsedMs([&] {
+      Raster32Surface surface(direct->pixels(), lx, ly, direct->getPixelSize(),
+                              direct->getRowSize());
+      for (const mypaint::Dab &dab : dabs) surface.drawDab(dab);
+    });
+
+    // The tiles only round when resolved: half a level, and the float noise
+    // of the dabs' coordinates in the tiles
+    double tiledError = maxError(tiled, reference);
+    bool ok           = tiledError <= 1.0;
+
+    std::printf(
+        "%-10s %7d dabs: tiles %8.0f dabs/s (error %5.2f), 8-bit %8.0f "
+        "dabs/s (error %5.2f)%s\n",
+        bc.m_name, (int)dabs.size(), 1000.0 * dabs.size() / tiledMs,
+        tiledError, 1000.0 * dabs.size() / directMs,
+        maxError(direct, reference), ok ? "" : "  (values differ!)");
+    if (!ok) ++failures;
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+// Times saving and loading a scene-sized document in the XML and in the
+// binary form of TOStream/TIStream, and reading a single section of the
+// binary file through its section index.
+
+// TnzCore includes
+#include "tstream.h"
+#include "tfilepath.h"
+#include "tpixel.h"
+#include "tsystem.h"
+#include "tconvert.h"
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace {
+
+const int levelCount = 200, columnCount = 400, rowCount = 3000,
+          fxCount = 2000, keyframeCount = 40, historyCount = 50;
+
+//-----------------------------------------------------------------------------
+
+//! Writes a document shaped like a .tnz file: a level set, dense xsheet
+//! columns, fx nodes with animated params and a trailing history section.
+void saveScene(const TFilePath &fp, bool binary) {
+  TOStream os(fp, false, binary);
+
+  std::map<std::string, std::string> attr;
+  attr["version"]    = "71.1";
+  attr["framecount"] = std::to_string(rowCount);
+  os.openChild("tnz", attr);
+
+  os.openChild("levelSet");
+  for (int l = 0; l < levelCount; ++l) {
+    os.openChild("level");
+    os.child("name") << "A" + std::to_string(l);
+    os.child("path") << "+drawings/A" + std::to_string(l) + ".pli";
+    os.closeChild();
+  }
+  os.closeChild();
+
+  os.openChild("columns");
+  for (int c = 0; c < columnCount; ++c) {
+    os.openChild("cells");
+    // holds of 1 to 3 frames, switching level every 50 cells
+    for (int r = 0, k = 0; r < rowCount; ++k) {
+      int n = 1 + (k * 7 + c) % 3;
+      os.child("cell") << r << n << (c + k / 50) % levelCount
+                       << std::to_string(k % 120 + 1);
+      r += n;
+    }
+    os.closeChild();
+  }
+  os.closeChild();
+
+  os.openChild("fxnodes");
+  for (int f = 0; f < fxCount; ++f) {
+    std::map<std::string, std::string> fxAttr;
+    fxAttr["id"] = std::to_string(f);
+    os.openChild("fx", fxAttr);
+    os.child("name") << "Blur" + std::to_string(f);
+    os.openChild("value");
+    for (int k = 0; k < keyframeCount; ++k)
+      os.child("k_linear") << k * 3 << std::sin(k + f * 0.1) * 100
+                           << std::string("inch");
+    os.closeChild();
+    os.child("color") << TPixel32(f % 255, 10, 20, 255);
+    os.closeChild();
+  }
+  os.closeChild();
+
+  os.openChild("history");
+  for (int h = 0; h < historyCount; ++h)
+    os << std::wstring(L"2026-10-19 12:00 | user | \"edit\" ||");
+  os.closeChild();
+
+  os.closeChild();
+}
+
+//-----------------------------------------------------------------------------
+
+//! Matches the children of the current tag, calling \b readChild(tagName)
+//! on each one up to its end tag; returns the number of children matched.
+template <typename Func>
+long readChildren(TIStream &is, Func readChild) {
+  long count = 0;
+  std::string tagName;
+  while (is.matchTag(tagName)) {
+    readChild(tagName);
+    if (!is.matchEndTag()) throw TException("Missing end of " + tagName);
+    ++count;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+long readHistory(TIStream &is) {
+  long count = 0;
+  while (!is.eos()) {
+    std::wstring entry;
+    is >> entry;
+    ++count;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Reads back what saveScene() writes; returns the number of tags and
+//! history entries read.
+long loadScene(const TFilePath &fp) {
+  TIStream is(fp);
+  std::string tagName;
+  if (!is.matchTag(tagName) || tagName != "tnz")
+    throw TException("Bad root tag");
+
+  long count = 0;
+  count += readChildren(is, [&](const std::string &section) {
+    if (section == "levelSet")
+      count += readChildren(is, [&](const std::string &) {
+        count += readChildren(is, [&](const std::string &) {
+          std::string value;
+          is >> value;
+        });
+      });
+    else if (section == "columns")
+      count += readChildren(is, [&](const std::string &) {
+        count += readChildren(is, [&](const std::string &) {
+          int row, length, level;
+          std::string fid;
+          is >> row >> length >> level >> fid;
+        });
+      });
+    else if (section == "fxnodes")
+      count += readChildren(is, [&](const std::string &) {
+        count += readChildren(is, [&](const std::string &tag) {
+          std::string name;
+          TPixel32 color;
+          if (tag == "name")
+            is >> name;
+          else if (tag == "color")
+            is >> color;
+          else
+            count += readChildren(is, [&](const std::string &) {
+              int frame;
+              double value;
+              std::string unit;
+              is >> frame >> value >> unit;
+            });
+        });
+      });
+    else
+      count += readHistory(is);
+  });
+
+  if (!is.matchEndTag() || !is) throw TException("Bad scene");
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Reads only the history section, jumping to it through the section index
+//! when the file has one.
+long loadHistory(const TFilePath &fp) {
+  TIStream is(fp);
+  std::string tagName;
+  if (!is.matchTag(tagName)) throw TException("Bad root tag");
+  is.seekSection("history");
+  while (is.matchTag(tagName)) {
+    if (tagName == "history") {
+      long count = readHistory(is);
+      is.matchEndTag();
+      return count;
+    }
+    is.skipCurrentTag();
+  }
+  throw TException("Missing history");
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the best time of three runs of f(), in milliseconds.
+template <typename Func>
+double bestMs(Func f) {
+  double best = 1e30;
+  for (int i = 0; i < 3; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main() {
+  TFilePath dir = TSystem::getTempDir();
+
+  const TFilePath fps[] = {dir + "scenebench_xml.tnz",
+                           dir + "scenebench_bin.tnz"};
+  const char *names[]   = {"xml", "binary"};
+
+  try {
+    for (int b = 0; b < 2; ++b) {
+      long values = 0, historyValues = 0;
+
+      double save = bestMs([&] { saveScene(fps[b], b == 1); });
+      double load = bestMs([&] { values = loadScene(fps[b]); });
+      double history =
+          bestMs([&] { historyValues = loadHistory(fps[b]); });
+
+      std::printf(
+          "%-6s: save %7.1f ms, load %7.1f ms (%ld tags), history only "
+          "%6.1f ms (%ld entries), %ld bytes\n",
+          names[b], save, load, values, history, historyValues,
+          (long)TFileStatus(fps[b]).getSize());
+    }
+  } catch (const TException &e) {
+    std::printf("error: %s\n", ::to_string(e.getMessage()).c_str());
+    return 1;
+  }
+
+  for (const TFilePath &fp : fps) TSystem::removeFileOrLevel(fp);
+  return 0;
+}
@@ -0,0 +1,176 @@
+// Times the xsheet redraw of ten 30 minute sound columns: the waveform values
+// of a screenful of pixels, at several zooms and scroll positions, read from
+// the peak index and by scanning the decoded tracks. Checks that the index
+// gives the same values as the scan over the whole base blocks.
+
+// TnzLib includes
+#include "flare/txshsoundlevel.h"
+#include "orientation.h"
+
+// TnzCore includes
+#include "tsound_t.h"
+#include "tsoundpeaks.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int trackCount = 10, minutes = 30, sampleRate = 11025, fps = 24;
+const int screenPixels = 1000, scrollCount = 20;
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! Dialogue-like track: words of a few hundred milliseconds, made of noisy
+//! tones, separated by pauses of digital silence.
+TSoundTrackP makeTrack(int seed) {
+  TINT32 sampleCount = minutes * 60 * sampleRate;
+  TSoundTrackMono16 *st = new TSoundTrackMono16(sampleRate, 1, sampleCount);
+  TMono16Sample *sample = st->samples();
+
+  unsigned int rnd = 12345 + seed;
+  auto next        = [&rnd]() { return (rnd = rnd * 1103515245 + 12345); };
+
+  TINT32 s = 0;
+  while (s < sampleCount) {
+    TINT32 word = sampleRate / 10 + next() % (sampleRate / 2);
+    TINT32 gap  = sampleRate / 20 + next() % sampleRate;
+    double freq = 100.0 + next() % 300, amp = 2000.0 + next() % 20000;
+
+    for (TINT32 i = 0; i < word && s < sampleCount; ++i, ++s) {
+      double env   = std::sin(3.14159265 * i / word);
+      double noise = int(next() % 2001) - 1000;
+      sample[s]    = TMono16Sample(short(
+          env * (amp * std::sin(6.2831853 * freq * i / sampleRate) + noise)));
+    }
+    for (TINT32 i = 0; i < gap && s < sampleCount; ++i, ++s)
+      sample[s] = TMono16Sample(0);
+  }
+
+  return st;
+}
+
+//-----------------------------------------------------------------------------
+
+//! The samples drawn at \b pixel since the start of a sound level, as in
+//! TXshSoundLevel::getValueAtPixel().
+void pixelRange(int frameHeight, int pixel, TINT32 &s0, TINT32 &s1) {
+  double samplePerFrame = double(sampleRate) / fps;
+  double samplePerPixel = samplePerFrame / frameHeight;
+
+  int i = pixel / frameHeight, j = pixel % frameHeight;
+  s0    = TINT32(i * samplePerFrame + j * samplePerPixel);
+  s1    = (j < frameHeight - 1)
+              ? TINT32(i * samplePerFrame + (j + 1) * samplePerPixel - 1)
+              : TINT32((i + 1) * samplePerFrame - 1);
+  s1    = std::max(s0, s1);
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  std::printf("%d cores, %d tracks of %d min at %d Hz\n",
+              QThread::idealThreadCount(), trackCount, minutes, sampleRate);
+
+  std::vector<TSoundTrackP> tracks;
+  for (int t = 0; t < trackCount; ++t) tracks.push_back(makeTrack(t));
+
+  // The index is built in background on load; the export waits for it
+  std::vector<TXshSoundLevelP> levels;
+  double build = elapsedMs([&] {
+    for (const TSoundTrackP &st : tracks) {
+      TXshSoundLevelP level = new TXshSoundLevel(L"track");
+      level->setFrameRate(fps);
+      level->setSoundTrack(st);
+      levels.push_back(level);
+    }
+    for (const TXshSoundLevelP &level : levels) level->waitForPeaks();
+  });
+  std::printf("peak index build: %8.1f ms\n", build);
+
+  const Orientation *o = Orientations::topToBottom();
+  int frameHeight      = o->dimension(PredefinedDimension::FRAME);
+  int trackPixels      = minutes * 60 * fps * frameHeight;
+
+  int failures = 0;
+  for (int zoom : {1, 5, 25}) {
+    // One redraw: a screenful of pixels of every column, one every zoom
+    auto redraw = [&](int top, bool scan) {
+      for (int t = 0; t < trackCount; ++t)
+        for (int p = 0; p < screenPixels; ++p) {
+          int pixel = top + p * zoom;
+          if (pixel >= trackPixels) break;
+
+          if (!scan) {
+            DoublePair values;
+            levels[t]->getValueAtPixel(o, pixel, values);
+            continue;
+          }
+
+          TINT32 s0, s1;
+          pixelRange(frameHeight, pixel, s0, s1);
+          double min = 0.0, max = 0.0;
+          tracks[t]->getMinMaxPressure(s0, s1, TSound::MONO, min, max);
+        }
+    };
+
+    double peaksMs = 0, scanMs = 0;
+    for (int s = 0; s < scrollCount; ++s) {
+      int top = (long long)trackPixels * s / scrollCount;
+      peaksMs += elapsedMs([&] { redraw(top, false); });
+      scanMs += elapsedMs([&] { redraw(top, true); });
+    }
+
+    // The index reads whole base blocks: compare with a scan over them, on
+    // ranges as long as a screenful
+    bool same = true;
+    for (int t = 0; t < trackCount && same; ++t) {
+      std::shared_ptr<const TSoundPeaks> peaks = levels[t]->getPeaks();
+      TINT32 lastSample = tracks[t]->getSampleCount() - 1;
+      for (int p = 0; p < trackPixels && same; p += 997 * zoom) {
+        TINT32 s0, s1;
+        pixelRange(frameHeight, p, s0, s1);
+        s1 = std::min(s0 + (s1 - s0 + 1) * zoom * screenPixels, lastSample);
+
+        double min, max, scanMin, scanMax;
+        peaks->getMinMaxPressure(s0, s1, min, max);
+
+        TINT32 block = TSoundPeaks::baseBlockSize();
+        tracks[t]->getMinMaxPressure(
+            s0 / block * block, std::min(s1 / block * block + block - 1,
+                                         lastSample),
+            TSound::MONO, scanMin, scanMax);
+        same = (min == scanMin && max == scanMax);
+      }
+    }
+
+    std::printf("zoom 1:%-2d redraw: peaks %7.3f ms, scan %8.3f ms%s\n", zoom,
+                peaksMs / scrollCount, scanMs / scrollCount,
+                same ? "" : "  (values differ!)");
+    if (!same) ++failures;
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+// Times TDoubleParam::getValue() on a cycled curve against the table lookup
+// of TBakedDoubleParam, querying integer frames below a growing bound.
+
+// TnzBase includes
+#include "tdoubleparam.h"
+#include "tdoublekeyframe.h"
+#include "tbakeddoubleparam.h"
+
+// STD includes
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+//! Returns the average time of \b count calls to f(i), in nanoseconds.
+template <typename Func>
+double nsPerCall(int count, Func f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) f(i);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main() {
+  // 6 linear keyframes, cycled after the last one
+  TDoubleParamP param(new TDoubleParam(0.0));
+  for (int k = 0; k < 6; ++k) {
+    TDoubleKeyframe kf(k * 4, (k % 2) ? 10.0 : -10.0);
+    kf.m_type = TDoubleKeyframe::Linear;
+    param->setKeyframe(kf);
+  }
+  param->enableCycle(true);
+
+  const int queries       = 1000000;
+  const int frameBounds[] = {20, 2000, 20000};
+
+  for (int bound : frameBounds) {
+    TBakedDoubleParam baked(param, 0, bound);
+
+    double directSum = 0, bakedSum = 0;
+
+    double direct = nsPerCall(
+        queries, [&](int i) { directSum += param->getValue(i % bound); });
+    double table = nsPerCall(
+        queries, [&](int i) { bakedSum += baked.getValue(i % bound); });
+
+    std::printf("frames < %5d: getValue %6.1f ns, baked %6.1f ns%s\n", bound,
+                direct, table,
+                directSum == bakedSum ? "" : "  (values differ!)");
+  }
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+// Times the batch vectorization of synthetic levels, in frames per second at
+// 1, 8 and 32 threads: centerline on Toonz rasters and outline on full-color
+// rasters. Checks that the strokes and the palette don't depend on the thread
+// count.
+
+// TnzLib includes
+#include "flare/batchvectorizer.h"
+#include "flare/tcenterlinevectorizer.h"
+#include "flare/vectorizerparameters.h"
+
+// TnzCore includes
+#include "tpalette.h"
+#include "tcolorstyles.h"
+#include "ttoonzimage.h"
+#include "trasterimage.h"
+#include "tstroke.h"
+#include "tvectorimage.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QThread>
+
+// STD includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int frameCount = 48, lx = 1280, ly = 720;
+
+//! Returns the time taken by f(), in milliseconds.
+template <typename Func>
+double elapsedMs(Func f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! Whether (x, y) lies on one of the frame's rings: circles moving along the
+//! sequence, so that each frame is different.
+bool onRing(int frame, int ring, int x, int y, double thickness) {
+  double cx = lx * (0.2 + 0.15 * ring) + 4.0 * frame;
+  double cy = ly * 0.5 + 60.0 * std::sin(0.3 * frame + ring);
+  double r  = 40.0 + 25.0 * ring;
+  double d  = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+  return std::abs(d - r) < thickness;
+}
+
+//-----------------------------------------------------------------------------
+
+TImageP makeToonzFrame(int frame) {
+  TRasterCM32P ras(lx, ly);
+  ras->fill(TPixelCM32());
+
+  for (int y = 0; y < ly; ++y) {
+    TPixelCM32 *pix = ras->pixels(y);
+    for (int x = 0; x < lx; ++x)
+      for (int ring = 0; ring < 5; ++ring)
+        if (onRing(frame, ring, x, y, 2.5))
+          pix[x] = TPixelCM32(1 + ring, 0, 0);
+  }
+
+  TToonzImageP ti(ras, ras->getBounds());
+  ti->setDpi(72, 72);
+  return ti;
+}
+
+//-----------------------------------------------------------------------------
+
+TImageP makeFullColorFrame(int frame) {
+  TRaster32P ras(lx, ly);
+  ras->fill(TPixel32::White);
+
+  for (int y = 0; y < ly; ++y) {
+    TPixel32 *pix = ras->pixels(y);
+    for (int x = 0; x < lx; ++x)
+      for (int ring = 0; ring < 5; ++ring)
+        if (onRing(frame, ring, x, y, 8.0))
+          pix[x] = TPixel32(50 * ring, 200 - 40 * ring, 40 * ring + frame);
+  }
+
+  TRasterImageP ri(ras);
+  ri->setDpi(72, 72);
+  return ri;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns a digest of the strokes and styles of the vectorized frames.
+std::string signature(const std::vector<TVectorImageP> &images,
+                      const TPalette *palette) {
+  std::string sig = std::to_string(palette->getStyleCount());
+  for (const TVectorImageP &vi : images) {
+    if (!vi) {
+      sig += "|null";
+      continue;
+    }
+    sig += "|" + std::to_string(vi->getStrokeCount());
+    for (UINT s = 0; s < vi->getStrokeCount(); ++s) {
+      const TStroke *stroke = vi->getStroke(s);
+      sig += " " + std::to_string(stroke->getStyle()) + ":" +
+             std::to_string(stroke->getControlPointCount());
+      TThickPoint p = stroke->getControlPoint(0);
+      char buf[64];
+      std::snprintf(buf, sizeof(buf), "(%.4f,%.4f)", p.x, p.y);
+      sig += buf;
+    }
+  }
+  return sig;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Vectorizes \b frames with \b threadCount threads; returns the digest of
+//! the result and sets the frames per second.
+std::string vectorize(const std::vector<TImageP> &frames, bool outline,
+                      int threadCount, double &fps) {
+  TPaletteP palette(new TPalette);
+  for (int ring = 0; ring < 5; ++ring)
+    palette->getPage(0)->addStyle(TPixel32(40 * ring, 0, 0));
+
+  std::vector<TVectorImageP> images;
+  int index = 0;
+
+  auto source = [&](BatchVectorizer::Frame &frame) -> bool {
+    if (index == (int)frames.size()) return false;
+
+    frame.m_fid = TFrameId(index + 1);
+    if (outline)
+      frame.m_configuration.reset(new NewOutlineConfiguration);
+    else
+      frame.m_configuration.reset(new CenterlineConfiguration);
+    BatchVectorizer::setImageTransform(frames[index], *frame.m_configuration);
+    frame.m_image = frames[index++];
+    return true;
+  };
+  auto sink = [&](const TFrameId &, const TVectorImageP &vi) {
+    images.push_back(vi);
+  };
+
+  BatchVectorizer batch(threadCount);
+  double ms = elapsedMs(
+      [&] { batch.run(palette.getPointer(), source, sink); });
+  fps = 1000.0 * frames.size() / ms;
+
+  return signature(images, palette.getPointer());
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  std::printf("%d cores, %d frames %dx%d\n", QThread::idealThreadCount(),
+              frameCount, lx, ly);
+
+  int failures = 0;
+  for (bool outline : {false, true}) {
+    std::vector<TImageP> frames;
+    for (int f = 0; f < frameCount; ++f)
+      frames.push_back(outline ? makeFullColorFrame(f) : makeToonzFrame(f));
+
+    std::string reference;
+    for (int threadCount : {1, 8, 32}) {
+      double fps = 0;
+      std::string sig = vectorize(frames, outline, threadCount, fps);
+      if (threadCount == 1) reference = sig;
+
+      bool same = (sig == reference);
+      std::printf("%-22s %2d threads: %6.2f fps%s\n",
+                  outline ? "outline, full-color" : "centerline, toonz",
+                  threadCount, fps, same ? "" : "  (values differ!)");
+      if (!same) ++failures;
+    }
+  }
+
+  return failures ? 1 : 0;
+}
@@ -124,6 +124,13 @@ bool TExpression::isValid() {
 
 //--------------------------------------------------------------------------
 
+bool TExpression::hasReference() {
+  if (!m_imp->m_hasBeenParsed) parse();
+  return m_imp->m_hasReference;
+}
+
+//--------------------------------------------------------------------------
+
 std::string TExpression::getError() const { return m_imp->m_error; }
 
 //--------------------------------------------------------------------------
@@ -17,6 +17,8 @@
 #include <math.h>
 #include <functional>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 // Qt includes
 #include <QString>
@@ -86,25 +88,383 @@ public:
   }
 };
 
+//===================================================================
+//
+// Program
+//
+//   Register code compiled from a tree of calculator nodes.
+//   Registers 0, 1 and 2 hold the variables (see CalculatorNode::T, FRAME
+//   and RFRAME); the others hold constants or the results of instructions.
+//   Each instruction writes a new register, except for the Move
+//   instructions of conditional expressions, so that constants are never
+//   overwritten and a program can be run repeatedly on the same registers.
+//
+//-------------------------------------------------------------------
+
+class Program {
+public:
+  typedef double (*Function1)(double);
+  typedef double (*Function2)(double, double);
+  typedef double (*Function3)(double, double, double);
+
+  enum Operator { Add, Subtract, Multiply, Divide };
+
+private:
+  struct Instruction {
+    enum Code {
+      Add,
+      Subtract,
+      Multiply,
+      Divide,
+      Call1,
+      Call2,
+      Call3,
+      Node,
+      Move,
+      Jump,
+      JumpIfZero
+    };
+
+    Code m_code;
+    int m_dst, m_a, m_b, m_c;  // registers. m_dst is the target of jumps
+
+    union {
+      Function1 m_function1;
+      Function2 m_function2;
+      Function3 m_function3;
+      const CalculatorNode *m_node;
+    };
+  };
+
+  std::vector<Instruction> m_instructions;
+  std::vector<double> m_registers;  //!< Initial values of the registers
+  std::vector<bool> m_isConstant;
+  int m_result;
+  bool m_folded;  //!< Whether some node was evaluated at compile time
+
+  // registers allocated on the stack in compute()
+  static const int MaxStackRegisters = 64;
+
+public:
+  Program()
+      : m_registers(3, 0.0)
+      , m_isConstant(3, false)
+      , m_result(0)
+      , m_folded(false) {}
+
+  //! Compiles the tree starting from the passed node.
+  void compile(const CalculatorNode *root) { m_result = root->compile(*this); }
+
+  int addRegister(bool isConstant = false, double value = 0) {
+    m_registers.push_back(value);
+    m_isConstant.push_back(isConstant);
+    return (int)m_registers.size() - 1;
+  }
+
+  int addConstant(double value) { return addRegister(true, value); }
+
+  //! Adds a constant replacing a node that was evaluated at compile time.
+  int addFolded(double value) {
+    setFolded();
+    return addConstant(value);
+  }
+
+  //! Records that some node was removed at compile time.
+  void setFolded() { m_folded = true; }
+  bool isFolded() const { return m_folded; }
+  bool isConstant(int reg) const { return m_isConstant[reg]; }
+  double getConstant(int reg) const { return m_registers[reg]; }
+
+  //! Applies an arithmetic operator, without the cost of a call.
+  int addOperation(Operator op, int a, int b) {
+    if (isConstant(a) && isConstant(b))
+      return addFolded(apply(op, getConstant(a), getConstant(b)));
+    Instruction::Code code = (op == Add)        ? Instruction::Add
+                             : (op == Subtract) ? Instruction::Subtract
+                             : (op == Multiply) ? Instruction::Multiply
+                                                : Instruction::Divide;
+    return addInstruction(code, addRegister(), a, b).m_dst;
+  }
+
+  //! Calls \b f on the passed registers - at compile time, if they are
+  //! constant. The function must not depend on anything else.
+  int addCall(Function1 f, int a) {
+    if (isConstant(a)) return addFolded(f(getConstant(a)));
+    Instruction &instr = addInstruction(Instruction::Call1, addRegister(), a);
+    instr.m_function1  = f;
+    return instr.m_dst;
+  }
+  int addCall(Function2 f, int a, int b) {
+    if (isConstant(a) && isConstant(b))
+      return addFolded(f(getConstant(a), getConstant(b)));
+    Instruction &instr =
+        addInstruction(Instruction::Call2, addRegister(), a, b);
+    instr.m_function2 = f;
+    return instr.m_dst;
+  }
+  int addCall(Function3 f, int a, int b, int c) {
+    if (isConstant(a) && isConstant(b) && isConstant(c))
+      return addFolded(f(getConstant(a), getConstant(b), getConstant(c)));
+    Instruction &instr =
+        addInstruction(Instruction::Call3, addRegister(), a, b, c);
+    instr.m_function3 = f;
+    return instr.m_dst;
+  }
+
+  //! Calls node->compute() at run time.
+  int addNode(const CalculatorNode *node) {
+    Instruction &instr = addInstruction(Instruction::Node, addRegister());
+    instr.m_node       = node;
+    return instr.m_dst;
+  }
+
+  void addMove(int dst, int src) {
+    addInstruction(Instruction::Move, dst, src);
+  }
+
+  //! Adds a jump, returning its index for setJumpTarget(). Conditional jumps
+  //! are taken when the register is zero.
+  int addJump() {
+    addInstruction(Instruction::Jump, -1);
+    return (int)m_instructions.size() - 1;
+  }
+  int addJumpIfZero(int reg) {
+    addInstruction(Instruction::JumpIfZero, -1, reg);
+    return (int)m_instructions.size() - 1;
+  }
+
+  //! Makes the passed jump land after the last added instruction.
+  void setJumpTarget(int jump) {
+    m_instructions[jump].m_dst = (int)m_instructions.size();
+  }
+
+  double compute(const double vars[3]) const {
+    double stackRegisters[MaxStackRegisters];
+    std::vector<double> heapRegisters;
+    double *regs = initRegisters(stackRegisters, heapRegisters);
+
+    for (int v = 0; v < 3; ++v) regs[v] = vars[v];
+    run(regs);
+    return regs[m_result];
+  }
+
+  void compute(const double vars[3], const double dvars[3], int count,
+               double *out) const {
+    double stackRegisters[MaxStackRegisters];
+    std::vector<double> heapRegisters;
+    double *regs = initRegisters(stackRegisters, heapRegisters);
+
+    for (int i = 0; i < count; ++i) {
+      for (int v = 0; v < 3; ++v) regs[v] = vars[v] + i * dvars[v];
+      run(regs);
+      out[i] = regs[m_result];
+    }
+  }
+
+private:
+  Instruction &addInstruction(Instruction::Code code, int dst, int a = 0,
+                              int b = 0, int c = 0) {
+    Instruction instr;
+    instr.m_code = code, instr.m_dst = dst;
+    instr.m_a = a, instr.m_b = b, instr.m_c = c;
+    instr.m_node = 0;
+    m_instructions.push_back(instr);
+    return m_instructions.back();
+  }
+
+  static double apply(Operator op, double a, double b) {
+    switch (op) {
+    case Add:
+      return a + b;
+    case Subtract:
+      return a - b;
+    case Multiply:
+      return a * b;
+    default:
+      return a / b;
+    }
+  }
+
+  double *initRegisters(double *stackRegisters,
+                        std::vector<double> &heapRegisters) const {
+    double *regs = stackRegisters;
+    if ((int)m_registers.size() > MaxStackRegisters) {
+      heapRegisters.resize(m_registers.size());
+      regs = &heapRegisters[0];
+    }
+    std::copy(m_registers.begin(), m_registers.end(), regs);
+    return regs;
+  }
+
+  void run(double *regs) const {
+    const Instruction *instructions = m_instructions.data();
+    int count                       = (int)m_instructions.size();
+    for (int i = 0; i < count;) {
+      const Instruction &instr = instructions[i++];
+      switch (instr.m_code) {
+      case Instruction::Add:
+        regs[instr.m_dst] = regs[instr.m_a] + regs[instr.m_b];
+        break;
+      case Instruction::Subtract:
+        regs[instr.m_dst] = regs[instr.m_a] - regs[instr.m_b];
+        break;
+      case Instruction::Multiply:
+        regs[instr.m_dst] = regs[instr.m_a] * regs[instr.m_b];
+        break;
+      case Instruction::Divide:
+        regs[instr.m_dst] = regs[instr.m_a] / regs[instr.m_b];
+        break;
+      case Instruction::Call1:
+        regs[instr.m_dst] = instr.m_function1(regs[instr.m_a]);
+        break;
+      case Instruction::Call2:
+        regs[instr.m_dst] = instr.m_function2(regs[instr.m_a], regs[instr.m_b]);
+        break;
+      case Instruction::Call3:
+        regs[instr.m_dst] = instr.m_function3(regs[instr.m_a], regs[instr.m_b],
+                                              regs[instr.m_c]);
+        break;
+      case Instruction::Node:
+        regs[instr.m_dst] = instr.m_node->compute(regs);
+        break;
+      case Instruction::Move:
+        regs[instr.m_dst] = regs[instr.m_a];
+        break;
+      case Instruction::Jump:
+        i = instr.m_dst;
+        break;
+      case Instruction::JumpIfZero:
+        if (regs[instr.m_a] == 0) i = instr.m_dst;
+        break;
+      }
+    }
+  }
+};
+
+//-------------------------------------------------------------------
+
+template <class Op>
+double call1(double a) {
+  Op op;
+  return op(a);
+}
+
+template <class Op>
+double call2(double a, double b) {
+  Op op;
+  return op(a, b);
+}
+
+template <class Op>
+double call3(double a, double b, double c) {
+  Op op;
+  return op(a, b, c);
+}
+
+//-------------------------------------------------------------------
+
+//! Compiles a binary operator. The arithmetic ones have their own
+//! instructions.
+template <class Op>
+int compileOp2(Program &program, int a, int b) {
+  return program.addCall(&call2<Op>, a, b);
+}
+
+template <>
+int compileOp2<std::plus<double>>(Program &program, int a, int b) {
+  return program.addOperation(Program::Add, a, b);
+}
+
+template <>
+int compileOp2<std::minus<double>>(Program &program, int a, int b) {
+  return program.addOperation(Program::Subtract, a, b);
+}
+
+template <>
+int compileOp2<std::multiplies<double>>(Program &program, int a, int b) {
+  return program.addOperation(Program::Multiply, a, b);
+}
+
+template <>
+int compileOp2<std::divides<double>>(Program &program, int a, int b) {
+  return program.addOperation(Program::Divide, a, b);
+}
+
 //===================================================================
 // Calculator
 //-------------------------------------------------------------------
 
-Calculator::Calculator() : m_rootNode(0), m_param(0), m_unit(0) {}
+Calculator::Calculator()
+    : m_rootNode(0), m_program(0), m_param(0), m_unit(0) {}
 
 //-------------------------------------------------------------------
 
-Calculator::~Calculator() { delete m_rootNode; }
+Calculator::~Calculator() {
+  delete m_program;
+  delete m_rootNode;
+}
 
 //-------------------------------------------------------------------
 
 void Calculator::setRootNode(CalculatorNode *node) {
   if (node != m_rootNode) {
+    delete m_program;
+    m_program = 0;
     delete m_rootNode;
     m_rootNode = node;
+
+    if (m_rootNode) {
+      // Without folding the program is slower than the tree: keep the latter
+      m_program = new Program;
+      m_program->compile(m_rootNode);
+      if (!m_program->isFolded()) {
+        delete m_program;
+        m_program = 0;
+      }
+    }
+  }
+}
+
+//-------------------------------------------------------------------
+
+double Calculator::compute(double vars[3]) const {
+  return m_program ? m_program->compute(vars) : m_rootNode->compute(vars);
+}
+
+//-------------------------------------------------------------------
+
+void Calculator::compute(const double vars[3], const double dvars[3],
+                         int count, double *out) const {
+  if (m_program) {
+    m_program->compute(vars, dvars, count, out);
+    return;
+  }
+
+  double v[3];
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < 3; ++j) v[j] = vars[j] + i * dvars[j];
+    out[i] = m_rootNode->compute(v);
   }
 }
 
+//===================================================================
+// Node compilation
+//-------------------------------------------------------------------
+
+int CalculatorNode::compile(Program &program) const {
+  return program.addNode(this);
+}
+
+//-------------------------------------------------------------------
+
+int NumberNode::compile(Program &program) const {
+  return program.addConstant(m_value);
+}
+
+//-------------------------------------------------------------------
+
+int VariableNode::compile(Program &program) const { return m_varIdx; }
+
 //===================================================================
 // Nodes
 //-------------------------------------------------------------------
@@ -136,6 +496,10 @@ public:
   }
 
   void accept(CalculatorNodeVisitor &visitor) override { m_a->accept(visitor); }
+
+  int compile(Program &program) const override {
+    return program.addCall(&call1<Op>, m_a->compile(program));
+  }
 };
 
 //-------------------------------------------------------------------
@@ -157,6 +521,11 @@ public:
   void accept(CalculatorNodeVisitor &visitor) override {
     m_a->accept(visitor), m_b->accept(visitor);
   }
+
+  int compile(Program &program) const override {
+    int a = m_a->compile(program);
+    return compileOp2<Op>(program, a, m_b->compile(program));
+  }
 };
 
 //-------------------------------------------------------------------
@@ -179,6 +548,11 @@ public:
   void accept(CalculatorNodeVisitor &visitor) override {
     m_a->accept(visitor), m_b->accept(visitor), m_c->accept(visitor);
   }
+
+  int compile(Program &program) const override {
+    int a = m_a->compile(program), b = m_b->compile(program);
+    return program.addCall(&call3<Op>, a, b, m_c->compile(program));
+  }
 };
 
 //-------------------------------------------------------------------
@@ -191,6 +565,10 @@ public:
 
   double compute(double vars[3]) const override { return -m_a->compute(vars); }
   void accept(CalculatorNodeVisitor &visitor) override { m_a->accept(visitor); }
+
+  int compile(Program &program) const override {
+    return program.addCall(&call1<std::negate<double>>, m_a->compile(program));
+  }
 };
 
 //-------------------------------------------------------------------
@@ -210,6 +588,25 @@ public:
   void accept(CalculatorNodeVisitor &visitor) override {
     m_a->accept(visitor), m_b->accept(visitor), m_c->accept(visitor);
   }
+
+  int compile(Program &program) const override {
+    int a = m_a->compile(program);
+    if (program.isConstant(a)) {
+      program.setFolded();
+      return (program.getConstant(a) != 0) ? m_b->compile(program)
+                                           : m_c->compile(program);
+    }
+
+    // Only the selected branch is evaluated, as in compute()
+    int result     = program.addRegister();
+    int jumpToElse = program.addJumpIfZero(a);
+    program.addMove(result, m_b->compile(program));
+    int jumpToEnd = program.addJump();
+    program.setJumpTarget(jumpToElse);
+    program.addMove(result, m_c->compile(program));
+    program.setJumpTarget(jumpToEnd);
+    return result;
+  }
 };
 
 //-------------------------------------------------------------------
@@ -224,6 +621,11 @@ public:
     return m_a->compute(vars) == 0;
   }
   void accept(CalculatorNodeVisitor &visitor) override { m_a->accept(visitor); }
+
+  int compile(Program &program) const override {
+    return program.addCall(&call1<std::logical_not<double>>,
+                           m_a->compile(program));
+  }
 };
 //-------------------------------------------------------------------
 
@@ -311,6 +713,30 @@ public:
     if (m_min.get()) m_min->accept(visitor);
     if (m_max.get()) m_max->accept(visitor);
   }
+
+  int compile(Program &program) const override {
+    struct locals {
+      static double random(double s, double arg) {
+        return RandomManager::instance()->getValue(s, fabs(arg));
+      }
+      static double mix(double r, double min, double max) {
+        return (1 - r) * min + r * max;
+      }
+    };
+
+    int s = m_seed.get() ? m_seed->compile(program) : program.addConstant(0);
+    int r = program.addCall(&locals::random, s, m_arg->compile(program));
+    if (m_min.get() == 0)
+      if (m_max.get() == 0)
+        return r;
+      else
+        return program.addOperation(Program::Multiply,
+                                    m_max->compile(program), r);
+    else {
+      int min = m_min->compile(program);
+      return program.addCall(&locals::mix, r, min, m_max->compile(program));
+    }
+  }
 };
 
 //-------------------------------------------------------------------
@@ -353,6 +779,10 @@ public:
     RandomNode::accept(visitor);
     if (m_period.get()) m_period->accept(visitor);
   }
+
+  int compile(Program &program) const override {
+    return CalculatorNode::compile(program);
+  }
 };
 
 //===================================================================
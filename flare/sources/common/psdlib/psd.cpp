@@ -8,6 +8,14 @@
 #include "trasterimage.h"
 #include "trop.h"
 #include "tpixelutils.h"
+#include "tsystem.h"
+#include "tthread.h"
+
+#include <QDateTime>
+
+#include <map>
+#include <memory>
+#include <vector>
 
 /*
   The entire content of this file is ridden with LEAKS. A bug has been filed,
@@ -41,6 +49,37 @@ void readKey(FILE *f, struct dictentry *parent, TPSDLayerInfo *li);
 void readLayer16(FILE *f, struct dictentry *parent, TPSDLayerInfo *li);
 //----end forward declarations
 
+namespace {
+
+// The header and layer records of a PSD file, together with the position of
+// each layer's data. Parsing them means visiting every layer of the file, so
+// they are shared by all the readers of an unchanged file; they are never
+// modified after parsing.
+struct LayerIndex {
+  QDateTime m_modified;
+  TINT64 m_size;
+  TPSDHeaderInfo m_headerInfo;
+};
+
+QMutex layerIndicesMutex;
+std::map<TFilePath, LayerIndex> layerIndices;
+
+// Channel infos used by a single load. The row positions (RLE) and unzipped
+// data (ZIP) are built at each load, and released afterwards.
+struct LoadChannels {
+  std::vector<TPSDChannelInfo> m_chans;
+
+  LoadChannels(int count) : m_chans(count) {}
+  ~LoadChannels() {
+    for (int ch = 0; ch < (int)m_chans.size(); ++ch) {
+      free(m_chans[ch].rowpos);
+      free(m_chans[ch].unzipdata);
+    }
+  }
+};
+
+}  // namespace
+
 static char swapByte(unsigned char src) {
   unsigned char out = 0;
   for (int i = 0; i < 8; ++i) {
@@ -62,12 +101,32 @@ TPSDReader::TPSDReader(const TFilePath &path)
   m_path = path.getParentDir() + TFilePath(name.toStdString());
   // m_path = path;
   QMutexLocker sl(&m_mutex);
+
+  TFileStatus status(m_path);
+  QDateTime modified = status.getLastModificationTime();
+  TINT64 size        = status.getSize();
+  {
+    QMutexLocker indexLocker(&layerIndicesMutex);
+    std::map<TFilePath, LayerIndex>::iterator it = layerIndices.find(m_path);
+    if (it != layerIndices.end() && it->second.m_modified == modified &&
+        it->second.m_size == size) {
+      m_headerInfo = it->second.m_headerInfo;
+      return;
+    }
+  }
+
   openFile();
   if (!doInfo()) {
     fclose(m_file);
     throw TImageException(m_path, "Do PSD INFO ERROR");
   }
   fclose(m_file);
+
+  QMutexLocker indexLocker(&layerIndicesMutex);
+  LayerIndex &index  = layerIndices[m_path];
+  index.m_modified   = modified;
+  index.m_size       = size;
+  index.m_headerInfo = m_headerInfo;
 }
 TPSDReader::~TPSDReader() {
   /*for(int i=0; i<m_headerInfo.layersCount;i++)
@@ -115,6 +174,7 @@ bool TPSDReader::doInfo() {
                   currentPos;  // 4 = bytes skipped by global layer mask info
     doExtraData(NULL, len);
   }
+  doLayersIndex();
   return true;
 }
 // Read Header Block
@@ -319,50 +379,55 @@ bool TPSDReader::readLayerInfo(int i) {
   return true;
 }
 
+// Locates the data of each layer and reads the compression type of its
+// channels, without decoding them: this is done by doImage() only for the
+// loaded layer.
+void TPSDReader::doLayersIndex() {
+  if (m_headerInfo.layersCount <= 0) return;
+
+  struct TPSDLayerInfo *lilast =
+      &m_headerInfo.linfo[m_headerInfo.layersCount - 1];
+  psdByte pos = lilast->additionalpos + lilast->additionallen;
+
+  for (int i = 0; i < m_headerInfo.layersCount; i++) {
+    TPSDLayerInfo *li = m_headerInfo.linfo + i;
+    li->startDataPos  = pos;
+    li->dataLength    = 0;
+    if (!li->chan) continue;  // skipped by readLayerInfo()
+
+    for (int ch = 0; ch < li->channels; ch++) {
+      TPSDChannelInfo *chan = li->chan + ch;
+      fseek(m_file, pos, SEEK_SET);
+      chan->comptype  = read2UBytes(m_file);
+      chan->filepos   = pos + 2;
+      chan->rowpos    = NULL;
+      chan->unzipdata = NULL;
+
+      li->dataLength += chan->length;
+      pos += chan->length;
+    }
+  }
+}
+
 void TPSDReader::doImage(TRasterP &rasP, int layerId) {
   m_layerId         = layerId;
   int layerIndex    = getLayerInfoIndexById(layerId);
   TPSDLayerInfo *li = getLayerInfo(layerIndex);
   psdByte imageDataEnd;
   // retrieve start data pos
-  psdByte startPos = ftell(m_file);
-  if (m_headerInfo.layersCount > 0) {
-    struct TPSDLayerInfo *lilast =
-        &m_headerInfo.linfo[m_headerInfo.layersCount - 1];
-    startPos = lilast->additionalpos + lilast->additionallen;
-  }
-  if (layerIndex > 0) {
-    for (int j = 0; j < layerIndex; j++) {
-      struct TPSDLayerInfo *liprev = &m_headerInfo.linfo[j];
-      for (int ch = 0; ch < liprev->channels; ch++) {
-        startPos += liprev->chan[ch].length;
-      }
-    }
-  }
-  fseek(m_file, startPos, SEEK_SET);
+  if (li)
+    fseek(m_file, li->startDataPos, SEEK_SET);
+  else
+    fseek(m_file, m_headerInfo.lmistart + m_headerInfo.lmilen, SEEK_SET);
 
   long pixw    = li ? li->right - li->left : m_headerInfo.cols;
   long pixh    = li ? li->bottom - li->top : m_headerInfo.rows;
   int channels = li ? li->channels : m_headerInfo.channels;
 
-  if (li == NULL)
-    fseek(m_file, m_headerInfo.lmistart + m_headerInfo.lmilen, SEEK_SET);
-
   psdPixel rows = pixh;
   psdPixel cols = pixw;
 
   int ch = 0;
-  psdByte **rowpos;
-
-  rowpos = (psdByte **)mymalloc(channels * sizeof(psdByte *));
-
-  for (ch = 0; ch < channels; ++ch) {
-    psdPixel chrows =
-        li && !m_headerInfo.linfoBlockEmpty && li->chan[ch].id == -2
-            ? li->mask.rows
-            : rows;
-    rowpos[ch] = (psdByte *)mymalloc((chrows + 1) * sizeof(psdByte));
-  }
 
   int tnzchannels = 0;
 
@@ -398,24 +463,28 @@ void TPSDReader::doImage(TRasterP &rasP, int layerId) {
   }
 
   if (!li || m_headerInfo.linfoBlockEmpty) {  // merged channel
-    TPSDChannelInfo *mergedChans =
-        (TPSDChannelInfo *)mymalloc(channels * sizeof(struct TPSDChannelInfo));
+    LoadChannels mergedChans(channels);
 
-    readChannel(m_file, NULL, mergedChans, channels, &m_headerInfo);
+    readChannel(m_file, NULL, mergedChans.m_chans.data(), channels,
+                &m_headerInfo);
     imageDataEnd = ftell(m_file);
-    readImageData(rasP, NULL, mergedChans, tnzchannels, rows, cols);
-    free(mergedChans);
+    readImageData(rasP, NULL, mergedChans.m_chans.data(), tnzchannels, rows,
+                  cols);
   } else {
+    // the layer index is shared with other readers: decode through a copy
+    LoadChannels layerChans(channels);
     for (ch = 0; ch < channels; ++ch) {
-      readChannel(m_file, li, li->chan + ch, 1, &m_headerInfo);
+      TPSDChannelInfo &chan = layerChans.m_chans[ch];
+      chan                  = li->chan[ch];
+      chan.rowpos           = NULL;
+      chan.unzipdata        = NULL;
+      readChannel(m_file, li, &chan, 1, &m_headerInfo);
     }
     imageDataEnd = ftell(m_file);
-    readImageData(rasP, li, li->chan, tnzchannels, rows, cols);
+    readImageData(rasP, li, layerChans.m_chans.data(), tnzchannels, rows,
+                  cols);
   }
   fseek(m_file, imageDataEnd, SEEK_SET);
-
-  for (ch = 0; ch < channels; ++ch) free(rowpos[ch]);
-  free(rowpos);
 }
 
 void TPSDReader::load(TRasterImageP &img, int layerId) {
@@ -522,18 +591,11 @@ void TPSDReader::readImageData(TRasterP &rasP, TPSDLayerInfo *li,
 
   psdByte savepos = ftell(m_file);
   if (rows == 0 || cols == 0) return;
-  psdPixel j;
-
-  unsigned char *inrows[4], *rledata;
 
   int ch, map[4];
 
-  rledata = (unsigned char *)mymalloc(chan->rowbytes * 2);
-
-  for (ch = 0; ch < chancount; ++ch) {
-    inrows[ch] = (unsigned char *)mymalloc(chan->rowbytes);
-    map[ch]    = li && chancount > 1 ? li->chindex[ch] : ch;
-  }
+  for (ch = 0; ch < chancount; ++ch)
+    map[ch] = li && chancount > 1 ? li->chindex[ch] : ch;
 
   // find the alpha channel, if needed
   if (li && (chancount == 2 || chancount == 4)) {  // grey+alpha
@@ -553,19 +615,13 @@ void TPSDReader::readImageData(TRasterP &rasP, TPSDLayerInfo *li,
   if (!m_region.isEmpty()) {
     x0 = m_region.getP00().x;
     // se x0 è fuori dalle dimensioni dell'immagine ritorna un'immagine vuota
-    if (x0 >= m_headerInfo.cols) {
-      free(rledata);
-      return;
-    }
+    if (x0 >= m_headerInfo.cols) return;
     x1 = x0 + m_region.getLx() - 1;
     // controllo che x1 rimanga all'interno dell'immagine
     if (x1 >= m_headerInfo.cols) x1 = m_headerInfo.cols - 1;
     y0 = m_region.getP00().y;
     // se y0 è fuori dalle dimensioni dell'immagine ritorna un'immagine vuota
-    if (y0 >= m_headerInfo.rows) {
-      free(rledata);
-      return;
-    }
+    if (y0 >= m_headerInfo.rows) return;
     y1 = y0 + m_region.getLy() - 1;
     // controllo che y1 rimanga all'interno dell'immagine
     if (y1 >= m_headerInfo.rows) y1 = m_headerInfo.rows - 1;
@@ -616,10 +672,7 @@ void TPSDReader::readImageData(TRasterP &rasP, TPSDLayerInfo *li,
   // Se è tutta fuori restutuisco TRasterImageP()
   layerSaveBox *= imageRect;
 
-  if (layerSaveBox == TRect() || layerSaveBox.isEmpty()) {
-    free(rledata);
-    return;
-  }
+  if (layerSaveBox == TRect() || layerSaveBox.isEmpty()) return;
   // Estraggo da rasP solo il rettangolo che si interseca con il livello
   // corrente
   // stando attento a prendere i pixel giusti.
@@ -654,171 +707,188 @@ void TPSDReader::readImageData(TRasterP &rasP, TPSDLayerInfo *li,
   // Nota che nel file photoshop le righe sono memorizzate dall'ultima alla
   // prima.
   int rowOffset = std::abs(sby1) % m_shrinkY;
-  int rowCount  = rowOffset;
-  // if(m_shrinkY==3) rowCount--;
-  for (j = 0; j < smallRas->getLy(); j++) {
-    for (ch = 0; ch < chancount; ++ch) {
-      /* get row data */
-      if (map[ch] < 0 || map[ch] > chancount) {
-        // warn("bad map[%d]=%d, skipping a channel", i, map[i]);
-        memset(inrows[ch], 0, chan->rowbytes);  // zero out the row
-      } else
-        readrow(m_file, chan + map[ch], rowCount, inrows[ch], rledata);
-    }
-    // se la riga corrente non rientra nell'immagine salto la copia
-    if (sby1 - rowCount < 0 || sby1 - rowCount > m_headerInfo.rows - 1) {
-      rowCount += m_shrinkY;
-      continue;
-    }
-    if (depth == 1 && chancount == 1) {
-      if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
-            layerSaveBox.getP00().x - sbx0 + smallRas->getLx() / 8 - 1 <
-                chan->rowbytes))
-        throw TImageException(
-            m_path, "Unable to read image with this depth and channels values");
-      smallRas->lock();
-      unsigned char *rawdata =
-          (unsigned char *)smallRas->getRawData(0, smallRas->getLy() - j - 1);
-      TPixelGR8 *pix = (TPixelGR8 *)rawdata;
-      int colCount   = colOffset;
-      for (int k = 0; k < smallRas->getLx(); k += 8) {
-        char value = ~inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
-        pix[k].setValue(value);
-        pix[k + 1].setValue(value);
-        pix[k + 2].setValue(value);
-        pix[k + 3].setValue(value);
-        pix[k + 4].setValue(value);
-        pix[k + 5].setValue(value);
-        pix[k + 6].setValue(value);
-        pix[k + 7].setValue(value);
-        colCount += m_shrinkX;
-      }
-      smallRas->unlock();
-    } else if (depth == 8 && chancount > 1) {
-      if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
-            layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
-                chan->rowbytes))
-        throw TImageException(
-            m_path, "Unable to read image with this depth and channels values");
-      smallRas->lock();
-      unsigned char *rawdata =
-          (unsigned char *)smallRas->getRawData(0, smallRas->getLy() - j - 1);
-      TPixel32 *pix = (TPixel32 *)rawdata;
-      int colCount  = colOffset;
-      for (int k = 0; k < smallRas->getLx(); k++) {
-        if (chancount >= 3) {
-          pix[k].r = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
-          pix[k].g = inrows[1][layerSaveBox.getP00().x - sbx0 + colCount];
-          pix[k].b = inrows[2][layerSaveBox.getP00().x - sbx0 + colCount];
-          if (chancount == 4)  // RGB + alpha
-            pix[k].m = inrows[3][layerSaveBox.getP00().x - sbx0 + colCount];
-          else
-            pix[k].m = 255;
-        } else if (chancount <= 2)  // gray + alpha
-        {
-          pix[k].r = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
-          pix[k].g = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
-          pix[k].b = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
-          if (chancount == 2)
-            pix[k].m = inrows[1][layerSaveBox.getP00().x - sbx0 + colCount];
-          else
-            pix[k].m = 255;
+
+  // Rows are independent: decode them in parallel, each chunk reading the
+  // file through its own handle.
+  smallRas->lock();
+  try {
+    TThread::parallelFor(smallRas->getLy(), [&](int begin, int end) {
+      std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(m_path, "rb"),
+                                                  fclose);
+      if (!file) throw TImageException(m_path, buildErrorString(2));
+
+      std::vector<unsigned char> rledata(chan->rowbytes * 2),
+          inrowsData(chancount * chan->rowbytes);
+      unsigned char *inrows[4];
+      for (int ch = 0; ch < chancount; ++ch)
+        inrows[ch] = inrowsData.data() + ch * chan->rowbytes;
+
+      for (int j = begin; j < end; j++) {
+        int rowCount = rowOffset + j * m_shrinkY;
+        for (int ch = 0; ch < chancount; ++ch) {
+          /* get row data */
+          if (map[ch] < 0 || map[ch] > chancount) {
+            // warn("bad map[%d]=%d, skipping a channel", i, map[i]);
+            memset(inrows[ch], 0, chan->rowbytes);  // zero out the row
+          } else
+            readrow(file.get(), chan + map[ch], rowCount, inrows[ch],
+                    rledata.data());
         }
-        colCount += m_shrinkX;
-      }
+        // se la riga corrente non rientra nell'immagine salto la copia
+        if (sby1 - rowCount < 0 || sby1 - rowCount > m_headerInfo.rows - 1) {
+          continue;
+        }
+        if (depth == 1 && chancount == 1) {
+          if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
+                layerSaveBox.getP00().x - sbx0 + smallRas->getLx() / 8 - 1 <
+                    chan->rowbytes))
+            throw TImageException(m_path,
+                                  "Unable to read image with this depth and "
+                                  "channels values");
+          unsigned char *rawdata = (unsigned char *)smallRas->getRawData(
+              0, smallRas->getLy() - j - 1);
+          TPixelGR8 *pix = (TPixelGR8 *)rawdata;
+          int colCount   = colOffset;
+          for (int k = 0; k < smallRas->getLx(); k += 8) {
+            char value = ~inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
+            pix[k].setValue(value);
+            pix[k + 1].setValue(value);
+            pix[k + 2].setValue(value);
+            pix[k + 3].setValue(value);
+            pix[k + 4].setValue(value);
+            pix[k + 5].setValue(value);
+            pix[k + 6].setValue(value);
+            pix[k + 7].setValue(value);
+            colCount += m_shrinkX;
+          }
+        } else if (depth == 8 && chancount > 1) {
+          if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
+                layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
+                    chan->rowbytes))
+            throw TImageException(m_path,
+                                  "Unable to read image with this depth and "
+                                  "channels values");
+          unsigned char *rawdata = (unsigned char *)smallRas->getRawData(
+              0, smallRas->getLy() - j - 1);
+          TPixel32 *pix = (TPixel32 *)rawdata;
+          int colCount  = colOffset;
+          for (int k = 0; k < smallRas->getLx(); k++) {
+            if (chancount >= 3) {
+              pix[k].r = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
+              pix[k].g = inrows[1][layerSaveBox.getP00().x - sbx0 + colCount];
+              pix[k].b = inrows[2][layerSaveBox.getP00().x - sbx0 + colCount];
+              if (chancount == 4)  // RGB + alpha
+                pix[k].m = inrows[3][layerSaveBox.getP00().x - sbx0 + colCount];
+              else
+                pix[k].m = 255;
+            } else if (chancount <= 2)  // gray + alpha
+            {
+              pix[k].r = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
+              pix[k].g = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
+              pix[k].b = inrows[0][layerSaveBox.getP00().x - sbx0 + colCount];
+              if (chancount == 2)
+                pix[k].m = inrows[1][layerSaveBox.getP00().x - sbx0 + colCount];
+              else
+                pix[k].m = 255;
+            }
+            colCount += m_shrinkX;
+          }
 
-      smallRas->unlock();
-    } else if (m_headerInfo.depth == 8 && chancount == 1) {
-      if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
-            layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
-                chan->rowbytes))
-        throw TImageException(
-            m_path, "Unable to read image with this depth and channels values");
-      smallRas->lock();
-      unsigned char *rawdata =
-          (unsigned char *)smallRas->getRawData(0, smallRas->getLy() - j - 1);
-
-      TPixelGR8 *pix = (TPixelGR8 *)rawdata;
-      int colCount   = colOffset;
-      for (int k = 0; k < smallRas->getLx(); k++) {
-        pix[k].setValue(inrows[0][layerSaveBox.getP00().x - sbx0 + colCount]);
-        colCount += m_shrinkX;
-      }
-      smallRas->unlock();
-    } else if (m_headerInfo.depth == 16 && chancount == 1 &&
-               m_headerInfo.mergedalpha)  // mergedChannels
-    {
-      if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
-            layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
-                chan->rowbytes))
-        throw TImageException(
-            m_path, "Unable to read image with this depth and channels values");
-      smallRas->lock();
-      unsigned char *rawdata =
-          (unsigned char *)smallRas->getRawData(0, smallRas->getLy() - j - 1);
-      TPixelGR8 *pix = (TPixelGR8 *)rawdata;
-      int colCount   = colOffset;
-      for (int k = 0; k < smallRas->getLx(); k++) {
-        pix[k].setValue(inrows[0][layerSaveBox.getP00().x - sbx0 + colCount]);
-        colCount += m_shrinkX;
-      }
-      smallRas->unlock();
-    } else if (m_headerInfo.depth == 16) {
-      if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
-            layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
-                chan->rowbytes))
-        throw TImageException(
-            m_path, "Unable to read image with this depth and channels values");
-      smallRas->lock();
-      unsigned short *rawdata =
-          (unsigned short *)smallRas->getRawData(0, smallRas->getLy() - j - 1);
-      TPixel64 *pix = (TPixel64 *)rawdata;
-      int colCount  = colOffset;
-      for (int k = 0; k < smallRas->getLx(); k++) {
-        if (chancount >= 3) {
-          pix[k].r = swapShort(
-              ((psdUint16 *)
-                   inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
-          pix[k].g = swapShort(
-              ((psdUint16 *)
-                   inrows[1])[layerSaveBox.getP00().x - sbx0 + colCount]);
-          pix[k].b = swapShort(
-              ((psdUint16 *)
-                   inrows[2])[layerSaveBox.getP00().x - sbx0 + colCount]);
-        } else if (chancount <= 2) {
-          pix[k].r = swapShort(
-              ((psdUint16 *)
-                   inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
-          pix[k].g = swapShort(
-              ((psdUint16 *)
-                   inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
-          pix[k].b = swapShort(
-              ((psdUint16 *)
-                   inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
-          if (chancount == 2)
-            pix[k].m = swapShort(
-                ((psdUint16 *)
-                     inrows[1])[layerSaveBox.getP00().x - sbx0 + colCount]);
+        } else if (m_headerInfo.depth == 8 && chancount == 1) {
+          if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
+                layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
+                    chan->rowbytes))
+            throw TImageException(m_path,
+                                  "Unable to read image with this depth and "
+                                  "channels values");
+          unsigned char *rawdata = (unsigned char *)smallRas->getRawData(
+              0, smallRas->getLy() - j - 1);
+
+          TPixelGR8 *pix = (TPixelGR8 *)rawdata;
+          int colCount   = colOffset;
+          for (int k = 0; k < smallRas->getLx(); k++) {
+            pix[k].setValue(
+                inrows[0][layerSaveBox.getP00().x - sbx0 + colCount]);
+            colCount += m_shrinkX;
+          }
+        } else if (m_headerInfo.depth == 16 && chancount == 1 &&
+                   m_headerInfo.mergedalpha)  // mergedChannels
+        {
+          if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
+                layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
+                    chan->rowbytes))
+            throw TImageException(m_path,
+                                  "Unable to read image with this depth and "
+                                  "channels values");
+          unsigned char *rawdata = (unsigned char *)smallRas->getRawData(
+              0, smallRas->getLy() - j - 1);
+          TPixelGR8 *pix = (TPixelGR8 *)rawdata;
+          int colCount   = colOffset;
+          for (int k = 0; k < smallRas->getLx(); k++) {
+            pix[k].setValue(
+                inrows[0][layerSaveBox.getP00().x - sbx0 + colCount]);
+            colCount += m_shrinkX;
+          }
+        } else if (m_headerInfo.depth == 16) {
+          if (!(layerSaveBox.getP00().x - sbx0 >= 0 &&
+                layerSaveBox.getP00().x - sbx0 + smallRas->getLx() - 1 <
+                    chan->rowbytes))
+            throw TImageException(m_path,
+                                  "Unable to read image with this depth and "
+                                  "channels values");
+          unsigned short *rawdata = (unsigned short *)smallRas->getRawData(
+              0, smallRas->getLy() - j - 1);
+          TPixel64 *pix = (TPixel64 *)rawdata;
+          int colCount  = colOffset;
+          for (int k = 0; k < smallRas->getLx(); k++) {
+            if (chancount >= 3) {
+              pix[k].r = swapShort(
+                  ((psdUint16 *)
+                       inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
+              pix[k].g = swapShort(
+                  ((psdUint16 *)
+                       inrows[1])[layerSaveBox.getP00().x - sbx0 + colCount]);
+              pix[k].b = swapShort(
+                  ((psdUint16 *)
+                       inrows[2])[layerSaveBox.getP00().x - sbx0 + colCount]);
+            } else if (chancount <= 2) {
+              pix[k].r = swapShort(
+                  ((psdUint16 *)
+                       inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
+              pix[k].g = swapShort(
+                  ((psdUint16 *)
+                       inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
+              pix[k].b = swapShort(
+                  ((psdUint16 *)
+                       inrows[0])[layerSaveBox.getP00().x - sbx0 + colCount]);
+              if (chancount == 2)
+                pix[k].m = swapShort(
+                    ((psdUint16 *)
+                         inrows[1])[layerSaveBox.getP00().x - sbx0 +
+                                    colCount]);
+            }
+            if (chancount == 4) {
+              pix[k].m = swapShort(
+                  ((psdUint16 *)
+                       inrows[3])[layerSaveBox.getP00().x - sbx0 + colCount]);
+            } else
+              pix[k].m = 0xffff;
+            colCount += m_shrinkX;
+          }
+        } else {
+          throw TImageException(m_path,
+                                "Unable to read image with this depth and "
+                                "channels values");
         }
-        if (chancount == 4) {
-          pix[k].m = swapShort(
-              ((psdUint16 *)
-                   inrows[3])[layerSaveBox.getP00().x - sbx0 + colCount]);
-        } else
-          pix[k].m = 0xffff;
-        colCount += m_shrinkX;
       }
-      smallRas->unlock();
-    } else {
-      throw TImageException(
-          m_path, "Unable to read image with this depth and channels values");
-    }
-    rowCount += m_shrinkY;
+    }, 64);
+  } catch (...) {
+    smallRas->unlock();
+    throw;
   }
-  fseek(m_file, savepos, SEEK_SET);  // restoring filepos
+  smallRas->unlock();
 
-  free(rledata);
-  for (ch = 0; ch < chancount; ++ch) free(inrows[ch]);
+  fseek(m_file, savepos, SEEK_SET);  // restoring filepos
 }
 
 void TPSDReader::doExtraData(TPSDLayerInfo *li, psdByte length) {
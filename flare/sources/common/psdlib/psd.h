@@ -98,6 +98,7 @@ struct TPSDLayerInfo {
 
   psdByte startDataPos;  // Posizione di inizio dati all'interno del file
   psdByte dataLength;    // lunghezza dati
+                         // (both set by doLayersIndex())
 
   // LAYER EFFECTS
   unsigned long int *fxCommonStateVersion;
@@ -185,6 +186,7 @@ private:
   bool doLayerAndMaskInfo();
   bool doLayersInfo();
   bool readLayerInfo(int index);
+  void doLayersIndex();
 
   // void doImage(unsigned char *rasP, TPSDLayerInfo *li);
   void doImage(TRasterP &rasP, int layerId);
@@ -15,6 +15,9 @@
 // STL includes
 #include <set>
 #include <deque>
+#include <atomic>
+#include <exception>
+#include <memory>
 
 // tcg includes
 #include "tcg/tcg_pool.h"
@@ -26,6 +29,8 @@
 #include <QWaitCondition>
 #include <QMetaType>
 #include <QCoreApplication>
+#include <QThreadPool>
+#include <QRunnable>
 
 //==============================================================================
 
@@ -1135,3 +1140,152 @@ inline void Worker::takeTask() {
     }
   }
 }
+
+//=====================================================================
+
+//============================
+//    parallelFor function
+//----------------------------
+
+namespace {
+
+//! Shared state of a parallelFor() call. Helpers that start after the caller
+//! closed it quit immediately, so that the caller never waits for queued
+//! helpers.
+struct ParallelForData {
+  const std::function<void(int, int)> &m_func;
+  int m_count, m_grain;
+  std::atomic<int> m_next;
+
+  QMutex m_mutex;
+  QWaitCondition m_helpersDone;
+  int m_running;  //!< Helpers processing chunks
+  bool m_closed;
+  std::exception_ptr m_exception;
+
+  ParallelForData(const std::function<void(int, int)> &func, int count,
+                  int grain)
+      : m_func(func)
+      , m_count(count)
+      , m_grain(grain)
+      , m_next(0)
+      , m_running(0)
+      , m_closed(false) {}
+
+  void work() {
+    for (;;) {
+      int begin = m_next.fetch_add(m_grain);
+      if (begin >= m_count) break;
+
+      try {
+        m_func(begin, std::min(begin + m_grain, m_count));
+      } catch (...) {
+        QMutexLocker locker(&m_mutex);
+        if (!m_exception) m_exception = std::current_exception();
+        m_next = m_count;  // Skip the remaining chunks
+      }
+    }
+  }
+};
+
+//---------------------------------------------------------------------
+
+QThreadPool *parallelForPool() {
+  static QThreadPool *pool = [] {
+    QThreadPool *pool = new QThreadPool;
+    pool->setMaxThreadCount(std::max(TSystem::getProcessorCount(), 1));
+    return pool;
+  }();
+  return pool;
+}
+
+std::atomic<int> parallelForHelpers(0);  //!< Helpers started, in all calls
+
+//---------------------------------------------------------------------
+
+//! Reserves up to \b wanted helpers, leaving one core to the caller and those
+//! busy with Executor tasks or other helpers.
+int acquireHelpers(int wanted) {
+  if (wanted <= 0) return 0;
+
+  int executorLoad = 0;
+  if (globalImp) {
+    QMutexLocker transitionLocker(&globalImp->m_transitionMutex);
+    executorLoad = globalImp->m_activeLoad;
+  }
+
+  int busyCores = std::max((executorLoad + 99) / 100, 1);
+  int limit     = TSystem::getProcessorCount() - busyCores;
+
+  int helpers = parallelForHelpers, count;
+  do {
+    count = std::min(wanted, limit - helpers);
+    if (count <= 0) return 0;
+  } while (
+      !parallelForHelpers.compare_exchange_weak(helpers, helpers + count));
+
+  return count;
+}
+
+//---------------------------------------------------------------------
+
+class ParallelForHelper final : public QRunnable {
+  std::shared_ptr<ParallelForData> m_data;
+
+public:
+  ParallelForHelper(const std::shared_ptr<ParallelForData> &data)
+      : m_data(data) {}
+
+  void run() override {
+    ParallelForData &d = *m_data;
+    {
+      QMutexLocker locker(&d.m_mutex);
+      if (!d.m_closed) ++d.m_running;
+      else {
+        --parallelForHelpers;
+        return;
+      }
+    }
+
+    d.work();
+
+    {
+      QMutexLocker locker(&d.m_mutex);
+      if (--d.m_running == 0) d.m_helpersDone.wakeAll();
+    }
+    --parallelForHelpers;
+  }
+};
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+void TThread::parallelFor(int count, const std::function<void(int, int)> &func,
+                          int grain) {
+  if (count <= 0) return;
+  grain = std::max(grain, 1);
+
+  int chunkCount = (count + grain - 1) / grain;
+  if (chunkCount == 1) {
+    func(0, count);
+    return;
+  }
+
+  std::shared_ptr<ParallelForData> data(
+      new ParallelForData(func, count, grain));
+
+  int helperCount = acquireHelpers(chunkCount - 1);
+  for (int h = 0; h < helperCount; ++h)
+    parallelForPool()->start(new ParallelForHelper(data));
+
+  data->work();
+
+  {
+    QMutexLocker locker(&data->m_mutex);
+    data->m_closed = true;
+    while (data->m_running > 0) data->m_helpersDone.wait(&data->m_mutex);
+  }
+
+  if (data->m_exception) std::rethrow_exception(data->m_exception);
+}
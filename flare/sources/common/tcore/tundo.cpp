@@ -112,17 +112,22 @@ struct TUndoManager::TUndoManagerImp {
   UndoListIterator m_current;
   bool m_skipped;
   int m_undoMemorySize;  // in bytes
+  TINT64 m_historySize;  // sum of the m_historySize of m_undoList, in bytes
 
   std::vector<TUndoBlock *> m_blockStack;
 
 public:
-  TUndoManagerImp() : m_skipped(false), m_undoMemorySize(0) {
+  TUndoManagerImp()
+      : m_skipped(false), m_undoMemorySize(0), m_historySize(0) {
     m_current = m_undoList.end();
   }
   ~TUndoManagerImp() {}
 
   void add(TUndo *undo);
 
+  //! Deletes the undos in [begin, end), updating the history size.
+  void erase(UndoListIterator begin, UndoListIterator end);
+
 public:
   static struct ManagerPtr {
     TUndoManager *m_ptr;
@@ -179,38 +184,45 @@ void TUndoManager::TUndoManagerImp::add(TUndo *undo) {
 
 //-----------------------------------------------------------------------------
 
-void TUndoManager::TUndoManagerImp::doAdd(TUndo *undo) {
-  if (m_current != m_undoList.end()) {
-    std::for_each(m_current, m_undoList.end(), deleteUndo);
-    m_undoList.erase(m_current, m_undoList.end());
+void TUndoManager::TUndoManagerImp::erase(UndoListIterator begin,
+                                          UndoListIterator end) {
+  for (UndoListIterator it = begin; it != end; ++it) {
+    m_historySize -= (*it)->m_historySize;
+    delete *it;
   }
+  m_undoList.erase(begin, end);
+  assert(m_historySize >= 0);
+}
 
-  int i, memorySize = 0, count = m_undoList.size();
-  for (i = 0; i < count; i++) memorySize += m_undoList[i]->getSize();
+//-----------------------------------------------------------------------------
+
+void TUndoManager::TUndoManagerImp::doAdd(TUndo *undo) {
+  if (m_current != m_undoList.end()) erase(m_current, m_undoList.end());
 
-  while (count > 100 || (count != 0 && memorySize + undo->getSize() >
-                                           m_undoMemorySize))  // 20MB
+  // The size is evaluated once: the history's total is kept incrementally
+  undo->m_historySize = undo->getSize();
+
+  int count = m_undoList.size();
+  while (count > 100 ||
+         (count != 0 &&
+          m_historySize + undo->m_historySize > m_undoMemorySize))  // 20MB
   {
     --count;
-    TUndo *undo = m_undoList.front();
-    m_undoList.pop_front();
-    memorySize -= undo->getSize();
-    delete undo;
+    erase(m_undoList.begin(), m_undoList.begin() + 1);
   }
 
   undo->m_isLastInBlock     = true;
   undo->m_isLastInRedoBlock = true;
   m_undoList.push_back(undo);
+  m_historySize += undo->m_historySize;
   m_current = m_undoList.end();
 }
 
 //-----------------------------------------------------------------------------
 
 void TUndoManager::beginBlock() {
-  if (m_imp->m_current != m_imp->m_undoList.end()) {
-    std::for_each(m_imp->m_current, m_imp->m_undoList.end(), deleteUndo);
-    m_imp->m_undoList.erase(m_imp->m_current, m_imp->m_undoList.end());
-  }
+  if (m_imp->m_current != m_imp->m_undoList.end())
+    m_imp->erase(m_imp->m_current, m_imp->m_undoList.end());
 
   TUndoBlock *undoBlock = new TUndoBlock;
   m_imp->m_blockStack.push_back(undoBlock);
@@ -306,6 +318,14 @@ void TUndoManager::add(TUndo *undo) {
   Q_EMIT historyChanged();
 
   undo->onAdd();
+
+  // onAdd() may have changed the size (eg raster undos compress their data)
+  if (m_imp->m_blockStack.empty() && !m_imp->m_undoList.empty() &&
+      m_imp->m_undoList.back() == undo) {
+    int size = undo->getSize();
+    m_imp->m_historySize += size - undo->m_historySize;
+    undo->m_historySize = size;
+  }
   Q_EMIT somethingChanged();
 }
 
@@ -314,9 +334,7 @@ void TUndoManager::add(TUndo *undo) {
 void TUndoManager::reset() {
   assert(m_imp->m_blockStack.empty());
   m_imp->m_blockStack.clear();
-  UndoList &lst = m_imp->m_undoList;
-  std::for_each(lst.begin(), lst.end(), deleteUndo);
-  lst.clear();
+  m_imp->erase(m_imp->m_undoList.begin(), m_imp->m_undoList.end());
   m_imp->m_current = m_imp->m_undoList.end();
   Q_EMIT historyChanged();
 }
@@ -337,8 +355,7 @@ void TUndoManager::popUndo(int n, bool forward) {
         for (i = 0; i < n && m_imp->m_current != m_imp->m_undoList.begin();
              i++) {
           m_imp->m_current--;
-          delete (*m_imp->m_current);
-          m_imp->m_undoList.erase(m_imp->m_current);
+          m_imp->erase(m_imp->m_current, m_imp->m_current + 1);
           m_imp->m_current = m_imp->m_undoList.end();
         }
       } else {
@@ -350,13 +367,8 @@ void TUndoManager::popUndo(int n, bool forward) {
         for (i = 0; i < n && m_imp->m_current != m_imp->m_undoList.begin(); i++)
           m_imp->m_current--;
 
-        start                 = m_imp->m_current;
-        UndoListIterator _end = end;
-        while (_end != start) {
-          _end--;
-          delete (*_end);
-        }
-        m_imp->m_undoList.erase(start, end);
+        start = m_imp->m_current;
+        m_imp->erase(start, end);
 
         m_imp->m_current = m_imp->m_undoList.begin();
         while (*m_imp->m_current != undo) m_imp->m_current++;
@@ -380,8 +392,7 @@ void TUndoManager::popUndo(int n, bool forward) {
         i++;
       }
     }
-    std::for_each(start, end, deleteUndo);
-    m_imp->m_undoList.erase(start, end);
+    m_imp->erase(start, end);
     m_imp->m_current = m_imp->m_undoList.end();
   } else
     m_imp->m_blockStack.back()->popUndo(n);
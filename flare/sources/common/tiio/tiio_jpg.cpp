@@ -24,6 +24,8 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <algorithm>
+
 //=========================================================
 
 const std::string Tiio::JpgWriterProperties::QUALITY("Quality");
@@ -51,7 +53,8 @@ JMETHOD(void, reset_error_mgr, (j_common_ptr cinfo));
 
 using namespace Tiio;
 
-JpgReader::JpgReader() : m_chan(0), m_isOpen(false) {
+JpgReader::JpgReader()
+    : m_chan(0), m_isOpen(false), m_started(false), m_scale(1), m_row(0) {
   memset(&m_cinfo, 0, sizeof m_cinfo);
   memset(&m_jerr, 0, sizeof m_jerr);
   memset(&m_buffer, 0, sizeof m_buffer);
@@ -60,7 +63,7 @@ JpgReader::JpgReader() : m_chan(0), m_isOpen(false) {
 JpgReader::~JpgReader() {
   if (m_isOpen) {
     try {
-      jpeg_finish_decompress(&m_cinfo);
+      if (m_started) jpeg_finish_decompress(&m_cinfo);
       jpeg_destroy_decompress(&m_cinfo);
     } catch (...) {
     }
@@ -106,15 +109,12 @@ void JpgReader::open(FILE *file) {
     }
   }
 
-  ret = ret && jpeg_start_decompress(&m_cinfo);
   if (!ret) return;
 
-  int row_stride = m_cinfo.output_width * m_cinfo.output_components;
-  m_buffer = (*m_cinfo.mem->alloc_sarray)((j_common_ptr)&m_cinfo, JPOOL_IMAGE,
-                                          row_stride, 1);
-
-  m_info.m_lx             = m_cinfo.output_width;
-  m_info.m_ly             = m_cinfo.output_height;
+  // The image is always described at full size - decompression is deferred
+  // until the requested shrink is known
+  m_info.m_lx             = m_cinfo.image_width;
+  m_info.m_ly             = m_cinfo.image_height;
   m_info.m_samplePerPixel = 3;
   m_info.m_valid          = true;
   m_isOpen                = true;
@@ -131,54 +131,79 @@ void JpgReader::open(FILE *file) {
   }
 }
 
-void JpgReader::readLine(char *buffer, int x0, int x1, int shrink) {
-  if (m_cinfo.out_color_space == JCS_RGB && m_cinfo.out_color_components == 3) {
+//! Starts decompression, at the smallest DCT scale (1/2, 1/4 or 1/8) not
+//! below 1 / \b shrink. Sampled pixels are then taken from the scaled image,
+//! whose pixels the IDCT computes as block averages at a fraction of the cost.
+void JpgReader::startDecompress(int shrink) {
+  m_scale = 1;
+  while (m_scale < 8 && 2 * m_scale <= shrink) m_scale *= 2;
+
+  m_cinfo.scale_num   = 1;
+  m_cinfo.scale_denom = m_scale;
+  jpeg_start_decompress(&m_cinfo);
+  m_started = true;
+
+  int row_stride = m_cinfo.output_width * m_cinfo.output_components;
+  m_buffer = (*m_cinfo.mem->alloc_sarray)((j_common_ptr)&m_cinfo, JPOOL_IMAGE,
+                                          row_stride, 1);
+}
+
+//! Returns the decoded scanline containing the current full-resolution line.
+unsigned char *JpgReader::scanline() {
+  JDIMENSION row =
+      std::min<JDIMENSION>(m_row / m_scale, m_cinfo.output_height - 1);
+  while (m_cinfo.output_scanline <= row) {
     int ret = jpeg_read_scanlines(&m_cinfo, m_buffer, 1);
     assert(ret == 1);
-    unsigned char *src = m_buffer[0];
-    TPixel32 *dst      = (TPixel32 *)buffer;
+    if (ret != 1) break;
+  }
+  ++m_row;
+
+  return m_buffer[0];
+}
+
+void JpgReader::readLine(char *buffer, int x0, int x1, int shrink) {
+  if (!m_started) startDecompress(shrink);
+
+  if (m_cinfo.out_color_space == JCS_RGB && m_cinfo.out_color_components == 3) {
+    unsigned char *line = scanline();
+    TPixel32 *dst       = (TPixel32 *)buffer;
     dst += x0;
-    src += 3 * x0;
 
-    int width           = (m_cinfo.output_width - 1) / shrink + 1;
+    int width           = (m_info.m_lx - 1) / shrink + 1;
     if (x1 >= x0) width = (x1 - x0) / shrink + 1;
 
-    while (--width >= 0) {
-      dst->r = src[0];
-      dst->g = src[1];
-      dst->b = src[2];
-      dst->m = (char)255;
-      src += 3 * shrink;
+    for (int x = x0; --width >= 0; x += shrink) {
+      unsigned char *src = line + 3 * (x / m_scale);
+      dst->r             = src[0];
+      dst->g             = src[1];
+      dst->b             = src[2];
+      dst->m             = (char)255;
       dst += shrink;
     }
   } else if (m_cinfo.out_color_components == 1) {
-    int ret = jpeg_read_scanlines(&m_cinfo, m_buffer, 1);
-    assert(ret == 1);
-    unsigned char *src = m_buffer[0];
-    TPixel32 *dst      = (TPixel32 *)buffer;
+    unsigned char *line = scanline();
+    TPixel32 *dst       = (TPixel32 *)buffer;
 
     dst += x0;
-    src += x0;
 
-    int width           = (m_cinfo.output_width - 1) / shrink + 1;
+    int width           = (m_info.m_lx - 1) / shrink + 1;
     if (x1 >= x0) width = (x1 - x0) / shrink + 1;
 
-    while (--width >= 0) {
-      dst->r = *src;
-      dst->g = *src;
-      dst->b = *src;
-      dst->m = (char)255;
-      src += shrink;
+    for (int x = x0; --width >= 0; x += shrink) {
+      unsigned char src = line[x / m_scale];
+      dst->r            = src;
+      dst->g            = src;
+      dst->b            = src;
+      dst->m            = (char)255;
       dst += shrink;
     }
   }
 }
 
 int JpgReader::skipLines(int lineCount) {
-  for (int i = 0; i < lineCount; i++) {
-    int ret = jpeg_read_scanlines(&m_cinfo, m_buffer, 1);
-    assert(ret == 1);
-  }
+  // Skipped lines are decoded only when they share a scanline with a read one
+  m_row += lineCount;
   return lineCount;
 }
 
@@ -100,25 +100,17 @@ const TImageInfo *TLevelReader::getImageInfo() {
 //-----------------------------------------------------------
 
 TLevelP TLevelReader::loadInfo() {
-  TFilePath parentDir = m_path.getParentDir();
-  TFilePath levelName(m_path.getLevelName());
-  //  cout << "Parent dir = '" << parentDir << "'" << endl;
-  //  cout << "Level name = '" << levelName << "'" << endl;
   TFilePathSet files;
   try {
-    files = TSystem::readDirectory(parentDir, false, true, true);
+    TSystem::readDirectory_LevelFrames(files, m_path);
   } catch (...) {
     throw TImageException(m_path, "unable to read directory content");
   }
   TLevelP level;
   vector<TFilePath> data;
   for (TFilePathSet::iterator it = files.begin(); it != files.end(); it++) {
-    TFilePath ln(it->getLevelName());
-    // cout << "try " << *it << "  " << it->getLevelName() <<  endl;
-    if (levelName == TFilePath(it->getLevelName())) {
-      level->setFrame(it->getFrame(), TImageP());
-      data.push_back(*it);
-    }
+    level->setFrame(it->getFrame(), TImageP());
+    data.push_back(*it);
   }
   if (!data.empty()) {
     std::vector<TFilePath>::iterator it =
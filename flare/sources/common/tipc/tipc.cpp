@@ -12,6 +12,11 @@
 #include <QEventLoop>
 #include <QTimer>
 
+// STD includes
+#include <list>
+#include <memory>
+#include <vector>
+
 // System-specific includes
 #if defined(_WIN32)
 #include <windows.h>
@@ -75,6 +80,117 @@ int shm_max = -1;
 int shm_all = -1;
 int shm_seg = -1;
 int shm_mni = -1;
+
+//! Maximum number of segments kept by the sending pool
+const int c_shMemPoolSize = 4;
+
+//-------------------------------------------------------------
+
+/*!
+  The segments this process sends shared memory buffers through, reused
+  across transfers.
+
+  Segments are cycled, so that the receiving side does not have to attach
+  and fault a new segment for each buffer. A segment is busy from acquire()
+  to release().
+*/
+class ShMemPool {
+  struct Segment {
+    QSharedMemory* m_shmem;
+    bool m_busy;
+  };
+
+  QMutex m_mutex;
+  std::vector<Segment> m_segments;
+
+public:
+  ~ShMemPool() {
+    for (const Segment& segment : m_segments) delete segment.m_shmem;
+  }
+
+  static ShMemPool* instance() {
+    static ShMemPool theInstance;
+    return &theInstance;
+  }
+
+  //! Returns a segment of at least \b size bytes, or 0 if all the segments
+  //! are in use.
+  QSharedMemory* acquire(int size) {
+    QMutexLocker locker(&m_mutex);
+
+    std::vector<Segment>::iterator spare = m_segments.end();
+    for (auto st = m_segments.begin(); st != m_segments.end(); ++st) {
+      if (st->m_busy) continue;
+
+      if (st->m_shmem->size() >= size) {
+        st->m_busy = true;
+        return st->m_shmem;
+      }
+      spare = st;
+    }
+
+    // Replace a free segment which is too small
+    if (spare != m_segments.end()) {
+      delete spare->m_shmem;
+      m_segments.erase(spare);
+    }
+
+    if (int(m_segments.size()) >= c_shMemPoolSize) return 0;
+
+    QSharedMemory* shmem = new QSharedMemory(tipc::uniqueId());
+    if (tipc::create(*shmem, size, true) <= 0) {
+      delete shmem;
+      return 0;
+    }
+
+    Segment segment = {shmem, true};
+    m_segments.push_back(segment);
+    return shmem;
+  }
+
+  void release(QSharedMemory* shmem) {
+    QMutexLocker locker(&m_mutex);
+
+    for (Segment& segment : m_segments)
+      if (segment.m_shmem == shmem) segment.m_busy = false;
+  }
+};
+
+//-------------------------------------------------------------
+
+/*!
+  The segments this process has read buffers from, kept attached since
+  senders reuse them. Only the most recently used ones are retained.
+*/
+class ShMemAttachments {
+  QMutex m_mutex;
+  std::list<std::shared_ptr<QSharedMemory>> m_segments;
+
+public:
+  static ShMemAttachments* instance() {
+    static ShMemAttachments theInstance;
+    return &theInstance;
+  }
+
+  std::shared_ptr<QSharedMemory> attach(const QString& key) {
+    QMutexLocker locker(&m_mutex);
+
+    for (auto st = m_segments.begin(); st != m_segments.end(); ++st)
+      if ((*st)->key() == key) {
+        m_segments.splice(m_segments.begin(), m_segments, st);
+        return m_segments.front();
+      }
+
+    std::shared_ptr<QSharedMemory> shmem(new QSharedMemory(key));
+    if (!shmem->attach()) return std::shared_ptr<QSharedMemory>();
+
+    m_segments.push_front(shmem);
+    if (int(m_segments.size()) > 2 * c_shMemPoolSize) m_segments.pop_back();
+
+    return shmem;
+  }
+};
+
 }  // namespace
 
 //********************************************************
@@ -683,32 +799,49 @@ bool tipc::writeShMemBuffer(Stream& stream, Message& msg, int bufSize,
   sem.acquire(1);
 
   {
-    // Create a shared memory segment, possibly of passed size
-    QSharedMemory shmem(tipc::uniqueId());
-    bool ok = (tipc::create(shmem, bufSize) > 0);
-    if (!ok) goto err;
+    // Take a segment from the pool, or create one for this transfer only
+    int segSize = std::min(bufSize, tipc::shm_maxSegmentSize());
+
+    std::unique_ptr<QSharedMemory> transient;
+    QSharedMemory* shmem = ShMemPool::instance()->acquire(segSize);
+    if (!shmem) {
+      transient.reset(new QSharedMemory(tipc::uniqueId()));
+      if (tipc::create(*transient, segSize) <= 0) goto err;
+
+      shmem = transient.get();
+    }
 
     // Communicate the shared memory id and bufSize to the reader
-    msg << QString("shm") << shmem.key() << bufSize;
+    msg << QString("shm") << shmem->key() << bufSize;
 
     // Fill in data until all the buffer has been sent
+    int chunkSize = shmem->size();
     int chunkData, remainingData = bufSize;
+    bool ok = true;
     while (remainingData > 0) {
       // Write to the shared memory segment
       tipc_debug(QTime xchTime; xchTime.start());
-      shmem.lock();
+      shmem->lock();
       remainingData -= chunkData =
-          dataWriter->write(reinterpret_cast<char*>(shmem.data()),
-                            std::min(shmem.size(), remainingData));
-      shmem.unlock();
+          dataWriter->write(reinterpret_cast<char*>(shmem->data()),
+                            std::min(chunkSize, remainingData));
+      shmem->unlock();
       tipc_debug(qDebug() << "exchange time:" << xchTime.elapsed());
 
       stream << (msg << QString("chk") << chunkData);
 
-      if (tipc::readMessage(stream, msg) != "ok") goto err;
+      if (tipc::readMessage(stream, msg) != "ok") {
+        ok = false;
+        break;
+      }
 
       msg.clear();
     }
+
+    // The reader is done with the segment
+    if (!transient) ShMemPool::instance()->release(shmem);
+
+    if (!ok) goto err;
   }
 
   sem.release(1);
@@ -747,10 +880,11 @@ bool tipc::readShMemBuffer(Stream& stream, Message& msg,
   int bufSize;
   msg >> id >> bufSize >> chkStr;
 
-  // Data is ready to be read - attach to the shared memory segment.
-  QSharedMemory shmem(id);
-  shmem.attach();
-  if (!shmem.isAttached()) {
+  // Data is ready to be read - attach to the shared memory segment. Senders
+  // reuse their segments, so the attachment is kept.
+  std::shared_ptr<QSharedMemory> shmem(
+      ShMemAttachments::instance()->attach(id));
+  if (!shmem) {
     tipc_debug(qDebug("tipc::readShMemBuffer exit (shmem not attached)"));
     return false;
   }
@@ -761,10 +895,10 @@ bool tipc::readShMemBuffer(Stream& stream, Message& msg,
     msg >> chunkData;
 
     tipc_debug(QTime xchTime; xchTime.start());
-    shmem.lock();
+    shmem->lock();
     remainingData -= dataReader->read(
-        reinterpret_cast<const char*>(shmem.data()), chunkData);
-    shmem.unlock();
+        reinterpret_cast<const char*>(shmem->data()), chunkData);
+    shmem->unlock();
     tipc_debug(qDebug() << "exchange time:" << xchTime.elapsed());
 
     // Data was read. Inform the writer
@@ -781,7 +915,6 @@ bool tipc::readShMemBuffer(Stream& stream, Message& msg,
     }
   }
 
-  shmem.detach();
   tipc_debug(qDebug("tipc::readShMemBuffer exit"));
   tipc_debug(qDebug() << "tipc::readShMemBuffer time:" << time.elapsed());
   return true;
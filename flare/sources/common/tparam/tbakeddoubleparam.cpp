@@ -0,0 +1,60 @@
+
+
+#include "tbakeddoubleparam.h"
+
+// TnzCore includes
+#include "tutil.h"
+
+// STD includes
+#include <algorithm>
+
+//*****************************************************************************
+//    TBakedDoubleParam  implementation
+//*****************************************************************************
+
+TBakedDoubleParam::TBakedDoubleParam(const TDoubleParamP &param, int frame0,
+                                     int frameCount)
+    : m_param(param), m_frame0(frame0), m_frameCount(std::max(frameCount, 0)) {
+  assert(m_param);
+}
+
+//-----------------------------------------------------------------------------
+
+double TBakedDoubleParam::getValue(double frame) {
+  int index = tfloor(frame) - m_frame0;
+  if (index < 0 || index >= m_frameCount || frame != tfloor(frame))
+    return m_param->getValue(frame);
+
+  std::shared_ptr<const Samples> samples = std::atomic_load(&m_samples);
+  if (!samples || samples->m_changeCount != m_param->getChangeCount())
+    samples = bake();
+
+  if (samples->m_values.empty()) return m_param->getValue(frame);
+  return samples->m_values[index];
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const TBakedDoubleParam::Samples> TBakedDoubleParam::bake() {
+  QMutexLocker locker(&m_mutex);
+
+  // Read before evaluating: a change made meanwhile gets the table built
+  // again by the next query
+  unsigned int changeCount = m_param->getChangeCount();
+
+  // another thread may have baked in the meantime
+  std::shared_ptr<const Samples> samples = std::atomic_load(&m_samples);
+  if (samples && samples->m_changeCount == changeCount) return samples;
+
+  std::shared_ptr<Samples> newSamples(new Samples);
+  newSamples->m_changeCount = changeCount;
+  if (!m_param->hasReferences()) {
+    newSamples->m_values.resize(m_frameCount);
+    m_param->evaluateRange(m_frame0, m_frame0 + m_frameCount - 1,
+                           newSamples->m_values.data());
+  }
+
+  samples = newSamples;
+  std::atomic_store(&m_samples, samples);
+  return samples;
+}
@@ -16,6 +16,7 @@
 #include "tunit.h"
 
 // STD includes
+#include <atomic>
 #include <set>
 
 #include "tdoubleparam.h"
@@ -30,8 +31,9 @@ public:
   mutable TDoubleParamFileData m_fileData;
 
   TActualDoubleKeyframe(double frame = 0, double value = 0)
-      : TDoubleKeyframe(frame, value), m_unit(0) {}
-  explicit TActualDoubleKeyframe(const TDoubleKeyframe &src) : m_unit(0) {
+      : TDoubleKeyframe(frame, value), m_unit(0), m_unitMeasure(0) {}
+  explicit TActualDoubleKeyframe(const TDoubleKeyframe &src)
+      : m_unit(0), m_unitMeasure(0) {
     TDoubleKeyframe::operator=(src);
     if (m_type == Expression || m_type == SimilarShape)
       m_expression.setText(m_expressionText);
@@ -50,6 +52,7 @@ public:
   }
 
   const TUnit *updateUnit(const TMeasure *measure) {
+    m_unitMeasure = measure;
     if (!measure) {
       m_unit     = 0;
       m_unitName = "";
@@ -68,11 +71,19 @@ public:
     }
     assert(measure || m_unit == 0 && m_unitName == "");
     assert((m_unit == 0) == (m_unitName == ""));
-    QString app = QString::fromStdString(m_unitName);
-    assert(m_unit == 0 || m_unit->isExtension(app.toStdWString()));
+    assert(m_unit == 0 ||
+           m_unit->isExtension(QString::fromStdString(m_unitName)
+                                   .toStdWString()));
     return m_unit;
   }
 
+  //! Returns the unit, as found by the last updateUnit() with the same
+  //! measure: unlike updateUnit(), it does not allocate.
+  const TUnit *getUnit(const TMeasure *measure) const {
+    if (m_unit && measure == m_unitMeasure) return m_unit;
+    return const_cast<TActualDoubleKeyframe *>(this)->updateUnit(measure);
+  }
+
   double convertFrom(TMeasure *measure, double value) const {
     if (!m_unit) const_cast<TActualDoubleKeyframe *>(this)->updateUnit(measure);
     if (m_unit) value = m_unit->convertFrom(value);
@@ -81,21 +92,38 @@ public:
 
 private:
   mutable const TUnit *m_unit;
+  mutable const TMeasure *m_unitMeasure;
 };
 
 typedef vector<TActualDoubleKeyframe> DoubleKeyframeVector;
 
 //===================================================================
 
-inline double getConstantValue(const TActualDoubleKeyframe &k0,
-                               const TActualDoubleKeyframe &k1, double f) {
+//! The keyframe data used by the interpolation of a segment. Unlike
+//! keyframes, points are copied without allocations - so that getValue() can
+//! replace the endpoint values and frames cheaply.
+struct KeyframePoint {
+  double m_frame, m_value;
+  TPointD m_speedIn, m_speedOut;
+
+  KeyframePoint(const TDoubleKeyframe &k)
+      : m_frame(k.m_frame)
+      , m_value(k.m_value)
+      , m_speedIn(k.m_speedIn)
+      , m_speedOut(k.m_speedOut) {}
+};
+
+//===================================================================
+
+inline double getConstantValue(const KeyframePoint &k0, const KeyframePoint &k1,
+                               double f) {
   return (f == k1.m_frame) ? k1.m_value : k0.m_value;
 }
 
 //---------------------------------------------------------
 
-inline double getLinearValue(const TActualDoubleKeyframe &k0,
-                             const TActualDoubleKeyframe &k1, double f) {
+inline double getLinearValue(const KeyframePoint &k0, const KeyframePoint &k1,
+                             double f) {
   return k0.m_value + (f - k0.m_frame) * (k1.m_value - k0.m_value) /
                           (k1.m_frame - k0.m_frame);
 }
@@ -123,10 +151,9 @@ static void truncateSpeeds(double aFrame, double bFrame, TPointD &aSpeedTrunc,
 
 //---------------------------------------------------------
 
-inline double getSpeedInOutValue(const TActualDoubleKeyframe &k0,
-                                 const TActualDoubleKeyframe &k1,
-                                 const TPointD &speed0, const TPointD &speed1,
-                                 double frame) {
+inline double getSpeedInOutValue(const KeyframePoint &k0,
+                                 const KeyframePoint &k1, const TPointD &speed0,
+                                 const TPointD &speed1, double frame) {
   double aFrame = k0.m_frame;
   double bFrame = k1.m_frame;
 
@@ -190,8 +217,8 @@ DV_EXPORT_API void splitSpeedInOutSegment(TDoubleKeyframe &k,
 
 //---------------------------------------------------------
 
-inline double getEaseInOutValue(const TActualDoubleKeyframe &k0,
-                                const TActualDoubleKeyframe &k1, double frame,
+inline double getEaseInOutValue(const KeyframePoint &k0,
+                                const KeyframePoint &k1, double frame,
                                 bool percentage) {
   double x3 = k1.m_frame - k0.m_frame;
   if (x3 <= 0.0) return k0.m_value;
@@ -232,9 +259,8 @@ inline double getEaseInOutValue(const TActualDoubleKeyframe &k0,
 
 //---------------------------------------------------------
 
-inline double getExponentialValue(const TActualDoubleKeyframe &k0,
-                                  const TActualDoubleKeyframe &k1,
-                                  double frame) {
+inline double getExponentialValue(const KeyframePoint &k0,
+                                  const KeyframePoint &k1, double frame) {
   double aFrame = k0.m_frame;
   double bFrame = k1.m_frame;
   double deltaX = bFrame - aFrame;
@@ -258,14 +284,13 @@ inline double getExponentialValue(const TActualDoubleKeyframe &k0,
 //---------------------------------------------------------
 
 inline double getExpressionValue(const TActualDoubleKeyframe &k0,
-                                 const TActualDoubleKeyframe &k1, double frame,
+                                 const KeyframePoint &k1, double frame,
                                  const TMeasure *measure) {
   double t = 0, rframe = frame - k0.m_frame;
   if (k1.m_frame > k0.m_frame) t = rframe / (k1.m_frame - k0.m_frame);
   TSyntax::Calculator *calculator = k0.m_expression.getCalculator();
   if (calculator) {
-    calculator->setUnit(
-        (const_cast<TActualDoubleKeyframe &>(k0)).updateUnit(measure));
+    calculator->setUnit(k0.getUnit(measure));
     return calculator->compute(t, frame + 1, rframe + 1);
   } else if (measure)
     return measure->getDefaultValue();
@@ -276,8 +301,8 @@ inline double getExpressionValue(const TActualDoubleKeyframe &k0,
 //---------------------------------------------------------
 
 inline double getSimilarShapeValue(const TActualDoubleKeyframe &k0,
-                                   const TActualDoubleKeyframe &k1,
-                                   double frame, const TMeasure *measure) {
+                                   const KeyframePoint &k1, double frame,
+                                   const TMeasure *measure) {
   double offset = k0.m_similarShapeOffset;
   double rv0    = getExpressionValue(k0, k1, k0.m_frame + offset, measure);
   double rv1    = getExpressionValue(k0, k1, k1.m_frame + offset, measure);
@@ -304,6 +329,7 @@ public:
   bool m_cycleEnabled;
 
   std::set<TParamObserver *> m_observers;
+  std::atomic<unsigned int> m_changeCount;  //!< See getChangeCount()
 
   Imp(double v = 0.0)
       : m_grammar(0)
@@ -312,7 +338,8 @@ public:
       , m_defaultValue(v)
       , m_minValue(-(std::numeric_limits<double>::max)())
       , m_maxValue((std::numeric_limits<double>::max)())
-      , m_cycleEnabled(false) {}
+      , m_cycleEnabled(false)
+      , m_changeCount(0) {}
 
   ~Imp() {}
 
@@ -325,9 +352,11 @@ public:
     m_maxValue     = src->m_maxValue;
     m_keyframes    = src->m_keyframes;
     m_cycleEnabled = src->m_cycleEnabled;
+    ++m_changeCount;
   }
 
   void notify(const TParamChange &change) {
+    ++m_changeCount;
     std::set<TParamObserver *>::iterator it = m_observers.begin();
     for (; it != m_observers.end(); ++it) (*it)->onChange(change);
   }
@@ -545,16 +574,15 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
       frame = f1;
     double valueOffset = 0;
 
-    if (m_imp->m_cycleEnabled) {
+    if (m_imp->m_cycleEnabled && frame >= f1) {
       double dist   = (f1 - f0);
       double dvalue = keyframes.back().m_value - keyframes.begin()->m_value;
-      while (frame >= f1) {
-        if (frame != f1 || !leftmost) {
-          frame -= dist;
-          valueOffset += dvalue;
-        } else
-          break;
-      }
+
+      // bring frame back to [f0,f1), or to f1 when leftmost
+      double cycles = std::floor((frame - f0) / dist);
+      if (leftmost && frame == f0 + cycles * dist) cycles -= 1;
+      frame       = tcrop(frame - cycles * dist, f0, f1);
+      valueOffset = cycles * dvalue;
     }
 
     // frame is in [f0,f1]
@@ -586,37 +614,29 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
 
     int kIndex = std::distance(keyframes.begin(), a);
 
-    vector<TActualDoubleKeyframe> tmpKeyframe(3);
+    // the segment endpoints, whose value or frame may be updated below
+    KeyframePoint pa(*a), pb(*b);
 
     // if segment is keyframe based ....
     if (TDoubleKeyframe::isKeyframeBased(a->m_type)) {
       // .. and next segment is not then update the b value
       if ((b + 1) != keyframes.end() &&
-          !TDoubleKeyframe::isKeyframeBased(b->m_type)) {
-        tmpKeyframe[0] = *b;
-        if (b->m_type != TDoubleKeyframe::Expression ||
-            !b->m_expression.isCycling())
-          tmpKeyframe[0].m_value = getValue(b->m_frame);
-        b = tmpKeyframe.begin();
-      }
+          !TDoubleKeyframe::isKeyframeBased(b->m_type) &&
+          (b->m_type != TDoubleKeyframe::Expression ||
+           !b->m_expression.isCycling()))
+        pb.m_value = getValue(b->m_frame);
       // .. and/or if prev segment is not then update the a value
       if (a != keyframes.begin() &&
-          !TDoubleKeyframe::isKeyframeBased(a[-1].m_type)) {
-        tmpKeyframe[1]         = *a;
-        tmpKeyframe[1].m_value = getValue(a->m_frame, true);
-        a                      = tmpKeyframe.begin() + 1;
-      }
+          !TDoubleKeyframe::isKeyframeBased(a[-1].m_type))
+        pa.m_value = getValue(a->m_frame, true);
     }
 
     if (a->m_step > 1) {
-      tmpKeyframe[2] = *b;
-      b              = tmpKeyframe.begin() + 2;
-
-      int relPos = tfloor(b->m_frame - a->m_frame),
+      int relPos = tfloor(pb.m_frame - a->m_frame),
           step   = std::min(a->m_step, relPos);
 
-      tmpKeyframe[2].m_frame = a->m_frame + tfloor(relPos, step);
-      if (frame > b->m_frame) frame = b->m_frame;
+      pb.m_frame = a->m_frame + tfloor(relPos, step);
+      if (frame > pb.m_frame) frame = pb.m_frame;
 
       frame = a->m_frame + tfloor(tfloor(frame - a->m_frame), step);
     }
@@ -626,26 +646,26 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
     bool convertUnit = false;
     switch (a->m_type) {
     case TDoubleKeyframe::Constant:
-      value = getConstantValue(*a, *b, frame);
+      value = getConstantValue(pa, pb, frame);
       break;
     case TDoubleKeyframe::Linear:
-      value = getLinearValue(*a, *b, frame);
+      value = getLinearValue(pa, pb, frame);
       break;
     case TDoubleKeyframe::SpeedInOut:
-      value = getSpeedInOutValue(*a, *b, getSpeedOut(kIndex),
+      value = getSpeedInOutValue(pa, pb, getSpeedOut(kIndex),
                                  getSpeedIn(kIndex + 1), frame);
       break;
     case TDoubleKeyframe::EaseInOut:
-      value = getEaseInOutValue(*a, *b, frame, false);
+      value = getEaseInOutValue(pa, pb, frame, false);
       break;
     case TDoubleKeyframe::EaseInOutPercentage:
-      value = getEaseInOutValue(*a, *b, frame, true);
+      value = getEaseInOutValue(pa, pb, frame, true);
       break;
     case TDoubleKeyframe::Exponential:
-      value = getExponentialValue(*a, *b, frame);
+      value = getExponentialValue(pa, pb, frame);
       break;
     case TDoubleKeyframe::Expression:
-      value       = getExpressionValue(*a, *b, frame, m_imp->m_measure);
+      value       = getExpressionValue(*a, pb, frame, m_imp->m_measure);
       convertUnit = true;
       break;
     case TDoubleKeyframe::File:
@@ -653,7 +673,7 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
       convertUnit = true;
       break;
     case TDoubleKeyframe::SimilarShape:
-      value = getSimilarShapeValue(*a, *b, frame, m_imp->m_measure);
+      value = getSimilarShapeValue(*a, pb, frame, m_imp->m_measure);
       // convertUnit = true;
       break;
 
@@ -671,6 +691,66 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
 
 //---------------------------------------------------------
 
+void TDoubleParam::evaluateRange(double frame0, double frame1,
+                                 double *values) const {
+  evaluateRange(frame0, 1.0, tfloor(frame1 - frame0) + 1, values);
+}
+
+//---------------------------------------------------------
+
+void TDoubleParam::evaluateRange(double frame0, double step, int count,
+                                 double *values) const {
+  assert(m_imp);
+  if (count <= 0) return;
+
+  const DoubleKeyframeVector &keyframes = m_imp->m_keyframes;
+  if (keyframes.size() < 2 || step <= 0) {
+    for (int i = 0; i < count; ++i) values[i] = getValue(frame0 + i * step);
+    return;
+  }
+
+  double f0 = keyframes.begin()->m_frame, f1 = keyframes.back().m_frame;
+  for (int i = 0; i < count;) {
+    double frame = frame0 + i * step;
+
+    // frames outside [f0,f1) are clamped or cycled: see getValue()
+    if (frame < f0 || frame >= f1) {
+      values[i++] = getValue(frame);
+      continue;
+    }
+
+    // segment (a,b) contains frame
+    DoubleKeyframeVector::const_iterator b = std::upper_bound(
+        keyframes.begin(), keyframes.end(), TDoubleKeyframe(frame));
+    DoubleKeyframeVector::const_iterator a = b - 1;
+
+    int n = std::min(tceil((b->m_frame - frame) / step), count - i);
+
+    TSyntax::Calculator *calculator =
+        (a->m_type == TDoubleKeyframe::Expression && a->m_step <= 1)
+            ? a->m_expression.getCalculator()
+            : 0;
+    if (!calculator || n < 2) {
+      values[i++] = getValue(frame);
+      continue;
+    }
+
+    // the same variables passed by getExpressionValue()
+    double length = b->m_frame - a->m_frame, rframe = frame - a->m_frame;
+    double vars[3]  = {rframe / length, frame + 1, rframe + 1};
+    double dvars[3] = {step / length, step, step};
+
+    calculator->setUnit(a->getUnit(m_imp->m_measure));
+    calculator->compute(vars, dvars, n, values + i);
+
+    for (int j = i; j < i + n; ++j)
+      values[j] = a->convertFrom(m_imp->m_measure, values[j]);
+    i += n;
+  }
+}
+
+//---------------------------------------------------------
+
 bool TDoubleParam::setValue(double frame, double value) {
   assert(m_imp);
   DoubleKeyframeVector &keyframes = m_imp->m_keyframes;
@@ -1022,6 +1102,12 @@ const std::set<TParamObserver *> &TDoubleParam::observers() const {
 
 //---------------------------------------------------------
 
+unsigned int TDoubleParam::getChangeCount() const {
+  return m_imp->m_changeCount;
+}
+
+//---------------------------------------------------------
+
 void TDoubleParam::loadData(TIStream &is) {
   string tagName;
   /*
@@ -1218,6 +1304,7 @@ void TDoubleParam::setGrammar(const TSyntax::Grammar *grammar) {
   m_imp->m_grammar = grammar;
   for (int i = 0; i < (int)m_imp->m_keyframes.size(); i++)
     m_imp->m_keyframes[i].m_expression.setGrammar(grammar);
+  ++m_imp->m_changeCount;
 }
 
 //-------------------------------------------------------------------
@@ -1235,6 +1322,17 @@ void TDoubleParam::accept(TSyntax::CalculatorNodeVisitor &visitor) {
       m_imp->m_keyframes[i].m_expression.accept(visitor);
 }
 
+//---------------------------------------------------------
+
+bool TDoubleParam::hasReferences() const {
+  for (int i = 0; i < (int)m_imp->m_keyframes.size(); i++)
+    if ((m_imp->m_keyframes[i].m_type == TDoubleKeyframe::Expression ||
+         m_imp->m_keyframes[i].m_type == TDoubleKeyframe::SimilarShape) &&
+        m_imp->m_keyframes[i].m_expression.hasReference())
+      return true;
+  return false;
+}
+
 //-------------------------------------------------------------------
 
 string TDoubleParam::getMeasureName() const { return m_imp->m_measureName; }
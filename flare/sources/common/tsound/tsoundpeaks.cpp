@@ -0,0 +1,237 @@
+
+
+#include "tsoundpeaks.h"
+#include "tsystem.h"
+#include "tfilepath_io.h"
+#include "tconvert.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char s_magic[4]   = {'T', 'P', 'K', 'S'};
+const TINT32 s_version = 1;
+
+struct PeaksHeader {
+  char m_magic[4];
+  TINT32 m_version;
+  TINT32 m_sampleCount;
+  TUINT32 m_sampleRate;
+  TINT32 m_baseBlock;
+  TINT32 m_levelCount;
+  TINT64 m_sourceSize;
+  TINT64 m_sourceTime;
+  double m_absMaxPressure;
+};
+
+//------------------------------------------------------------------------------
+
+void getSourceStamp(const TFilePath &soundPath, TINT64 &size, TINT64 &time) {
+  TFileStatus fs(soundPath);
+  size = fs.doesExist() ? fs.getSize() : -1;
+  time = fs.doesExist() ? fs.getLastModificationTime().toMSecsSinceEpoch() : 0;
+}
+
+}  // namespace
+
+//==============================================================================
+
+TSoundPeaks::TSoundPeaks()
+    : m_sampleCount(0), m_sampleRate(0), m_absMaxPressure(0) {}
+
+//------------------------------------------------------------------------------
+
+void TSoundPeaks::clear() {
+  m_levels.clear();
+  m_sampleCount    = 0;
+  m_sampleRate     = 0;
+  m_absMaxPressure = 0;
+}
+
+//------------------------------------------------------------------------------
+
+bool TSoundPeaks::build(const TSoundTrackP &st,
+                        const std::atomic<bool> *canceled) {
+  clear();
+  if (!st) return true;
+
+  TINT32 sampleCount = st->getSampleCount();
+  if (sampleCount <= 0) return true;
+
+  const int block = baseBlockSize(), ratio = levelRatio();
+
+  // Level 0 is the only one scanning actual samples
+  std::vector<std::vector<Peak>> levels(1);
+  std::vector<Peak> &base = levels[0];
+  base.resize((sampleCount + block - 1) / block);
+
+  double absMax = 0.0;
+  for (TINT32 b = 0, bCount = (TINT32)base.size(); b < bCount; ++b) {
+    if (canceled && (b & 0x3ff) == 0 && canceled->load()) return false;
+
+    TINT32 s0 = b * block, s1 = std::min(s0 + block, sampleCount) - 1;
+    double min = 0.0, max = 0.0;
+    st->getMinMaxPressure(s0, s1, TSound::MONO, min, max);
+
+    base[b].m_min = (float)min, base[b].m_max = (float)max;
+    absMax = std::max(absMax, std::max(fabs(min), fabs(max)));
+  }
+
+  // Upper levels merge blocks of the previous one
+  while (levels.back().size() > 1) {
+    const std::vector<Peak> &prev = levels.back();
+    std::vector<Peak> level((prev.size() + ratio - 1) / ratio);
+
+    for (size_t b = 0; b < level.size(); ++b) {
+      size_t p0 = b * ratio, p1 = std::min(p0 + ratio, prev.size());
+
+      Peak peak = prev[p0];
+      for (size_t p = p0 + 1; p < p1; ++p) {
+        peak.m_min = std::min(peak.m_min, prev[p].m_min);
+        peak.m_max = std::max(peak.m_max, prev[p].m_max);
+      }
+      level[b] = peak;
+    }
+
+    levels.push_back(std::move(level));
+  }
+
+  m_levels.swap(levels);
+  m_sampleCount    = sampleCount;
+  m_sampleRate     = st->getSampleRate();
+  m_absMaxPressure = absMax;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void TSoundPeaks::getMinMaxPressure(TINT32 s0, TINT32 s1, double &min,
+                                    double &max) const {
+  if (m_levels.empty() || m_sampleCount <= 0) {
+    min = max = 0.0;
+    return;
+  }
+
+  if (s1 < s0) std::swap(s0, s1);
+  s0 = tcrop<TINT32>(s0, 0, m_sampleCount - 1);
+  s1 = tcrop<TINT32>(s1, 0, m_sampleCount - 1);
+
+  // Cover the range with the coarsest blocks lying inside it: [b0, b1) are
+  // blocks of the current level, and the ones that do not fill a whole block
+  // of the next level are merged here. Only the 2 level 0 blocks at the ends
+  // may stick out of the range.
+  const int ratio = levelRatio(), lCount = (int)m_levels.size();
+  TINT32 b0 = s0 / baseBlockSize(), b1 = s1 / baseBlockSize() + 1;
+
+  float fMin = m_levels[0][b0].m_min, fMax = m_levels[0][b0].m_max;
+  auto merge = [&](const std::vector<Peak> &level, TINT32 p0, TINT32 p1) {
+    for (TINT32 b = p0; b < p1; ++b) {
+      fMin = std::min(fMin, level[b].m_min);
+      fMax = std::max(fMax, level[b].m_max);
+    }
+  };
+
+  for (int l = 0;; ++l) {
+    const std::vector<Peak> &level = m_levels[l];
+    assert(b1 <= (TINT32)level.size());
+
+    TINT32 n0 = (b0 + ratio - 1) / ratio, n1 = b1 / ratio;
+    if (l + 1 == lCount || n0 >= n1) {
+      merge(level, b0, b1);
+      break;
+    }
+
+    merge(level, b0, n0 * ratio);
+    merge(level, n1 * ratio, b1);
+    b0 = n0, b1 = n1;
+  }
+
+  min = fMin, max = fMax;
+}
+
+//------------------------------------------------------------------------------
+
+TFilePath TSoundPeaks::getPeaksPath(const TFilePath &soundPath) {
+  return soundPath.withName(soundPath.getWideName() + L"_" +
+                            ::to_wstring(soundPath.getType()))
+      .withType("peaks");
+}
+
+//------------------------------------------------------------------------------
+
+bool TSoundPeaks::save(const TFilePath &peaksPath,
+                       const TFilePath &soundPath) const {
+  if (m_levels.empty()) return false;
+
+  PeaksHeader header;
+  memcpy(header.m_magic, s_magic, sizeof(s_magic));
+  header.m_version        = s_version;
+  header.m_sampleCount    = m_sampleCount;
+  header.m_sampleRate     = m_sampleRate;
+  header.m_baseBlock      = baseBlockSize();
+  header.m_levelCount     = (TINT32)m_levels.size();
+  header.m_absMaxPressure = m_absMaxPressure;
+  getSourceStamp(soundPath, header.m_sourceSize, header.m_sourceTime);
+
+  FILE *chan = fopen(peaksPath, "wb");
+  if (!chan) return false;
+
+  bool ok = fwrite(&header, sizeof(header), 1, chan) == 1;
+  for (const std::vector<Peak> &level : m_levels) {
+    if (!ok) break;
+    ok = fwrite(level.data(), sizeof(Peak), level.size(), chan) ==
+         level.size();
+  }
+
+  fclose(chan);
+  if (!ok) TSystem::removeFileOrLevel(peaksPath);
+
+  return ok;
+}
+
+//------------------------------------------------------------------------------
+
+bool TSoundPeaks::load(const TFilePath &peaksPath, const TFilePath &soundPath,
+                       TINT32 sampleCount) {
+  clear();
+
+  FILE *chan = fopen(peaksPath, "rb");
+  if (!chan) return false;
+
+  PeaksHeader header;
+  bool ok = fread(&header, sizeof(header), 1, chan) == 1 &&
+            memcmp(header.m_magic, s_magic, sizeof(s_magic)) == 0 &&
+            header.m_version == s_version &&
+            header.m_sampleCount == sampleCount &&
+            header.m_baseBlock == baseBlockSize() && header.m_levelCount > 0;
+
+  if (ok) {
+    TINT64 size, time;
+    getSourceStamp(soundPath, size, time);
+    ok = (size == header.m_sourceSize && time == header.m_sourceTime);
+  }
+
+  // The levels' sizes are implied by the sample count
+  std::vector<std::vector<Peak>> levels;
+  size_t count = (sampleCount + baseBlockSize() - 1) / baseBlockSize();
+  for (int l = 0; ok && l < header.m_levelCount; ++l) {
+    levels.emplace_back(count);
+    ok = fread(levels.back().data(), sizeof(Peak), count, chan) == count;
+    count = (count + levelRatio() - 1) / levelRatio();
+  }
+
+  fclose(chan);
+  if (!ok) return false;
+
+  m_levels.swap(levels);
+  m_sampleCount    = header.m_sampleCount;
+  m_sampleRate     = header.m_sampleRate;
+  m_absMaxPressure = header.m_absMaxPressure;
+
+  return true;
+}
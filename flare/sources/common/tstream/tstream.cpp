@@ -182,6 +182,400 @@ public:
 
 TPersistFactory *TPersistFactory::m_factory = 0;
 
+//===============================================================
+//    Binary format
+//===============================================================
+
+/*
+  Binary documents hold the same tags and values as the XML ones, as a
+  sequence of records following a fixed header:
+
+    "TNZB" <byte order mark> <format version> <string table offset>
+    <section index offset> <records> <string table> <section index>
+
+  Header fields are 32 bit integers. Tag names, attributes and string values
+  are stored once in the string table and referenced by index, integers are
+  zigzag varints - so that cell runs and keyframe indices take a byte or two
+  each. Begin tags record the offset past their end tag, making skipped tags
+  a seek; the section index locates the children of the root tag.
+*/
+
+const char c_binaryMagic[]      = "TNZB";
+const TUINT32 c_byteOrderMark   = 0x0A0B0C0D;
+const TUINT32 c_binaryVersion   = 1;
+const size_t c_binaryHeaderSize = 20;
+
+enum BinaryRecord {
+  BeginTagRecord = 1,
+  BeginEndTagRecord,
+  EndTagRecord,
+  IntRecord,
+  DoubleRecord,
+  StringRecord
+};
+
+//--------------------------------
+
+//! A value token, as stored in binary documents or as parsed from XML ones.
+//! Values convert to the requested type like the XML text would.
+struct StreamValue {
+  enum Type { Int, Double, String };
+
+  Type m_type;
+  int m_int;
+  double m_double;
+  std::string m_string;
+
+  StreamValue() : m_type(Int), m_int(0), m_double(0) {}
+
+  bool toInt(int &v) const {
+    if (m_type == Int)
+      v = m_int;
+    else if (m_type == Double)
+      v = (int)m_double;
+    else {
+      std::istringstream is(m_string);
+      return !!(is >> v);
+    }
+    return true;
+  }
+
+  bool toDouble(double &v) const {
+    if (m_type == Int)
+      v = m_int;
+    else if (m_type == Double)
+      v = m_double;
+    else {
+      std::istringstream is(m_string);
+      return !!(is >> v);
+    }
+    return true;
+  }
+
+  std::string toString() const {
+    if (m_type == String) return m_string;
+    if (m_type == Int) return std::to_string(m_int);
+
+    std::ostringstream os;
+    os << m_double;
+    return os.str();
+  }
+};
+
+//--------------------------------
+
+//! Classifies an unquoted XML token, keeping it a string unless it is the
+//! exact text TOStream writes for a number.
+void parseXmlValue(const std::string &text, StreamValue &value) {
+  value.m_type   = StreamValue::String;
+  value.m_string = text;
+
+  char *end;
+  long n = strtol(text.c_str(), &end, 10);
+  if (*end == 0 && n == (int)n && std::to_string(n) == text) {
+    value.m_type = StreamValue::Int;
+    value.m_int  = n;
+    return;
+  }
+
+  double d = strtod(text.c_str(), &end);
+  if (*end == 0) {
+    std::ostringstream os;
+    os << d;
+    if (os.str() == text) {
+      value.m_type   = StreamValue::Double;
+      value.m_double = d;
+    }
+  }
+}
+
+//===============================================================
+
+class BinaryWriter {
+  struct Section {
+    int m_name;
+    TUINT32 m_begin, m_end;
+  };
+
+  std::string m_data;  //!< The records, header excluded
+
+  std::map<std::string, int> m_stringIds;
+  std::vector<const std::string *> m_strings;
+
+  std::vector<size_t> m_openTags;  //!< Positions of the open tags' end fields
+  std::vector<Section> m_sections;
+
+public:
+  size_t size() const { return m_data.size(); }
+
+  void putVarint(TUINT64 v) {
+    for (; v >= 0x80; v >>= 7) m_data += (char)(v | 0x80);
+    m_data += (char)v;
+  }
+
+  void putUInt32(TUINT32 v, size_t pos) {
+    memcpy(&m_data[pos], &v, sizeof v);
+  }
+
+  void putStringId(const std::string &s) {
+    std::map<std::string, int>::iterator it = m_stringIds.find(s);
+    if (it == m_stringIds.end()) {
+      it = m_stringIds.insert(std::make_pair(s, (int)m_strings.size())).first;
+      m_strings.push_back(&it->first);
+    }
+    putVarint(it->second);
+  }
+
+  void putInt(int v) {
+    m_data += (char)IntRecord;
+    putVarint(((TUINT32)v << 1) ^ (TUINT32)(v >> 31));
+  }
+
+  void putDouble(double v) {
+    m_data += (char)DoubleRecord;
+    m_data.append((const char *)&v, sizeof v);
+  }
+
+  void putString(const std::string &v) {
+    m_data += (char)StringRecord;
+    putStringId(v);
+  }
+
+  void beginTag(const std::string &name,
+                const std::map<std::string, std::string> &attributes,
+                bool closed) {
+    size_t begin = m_data.size();
+
+    m_data += (char)(closed ? BeginEndTagRecord : BeginTagRecord);
+    putStringId(name);
+    putVarint(attributes.size());
+    for (std::map<std::string, std::string>::const_iterator it =
+             attributes.begin();
+         it != attributes.end(); ++it) {
+      putStringId(it->first);
+      putStringId(it->second);
+    }
+
+    if (m_openTags.size() == 1) {
+      Section section = {m_stringIds[name],
+                         TUINT32(c_binaryHeaderSize + begin), 0};
+      m_sections.push_back(section);
+    }
+
+    if (closed) {
+      if (m_openTags.size() == 1)
+        m_sections.back().m_end = c_binaryHeaderSize + m_data.size();
+      return;
+    }
+
+    m_openTags.push_back(m_data.size());
+    m_data.append(sizeof(TUINT32), 0);
+  }
+
+  void endTag() {
+    assert(!m_openTags.empty());
+    m_data += (char)EndTagRecord;
+
+    TUINT32 end = c_binaryHeaderSize + m_data.size();
+    putUInt32(end, m_openTags.back());
+    m_openTags.pop_back();
+
+    if (m_openTags.size() == 1) m_sections.back().m_end = end;
+  }
+
+  //! Writes the whole document; may be called again after more records.
+  void write(std::ostream &os) const {
+    BinaryWriter strings, index;
+    strings.putVarint(m_strings.size());
+    for (const std::string *s : m_strings) {
+      strings.putVarint(s->size());
+      strings.m_data += *s;
+    }
+
+    index.putVarint(m_sections.size());
+    for (const Section &section : m_sections) {
+      index.putVarint(section.m_name);
+      index.putVarint(section.m_begin);
+      index.putVarint(section.m_end);
+    }
+
+    TUINT32 stringsOffset = TUINT32(c_binaryHeaderSize + m_data.size());
+    TUINT32 header[4]     = {c_byteOrderMark, c_binaryVersion, stringsOffset,
+                             TUINT32(stringsOffset + strings.m_data.size())};
+    os.seekp(0);
+    os.write(c_binaryMagic, 4);
+    os.write((const char *)header, sizeof header);
+    os.write(m_data.data(), m_data.size());
+    os.write(strings.m_data.data(), strings.m_data.size());
+    os.write(index.m_data.data(), index.m_data.size());
+  }
+};
+
+//===============================================================
+
+class BinaryReader {
+  struct OpenTag {
+    int m_name;
+    size_t m_end;
+  };
+
+  std::string m_buffer;
+  size_t m_pos, m_end;  //!< Current position and end of the records
+
+  std::vector<std::string> m_strings;
+  std::map<std::string, size_t> m_sections;
+
+  std::vector<OpenTag> m_openTags;
+
+public:
+  BinaryReader(std::string &buffer) : m_pos(c_binaryHeaderSize) {
+    m_buffer.swap(buffer);
+    if (m_buffer.size() < c_binaryHeaderSize ||
+        m_buffer.compare(0, 4, c_binaryMagic) != 0)
+      throw TException("Bad magic number");
+
+    TUINT32 header[4];
+    memcpy(header, &m_buffer[4], sizeof header);
+    if (header[0] != c_byteOrderMark)
+      throw TException("Unsupported byte order");
+    if (header[1] > c_binaryVersion)
+      throw TException("Unsupported binary format version");
+    if (header[2] < c_binaryHeaderSize || header[3] < header[2] ||
+        header[3] > m_buffer.size())
+      throw TException("Corrupted file");
+
+    // Read the string table and the section index, then the records
+    m_pos = header[2];
+    m_end = header[3];
+
+    size_t count = getVarint();
+    m_strings.reserve(std::min(count, m_buffer.size()));
+    for (size_t i = 0; i < count; ++i) {
+      size_t len = getVarint();
+      if (len > m_end - m_pos) throw TException("Corrupted file");
+      m_strings.push_back(m_buffer.substr(m_pos, len));
+      m_pos += len;
+    }
+
+    m_pos = header[3];
+    m_end = m_buffer.size();
+
+    count = getVarint();
+    for (size_t i = 0; i < count; ++i) {
+      const std::string &name = getString();
+      size_t begin            = getVarint();
+      getVarint();
+      m_sections.insert(std::make_pair(name, begin));
+    }
+
+    m_pos = c_binaryHeaderSize;
+    m_end = header[2];
+  }
+
+  bool atEnd() const { return m_pos >= m_end; }
+  int peek() const { return atEnd() ? -1 : (unsigned char)m_buffer[m_pos]; }
+
+  TUINT64 getVarint() {
+    TUINT64 v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (atEnd()) throw TException("unexpected EOF");
+      unsigned char c = m_buffer[m_pos++];
+      v |= (TUINT64)(c & 0x7f) << shift;
+      if (!(c & 0x80)) return v;
+    }
+    throw TException("Corrupted file");
+  }
+
+  const std::string &getString() {
+    TUINT64 id = getVarint();
+    if (id >= m_strings.size()) throw TException("Corrupted file");
+    return m_strings[id];
+  }
+
+  //! Reads the next tag, if any. Like XML, end tags are reported too.
+  bool readTag(StreamTag &tag) {
+    int record = peek();
+    if (record == EndTagRecord) {
+      if (m_openTags.empty()) throw TException("unexpected end tag");
+      ++m_pos;
+      tag.m_name = m_strings[m_openTags.back().m_name];
+      tag.m_type = StreamTag::EndTag;
+      m_openTags.pop_back();
+      return true;
+    }
+    if (record != BeginTagRecord && record != BeginEndTagRecord) return false;
+
+    ++m_pos;
+    TUINT64 name = getVarint();
+    if (name >= m_strings.size()) throw TException("Corrupted file");
+    tag.m_name = m_strings[name];
+
+    size_t count = getVarint();
+    for (size_t i = 0; i < count; ++i) {
+      const std::string &key = getString();
+      tag.m_attributes[key]  = getString();
+    }
+
+    if (record == BeginEndTagRecord) {
+      tag.m_type = StreamTag::BeginEndTag;
+      return true;
+    }
+
+    TUINT32 end;
+    if (m_end - m_pos < sizeof end) throw TException("unexpected EOF");
+    memcpy(&end, &m_buffer[m_pos], sizeof end);
+    m_pos += sizeof end;
+    if (end <= m_pos || end > m_end) throw TException("Corrupted file");
+
+    OpenTag openTag = {int(name), end};
+    m_openTags.push_back(openTag);
+    tag.m_type = StreamTag::BeginTag;
+    return true;
+  }
+
+  bool readValue(StreamValue &value) {
+    switch (peek()) {
+    case IntRecord: {
+      ++m_pos;
+      TUINT32 v    = getVarint();
+      value.m_type = StreamValue::Int;
+      value.m_int  = int(v >> 1) ^ -int(v & 1);
+      return true;
+    }
+    case DoubleRecord:
+      if (m_end - m_pos <= sizeof(double)) throw TException("unexpected EOF");
+      memcpy(&value.m_double, &m_buffer[m_pos + 1], sizeof(double));
+      m_pos += 1 + sizeof(double);
+      value.m_type = StreamValue::Double;
+      return true;
+    case StringRecord:
+      ++m_pos;
+      value.m_string = getString();
+      value.m_type   = StreamValue::String;
+      return true;
+    }
+    return false;
+  }
+
+  //! Moves past the end tag of the innermost open tag.
+  void skipTag() {
+    if (m_openTags.empty()) return;
+    m_pos = m_openTags.back().m_end;
+    m_openTags.pop_back();
+  }
+
+  //! Moves to the named child of the root tag, leaving only the root open.
+  bool seekSection(const std::string &name) {
+    std::map<std::string, size_t>::iterator it = m_sections.find(name);
+    if (it == m_sections.end() || it->second >= m_end || m_openTags.empty())
+      return false;
+
+    m_openTags.erase(m_openTags.begin() + 1, m_openTags.end());
+    m_pos = it->second;
+    return true;
+  }
+};
+
 }  // namespace
 
 //--------------------------------
@@ -213,21 +607,36 @@ public:
   int m_maxId;
   TFilePath m_filepath;
 
+  std::unique_ptr<BinaryWriter> m_binary;
+  size_t m_binaryWritten;  //!< Size of the records last written to file
+
   Imp()
       : m_os(0)
       , m_chanOwner(false)
       , m_tab(0)
       , m_justStarted(true)
       , m_maxId(0)
-      , m_compressed(false) {}
+      , m_compressed(false)
+      , m_binaryWritten(std::string::npos) {}
+
+  //! Writes binary documents to the file, which happens once all tags are
+  //! closed.
+  void writeBinary() {
+    if (!m_os || m_binaryWritten == m_binary->size()) return;
+    m_binary->write(*m_os);
+    m_binaryWritten = m_binary->size();
+  }
 };
 
 //---------------------------------------------------------------
 
-TOStream::TOStream(const TFilePath &fp, bool compressed) : m_imp(new Imp) {
+TOStream::TOStream(const TFilePath &fp, bool compressed, bool binary)
+    : m_imp(new Imp) {
   m_imp->m_filepath = fp;
 
-  if (compressed) {
+  if (binary) m_imp->m_binary.reset(new BinaryWriter);
+
+  if (compressed && !binary) {
     m_imp->m_os         = &m_imp->m_ostringstream;
     m_imp->m_compressed = true;
     m_imp->m_chanOwner  = false;
@@ -244,6 +653,11 @@ TOStream::TOStream(const TFilePath &fp, bool compressed) : m_imp(new Imp) {
 
 TOStream::TOStream(std::shared_ptr<Imp> imp) : m_imp(std::move(imp)) {
   assert(!m_imp->m_tagStack.empty());
+  if (m_imp->m_binary) {
+    m_imp->m_binary->beginTag(m_imp->m_tagStack.back(),
+                              std::map<std::string, std::string>(), false);
+    return;
+  }
   std::ostream &os = *m_imp->m_os;
   if (!m_imp->m_justStarted) cr();
   os << "<" << m_imp->m_tagStack.back() << ">";
@@ -272,6 +686,10 @@ TOStream::~TOStream() {
       std::string tagName = m_imp->m_tagStack.back();
       m_imp->m_tagStack.pop_back();
       assert(tagName != "");
+      if (m_imp->m_binary) {
+        m_imp->m_binary->endTag();
+        return;
+      }
       std::ostream &os = *m_imp->m_os;
       m_imp->m_tab--;
       if (!m_imp->m_justStarted) cr();
@@ -279,6 +697,7 @@ TOStream::~TOStream() {
       cr();
       m_imp->m_justStarted = true;
     } else {
+      if (m_imp->m_binary) m_imp->writeBinary();
       if (m_imp->m_compressed) {
         std::string tmp = m_imp->m_ostringstream.str();
         const void *in  = (const void *)tmp.c_str();
@@ -326,6 +745,10 @@ TFilePath TOStream::getRepositoryPath() {
 //---------------------------------------------------------------
 
 TOStream &TOStream::operator<<(int v) {
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putInt(v);
+    return *this;
+  }
   *(m_imp->m_os) << v << " ";
   m_imp->m_justStarted = false;
   return *this;
@@ -338,6 +761,10 @@ TOStream &TOStream::operator<<(double v) {
                              // read them back!
     v = 0;
 
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putDouble(v);
+    return *this;
+  }
   *(m_imp->m_os) << v << " ";
   m_imp->m_justStarted = false;
   return *this;
@@ -346,6 +773,10 @@ TOStream &TOStream::operator<<(double v) {
 //---------------------------------------------------------------
 
 TOStream &TOStream::operator<<(std::string v) {
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putString(v);
+    return *this;
+  }
   std::ostream &os = *(m_imp->m_os);
   int len          = v.length();
   if (len == 0) {
@@ -373,6 +804,10 @@ TOStream &TOStream::operator<<(std::string v) {
 
 TOStream &TOStream::operator<<(QString _v) {
   std::string v = _v.toStdString();
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putString(v);
+    return *this;
+  }
 
   std::ostream &os = *(m_imp->m_os);
   int len          = v.length();
@@ -449,6 +884,13 @@ TOStream &TOStream::operator<<(const TFilePath &v) {
 //---------------------------------------------------------------
 
 TOStream &TOStream::operator<<(const TPixel32 &v) {
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putInt(v.r);
+    m_imp->m_binary->putInt(v.g);
+    m_imp->m_binary->putInt(v.b);
+    m_imp->m_binary->putInt(v.m);
+    return *this;
+  }
   std::ostream &os = *(m_imp->m_os);
   os << (int)v.r << " " << (int)v.g << " " << (int)v.b << " " << (int)v.m
      << " ";
@@ -459,6 +901,13 @@ TOStream &TOStream::operator<<(const TPixel32 &v) {
 //---------------------------------------------------------------
 
 TOStream &TOStream::operator<<(const TPixel64 &v) {
+  if (m_imp->m_binary) {
+    m_imp->m_binary->putInt(v.r);
+    m_imp->m_binary->putInt(v.g);
+    m_imp->m_binary->putInt(v.b);
+    m_imp->m_binary->putInt(v.m);
+    return *this;
+  }
   std::ostream &os = *(m_imp->m_os);
   os << (int)v.r << " " << (int)v.g << " " << (int)v.b << " " << (int)v.m
      << " ";
@@ -469,6 +918,7 @@ TOStream &TOStream::operator<<(const TPixel64 &v) {
 //---------------------------------------------------------------
 
 void TOStream::cr() {
+  if (m_imp->m_binary) return;
   *(m_imp->m_os) << std::endl;
   for (int i = 0; i < m_imp->m_tab; i++) *(m_imp->m_os) << "  ";
   m_imp->m_justStarted = false;
@@ -490,6 +940,11 @@ TOStream TOStream::child(std::string tagName) {
 void TOStream::openChild(std::string tagName) {
   assert(tagName != "");
   m_imp->m_tagStack.push_back(tagName);
+  if (m_imp->m_binary) {
+    m_imp->m_binary->beginTag(tagName, std::map<std::string, std::string>(),
+                              false);
+    return;
+  }
   if (m_imp->m_justStarted == false) cr();
   *(m_imp->m_os) << "<" << m_imp->m_tagStack.back() << ">";
   m_imp->m_tab++;
@@ -503,6 +958,10 @@ void TOStream::openChild(std::string tagName,
                          const std::map<std::string, std::string> &attributes) {
   assert(tagName != "");
   m_imp->m_tagStack.push_back(tagName);
+  if (m_imp->m_binary) {
+    m_imp->m_binary->beginTag(tagName, attributes, false);
+    return;
+  }
   if (m_imp->m_justStarted == false) cr();
   *(m_imp->m_os) << "<" << m_imp->m_tagStack.back();
   for (std::map<std::string, std::string>::const_iterator it =
@@ -523,6 +982,10 @@ void TOStream::closeChild() {
   std::string tagName = m_imp->m_tagStack.back();
   m_imp->m_tagStack.pop_back();
   assert(tagName != "");
+  if (m_imp->m_binary) {
+    m_imp->m_binary->endTag();
+    return;
+  }
   // std::ostream &os = *m_imp->m_os; // os is not used
   m_imp->m_tab--;
   if (!m_imp->m_justStarted) cr();
@@ -536,6 +999,10 @@ void TOStream::closeChild() {
 void TOStream::openCloseChild(
     std::string tagName, const std::map<std::string, std::string> &attributes) {
   assert(tagName != "");
+  if (m_imp->m_binary) {
+    m_imp->m_binary->beginTag(tagName, attributes, true);
+    return;
+  }
   // m_imp->m_tagStack.push_back(tagName);
   if (m_imp->m_justStarted == false) cr();
   *(m_imp->m_os) << "<" << tagName;
@@ -561,6 +1028,19 @@ TOStream &TOStream::operator<<(TPersist &v) {
 
 TOStream &TOStream::operator<<(TPersist *v) {
   Imp::PersistTable::iterator it = m_imp->m_table.find(v);
+  if (m_imp->m_binary) {
+    std::map<std::string, std::string> attributes;
+    bool saved = it != m_imp->m_table.end();
+    int id     = saved ? it->second : (m_imp->m_table[v] = ++m_imp->m_maxId);
+
+    attributes["id"] = std::to_string(id);
+    m_imp->m_binary->beginTag(v->getStreamTag(), attributes, saved);
+    if (!saved) {
+      v->saveData(*this);
+      m_imp->m_binary->endTag();
+    }
+    return *this;
+  }
   if (it != m_imp->m_table.end()) {
     *(m_imp->m_os) << "<" << v->getStreamTag() << " id='" << it->second
                    << "'/>";
@@ -585,6 +1065,8 @@ TOStream &TOStream::operator<<(TPersist *v) {
 bool TOStream::checkStatus() const {
   if (!m_imp->m_os) return false;
 
+  if (m_imp->m_binary && m_imp->m_tagStack.empty()) m_imp->writeBinary();
+
   m_imp->m_os->flush();
   return m_imp->m_os->rdstate() == std::ios_base::goodbit;
 }
@@ -617,12 +1099,16 @@ public:
 
   VersionNumber m_versionNumber;
 
+  std::unique_ptr<BinaryReader> m_binary;
+  bool m_failed;  //!< Whether a binary document read has failed
+
   Imp()
       : m_is(0)
       , m_chanOwner(false)
       , m_line(0)
       , m_compressed(false)
-      , m_versionNumber(0, 0) {}
+      , m_versionNumber(0, 0)
+      , m_failed(false) {}
 
   // update m_line if necessary; returns -e if eof
   int getNextChar();
@@ -634,6 +1120,13 @@ public:
   bool matchValue(std::string &value);
 
   void skipCurrentTag();
+
+  //! Reads the next value of binary documents, failing the stream on tags.
+  bool readBinaryValue(StreamValue &value) {
+    if (!m_currentTag && m_binary->readValue(value)) return true;
+    m_failed = true;
+    return false;
+  }
 };
 
 //---------------------------------------------------------------
@@ -722,6 +1215,7 @@ bool TIStream::Imp::matchTag() {
   if (m_currentTag) return true;
   StreamTag &tag = m_currentTag;
   tag            = StreamTag();
+  if (m_binary) return m_binary->readTag(tag);
   skipBlanks();
   if (!match('<')) return false;
   skipBlanks();
@@ -784,6 +1278,12 @@ bool TIStream::Imp::matchTag() {
 
 void TIStream::Imp::skipCurrentTag() {
   if (m_currentTag.m_type == StreamTag::BeginEndTag) return;
+  if (m_binary) {
+    m_binary->skipTag();
+    if (!m_tagStack.empty()) m_tagStack.pop_back();
+    m_currentTag = StreamTag();
+    return;
+  }
   std::istream &is = *m_is;
   int level        = 1;
   int c;
@@ -844,6 +1344,17 @@ TIStream::TIStream(const TFilePath &fp) : m_imp(new Imp) {
     std::string magic(magicBuffer, 4);
     size_t in_len, out_len;
 
+    if (magic == c_binaryMagic) {
+      is->seekg(0, std::ios::end);
+      std::string buffer(size_t(is->tellg()), 0);
+      is->seekg(0);
+      if (!is->read(&buffer[0], buffer.size()))
+        throw TException("Corrupted file");
+
+      m_imp->m_binary.reset(new BinaryReader(buffer));
+      return;
+    }
+
     if (magic == "TNZC") {
       // Tab3.0 beta
       is->read((char *)&out_len, sizeof out_len);
@@ -924,6 +1435,12 @@ TIStream::~TIStream() {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(int &v) {
+  if (m_imp->m_binary) {
+    StreamValue value;
+    if (m_imp->readBinaryValue(value) && !value.toInt(v))
+      m_imp->m_failed = true;
+    return *this;
+  }
   *(m_imp->m_is) >> v;
   return *this;
 }
@@ -931,6 +1448,12 @@ TIStream &TIStream::operator>>(int &v) {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(double &v) {
+  if (m_imp->m_binary) {
+    StreamValue value;
+    if (m_imp->readBinaryValue(value) && !value.toDouble(v))
+      m_imp->m_failed = true;
+    return *this;
+  }
   *(m_imp->m_is) >> v;
   return *this;
 }
@@ -946,6 +1469,11 @@ TIStream &TIStream::operator>>(std::wstring &v) {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(std::string &v) {
+  if (m_imp->m_binary) {
+    StreamValue value;
+    v = m_imp->readBinaryValue(value) ? value.toString() : std::string();
+    return *this;
+  }
   std::istream &is = *(m_imp->m_is);
   v                = "";
   m_imp->skipBlanks();
@@ -986,6 +1514,13 @@ TIStream &TIStream::operator>>(std::string &v) {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(QString &v) {
+  if (m_imp->m_binary) {
+    StreamValue value;
+    v = m_imp->readBinaryValue(value)
+            ? QString::fromStdString(value.toString())
+            : QString();
+    return *this;
+  }
   std::istream &is = *(m_imp->m_is);
   v                = "";
   m_imp->skipBlanks();
@@ -1026,6 +1561,13 @@ TIStream &TIStream::operator>>(QString &v) {
 //---------------------------------------------------------------
 
 std::string TIStream::getString() {
+  if (m_imp->m_binary) {
+    std::string v;
+    StreamValue value;
+    while (!m_imp->m_currentTag && m_imp->m_binary->readValue(value))
+      v += (v.empty() ? "" : " ") + value.toString();
+    return v;
+  }
   std::istream &is = *(m_imp->m_is);
   std::string v    = "";
   m_imp->skipBlanks();
@@ -1042,6 +1584,12 @@ std::string TIStream::getString() {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(TPixel32 &v) {
+  if (m_imp->m_binary) {
+    int r = 0, g = 0, b = 0, m = 0;
+    *this >> r >> g >> b >> m;
+    v = TPixel32(r, g, b, m);
+    return *this;
+  }
   std::istream &is = *(m_imp->m_is);
   int r, g, b, m;
   is >> r;
@@ -1057,6 +1605,12 @@ TIStream &TIStream::operator>>(TPixel32 &v) {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(TPixel64 &v) {
+  if (m_imp->m_binary) {
+    int r = 0, g = 0, b = 0, m = 0;
+    *this >> r >> g >> b >> m;
+    v = TPixel64(r, g, b, m);
+    return *this;
+  }
   std::istream &is = *(m_imp->m_is);
   int r, g, b, m;
   is >> r;
@@ -1073,6 +1627,12 @@ TIStream &TIStream::operator>>(TPixel64 &v) {
 //---------------------------------------------------------------
 
 TIStream &TIStream::operator>>(TFilePath &v) {
+  if (m_imp->m_binary) {
+    std::string s;
+    *this >> s;
+    v = TFilePath(s);
+    return *this;
+  }
   std::istream &is = *(m_imp->m_is);
   std::string s;
   char c;
@@ -1171,6 +1731,8 @@ bool TIStream::matchEndTag() {
 bool TIStream::eos() {
   if (m_imp->matchTag())
     return m_imp->m_currentTag.m_type == StreamTag::EndTag;
+  else if (m_imp->m_binary)
+    return m_imp->m_binary->atEnd();
   else
     return !(*m_imp->m_is);
 }
@@ -1255,6 +1817,7 @@ void TIStream::closeChild() {
 //---------------------------------------------------------------
 
 bool TIStream::match(char c) const {
+  if (m_imp->m_binary) return false;
   m_imp->skipBlanks();
   if (m_imp->m_is->peek() != c) return false;
   m_imp->m_is->get(c);
@@ -1264,7 +1827,10 @@ bool TIStream::match(char c) const {
 
 //---------------------------------------------------------------
 
-TIStream::operator bool() const { return (m_imp->m_is && *m_imp->m_is); }
+TIStream::operator bool() const {
+  if (m_imp->m_binary) return !m_imp->m_failed;
+  return (m_imp->m_is && *m_imp->m_is);
+}
 
 //---------------------------------------------------------------
 
@@ -1288,6 +1854,68 @@ void TIStream::skipCurrentTag() { m_imp->skipCurrentTag(); }
 
 std::string TIStream::getCurrentTagName() { return m_imp->m_tagStack.back(); }
 
+//---------------------------------------------------------------
+
+bool TIStream::seekSection(std::string tagName) {
+  if (!m_imp->m_binary || m_imp->m_tagStack.empty() ||
+      !m_imp->m_binary->seekSection(tagName))
+    return false;
+
+  m_imp->m_tagStack.resize(1);
+  m_imp->m_currentTag = StreamTag();
+  return true;
+}
+
+//---------------------------------------------------------------
+
+void TIStream::copyTo(TOStream &os) {
+  for (;;) {
+    std::string tagName;
+    if (matchTag(tagName)) {
+      std::map<std::string, std::string> attributes =
+          m_imp->m_currentTag.m_attributes;
+      if (isBeginEndTag()) {
+        os.openCloseChild(tagName, attributes);
+        continue;
+      }
+
+      os.openChild(tagName, attributes);
+      copyTo(os);
+      if (!matchEndTag()) throw TException(tagName + " : missing end tag");
+      os.closeChild();
+      continue;
+    }
+    if (eos()) return;
+
+    StreamValue value;
+    if (m_imp->m_binary) {
+      if (!m_imp->readBinaryValue(value)) throw TException("expected value");
+    } else {
+      // Quoted text is always a string; bare text may be a number
+      m_imp->skipBlanks();
+      int c = m_imp->m_is->peek();
+      if (c == std::char_traits<char>::eof()) return;
+
+      if (c == '"') {
+        value.m_type = StreamValue::String;
+        *this >> value.m_string;
+      } else {
+        std::string text;
+        for (; c >= 0 && !isspace(c) && c != '<'; c = m_imp->m_is->peek())
+          text.append(1, (char)m_imp->getNextChar());
+        parseXmlValue(text, value);
+      }
+    }
+
+    if (value.m_type == StreamValue::Int)
+      os << value.m_int;
+    else if (value.m_type == StreamValue::Double)
+      os << value.m_double;
+    else
+      os << value.m_string;
+  }
+}
+
 //===============================================================
 // MOVE CONSTRUCTORS AND ASSIGNMENTS FOR TIStream
 //===============================================================
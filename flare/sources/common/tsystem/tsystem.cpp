@@ -26,11 +26,22 @@
 #include <QRegularExpression>
 #include <QDesktopServices>
 #include <QHostInfo>
+#include <QMutex>
+
+#include "tthread.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
 
 #ifdef _WIN32
 #include <shlobj.h>
 #include <shellapi.h>
 #include <winnt.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
 #endif
 
 namespace {
@@ -506,6 +517,241 @@ public:
   }
 };
 
+//------------------------------------------------------------
+
+namespace {
+
+//! An entry of a directory listing
+struct DirEntry {
+  QString m_name;
+  bool m_isDir, m_isHidden;
+};
+
+typedef std::vector<DirEntry> DirEntries;
+
+//------------------------------------------------------------
+
+/*!
+  Lists the files and folders in \b path in a single pass over the directory.
+  Entry types come from the listing itself - only links, and entries of file
+  systems not reporting types, need a stat(). Other kinds of entries, like
+  devices or pipes, are skipped. Returns false if the directory could not be
+  read.
+*/
+bool scanDirectory(const QString &path, DirEntries &entries) {
+#ifdef _WIN32
+  WIN32_FIND_DATA find_dir_data;
+  QString dir_search_path = QDir(path).absolutePath() + "\\*";
+  HANDLE hFind =
+      FindFirstFile((const wchar_t *)dir_search_path.utf16(), &find_dir_data);
+  if (hFind == INVALID_HANDLE_VALUE) return false;
+
+  do {
+    if (wcscmp(find_dir_data.cFileName, L".") == 0 ||
+        wcscmp(find_dir_data.cFileName, L"..") == 0)
+      continue;
+
+    DirEntry entry = {
+        QString::fromWCharArray(find_dir_data.cFileName),
+        (find_dir_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0,
+        (find_dir_data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0};
+    entries.push_back(entry);
+  } while (FindNextFile(hFind, &find_dir_data));
+  FindClose(hFind);
+#else
+  QByteArray encodedPath = QFile::encodeName(path);
+
+  DIR *dir = opendir(encodedPath.constData());
+  if (!dir) return false;
+
+  while (struct dirent *ent = readdir(dir)) {
+    const char *name = ent->d_name;
+    if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+      continue;
+
+    bool isDir;
+#ifdef DT_UNKNOWN
+    if (ent->d_type == DT_REG)
+      isDir = false;
+    else if (ent->d_type == DT_DIR)
+      isDir = true;
+    else if (ent->d_type != DT_LNK && ent->d_type != DT_UNKNOWN)
+      continue;
+    else
+#endif
+    {
+      struct stat st;
+      if (stat((encodedPath + '/' + name).constData(), &st) != 0) continue;
+      if (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode)) continue;
+
+      isDir = S_ISDIR(st.st_mode);
+    }
+
+    DirEntry entry = {QFile::decodeName(name), isDir, name[0] == '.'};
+    entries.push_back(entry);
+  }
+  closedir(dir);
+#endif
+
+  return true;
+}
+
+//------------------------------------------------------------
+
+/*!
+  Caches the listings of the last scanned directories, validated against the
+  modification time of the directory - which changes whenever entries are
+  added, removed or renamed. Checking it costs a single stat() per read.
+*/
+class DirectoryCache {
+  struct Listing {
+    QDateTime m_modified;
+    std::shared_ptr<const DirEntries> m_entries;
+    unsigned int m_lastUse;
+  };
+
+  QMutex m_mutex;
+  std::map<QString, Listing> m_listings;
+  unsigned int m_useCount;
+
+  enum { MaxListings = 32 };
+
+  //! Changes done within this time from the last modification could share
+  //! its timestamp, so such listings are not cached
+  enum { UnstableMsecs = 2000 };
+
+public:
+  DirectoryCache() : m_useCount(0) {}
+
+  static DirectoryCache *instance() {
+    static DirectoryCache theInstance;
+    return &theInstance;
+  }
+
+  //! Returns the entries of \b path, or 0 if it is not a directory.
+  std::shared_ptr<const DirEntries> entries(const QString &path) {
+    QFileInfo info(path);
+    if (!info.isDir()) return std::shared_ptr<const DirEntries>();
+
+    QDateTime modified = info.lastModified();
+    {
+      QMutexLocker locker(&m_mutex);
+
+      std::map<QString, Listing>::iterator lt = m_listings.find(path);
+      if (lt != m_listings.end() && lt->second.m_modified == modified) {
+        lt->second.m_lastUse = ++m_useCount;
+        return lt->second.m_entries;
+      }
+    }
+
+    // Unreadable directories are listed as empty
+    std::shared_ptr<DirEntries> entries(new DirEntries);
+    if (!scanDirectory(path, *entries) ||
+        modified.msecsTo(QDateTime::currentDateTime()) < UnstableMsecs)
+      return entries;
+
+    QMutexLocker locker(&m_mutex);
+
+    Listing listing = {modified, entries, ++m_useCount};
+    m_listings[path] = listing;
+
+    if (m_listings.size() > MaxListings) {
+      std::map<QString, Listing>::iterator lt, oldest = m_listings.begin();
+      for (lt = m_listings.begin(); lt != m_listings.end(); ++lt)
+        if (lt->second.m_lastUse < oldest->second.m_lastUse) oldest = lt;
+      m_listings.erase(oldest);
+    }
+
+    return entries;
+  }
+};
+
+//------------------------------------------------------------
+
+/*!
+  Returns the paths of the entries of directory \b path passing the filters,
+  throwing if \b path is not a directory.
+*/
+std::vector<TFilePath> listDirectory(const TFilePath &path, bool files,
+                                     bool dirs, bool hidden) {
+  std::shared_ptr<const DirEntries> entries(
+      DirectoryCache::instance()->entries(toQString(path)));
+  if (!entries) throw TSystemException(path, " is not a directory");
+
+  std::vector<const DirEntry *> filtered;
+  filtered.reserve(entries->size());
+  for (const DirEntry &entry : *entries)
+    if ((entry.m_isDir ? dirs : files) && (hidden || !entry.m_isHidden))
+      filtered.push_back(&entry);
+
+  // Parsing the paths is what takes time in large folders
+  std::vector<TFilePath> paths(filtered.size());
+  TThread::parallelFor(
+      int(filtered.size()),
+      [&](int begin, int end) {
+        for (int i = begin; i != end; ++i)
+          paths[i] = path + TFilePath(filtered[i]->m_name.toStdWString());
+      },
+      1024);
+
+  return paths;
+}
+
+//------------------------------------------------------------
+
+//! Replaces the frames of sequences in \b paths with their level path.
+void groupFrames(std::vector<TFilePath> &paths) {
+  TThread::parallelFor(
+      int(paths.size()),
+      [&paths](int begin, int end) {
+        for (int i = begin; i != end; ++i)
+          if (paths[i].getDots() == "..") paths[i] = paths[i].withFrame();
+      },
+      1024);
+}
+
+//------------------------------------------------------------
+
+/*!
+  Appends \b paths to \b dst, sorted by CaselessFilepathLess and without
+  duplicates - as inserting them in a std::set would, but comparing
+  precomputed lowercase keys.
+*/
+void appendSorted(TFilePathSet &dst, const std::vector<TFilePath> &paths) {
+  // CaselessFilepathLess orders by lowercase path, and then by path
+  struct Key {
+    std::wstring m_lower, m_path;
+    int m_index;
+
+    bool operator<(const Key &other) const {
+      int c = m_lower.compare(other.m_lower);
+      return c < 0 || (c == 0 && m_path < other.m_path);
+    }
+  };
+
+  std::vector<Key> keys(paths.size());
+  TThread::parallelFor(
+      int(paths.size()),
+      [&](int begin, int end) {
+        for (int i = begin; i != end; ++i) {
+          Key &key    = keys[i];
+          key.m_path  = paths[i].getWideString();
+          key.m_lower = key.m_path;
+          for (wchar_t &c : key.m_lower) c = towlower(c);
+          key.m_index = i;
+        }
+      },
+      1024);
+
+  std::stable_sort(keys.begin(), keys.end());
+
+  for (int k = 0; k != int(keys.size()); ++k)
+    if (k == 0 || keys[k - 1] < keys[k])
+      dst.push_back(paths[keys[k].m_index]);
+}
+
+}  // namespace
+
 //------------------------------------------------------------
 /*! return the folder path list which is readable and executable
  */
@@ -575,62 +821,67 @@ void TSystem::readDirectory_DirItems(QStringList &dst, const TFilePath &path) {
 }
 
 //------------------------------------------------------------
-/*! to retrieve the both lists with groupFrames option = on and off.
+/*! return the files of the sequence levelPath in its folder. Only the
+    entries starting with the level's name are parsed.
  */
-void TSystem::readDirectory(TFilePathSet &groupFpSet, TFilePathSet &allFpSet,
-                            const TFilePath &path) {
-  if (!TFileStatus(path).isDirectory())
-    throw TSystemException(path, " is not a directory");
+void TSystem::readDirectory_LevelFrames(TFilePathSet &dst,
+                                        const TFilePath &levelPath) {
+  TFilePath parentDir = levelPath.getParentDir();
 
-  std::set<TFilePath, CaselessFilepathLess> fileSet_group;
-  std::set<TFilePath, CaselessFilepathLess> fileSet_all;
+  std::shared_ptr<const DirEntries> entries(
+      DirectoryCache::instance()->entries(toQString(parentDir)));
+  if (!entries) throw TSystemException(parentDir, " is not a directory");
 
-  QStringList fil;
-#ifdef _WIN32
-  WIN32_FIND_DATA find_dir_data;
-  QString dir_search_path = QDir(toQString(path)).absolutePath() + "\\*";
-  auto addEntry           = [&]() {
-    // QDir::NoDotAndDotDot condition
-    if (wcscmp(find_dir_data.cFileName, L".") != 0 &&
-        wcscmp(find_dir_data.cFileName, L"..") != 0) {
-      // QDir::Files condition
-      if ((find_dir_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 &&
-          (find_dir_data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) == 0) {
-        fil.append(QString::fromWCharArray(find_dir_data.cFileName));
-      }
-    }
-  };
-  HANDLE hFind =
-      FindFirstFile((const wchar_t *)dir_search_path.utf16(), &find_dir_data);
-  if (hFind != INVALID_HANDLE_VALUE) {
-    do {
-      addEntry();
-    } while (FindNextFile(hFind, &find_dir_data));
-    FindClose(hFind);  // FIXED: Added FindClose
-  }
-#else
-  fil = QDir(toQString(path))
-            .entryList(QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
-#endif
+  QString name = QString::fromStdWString(levelPath.getWideName());
+  TFilePath levelName(levelPath.getLevelNameW());
+
+  std::vector<TFilePath> frames;
+  for (const DirEntry &entry : *entries) {
+    if (entry.m_isDir || !entry.m_name.startsWith(name, Qt::CaseInsensitive))
+      continue;
 
-  if (fil.empty()) return;
+    TFilePath fp(parentDir + TFilePath(entry.m_name.toStdWString()));
+    if (TFilePath(fp.getLevelNameW()) == levelName) frames.push_back(fp);
+  }
 
-  for (const QString &fi : fil) {
-    TFilePath son = path + TFilePath(fi.toStdWString());
+  appendSorted(dst, frames);
+}
 
-    // store all file paths
-    fileSet_all.insert(son);
+//------------------------------------------------------------
+/*! to retrieve the both lists with groupFrames option = on and off.
+ */
+void TSystem::readDirectory(TFilePathSet &groupFpSet, TFilePathSet &allFpSet,
+                            const TFilePath &path) {
+  std::vector<TFilePath> paths(listDirectory(path, true, false, false));
+
+#ifndef _WIN32
+  // As QDir::Readable: the access checks are the only per-file calls left,
+  // so they run in parallel - on network storage each one is a round trip
+  std::vector<char> readable(paths.size());
+  TThread::parallelFor(
+      int(paths.size()),
+      [&](int begin, int end) {
+        for (int i = begin; i != end; ++i)
+          readable[i] =
+              access(QFile::encodeName(toQString(paths[i])).constData(),
+                     R_OK) == 0;
+      },
+      256);
+
+  int count = 0;
+  for (int i = 0; i != int(paths.size()); ++i)
+    if (readable[i]) paths[count++] = paths[i];
+  paths.resize(count);
+#endif
 
-    // in case of the sequential files
-    if (son.getDots() == "..") son = son.withFrame();
+  if (paths.empty()) return;
 
-    // store the group. insertion avoids duplication of the item
-    fileSet_group.insert(son);
-  }
+  // store all file paths
+  appendSorted(allFpSet, paths);
 
-  groupFpSet.insert(groupFpSet.end(), fileSet_group.begin(),
-                    fileSet_group.end());
-  allFpSet.insert(allFpSet.end(), fileSet_all.begin(), fileSet_all.end());
+  // store the groups, once each
+  groupFrames(paths);
+  appendSorted(groupFpSet, paths);
 }
 
 //------------------------------------------------------------
@@ -728,14 +979,11 @@ void TSystem::readDirectory(TFilePathSet &dst, const QDir &dir,
 void TSystem::readDirectory(TFilePathSet &dst, const TFilePath &path,
                             bool groupFrames, bool onlyFiles,
                             bool getHiddenFiles) {
-  QDir dir(toQString(path));
-
-  QDir::Filters filters(QDir::Files);
-  if (!onlyFiles) filters |= QDir::Dirs;
-  if (getHiddenFiles) filters |= QDir::Hidden;
-  dir.setFilter(filters);
+  std::vector<TFilePath> paths(
+      listDirectory(path, true, !onlyFiles, getHiddenFiles));
+  if (groupFrames) ::groupFrames(paths);
 
-  readDirectory(dst, dir, groupFrames);
+  appendSorted(dst, paths);
 }
 
 //------------------------------------------------------------
@@ -743,8 +991,18 @@ void TSystem::readDirectory(TFilePathSet &dst, const TFilePath &path,
 void TSystem::readDirectory(TFilePathSet &dst, const TFilePathSet &pathSet,
                             bool groupFrames, bool onlyFiles,
                             bool getHiddenFiles) {
-  for (const auto &path : pathSet)
-    readDirectory(dst, path, groupFrames, onlyFiles, getHiddenFiles);
+  // Folders are scanned in parallel, which pays off on network storage
+  std::vector<TFilePath> paths(pathSet.begin(), pathSet.end());
+  std::vector<TFilePathSet> results(paths.size());
+
+  TThread::parallelFor(int(paths.size()), [&](int begin, int end) {
+    for (int i = begin; i != end; ++i)
+      readDirectory(results[i], paths[i], groupFrames, onlyFiles,
+                    getHiddenFiles);
+  });
+
+  for (const TFilePathSet &result : results)
+    dst.insert(dst.end(), result.begin(), result.end());
 }
 
 //------------------------------------------------------------
@@ -768,30 +1026,61 @@ TFilePathSet TSystem::readDirectory(const TFilePathSet &pathSet,
 
 //------------------------------------------------------------
 
+namespace {
+
+//! Appends the content of directory \b path to \b dst - each subfolder
+//! followed by its content, and then the files. Subfolders are read in
+//! parallel.
+void readTree(TFilePathSet &dst, const TFilePath &path, bool groupFrames,
+              bool onlyFiles) {
+  std::shared_ptr<const DirEntries> entries(
+      DirectoryCache::instance()->entries(toQString(path)));
+  if (!entries) return;
+
+  std::vector<const DirEntry *> dirs;
+  std::vector<TFilePath> files;
+  for (const DirEntry &entry : *entries) {
+    if (entry.m_isHidden) continue;
+
+    if (entry.m_isDir)
+      dirs.push_back(&entry);
+    else
+      files.push_back(path + TFilePath(entry.m_name.toStdWString()));
+  }
+
+  // Subfolders come in QDir's default order
+  std::sort(dirs.begin(), dirs.end(),
+            [](const DirEntry *a, const DirEntry *b) {
+              return a->m_name.compare(b->m_name, Qt::CaseInsensitive) < 0;
+            });
+
+  std::vector<TFilePathSet> subTrees(dirs.size());
+  TThread::parallelFor(int(dirs.size()), [&](int begin, int end) {
+    for (int i = begin; i != end; ++i)
+      readTree(subTrees[i], path + TFilePath(dirs[i]->m_name.toStdWString()),
+               groupFrames, onlyFiles);
+  });
+
+  for (int i = 0; i != int(dirs.size()); ++i) {
+    if (!onlyFiles)
+      dst.push_back(path + TFilePath(dirs[i]->m_name.toStdWString()));
+    dst.insert(dst.end(), subTrees[i].begin(), subTrees[i].end());
+  }
+
+  if (groupFrames) ::groupFrames(files);
+  appendSorted(dst, files);
+}
+
+}  // namespace
+
+//------------------------------------------------------------
+
 void TSystem::readDirectoryTree(TFilePathSet &dst, const TFilePath &path,
                                 bool groupFrames, bool onlyFiles) {
   if (!TFileStatus(path).isDirectory())
     throw TSystemException(path, " is not a directory");
 
-  std::set<TFilePath, CaselessFilepathLess> fpSet;
-
-  QFileInfoList fil = QDir(toQString(path)).entryInfoList();
-  for (const QFileInfo &fi : fil) {
-    if (fi.fileName() == QString(".") || fi.fileName() == QString(".."))
-      continue;
-    TFilePath son = TFilePath(fi.filePath().toStdWString());
-    if (TFileStatus(son).isDirectory()) {
-      if (!onlyFiles) dst.push_back(son);
-      readDirectoryTree(dst, son, groupFrames, onlyFiles);
-    } else {
-      if (groupFrames && son.getDots() == "..") {
-        son = son.withFrame();
-      }
-      fpSet.insert(son);
-    }
-  }
-
-  dst.insert(dst.end(), fpSet.begin(), fpSet.end());
+  readTree(dst, path, groupFrames, onlyFiles);
 }
 
 //------------------------------------------------------------
@@ -9,6 +9,7 @@
 #include "tcurveutil.h"
 #include "cornerdetector.h"
 
+#include <atomic>
 #include <limits>
 
 #include "tstroke.h"
@@ -726,7 +727,7 @@ private:
 //-----------------------------------------------------------------------------
 
 namespace {
-int maxStrokeId = 0;
+std::atomic<int> maxStrokeId(0);
 }
 
 /*! init() is required to initialize all variable
@@ -17,6 +17,8 @@
 #include "tcomputeregions.h"
 
 #include <memory>
+#include <algorithm>
+#include <functional>
 #include <QSet>
 
 //=============================================================================
@@ -43,6 +45,14 @@ inline bool isStrokeStyleEnabled__(int index) {
   return disabledSet.find(index) == disabledSet.end();
 }
 
+//! Returns the square distance between \b p and \b bbox, which is a lower
+//! bound for the distance between \b p and any point in the box.
+inline double bboxDistance2(const TRectD &bbox, const TPointD &p) {
+  double dx = std::max(0.0, std::max(bbox.x0 - p.x, p.x - bbox.x1));
+  double dy = std::max(0.0, std::max(bbox.y0 - p.y, p.y - bbox.y1));
+  return dx * dx + dy * dy;
+}
+
 }  // namespace
 
 //=============================================================================
@@ -654,16 +664,41 @@ bool TVectorImage::getNearestStroke(const TPointD &p, double &outW,
   strokeIndex = getStrokeCount();
   outW        = -1;
 
-  double tempdis2, tempPar;
+  // Strokes are examined by increasing distance of their bbox (which is
+  // cached in the stroke), so that the search stops as soon as the remaining
+  // bboxes are farther than the nearest stroke found
+  typedef std::pair<double, int> Candidate;
+
+  std::vector<Candidate> candidates;
+  candidates.reserve(m_imp->m_strokes.size());
 
   for (int i = 0; i < (int)m_imp->m_strokes.size(); ++i) {
     if (onlyInCurrentGroup && !inCurrentGroup(i)) continue;
     TStroke *s = m_imp->m_strokes[i]->m_s;
+    candidates.push_back(Candidate(bboxDistance2(s->getBBox(), p), i));
+  }
+
+  std::make_heap(candidates.begin(), candidates.end(),
+                 std::greater<Candidate>());
+
+  double tempdis2, tempPar;
+
+  while (!candidates.empty()) {
+    std::pop_heap(candidates.begin(), candidates.end(),
+                  std::greater<Candidate>());
+    Candidate candidate = candidates.back();
+    candidates.pop_back();
+
+    if (candidate.first > dist2) break;
+
+    int i      = candidate.second;
+    TStroke *s = m_imp->m_strokes[i]->m_s;
     tempPar    = s->getW(p);
 
     tempdis2 = tdistance2(TThickPoint(p, 0), s->getThickPoint(tempPar));
 
-    if (tempdis2 < dist2) {
+    // on ties, the first stroke wins - as in a plain scan
+    if (tempdis2 < dist2 || (tempdis2 == dist2 && i < (int)strokeIndex)) {
       outW        = tempPar;
       dist2       = tempdis2;
       strokeIndex = i;
@@ -716,13 +751,23 @@ TRegion *TVectorImage::getRegion(const TPointD &p) {
 //-----------------------------------------------------------------------------
 
 TRegion *TVectorImage::Imp::getRegion(const TPointD &p) {
+  // Only the regions whose bbox contains p need to be tested, in every group
+  std::vector<UINT> candidates;
+  for (UINT regionIndex = 0; regionIndex < m_regions.size(); regionIndex++)
+    if (m_regions[regionIndex]->getBBox().contains(p))
+      candidates.push_back(regionIndex);
+
+  if (candidates.empty()) return 0;
+
   int strokeIndex = (int)m_strokes.size() - 1;
 
   while (strokeIndex >= 0) {
-    for (UINT regionIndex = 0; regionIndex < m_regions.size(); regionIndex++)
+    for (UINT c = 0; c < candidates.size(); c++) {
+      UINT regionIndex = candidates[c];
       if (areDifferentGroup(strokeIndex, false, regionIndex, true) == -1 &&
           m_regions[regionIndex]->contains(p))
         return m_regions[regionIndex]->getRegion(p);
+    }
     int curr = strokeIndex;
     while (strokeIndex >= 0 &&
            areDifferentGroup(curr, false, strokeIndex, false) == -1)
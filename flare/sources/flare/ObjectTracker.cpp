@@ -13,7 +13,10 @@ Luigi Sgaglione
 #include <memory>
 
 #include "ObjectTracker.h"
+#include "tthread.h"
 #include <math.h>
+#include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fstream>
@@ -29,6 +32,71 @@ using namespace std;
 #define ITERACTION_THRESHOLD 0.4
 #define MAX_FLOAT 3.40282e+38;
 
+//---------------------------------------------------------------------------------------------------------
+// Frame data: the histogram index of all pixels, shared by all the objects
+// tracked in the frame - the trackers scan their regions many times per
+// frame
+CTrackerFrame::CTrackerFrame(const TRaster32P &raster, bool _colorimage)
+    : m_width(raster->getLx())
+    , m_height(raster->getLy())
+    , m_colorimage(_colorimage)
+    , m_indices(new unsigned short[raster->getLx() * raster->getLy()]) {
+  raster->lock();
+
+  // gray value of the pixels of row y (0 outside the image)
+  auto grayRow = [&](short y, short *gray) {
+    if (y < 0 || y > m_height - 1) {
+      std::fill(gray, gray + m_width, 0);
+      return;
+    }
+    const TPixel32 *pix = raster->pixels(m_height - 1 - y);
+    for (short x = 0; x < m_width; x++, pix++)
+      gray[x] = short(3 * pix->r + 6 * pix->g + pix->b);
+  };
+
+  TThread::parallelFor(
+      m_height,
+      [&](int begin, int end) {
+        std::unique_ptr<short[]> buffer(new short[3 * m_width]);
+        short *up = buffer.get(), *center = up + m_width,
+              *down = center + m_width;
+
+        for (short y = begin; y < end; y++) {
+          grayRow(y - 1, up);
+          grayRow(y, center);
+          grayRow(y + 1, down);
+
+          const TPixel32 *pix    = raster->pixels(m_height - 1 - y);
+          unsigned short *indice = m_indices.get() + y * m_width;
+
+          for (short x = 0; x < m_width; x++, pix++, indice++) {
+            // edge information, as 0 outside the image
+            short GrayCenter = center[x];
+            short GrayLeft   = (x > 0) ? center[x - 1] : 0;
+            short GrayRight  = (x < m_width - 1) ? center[x + 1] : 0;
+
+            UBYTE8 E = 0;
+            if ((abs((GrayCenter - GrayLeft) / 10) > EDGE_DETECT_THRESHOLD) ||
+                (abs((GrayCenter - GrayRight) / 10) > EDGE_DETECT_THRESHOLD) ||
+                (abs((GrayCenter - up[x]) / 10) > EDGE_DETECT_THRESHOLD) ||
+                (abs((GrayCenter - down[x]) / 10) > EDGE_DETECT_THRESHOLD))
+              E = 1;
+
+            // components RGB "quantizzate"
+            if (!m_colorimage)
+              *indice = 256 * E + pix->r;
+            else
+              *indice =
+                  4096 * E + 256 * (pix->r / 16) + 16 * (pix->g / 16) +
+                  pix->b / 16;
+          }
+        }
+      },
+      16);
+
+  raster->unlock();
+}
+
 //---------------------------------------------------------------------------------------------------------
 // Constructor
 CObjectTracker::CObjectTracker(int imW, int imH, bool _colorimage,
@@ -144,7 +212,7 @@ void CObjectTracker::updateTemp() {
 }
 //--------------------------------------------------------------------------------------------------------
 // Object Tracking
-void CObjectTracker::ObjeckTrackerHandlerByUser(TRaster32P *frame) {
+void CObjectTracker::ObjeckTrackerHandlerByUser(const CTrackerFrame &frame) {
   if (m_sTrackingObject.Status) {
     if (!m_sTrackingObject.assignedAnObject) {
       FindHistogram(frame, m_sTrackingObject.initHistogram.get(), 1);
@@ -190,18 +258,17 @@ void CObjectTracker::ObjeckTrackerHandlerByUser(TRaster32P *frame) {
 
 //--------------------------------------------------------------------------------------------------------
 // histogram object
-void CObjectTracker::FindHistogram(TRaster32P *frame, float(*histogram),
-                                   float h) {
+void CObjectTracker::FindHistogram(const CTrackerFrame &frame,
+                                   float(*histogram), float h) {
   short normx = 0, normy = 0;
   float normc = 0.0, normc1 = 0.0;
-  short i   = 0;
-  short x   = 0;
-  short y   = 0;
-  UBYTE8 E  = 0;
-  UBYTE8 qR = 0, qG = 0, qB = 0;
-  ValuePixel pixelValues;
+  short i    = 0;
+  short x    = 0;
+  short y    = 0;
   int indice = 0;
 
+  assert(frame.IsColorImage() == colorimage);
+
   for (i = 0; i < HISTOGRAM_LENGTH; i++) histogram[i] = 0.0;
 
   if ((colorimage) && (att_background)) FindWeightsBackground(frame);
@@ -218,19 +285,7 @@ void CObjectTracker::FindHistogram(TRaster32P *frame, float(*histogram),
          x <= std::min(m_sTrackingObject.X + m_sTrackingObject.W / 2,
                        m_nImageWidth - 1);
          x++) {
-      E = CheckEdgeExistence(frame, x, y);
-
-      pixelValues = GetPixelValues(frame, x, y);
-
-      // components RGB "quantizzate"
-      if (!colorimage) {
-        indice = 256 * E + pixelValues.r;
-      } else {
-        qR     = pixelValues.r / 16;
-        qG     = pixelValues.g / 16;
-        qB     = pixelValues.b / 16;
-        indice = 4096 * E + 256 * qR + 16 * qG + qB;
-      }
+      indice = frame.GetIndex(x, y);
 
       histogram[indice] += 1 -
                            (((m_sTrackingObject.X - x) / normx) *
@@ -264,14 +319,11 @@ void CObjectTracker::FindHistogram(TRaster32P *frame, float(*histogram),
 
 //--------------------------------------------------------------------------------------------------------
 // Histogram background
-void CObjectTracker::FindHistogramBackground(TRaster32P *frame,
+void CObjectTracker::FindHistogramBackground(const CTrackerFrame &frame,
                                              float(*background)) {
-  short i   = 0;
-  short x   = 0;
-  short y   = 0;
-  UBYTE8 E  = 0;
-  UBYTE8 qR = 0, qG = 0, qB = 0;
-  ValuePixel pixelValues;
+  short i    = 0;
+  short x    = 0;
+  short y    = 0;
   UINT32 pix = 0;
 
   for (i = 0; i < HISTOGRAM_LENGTH; i++) background[i] = 0.0;
@@ -292,16 +344,7 @@ void CObjectTracker::FindHistogramBackground(TRaster32P *frame,
           (x <= (m_sTrackingObject.X + m_sTrackingObject.W / 2)))
         continue;
 
-      E = CheckEdgeExistence(frame, x, y);
-
-      pixelValues = GetPixelValues(frame, x, y);
-
-      // components RGB "quantizzate"
-      qR = pixelValues.r / 16;
-      qG = pixelValues.g / 16;
-      qB = pixelValues.b / 16;
-
-      background[4096 * E + 256 * qR + 16 * qG + qB] += 1;
+      background[frame.GetIndex(x, y)] += 1;
       pix++;
     }
 
@@ -310,7 +353,7 @@ void CObjectTracker::FindHistogramBackground(TRaster32P *frame,
 }
 //--------------------------------------------------------------------------------------------------------
 // Weights Background
-void CObjectTracker::FindWeightsBackground(TRaster32P *frame) {
+void CObjectTracker::FindWeightsBackground(const CTrackerFrame &frame) {
   float small1;
   std::unique_ptr<float[]> background(new float[HISTOGRAM_LENGTH]);
   short i;
@@ -339,17 +382,15 @@ void CObjectTracker::FindWeightsBackground(TRaster32P *frame) {
 
 //--------------------------------------------------------------------------------------------------------
 // new location
-void CObjectTracker::FindWightsAndCOM(TRaster32P *frame, float(*histogram)) {
+void CObjectTracker::FindWightsAndCOM(const CTrackerFrame &frame,
+                                      float(*histogram)) {
   short i            = 0;
   short x            = 0;
   short y            = 0;
-  UBYTE8 E           = 0;
   float sumOfWeights = 0;
   short ptr          = 0;
-  UBYTE8 qR = 0, qG = 0, qB = 0;
-  float newX = 0.0;
-  float newY = 0.0;
-  ValuePixel pixelValues;
+  float newX         = 0.0;
+  float newY         = 0.0;
 
   std::unique_ptr<float[]> weights(new float[HISTOGRAM_LENGTH]);
 
@@ -370,19 +411,7 @@ void CObjectTracker::FindWightsAndCOM(TRaster32P *frame, float(*histogram)) {
          x <= std::min(m_sTrackingObject.X + m_sTrackingObject.W / 2,
                        m_nImageWidth - 1);
          x++) {
-      E = CheckEdgeExistence(frame, x, y);
-
-      pixelValues = GetPixelValues(frame, x, y);
-
-      if (!colorimage) {
-        ptr = 256 * E + pixelValues.r;
-      } else {
-        qR = pixelValues.r / 16;
-        qG = pixelValues.g / 16;
-        qB = pixelValues.b / 16;
-
-        ptr = 4096 * E + 256 * qR + 16 * qG + qB;
-      }
+      ptr = frame.GetIndex(x, y);
 
       newX += (weights[ptr] * x);
       newY += (weights[ptr] * y);
@@ -396,59 +425,9 @@ void CObjectTracker::FindWightsAndCOM(TRaster32P *frame, float(*histogram)) {
   }
 }
 
-//--------------------------------------------------------------------------------------------------------
-// Edge Information of pixel
-UBYTE8 CObjectTracker::CheckEdgeExistence(TRaster32P *frame, short _x,
-                                          short _y) {
-  UBYTE8 E         = 0;
-  short GrayCenter = 0;
-  short GrayLeft   = 0;
-  short GrayRight  = 0;
-  short GrayUp     = 0;
-  short GrayDown   = 0;
-  ValuePixel pixelValues;
-
-  pixelValues = GetPixelValues(frame, _x, _y);
-
-  GrayCenter = short(3 * pixelValues.r + 6 * pixelValues.g + pixelValues.b);
-  if (_x > 0) {
-    pixelValues = GetPixelValues(frame, _x - 1, _y);
-
-    GrayLeft = short(3 * pixelValues.r + 6 * pixelValues.g + pixelValues.b);
-  }
-
-  if (_x < (m_nImageWidth - 1)) {
-    pixelValues = GetPixelValues(frame, _x + 1, _y);
-
-    GrayRight = short(3 * pixelValues.r + 6 * pixelValues.g + pixelValues.b);
-  }
-
-  if (_y > 0) {
-    pixelValues = GetPixelValues(frame, _x, _y - 1);
-
-    GrayUp = short(3 * pixelValues.r + 6 * pixelValues.g + pixelValues.b);
-  }
-
-  if (_y < (m_nImageHeight - 1)) {
-    pixelValues = GetPixelValues(frame, _x, _y + 1);
-
-    GrayDown = short(3 * pixelValues.r + 6 * pixelValues.g + pixelValues.b);
-  }
-
-  if (abs((GrayCenter - GrayLeft) / 10) > EDGE_DETECT_THRESHOLD) E = 1;
-
-  if (abs((GrayCenter - GrayRight) / 10) > EDGE_DETECT_THRESHOLD) E = 1;
-
-  if (abs((GrayCenter - GrayUp) / 10) > EDGE_DETECT_THRESHOLD) E = 1;
-
-  if (abs((GrayCenter - GrayDown) / 10) > EDGE_DETECT_THRESHOLD) E = 1;
-
-  return (E);
-}
-
 //--------------------------------------------------------------------------------------------------------
 // Mean-shift
-void CObjectTracker::FindNextLocation(TRaster32P *frame) {
+void CObjectTracker::FindNextLocation(const CTrackerFrame &frame) {
   short i         = 0;
   short iteration = 0;
   short xold      = 0;
@@ -822,57 +801,97 @@ float CObjectTracker::Matching(TRaster32P *frame, TRaster32P *frame_temp) {
       else
         v_max--;
 
-    unsigned long indt, indc;
-
-    std::unique_ptr<float[]> mat_dist(
-        new float[(2 * ok_u - 1) * (2 * ok_v - 1)]);
-    float att_dist_cent = MAX_FLOAT;
-    float dist_cent;
-
-    // Distance
-    for (u = 2 * u_min; u <= 2 * u_max; u++) {
-      for (v = 2 * v_min; v <= 2 * v_max; v++) {
-        dist = 0.0;
-        //
-        for (x = 0; x < dimx_int; x++)
-          for (y = 0; y < dimy_int; y++) {
-            // T(x,y)
-
-            indt = x * dimy_int + y;
-
-            // L(x+u,y+v)
-
-            indc =
-                ((x + (u - 2 * u_min))) * dimy_int_ric + (y + (v - 2 * v_min));
-
-            dist += (pixel_temp[indt].r - area_ricerca[indc].r) *
-                        (pixel_temp[indt].r - area_ricerca[indc].r) +
-                    (pixel_temp[indt].g - area_ricerca[indc].g) *
-                        (pixel_temp[indt].g - area_ricerca[indc].g) +
-                    (pixel_temp[indt].b - area_ricerca[indc].b) *
-                        (pixel_temp[indt].b - area_ricerca[indc].b);
-          }
-        dist = sqrt(dist) / (sqrt(float(dimx_int * dimy_int * 3 * 255 * 255)));
-
-        mat_dist[(u - 2 * u_min) * (2 * ok_v - 1) + (v - 2 * v_min)] = dist;
+    // planar copies of the interpolated areas, so that the distances are
+    // computed on contiguous columns
+    int size_temp = dimx_int * dimy_int, size_ric = dimx_int_ric * dimy_int_ric;
+    std::unique_ptr<short[]> planes(new short[3 * (size_temp + size_ric)]);
+    short *temp[3] = {planes.get(), planes.get() + size_temp,
+                      planes.get() + 2 * size_temp};
+    short *ric[3]  = {temp[2] + size_temp, temp[2] + size_temp + size_ric,
+                     temp[2] + size_temp + 2 * size_ric};
+
+    for (int i = 0; i < size_temp; i++) {
+      temp[0][i] = pixel_temp[i].r;
+      temp[1][i] = pixel_temp[i].g;
+      temp[2][i] = pixel_temp[i].b;
+    }
+    for (int i = 0; i < size_ric; i++) {
+      ric[0][i] = area_ricerca[i].r;
+      ric[1][i] = area_ricerca[i].g;
+      ric[2][i] = area_ricerca[i].b;
+    }
 
-        if (dist < min_dist) {
-          min_dist      = dist;
-          u_sup         = u;
-          v_sup         = v;
-          att_dist_cent = sqrt(float(u * u + v * v));
+    // Squared distance T(x,y) - L(x+u,y+v), computed exactly on integers.
+    // The sum stops as soon as it exceeds maxDist2
+    auto distance2 = [&](short u, short v, long long maxDist2) {
+      long long dist2 = 0;
+      for (x = 0; x < dimx_int && dist2 <= maxDist2; x++) {
+        int column = 0;
+        for (int c = 0; c < 3; c++) {
+          const short *t = temp[c] + x * dimy_int;
+          const short *l =
+              ric[c] + (x + (u - 2 * u_min)) * dimy_int_ric + (v - 2 * v_min);
+          for (y = 0; y < dimy_int; y++)
+            column += (t[y] - l[y]) * (t[y] - l[y]);
         }
+        dist2 += column;
+      }
+      return dist2;
+    };
 
-        else if (dist == min_dist) {
-          dist_cent = sqrt(float(u * u + v * v));
-          if (dist_cent < att_dist_cent) {
-            min_dist      = dist;
-            u_sup         = u;
-            v_sup         = v;
-            att_dist_cent = dist_cent;
-          }
-        }
+    // (in floats: the int product overflows on regions wider than ~50 pixels)
+    const float normDist = sqrt(float(dimx_int * dimy_int) * 3 * 255 * 255);
+
+    // distances of the positions that were not computed in full are < 0
+    std::unique_ptr<float[]> mat_dist(
+        new float[(2 * ok_u - 1) * (2 * ok_v - 1)]);
+    long long min_dist2 = LLONG_MAX;
+    int min_cent2       = INT_MAX;
+
+    // Distance. The position with minimum distance wins, then the closest to
+    // the center, then the first in (u, v) order
+    auto evaluate = [&](short u, short v) {
+      long long dist2 = distance2(u, v, min_dist2);
+
+      float &mat =
+          mat_dist[(u - 2 * u_min) * (2 * ok_v - 1) + (v - 2 * v_min)];
+      if (dist2 > min_dist2) {
+        mat = -1;
+        return;
+      }
+      mat = sqrt(float(dist2)) / normDist;
+
+      int cent2 = u * u + v * v;
+      if (dist2 < min_dist2 || cent2 < min_cent2 ||
+          (cent2 == min_cent2 && (u < u_sup || (u == u_sup && v < v_sup)))) {
+        min_dist2 = dist2;
+        min_cent2 = cent2;
+        min_dist  = mat;
+        u_sup     = u;
+        v_sup     = v;
       }
+    };
+
+    // starting from the old position, which usually is close to the best one,
+    // lets most of the other distances stop early
+    short u_start = std::min<short>(std::max<short>(0, 2 * u_min), 2 * u_max);
+    short v_start = std::min<short>(std::max<short>(0, 2 * v_min), 2 * v_max);
+    evaluate(u_start, v_start);
+
+    for (u = 2 * u_min; u <= 2 * u_max; u++)
+      for (v = 2 * v_min; v <= 2 * v_max; v++)
+        if (u != u_start || v != v_start) evaluate(u, v);
+
+    // complete the distances around the minimum, used for the half pixel
+    if (min_dist2 != LLONG_MAX) {
+      for (u = std::max(u_sup - 1, 2 * u_min);
+           u <= std::min(u_sup + 1, 2 * u_max); u++)
+        for (v = std::max(v_sup - 1, 2 * v_min);
+             v <= std::min(v_sup + 1, 2 * v_max); v++) {
+          float &mat =
+              mat_dist[(u - 2 * u_min) * (2 * ok_v - 1) + (v - 2 * v_min)];
+          if (mat < 0) mat = sqrt(float(distance2(u, v, LLONG_MAX))) / normDist;
+        }
     }
 
     if (!man_occlusion) {
@@ -26,6 +26,26 @@ struct NEIGHBOUR {
   short X_old, Y_old;
 };
 
+// frame data shared by the trackers of all objects
+class CTrackerFrame {
+public:
+  // computes the histogram index of each pixel (edge flag + quantized color)
+  CTrackerFrame(const TRaster32P &raster, bool _colorimage);
+
+  bool IsColorImage() const { return m_colorimage; }
+
+  // histogram index of pixel (x, y) - y goes downwards, as in the trackers
+  unsigned short GetIndex(short x, short y) const {
+    return m_indices[y * m_width + x];
+  }
+
+private:
+  short m_width;
+  short m_height;
+  bool m_colorimage;
+  std::unique_ptr<unsigned short[]> m_indices;
+};
+
 class CObjectTracker {
 public:
   short objID;
@@ -82,19 +102,17 @@ private:
 
   //--------------------------------------------------------------------------------------------------------
 
-  void FindHistogram(TRaster32P *frame, float(*histogram), float h);
-  //--------------------------------------------------------------------------------------------------------
-
-  void FindHistogramBackground(TRaster32P *frame, float(*background));
+  void FindHistogram(const CTrackerFrame &frame, float(*histogram), float h);
   //--------------------------------------------------------------------------------------------------------
 
-  void FindWeightsBackground(TRaster32P *frame);
+  void FindHistogramBackground(const CTrackerFrame &frame,
+                               float(*background));
   //--------------------------------------------------------------------------------------------------------
 
-  void FindWightsAndCOM(TRaster32P *frame, float(*histogram));
+  void FindWeightsBackground(const CTrackerFrame &frame);
   //--------------------------------------------------------------------------------------------------------
 
-  UBYTE8 CheckEdgeExistence(TRaster32P *frame, short _x, short _y);
+  void FindWightsAndCOM(const CTrackerFrame &frame, float(*histogram));
   //--------------------------------------------------------------------------------------------------------
 
   void UpdateInitialHistogram(float(*histogram));
@@ -114,10 +132,10 @@ public:
   virtual ~CObjectTracker();
   //--------------------------------------------------------------------------------------------------------
 
-  void FindNextLocation(TRaster32P *frame);
+  void FindNextLocation(const CTrackerFrame &frame);
   //--------------------------------------------------------------------------------------------------------
 
-  void ObjeckTrackerHandlerByUser(TRaster32P *frame);
+  void ObjeckTrackerHandlerByUser(const CTrackerFrame &frame);
   //--------------------------------------------------------------------------------------------------------
 
   void ObjectTrackerInitObjectParameters(short id, short x, short y,
@@ -21,8 +21,10 @@
 #include "flare/txshsimplelevel.h"
 #include "flare/txshlevelhandle.h"
 #include "flare/txshcell.h"
+#include "flare/txshsoundlevel.h"
 #include "flare/sceneproperties.h"
 #include "tsound_io.h"
+#include "tsoundpeaks.h"
 #include "toutputproperties.h"
 #include "flare/tproject.h"
 #include "thirdparty.h"
@@ -789,6 +791,10 @@ bool AutoLipSyncPopup::setAudioFile() {
 
   int level = m_soundLevels->currentData().toInt();
   if (level >= 0) {
+    if (isSoundColumnSilent(level)) {
+      DVGui::warning(tr("The sound column is silent."));
+      return false;
+    }
     saveAudio();
     m_deleteFile = true;
   } else {
@@ -807,6 +813,38 @@ bool AutoLipSyncPopup::setAudioFile() {
   return true;
 }
 
+//-----------------------------------------------------------------------------
+
+//! Whether the cells of the sound column \b col hold only digital silence,
+//! read from the peak indices of its levels: there is nothing to export and
+//! analyze then.
+bool AutoLipSyncPopup::isSoundColumnSilent(int col) const {
+  TXsheet *xsh = TApp::instance()->getCurrentXsheet()->getXsheet();
+
+  int r0, r1;
+  xsh->getCellRange(col, r0, r1);
+  for (int r = r0; r <= r1; ++r) {
+    TXshCell cell         = xsh->getCell(r, col);
+    TXshSoundLevel *level = cell.getSoundLevel();
+    if (!level) continue;
+
+    level->waitForPeaks();
+    std::shared_ptr<const TSoundPeaks> peaks = level->getPeaks();
+    if (!peaks) return false;  // The index could not be built
+
+    double samplePerFrame = peaks->getSampleRate() / level->getFrameRate();
+    int frame             = cell.getFrameId().getNumber();
+    TINT32 s0             = TINT32(frame * samplePerFrame);
+    TINT32 s1             = TINT32((frame + 1) * samplePerFrame) - 1;
+
+    double min = 0.0, max = 0.0;
+    peaks->getMinMaxPressure(s0, s1, min, max);
+    if (max > min) return false;
+  }
+
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 void AutoLipSyncPopup::saveAudio() {
   QString cacheRoot = FlareFolder::getCacheRootFolder().getQString();
@@ -112,6 +112,7 @@ protected:
   void updateThumbnail(int index);
 
   // Audio processing
+  bool isSoundColumnSilent(int col) const;
   void saveAudio();
   void runRhubarb();
 
@@ -333,9 +333,12 @@ void BatchesController::addComposerTask(const TFilePath &_taskFilePath) {
   } catch (TException &) {
   }
 
+  // Only the output settings and the frame count are needed
   ToonzScene scene;
+  int sceneFrameCount;
   try {
-    scene.loadNoResources(taskFilePath);
+    scene.loadProperties(taskFilePath);
+    sceneFrameCount = scene.loadFrameCount(taskFilePath);
   } catch (...) {
     return;
   }
@@ -348,7 +351,6 @@ void BatchesController::addComposerTask(const TFilePath &_taskFilePath) {
   int r0, r1, step;
   out.getRange(r0, r1, step);
 
-  int sceneFrameCount = scene.getFrameCount();
   if (r0 < 0) r0 = 0;
   if (r1 >= sceneFrameCount)
     r1 = sceneFrameCount - 1;
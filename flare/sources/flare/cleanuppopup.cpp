@@ -876,7 +876,7 @@ void CleanupPopup::execute() {
 
 QString CleanupPopup::setupLevel() {
   // Level's pre-cleanup stuff initialization.
-  // Invoked right before the cleanupFrame() of the first level frame.
+  // Invoked right before the cleanupFrames() of the first level frame.
 
   assert(isValidPosition(m_idx));
 
@@ -1189,121 +1189,112 @@ void CleanupPopup::closeLevel() {
 }
 
 //-----------------------------------------------------------------------------
-/*-- 各フレームの処理 --*/
-void CleanupPopup::cleanupFrame() {
-  assert(isValidPosition(m_idx));
+/*-- 各フレームの読み込み --*/
+bool CleanupPopup::readFrame(int level, int frame,
+                             BatchCleanupper::Frame &out) {
+  if (!isValidPosition(std::make_pair(level, frame))) return false;
 
-  TRasterImageP original(currentImage());
-  if (!original) return;
-
-  CleanupLevel &cl    = m_cleanupLevels[m_idx.first];
+  CleanupLevel &cl    = m_cleanupLevels[level];
   TXshSimpleLevel *sl = cl.m_sl;
-  const TFrameId &fid = cl.m_frames[m_idx.second];
-
   assert(sl);
 
-  // Perform image cleanup
-  {
-    TCleanupper *cl                 = TCleanupper::instance();
-    const CleanupParameters *params = cl->getParameters();
-
-    // Obtain the source dpi. Changed it to be done once at the first frame of
-    // each level in order to avoid the following problem:
-    // If the original raster level has no dpi (such as TGA images), obtaining
-    // dpi in every frame causes dpi mismatch between the first frame and the
-    // following frames, since the value
-    // TXshSimpleLevel::m_properties->getDpi() will be changed to the
-    // dpi of cleanup camera (= TLV's dpi) after finishing the first frame.
-    if (m_firstLevelFrame) {
-      TPointD dpi;
-      original->getDpi(dpi.x, dpi.y);
-      if (dpi.x == 0 && dpi.y == 0) dpi = sl->getProperties()->getDpi();
-      cl->setSourceDpi(dpi);
-    }
+  TCleanupper *cleanupper = TCleanupper::instance();
 
-    if (params->m_lineProcessingMode == lpNone) {
-      // No line processing
+  // if lines are not processed, obtain the original sampled image
+  bool toBeLineProcessed =
+      cleanupper->getParameters()->m_lineProcessingMode != lpNone;
+
+  out.m_fid   = cl.m_frames[frame];
+  out.m_image = sl->getFrameToCleanup(out.m_fid, toBeLineProcessed);
+  out.m_first = m_firstLevelFrame;
+
+  // Obtain the source dpi. Changed it to be done once at the first frame of
+  // each level in order to avoid the following problem:
+  // If the original raster level has no dpi (such as TGA images), obtaining
+  // dpi in every frame causes dpi mismatch between the first frame and the
+  // following frames, since the value
+  // TXshSimpleLevel::m_properties->getDpi() will be changed to the
+  // dpi of cleanup camera (= TLV's dpi) after finishing the first frame.
+  if (m_firstLevelFrame && out.m_image) {
+    TPointD dpi;
+    out.m_image->getDpi(dpi.x, dpi.y);
+    if (dpi.x == 0 && dpi.y == 0) dpi = sl->getProperties()->getDpi();
+    cleanupper->setSourceDpi(dpi);
+  }
 
-      TRasterImageP ri(original);
-      /*if (params->m_autocenterType != CleanupTypes::AUTOCENTER_NONE) {
-        bool autocentered;
-        ri = cl->autocenterOnly(original, false, autocentered);
-        if (!autocentered)
-          DVGui::warning(
-              QObject::tr("The autocentering failed on the current drawing."));
-      }*/
-      cl->process(original, false, ri, false, true, true, nullptr,
-                  ri->getRaster());
+  return true;
+}
 
-      if (TRaster32P(ri->getRaster())) sl->setFrame(fid, ri);
+//-----------------------------------------------------------------------------
+/*-- 各フレームの処理結果を保存 --*/
+void CleanupPopup::commitFrame(BatchCleanupper::Result &result) {
+  assert(isValidPosition(m_idx));
 
-      // Update the associated file. In case the operation throws, oh well the
-      // image gets skipped.
-      try {
-        m_updater->update(fid, ri);
-      } catch (...) {
-      }
+  CleanupLevel &cl    = m_cleanupLevels[m_idx.first];
+  TXshSimpleLevel *sl = cl.m_sl;
+  const TFrameId &fid = result.m_fid;
 
-      IconGenerator::instance()->invalidate(sl, fid);
-    } else {
-      // Perform main processing
+  assert(sl);
+  assert(fid == cl.m_frames[m_idx.second]);
 
-      CleanupPreprocessedImage *cpi;
-      {
-        TRasterImageP resampledRaster;
-        cpi = cl->process(original, m_firstLevelFrame, resampledRaster);
-      }
+  const CleanupParameters *params = TCleanupper::instance()->getParameters();
 
-      if (!cpi) return;
+  if (TRasterImageP ri = result.m_rasterImage) {
+    // No line processing
 
-      // Perform post-processing
-      TToonzImageP ti(cl->finalize(cpi));
+    if (TRaster32P(ri->getRaster())) sl->setFrame(fid, ri);
 
-      /*--- Cleanup Default Paletteを作成、適用 ---*/
-      if (m_firstLevelFrame) {
-        addCleanupDefaultPalette(sl);
-        sl->getPalette()->setPaletteName(sl->getName());
-      }
+    // Update the associated file. In case the operation throws, oh well the
+    // image gets skipped.
+    try {
+      m_updater->update(fid, ri);
+    } catch (...) {
+    }
 
-      ti->setPalette(sl->getPalette());  // Assigned to sl in setupLevel()
-      assert(sl->getPalette());
+    IconGenerator::instance()->invalidate(sl, fid);
+  } else if (TToonzImageP ti = result.m_toonzImage) {
+    /*--- Cleanup Default Paletteを作成、適用 ---*/
+    if (m_firstLevelFrame) {
+      addCleanupDefaultPalette(sl);
+      sl->getPalette()->setPaletteName(sl->getName());
+    }
 
-      // Update the level data about the cleanupped frame
-      sl->setFrameStatus(fid,
-                         sl->getFrameStatus(fid) | TXshSimpleLevel::Cleanupped);
+    ti->setPalette(sl->getPalette());  // Assigned to sl in setupLevel()
+    assert(sl->getPalette());
 
-      // sl->setFrame(fid, TImageP());  // Invalidate the old image data
-      sl->setFrame(fid, ti);  // replace with the new image data
+    // Update the level data about the cleanupped frame
+    sl->setFrameStatus(fid,
+                       sl->getFrameStatus(fid) | TXshSimpleLevel::Cleanupped);
 
-      // Output the cleanupped image to disk
-      try {
-        m_updater->update(fid, ti);
-      }  // The file image data will be reloaded upon request
-      catch (...) {
-      }
+    // sl->setFrame(fid, TImageP());  // Invalidate the old image data
+    sl->setFrame(fid, ti);  // replace with the new image data
 
-      // Invalidate icons
-      IconGenerator::instance()->invalidate(sl, fid);
+    // Output the cleanupped image to disk
+    try {
+      m_updater->update(fid, ti);
+    }  // The file image data will be reloaded upon request
+    catch (...) {
+    }
 
-      int autocenterType = params->m_autocenterType;
-      if (autocenterType == CleanupTypes::AUTOCENTER_FDG &&
-          !cpi->m_autocentered)
-        DVGui::warning(
-            QObject::tr("The autocentering failed on the current drawing."));
+    // Invalidate icons
+    IconGenerator::instance()->invalidate(sl, fid);
 
-      delete cpi;
+    int autocenterType = params->m_autocenterType;
+    if (autocenterType == CleanupTypes::AUTOCENTER_FDG && !result.m_autocentered)
+      DVGui::warning(
+          QObject::tr("The autocentering failed on the current drawing."));
 
-      if (m_firstLevelFrame) {
-        // Update result-dependent level data
-        TPointD dpi(0, 0);
-        ti->getDpi(dpi.x, dpi.y);
-        if (dpi.x != 0 && dpi.y != 0) sl->getProperties()->setDpi(dpi);
+    if (m_firstLevelFrame) {
+      // Update result-dependent level data
+      TPointD dpi(0, 0);
+      ti->getDpi(dpi.x, dpi.y);
+      if (dpi.x != 0 && dpi.y != 0) sl->getProperties()->setDpi(dpi);
 
-        sl->getProperties()->setImageRes(ti->getSize());
-        sl->getProperties()->setBpp(32);
-      }
+      sl->getProperties()->setImageRes(ti->getSize());
+      sl->getProperties()->setBpp(32);
     }
-  }
+  } else
+    return;  // The frame could not be read or cleaned up
 
   // this enables to view the level during cleanup by another user. this
   // behavior may abort Toonz.
@@ -1323,6 +1314,34 @@ rebuilding icons... (still dangerous though)
   app->getCurrentXsheet()->notifyXsheetChanged();
 }
 
+//-----------------------------------------------------------------------------
+/*-- 各フレームの処理 --*/
+void CleanupPopup::cleanupFrames(int count) {
+  assert(isValidPosition(m_idx));
+
+  // Frames are read and written here, while their cleanup runs in parallel
+  int level = m_idx.first, next = m_idx.second,
+      end = (count < 0) ? int(m_cleanupLevels[level].m_frames.size())
+                        : next + count;
+
+  BatchCleanupper batch;
+
+  batch.run(
+      [this, level, end, &next](BatchCleanupper::Frame &frame) {
+        return next < end && readFrame(level, next++, frame);
+      },
+      [this, level, count, &batch](BatchCleanupper::Result &result) {
+        commitFrame(result);
+        advanceFrame();
+
+        if (count != 1)
+          QCoreApplication::processEvents();  // Allow cancels to be received
+
+        // The popup may have been closed, resetting the cleanup list
+        if (!isValidPosition(m_idx) || m_idx.first != level) batch.cancel();
+      });
+}
+
 //-----------------------------------------------------------------------------
 
 void CleanupPopup::advanceFrame() {
@@ -1381,8 +1400,7 @@ void CleanupPopup::onCleanupFrame() {
     }
   }
 
-  cleanupFrame();
-  advanceFrame();
+  cleanupFrames(1);
 
   /*--- ボタンを元に戻す---*/
   m_cleanupAllButton->setEnabled(true);
@@ -1414,10 +1432,7 @@ void CleanupPopup::onCleanupAllFrame() {
       }
     }
 
-    cleanupFrame();
-    advanceFrame();
-
-    QCoreApplication::processEvents();  // Allow cancels to be received
+    cleanupFrames(-1);
   }
   /*--- ボタンを元に戻す---*/
   m_cleanupAllButton->setEnabled(true);
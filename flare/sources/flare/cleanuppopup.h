@@ -8,6 +8,9 @@
 // TnzQt includes
 #include "flareqt/validatedchoicedialog.h"
 
+// TnzLib includes
+#include "flare/batchcleanupper.h"
+
 // TnzCore includes
 #include "tfilepath.h"
 #include "timage.h"
@@ -115,7 +118,14 @@ private:
                          //!\return  An eventual failure message.
   void closeLevel();
 
-  void cleanupFrame();
+  bool readFrame(int level, int frame,
+                 BatchCleanupper::Frame &out);  //!< Loads a frame to be
+                                                //! cleaned up.
+  void commitFrame(BatchCleanupper::Result &result);  //!< Stores the cleaned
+                                                      //! up current frame.
+  void cleanupFrames(int count);  //!< Cleans up and advances past \b count
+                                  //! frames of the current level (all of
+                                  //! them if negative).
   void advanceFrame();
 
   /*--- 進捗をタスクバーから確認するため、MainWindowのタイトルバーに表示する
@@ -1139,6 +1139,8 @@ void XSheetPDFTemplate::drawSound(QPainter& painter, int framePage) {
         continue;
 
       TXshSoundLevelP soundLevel = cell.getSoundLevel();
+      // The waveform must be complete in the exported document
+      soundLevel->waitForPeaks();
 
       int soundPixel = cell.getFrameId().getNumber() *
                        oneFrameHeight;  // pixels since start of clip
@@ -1966,7 +1966,8 @@ bool IoCmd::loadScene(const TFilePath &path, bool updateRecentFile,
       SxfIo::loadSxfScene(scene, scenePath);
     else
       /*-- プログレス表示を行いながらLoad --*/
-      scene->load(scenePath);
+      scene->load(scenePath, false,
+                  Preferences::instance()->isLazyLevelLoadingEnabled());
     // import if needed
     auto currentProject = TProjectManager::instance()->getCurrentProject();
     if (!scene->getProject() || scene->getProject()->getProjectPath() !=
@@ -2047,7 +2048,8 @@ bool IoCmd::loadScene(const TFilePath &path, bool updateRecentFile,
   int forbiddenLevelCount = 0;
   for (int i = 0; i < scene->getLevelSet()->getLevelCount(); i++) {
     TXshLevel *xl = scene->getLevelSet()->getLevel(i);
-    if (xl && xl->getSimpleLevel() &&
+    // Levels still loading report their own problems
+    if (xl && xl->getSimpleLevel() && !xl->getSimpleLevel()->isLoadPending() &&
         xl->getSimpleLevel()->getProperties()->isForbidden())
       forbiddenLevelCount++;
   }
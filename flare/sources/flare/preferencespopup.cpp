@@ -1258,11 +1258,15 @@ QString PreferencesPopup::getUIString(PreferencesItemId id) {
       {IgnoreImageDpi, tr("Use Camera DPI for All Imported Images")},
       {rasterLevelCachingBehavior, tr("Raster Level Caching Behavior:")},
       {columnIconLoadingPolicy, tr("Column Icon:")},
+      {soundPeakFilesEnabled,
+       tr("Save Sound Waveform Data next to Audio Files")},
+      {lazyLevelLoading, tr("Load Scene Levels in Background")},
       //{ levelFormats,                           tr("") },
 
       // Saving
       {rasterBackgroundColor, tr("Matte color:")},
       {resetUndoOnSavingLevel, tr("Clear Undo History when Saving Levels")},
+      {binarySceneFormat, tr("Save Scenes in Binary Format")},
 
       // Import / Export
       {ffmpegPath, tr("FFmpeg Path:")},
@@ -1877,6 +1881,8 @@ QWidget* PreferencesPopup::createLoadingPage() {
            getComboItemList(rasterLevelCachingBehavior));
   insertUI(columnIconLoadingPolicy, lay,
            getComboItemList(columnIconLoadingPolicy));
+  insertUI(soundPeakFilesEnabled, lay);
+  insertUI(lazyLevelLoading, lay);
 
   // levelFormats,// need to be handle separately
   int row = lay->rowCount();
@@ -1934,6 +1940,14 @@ QWidget* PreferencesPopup::createSavingPage() {
 
   insertUI(replaceAfterSaveLevelAs, lay);
   insertUI(resetUndoOnSavingLevel, lay);
+  insertUI(binarySceneFormat, lay);
+  QLabel* binarySceneLabel =
+      new QLabel(tr("Binary scenes keep the .tnz extension, but older "
+                    "versions cannot open them and they cannot be edited "
+                    "as text.\nUse \"tconverter\" to convert them back to "
+                    "XML."),
+                 this);
+  lay->addWidget(binarySceneLabel, lay->rowCount(), 0, 1, 3, Qt::AlignLeft);
   QLabel* matteColorLabel =
       new QLabel(tr("Matte color is used for background when overwriting "
                     "raster levels with transparent pixels\nin non "
@@ -800,6 +800,8 @@ SceneViewer::SceneViewer(ImageUtils::FullScreenWidget *parent)
     , m_freezedStatus(NO_FREEZED)
     , m_viewGrabImage(0)
     , m_FPS(0)
+    , m_rasterLayerCache(new Stage::RasterLayerCache)
+    , m_compositeTime(0)
     , m_hRuler(0)
     , m_vRuler(0)
     , m_viewMode(SCENE_VIEWMODE)
@@ -881,6 +883,7 @@ SceneViewer::~SceneViewer() {
   emit aboutToBeDestroyed();
 
   if (m_fbo) delete m_fbo;
+  delete m_rasterLayerCache;
 
   // release all the registered context (once when exit the software)
   std::set<TGlContext>::iterator ct, cEnd(l_contexts.end());
@@ -1792,9 +1795,10 @@ void SceneViewer::drawOverlay() {
 #endif
 
     // record fps (frame per second)
-    if (app->getCurrentFrame()->isPlaying())
+    if (app->getCurrentFrame()->isPlaying()) {
       m_FPS = getActualFrameRate();
-    else
+      emit compositeTimeChanged(m_compositeTime);
+    } else
       m_FPS = 0;
 
     assert(glGetError() == GL_NO_ERROR);
@@ -1987,11 +1991,18 @@ void SceneViewer::drawViewerIndicators() {
 
 //-----------------------------------------------------------------------------
 
-static void drawFpsGraph(int t0, int t1) {
+//! Draws the histogram of the last repaint times: \b t0 is the time spent
+//! issuing the drawing commands, \b t1 also includes their execution, and
+//! \b compositeTime is the part of \b t0 spent compositing raster images
+//! (drawn in blue).
+static void drawFpsGraph(int t0, int t1, double compositeTime) {
   glDisable(GL_BLEND);
   static std::deque<std::pair<int, int>> times;
+  static std::deque<double> compositeTimes;
   times.push_back(std::make_pair(t0, t1));
+  compositeTimes.push_back(compositeTime);
   while (times.size() > 200) times.pop_front();
+  while (compositeTimes.size() > 200) compositeTimes.pop_front();
   double x0 = 10, y0 = 10;
   double x1 = x0 + 200;
   double y1 = y0 + 150;
@@ -2023,6 +2034,11 @@ static void drawFpsGraph(int t0, int t1) {
     glVertex2d(x, y0 + 5 + times[i].second / 5);
   }
   glEnd();
+  glColor3d(0, 0.5, 1);
+  glBegin(GL_LINE_STRIP);
+  for (int i = 0; i < (int)compositeTimes.size(); i++)
+    glVertex2d(x1 - i, y0 + 5 + compositeTimes[i] / 5);
+  glEnd();
   glPopMatrix();
 }
 
@@ -2126,7 +2142,7 @@ void SceneViewer::paintGL() {
   glFlush();
   glFinish();
   int t1 = time.elapsed();
-  drawFpsGraph(t0, t1);
+  drawFpsGraph(t0, t1, m_compositeTime);
 #endif
   // TOfflineGL::setContextManager(0);
 
@@ -2143,6 +2159,7 @@ void SceneViewer::drawScene() {
   TXsheet *xsh      = app->getCurrentXsheet()->getXsheet();
   TRect clipRect    = getActualClipRect(getViewMatrix());
   clipRect += TPoint(width() * 0.5, height() * 0.5);
+  m_compositeTime = 0;
 
   ChildStack *childStack = scene->getChildStack();
   bool editInPlace       = editInPlaceToggle.getStatus() &&
@@ -2212,6 +2229,7 @@ void SceneViewer::drawScene() {
 
     Stage::RasterPainter painter(viewerSize, viewAff, clipRect,
                                  m_visualSettings, true);
+    if (!m_isPicking) painter.setLayerCache(m_rasterLayerCache);
 
     // darken blended view mode for viewing the non-cleanuped and stacked
     // drawings
@@ -2323,6 +2341,7 @@ void SceneViewer::drawScene() {
       }
     }
     painter.flushRasterImages();
+    m_compositeTime = painter.getCompositeTime();
 
     TXshSimpleLevel::m_fillFullColorRaster = fillFullColorRaster;
 
@@ -44,6 +44,10 @@ namespace ImageUtils {
 class FullScreenWidget;
 }
 
+namespace Stage {
+class RasterLayerCache;
+}
+
 //=====================================================================
 
 class ToggleCommandHandler final : public MenuItemHandler {
@@ -116,6 +120,11 @@ class SceneViewer final : public TToolViewer,
 
   int m_FPS;
 
+  Stage::RasterLayerCache *m_rasterLayerCache;  //!< Raster layers composited
+                                                //!  in the previous repaints
+  double m_compositeTime;  //!< Msecs spent compositing rasters at the last
+                           //!  repaint
+
   ImagePainter::CompareSettings m_compareSettings;
   Ruler *m_hRuler;
   Ruler *m_vRuler;
@@ -473,6 +482,8 @@ signals:
   void previewToggled();
   // to notify FilmStripFrames and safely disconnect with this
   void aboutToBeDestroyed();
+  // to show the composite time next to the fps while playing
+  void compositeTimeChanged(double msecs);
 };
 
 // Functions
@@ -40,6 +40,7 @@
 #include "tofflinegl.h"
 #include "tvectorrenderdata.h"
 #include "tsystem.h"
+#include "tthread.h"
 
 // Qt includes
 #include <QPushButton>
@@ -289,6 +290,7 @@ Tracker::Tracker(double threshold, double sensitivity, int activeBackground,
   m_variationWindow  = variationWindow;
   m_indexFrameStart  = frameStart;
   m_framesNumber     = framesNumber;
+  m_colorImage       = true;
   m_processor        = new DummyProcessor();
 
   m_processor->setActive(false);
@@ -586,7 +588,7 @@ bool Tracker::setup() {
   // Set processing false
   m_processor->setActive(false);
 
-  bool image_c          = true;
+  bool image_c          = m_colorImage;
   bool image_background = false;
   bool occl             = m_manageOcclusion;
 
@@ -614,14 +616,16 @@ bool Tracker::setup() {
 
   m_raster_template = new TRaster32P[m_trackerCount];
 
+  CTrackerFrame frame(m_raster, image_c);
   for (i = 0; (i < m_numobjactive); i++) {
     // tracking	object first frame
-    m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(&m_raster);
+    m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(frame);
     m_raster_template[i] = m_raster;
   }
 
   m_num = m_numstart[0] + 1;
   ++m_currentFrame;
+  loadFrameInBackground(m_currentFrame);
   m_trackerRegionIndex = 0;
   m_oldObjectId        = 0;
 
@@ -630,16 +634,30 @@ bool Tracker::setup() {
 
 //-----------------------------------------------------------------------------
 
+void Tracker::loadFrameInBackground(int frame) {
+  if (frame >= m_indexFrameStart + m_framesNumber) return;
+
+  // the frame is decoded while the previous one is tracked
+  m_nextRaster = std::async(std::launch::async, loadFrame, frame, m_affine);
+}
+
+//-----------------------------------------------------------------------------
+
 bool Tracker::trackCurrentFrame() {
   m_raster_prev = m_raster;
 
   // update Current Frame;
-  m_raster = loadFrame(m_currentFrame, m_affine);
+  m_raster = m_nextRaster.valid() ? m_nextRaster.get()
+                                  : loadFrame(m_currentFrame, m_affine);
   if (!m_raster) {
     m_lastErrorCode = 1;
     return false;
   }
   m_processor->process(m_raster);
+  CTrackerFrame frame(m_raster, m_colorImage);
+
+  loadFrameInBackground(m_currentFrame + 1);
+
   short app1 = 0;
   app1       = m_numobjactive;
 
@@ -652,17 +670,20 @@ bool Tracker::trackCurrentFrame() {
       break;
   }
 
-  for (i = 0; i < app1; i++) {
-    // tracking old objects
-    if (m_pObjectTracker[i]->track)
-      m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(&m_raster);
-    float dist_temp;
-    dist_temp = m_pObjectTracker[i]->Matching(&m_raster, &m_raster_template[i]);
-    if ((dist_temp < m_sensitivity) && (m_pObjectTracker[i]->track)) {
-      m_raster_template[i] = m_raster;
-      m_pObjectTracker[i]->updateTemp();
+  // tracking old objects - each one only reads the frame
+  TThread::parallelFor(app1, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      if (m_pObjectTracker[i]->track)
+        m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(frame);
+      float dist_temp;
+      dist_temp =
+          m_pObjectTracker[i]->Matching(&m_raster, &m_raster_template[i]);
+      if ((dist_temp < m_sensitivity) && (m_pObjectTracker[i]->track)) {
+        m_raster_template[i] = m_raster;
+        m_pObjectTracker[i]->updateTemp();
+      }
     }
-  }
+  });
   // update neighbours
   for (i = 0; i < app1; i++) {
     m_pObjectTracker[i]->DistanceReset();
@@ -729,7 +750,7 @@ bool Tracker::trackCurrentFrame() {
 
   // tracking new objects
   for (i = app1; i < m_numobjactive; i++) {
-    m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(&m_raster);
+    m_pObjectTracker[i]->ObjeckTrackerHandlerByUser(frame);
     m_raster_template[i] = m_raster;
   }
 
@@ -6,6 +6,8 @@
 #include <QWidget>
 #include <QThread>
 
+#include <future>
+
 #include "tlevel.h"
 
 #include "flareqt/dvdialog.h"
@@ -87,6 +89,7 @@ class Tracker {
   int m_variationWindow;
   int m_indexFrameStart;
   int m_framesNumber;
+  bool m_colorImage;  // the trackers work on the colors, not on the gray
   short m_trackerCount;
   int *m_numstart;
   // TLevel::Iterator m_currentFrameIt;
@@ -102,6 +105,7 @@ class Tracker {
 
   TRaster32P m_raster_prev;
   TRaster32P m_raster;
+  std::future<TRaster32P> m_nextRaster;  // next frame, loaded while tracking
   TRaster32P *m_raster_template;
   TrackerObjectsSet *m_trackerObjectsSet;
   DummyProcessor *m_processor;
@@ -124,6 +128,8 @@ private:
   // Inizializzazione Variabili
   // ritorna true se è tutto ok
   bool setup();
+  // Avvia il caricamento di un frame in un altro thread
+  void loadFrameInBackground(int frame);
   int m_lastErrorCode;
   // Restituisce il messaggio di errore dal codice di errore che viene dato dal
   // metodo apply()
@@ -29,6 +29,7 @@
 #include "flare/txshcell.h"
 #include "flare/toonzscene.h"
 #include "flare/tcenterlinevectorizer.h"
+#include "flare/batchvectorizer.h"
 #include "flare/dpiscale.h"
 #include "flare/txshchildlevel.h"
 #include "flare/levelset.h"
@@ -187,24 +188,6 @@ Vectorizer::~Vectorizer() {
 
 //-----------------------------------------------------------------------------
 
-TVectorImageP Vectorizer::doVectorize(TImageP img, TPalette *palette,
-                                      const VectorizerConfiguration &conf) {
-  TToonzImageP ti  = img;
-  TRasterImageP ri = img;
-
-  if (!ti && !ri) return TVectorImageP();
-
-  VectorizerCore vCore;
-  connect(&vCore, SIGNAL(partialDone(int, int)), this,
-          SIGNAL(partialDone(int, int)));
-  connect(this, SIGNAL(transmitCancel()), &vCore, SLOT(onCancel()),
-          Qt::DirectConnection);  // Direct connection *must* be
-                                  // established for child cancels
-  return vCore.vectorize(img, conf, palette);
-}
-
-//-----------------------------------------------------------------------------
-
 void Vectorizer::setLevel(const TXshSimpleLevelP &level) {
   m_level = level;
 
@@ -282,26 +265,6 @@ void Vectorizer::setLevel(const TXshSimpleLevelP &level) {
 //-----------------------------------------------------------------------------
 
 int Vectorizer::doVectorize() {
-  struct {
-    Vectorizer *m_this;
-
-    CenterlineConfiguration m_cConf;
-    NewOutlineConfiguration m_oConf;
-
-    void updateConfig(double weight) {
-      if (m_this->m_params.m_isOutline)
-        m_oConf = m_this->m_params.getOutlineConfiguration(weight);
-      else
-        m_cConf = m_this->m_params.getCenterlineConfiguration(weight);
-    }
-
-  } locals = {this};
-
-  VectorizerConfiguration &configuration =
-      m_params.m_isOutline
-          ? static_cast<VectorizerConfiguration &>(locals.m_oConf)
-          : static_cast<VectorizerConfiguration &>(locals.m_cConf);
-
   if (!m_vLevel) return 0;
 
   if (m_dialog->getChoice() == OverwriteDialog::KEEP_OLD && m_dialogShown)
@@ -316,20 +279,26 @@ int Vectorizer::doVectorize() {
   double frameRange[2] = {static_cast<double>(m_fids.front().getNumber()) - 1,
                           static_cast<double>(m_fids.back().getNumber()) - 1};
 
-  int count = 0;
+  std::vector<TFrameId>::const_iterator ft = m_fids.begin(),
+                                        fEnd = m_fids.end();
+
+  // Frames are loaded here, and vectorized on the batch's worker threads
+  auto source = [&](BatchVectorizer::Frame &frame) -> bool {
+    if (ft == fEnd) return false;
+
+    const TFrameId &fid = *ft++;
+    frame.m_fid         = fid;
 
-  std::vector<TFrameId>::const_iterator ft, fEnd = m_fids.end();
-  for (ft = m_fids.begin(); ft != fEnd; ++ft) {
     // Retrieve the image to be vectorized
     TImageP img;
     if (sl->getType() == OVL_XSHLEVEL || sl->getType() == TZP_XSHLEVEL ||
         sl->getType() == TZI_XSHLEVEL)
-      img = sl->getFullsampledFrame(*ft, ImageManager::dontPutInCache);
+      img = sl->getFullsampledFrame(fid, ImageManager::dontPutInCache);
 
-    if (!img) continue;
+    if (!img) return true;
 
     // Build image-toonz coordinate transformation
-    TAffine dpiAff = getDpiAffine(sl, *ft, true);
+    TAffine dpiAff = getDpiAffine(sl, fid, true);
     double factor  = norm(dpiAff * TPointD(1, 0));
 
     TPointD center;
@@ -339,38 +308,51 @@ int Vectorizer::doVectorize() {
       center = ri->getRaster()->getCenterD();
 
     // Build vectorizer configuration
-    double weight = (ft->getNumber() - 1 - frameRange[0]) /
+    double weight = (fid.getNumber() - 1 - frameRange[0]) /
                     std::max(frameRange[1] - frameRange[0], 1.0);
     weight = tcrop(weight, 0.0, 1.0);
 
-    locals.updateConfig(weight);  // TEMPORARY
+    frame.m_configuration.reset(m_params.getCurrentConfiguration(weight));
+    frame.m_configuration->m_affine     = dpiAff * TTranslation(-center);
+    frame.m_configuration->m_thickScale = factor;
+    frame.m_image                       = img;
 
-    configuration.m_affine     = dpiAff * TTranslation(-center);
-    configuration.m_thickScale = factor;
+    return true;
+  };
 
-    // Build vectorization label to be displayed
-    QString labelName = QString::fromStdWString(sl->getShortName());
-    labelName.push_back(' ');
-    labelName.append(QString::fromStdString(ft->expand(TFrameId::NO_PAD)));
+  int count = 0;
 
-    emit frameName(labelName);
+  // Results are delivered in the input frames order
+  auto sink = [&](const TFrameId &srcFid, const TVectorImageP &vi) {
+    if (!vi) return;
 
-    // Perform vectorization
-    if (TVectorImageP vi =
-            doVectorize(img, m_vLevel->getPalette(), configuration)) {
-      TFrameId fid = *ft;
+    TFrameId fid = srcFid;
+    if (fid.getNumber() < 0) fid = TFrameId(1, srcFid.getLetter());
 
-      if (fid.getNumber() < 0) fid = TFrameId(1, ft->getLetter());
+    m_vLevel->setFrame(fid, vi);
+    vi->setPalette(m_vLevel->getPalette());
 
-      m_vLevel->setFrame(fid, vi);
-      vi->setPalette(m_vLevel->getPalette());
+    emit frameDone(++count);
+  };
 
-      emit frameDone(++count);
-    }
+  BatchVectorizer batch;
+  connect(&batch, SIGNAL(partialDone(int, int)), this,
+          SIGNAL(partialDone(int, int)));
+  connect(&batch, &BatchVectorizer::frameStarted,
+          [this, sl](const TFrameId &fid) {
+            // Build vectorization label to be displayed
+            QString labelName = QString::fromStdWString(sl->getShortName());
+            labelName.push_back(' ');
+            labelName.append(
+                QString::fromStdString(fid.expand(TFrameId::NO_PAD)));
+
+            emit frameName(labelName);
+          });
+  connect(this, SIGNAL(transmitCancel()), &batch, SLOT(cancel()),
+          Qt::DirectConnection);  // Direct connection *must* be
+                                  // established for child cancels
 
-    // Stop if canceled
-    if (m_isCanceled) break;
-  }
+  if (!m_isCanceled) batch.run(m_vLevel->getPalette(), source, sink);
 
   m_dialogShown = false;
 
@@ -333,11 +333,6 @@ private:
 
 private:
   int doVectorize();  //!< Start vectorization of input frames.
-
-  //! Makes connections to low-level partial progress signals and cancel slots,
-  //! and invokes the low-level vectorization of \b img.
-  TVectorImageP doVectorize(TImageP img, TPalette *palette,
-                            const VectorizerConfiguration &conf);
 };
 
 #endif  // VECTORIZERPOPUP_H
@@ -152,6 +152,8 @@ BaseViewerPanel::BaseViewerPanel(QWidget *parent, Qt::WindowFlags flags)
 
   ret = ret && connect(m_sceneViewer, SIGNAL(previewStatusChanged()), this,
                        SLOT(onPreviewStatusChanged()));
+  ret = ret && connect(m_sceneViewer, SIGNAL(compositeTimeChanged(double)),
+                       m_flipConsole, SLOT(setCompositeTime(double)));
   ret = ret && connect(m_sceneViewer, SIGNAL(onFlipHChanged(bool)), this,
                        SLOT(setFlipHButtonChecked(bool)));
   ret = ret && connect(m_sceneViewer, SIGNAL(onFlipVChanged(bool)), this,
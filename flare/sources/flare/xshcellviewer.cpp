@@ -1685,6 +1685,11 @@ void CellArea::drawSoundCell(QPainter &p, int row, int col, bool isReference) {
   DoublePair minmax;
   soundLevel->getValueAtPixel(o, soundPixel, minmax);
 
+  // The peak index is built in background: repaint once it is available
+  if (!soundLevel->arePeaksReady())
+    connect(soundLevel.getPointer(), SIGNAL(peaksReady()), this,
+            SLOT(update()), Qt::UniqueConnection);
+
   double pmin = minmax.first;
   double pmax = minmax.second;
 
@@ -2089,7 +2094,14 @@ void CellArea::drawLevelCell(QPainter &p, int row, int col, bool isReference,
   // draw text in red if the file does not exist
   bool isRed          = false;
   TXshSimpleLevel *sl = cell.getSimpleLevel();
-  if (sl && !sl->isFid(cell.m_frameId)) isRed = true;
+  if (sl && sl->isLoadPending()) {
+    // Don't wait for levels loading in background: read them first, and
+    // repaint once they are loaded
+    sl->prioritizeLoad();
+    connect(sl, SIGNAL(loadCompleted()), this, SLOT(update()),
+            Qt::UniqueConnection);
+  } else if (sl && !sl->isFid(cell.m_frameId))
+    isRed = true;
   TXshChildLevel *cl = cell.getChildLevel();
   if (cl && cell.getFrameId().getNumber() - 1 >= cl->getFrameCount())
     isRed = true;
@@ -23,6 +23,12 @@ typedef struct big { UINT lo, hi; } BIG;
    (B1).lo &= 0x3fffffff, (B1))
 #define BIG_TO_DOUBLE(B) ((double)(B).hi * (double)0x40000000 + (double)(B).lo)
 
+/*
+  Ref_cum and Ref_edgelen keep the first frame's reference for the following
+  ones; they, and the scratch Window_*, y_start and Edge_value below, are
+  shared by all threads. BatchCleanupper::run() auto-adjusts one frame at a
+  time, on the calling thread.
+*/
 static int Black = 0;
 
 static int Ref_cum[256];
@@ -7,6 +7,11 @@
 #include "trastercm.h"
 #include "skeletonlut.h"
 #include "flare/fill.h"
+#include "tthread.h"
+
+// Qt includes
+#include <QThread>
+
 #include <set>
 #include <queue>
 #include <unordered_set>
@@ -96,6 +101,12 @@ public:
   void skeletonize(std::vector<TPoint> &endpoints);
   void findSeeds(std::vector<Seed> &seeds, std::vector<TPoint> &endpoints);
   void erase(std::vector<Seed> &seeds, std::vector<TPoint> &endpoints);
+  void eraseComponents(std::vector<Seed> &seeds,
+                       std::vector<TPoint> &endpoints);
+  bool eraseStep(Seed &seed, std::vector<TPoint> &endpoints);
+  std::vector<int> labelComponents(const std::vector<Seed> &seeds,
+                                   std::vector<UCHAR *> &pixels,
+                                   std::vector<int> &pixelsBegin);
   void circuitAndMark(UCHAR *seed, UCHAR preseed);
   bool circuitAndCancel(UCHAR *seed, UCHAR preseed,
                         std::vector<TPoint> &endpoints);
@@ -168,7 +179,7 @@ inline bool isInk(const TPixel32 &pix) { return pix.r < 80; }
 /*------------------------------------------------------------------------*/
 
 TRasterGR8P fillByteRaster(const TRasterCM32P &r, TRasterGR8P &bRaster) {
-  int i, j;
+  int i;
   int lx = r->getLx();
   int ly = r->getLy();
   // bRaster->create(lx+4, ly+4);
@@ -178,19 +189,28 @@ TRasterGR8P fillByteRaster(const TRasterCM32P &r, TRasterGR8P &bRaster) {
 
   for (i = 0; i < lx + 4; i++) *(br++) = 131;
 
-  for (i = 0; i < ly; i++) {
-    *(br++)         = 0;
-    *(br++)         = 131;
-    TPixelCM32 *pix = r->pixels(i);
-    for (j = 0; j < lx; j++, pix++) {
-      if (pix->getTone() != pix->getMaxTone())
-        *(br++) = 3;
-      else
-        *(br++) = 0;
-    }
-    *(br++) = 131;
-    *(br++) = 0;
-  }
+  // Rows are independent - fill them in parallel
+  UCHAR *rows = br;
+  TThread::parallelFor(
+      ly,
+      [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+          UCHAR *br       = rows + y * (lx + 4);
+          *(br++)         = 0;
+          *(br++)         = 131;
+          TPixelCM32 *pix = r->pixels(y);
+          for (int x = 0; x < lx; x++, pix++) {
+            if (pix->getTone() != pix->getMaxTone())
+              *(br++) = 3;
+            else
+              *(br++) = 0;
+          }
+          *(br++) = 131;
+          *(br++) = 0;
+        }
+      },
+      64);
+  br += ly * (lx + 4);
 
   for (i = 0; i < lx + 4; i++) *(br++) = 131;
 
@@ -1402,8 +1422,14 @@ void TAutocloser::Imp::circuitAndMark(UCHAR *seed, UCHAR preseed) {
 
 void TAutocloser::Imp::erase(std::vector<Seed> &seeds,
                              std::vector<TPoint> &endpoints) {
+  // Labeling the components costs about half the sequential peeling, so it
+  // pays off only with a few cores
+  if (seeds.size() > 1 && QThread::idealThreadCount() >= 4) {
+    eraseComponents(seeds, endpoints);
+    return;
+  }
+
   int i, size = 0, oldSize;
-  UCHAR *seed, preseed, code, displ;
   oldSize = seeds.size();
 
   while (oldSize != size) {
@@ -1411,30 +1437,161 @@ void TAutocloser::Imp::erase(std::vector<Seed> &seeds,
     size    = seeds.size();
 
     for (i = oldSize; i < size; i++) {
-      seed    = seeds[i].m_ptr;
-      preseed = seeds[i].m_preseed;
+      Seed seed = seeds[i];
+      if (eraseStep(seed, endpoints)) seeds.push_back(seed);
+    }
+  }
+}
 
-      if (!isInk(seed)) {
-        code = NextSeedTable[neighboursCode(seed)];
-        seed += m_displaceVector[code & 0x7];
-        preseed = (code & 0x38) >> 3;
-      }
+/*------------------------------------------------------------------------*/
 
-      if (circuitAndCancel(seed, preseed, endpoints)) {
-        if (isInk(seed)) {
-          displ = NextPointTable[(neighboursCode(seed) << 3) | preseed];
-          //				assert(displ>=0 && displ<8);
-          seeds.push_back(Seed(seed + m_displaceVector[displ], displ ^ 0x7));
+//! Peels the contour starting at \b seed, and returns whether it must be
+//! peeled again - in that case \b seed is updated to the next contour's seed.
+bool TAutocloser::Imp::eraseStep(Seed &seed, std::vector<TPoint> &endpoints) {
+  UCHAR *ptr = seed.m_ptr, preseed = seed.m_preseed, code, displ;
 
-        } else /* the seed has been erased */
-        {
-          code = NextSeedTable[neighboursCode(seed)];
-          seeds.push_back(
-              Seed(seed + m_displaceVector[code & 0x7], (code & 0x38) >> 3));
+  if (!isInk(ptr)) {
+    code = NextSeedTable[neighboursCode(ptr)];
+    ptr += m_displaceVector[code & 0x7];
+    preseed = (code & 0x38) >> 3;
+  }
+
+  if (!circuitAndCancel(ptr, preseed, endpoints)) return false;
+
+  if (isInk(ptr)) {
+    displ = NextPointTable[(neighboursCode(ptr) << 3) | preseed];
+    //				assert(displ>=0 && displ<8);
+    seed = Seed(ptr + m_displaceVector[displ], displ ^ 0x7);
+  } else /* the seed has been erased */
+  {
+    code = NextSeedTable[neighboursCode(ptr)];
+    seed = Seed(ptr + m_displaceVector[code & 0x7], (code & 0x38) >> 3);
+  }
+
+  return true;
+}
+
+/*------------------------------------------------------------------------*/
+
+//! Returns the index of the 8-connected ink component of each seed, and
+//! stores in \b pixels the pixels of the components, starting at the
+//! positions in \b pixelsBegin. The raster frame is ink too, so all the
+//! components touching it are one.
+/*!
+  Visited pixels are tagged with 0x20 and seeds with 0x40, bits that are
+  unused until the skeleton is built. Callers must reset them.
+*/
+std::vector<int> TAutocloser::Imp::labelComponents(
+    const std::vector<Seed> &seeds, std::vector<UCHAR *> &pixels,
+    std::vector<int> &pixelsBegin) {
+  std::unordered_map<UCHAR *, int> seedIndices;
+  for (int i = 0; i < (int)seeds.size(); ++i) {
+    seedIndices[seeds[i].m_ptr] = i;
+    *seeds[i].m_ptr |= 0x40;
+  }
+
+  std::vector<int> components(seeds.size(), -1);
+
+  for (int i = 0; i < (int)seeds.size(); ++i) {
+    if (components[i] >= 0) continue;
+
+    int component = pixelsBegin.size();
+    pixelsBegin.push_back(pixels.size());
+
+    pixels.push_back(seeds[i].m_ptr);
+    *seeds[i].m_ptr |= 0x20;
+
+    for (int p = pixelsBegin.back(); p < (int)pixels.size(); ++p) {
+      UCHAR *br = pixels[p];
+      if ((*br) & 0x40) components[seedIndices[br]] = component;
+
+      // The frame rows span the whole byte raster, 2 pixels beyond m_br on
+      // each side: their first and last pixels have neighbours outside it,
+      // and no others to add
+      int x = (br - (m_br - 2 * m_bWrap - 2)) % m_bWrap;
+      if (x == 0 || x == m_bWrap - 1) continue;
+
+      for (int d = 0; d < 8; ++d) {
+        UCHAR *v = br + m_displaceVector[d];
+        if (((*v) & 0x21) == 0x1) {
+          *v |= 0x20;
+          pixels.push_back(v);
         }
       }
     }
   }
+
+  pixelsBegin.push_back(pixels.size());
+  return components;
+}
+
+/*------------------------------------------------------------------------*/
+
+//! Same as the sequential erase(), but thins separate ink components in
+//! parallel. Peeling a component never reads the pixels of another one, so
+//! the skeleton is the same; endpoints are then sorted back in the order
+//! erase() would have found them - by round, then by seed.
+void TAutocloser::Imp::eraseComponents(std::vector<Seed> &seeds,
+                                       std::vector<TPoint> &endpoints) {
+  struct Endpoint {
+    int m_round, m_chain;  //!< Peeling round, and index of the initial seed
+    TPoint m_point;
+  };
+
+  std::vector<UCHAR *> pixels;
+  std::vector<int> pixelsBegin;
+  std::vector<int> components = labelComponents(seeds, pixels, pixelsBegin);
+
+  int componentsCount = pixelsBegin.size() - 1;
+
+  std::vector<std::vector<int>> chains(componentsCount);
+  for (int i = 0; i < (int)seeds.size(); ++i)
+    chains[components[i]].push_back(i);
+
+  std::vector<std::vector<Endpoint>> found(componentsCount);
+
+  TThread::parallelFor(componentsCount, [&](int begin, int end) {
+    std::vector<TPoint> points;
+
+    for (int c = begin; c < end; ++c) {
+      std::vector<int> chain = chains[c], nextChain;
+      std::vector<Seed> round, nextRound;
+      for (int i : chain) round.push_back(seeds[i]);
+
+      for (int r = 0; !round.empty(); ++r) {
+        for (int k = 0; k < (int)round.size(); ++k) {
+          points.clear();
+
+          Seed seed = round[k];
+          if (eraseStep(seed, points)) {
+            nextRound.push_back(seed);
+            nextChain.push_back(chain[k]);
+          }
+
+          for (const TPoint &p : points)
+            found[c].push_back(Endpoint{r, chain[k], p});
+        }
+
+        round.swap(nextRound), nextRound.clear();
+        chain.swap(nextChain), nextChain.clear();
+      }
+
+      for (int p = pixelsBegin[c]; p < pixelsBegin[c + 1]; ++p)
+        *pixels[p] &= 0x9f;
+    }
+  });
+
+  std::vector<Endpoint> all;
+  for (const std::vector<Endpoint> &f : found)
+    all.insert(all.end(), f.begin(), f.end());
+
+  std::stable_sort(all.begin(), all.end(),
+                   [](const Endpoint &a, const Endpoint &b) {
+                     return a.m_round < b.m_round ||
+                            (a.m_round == b.m_round && a.m_chain < b.m_chain);
+                   });
+
+  for (const Endpoint &e : all) endpoints.push_back(e.m_point);
 }
 
 /*------------------------------------------------------------------------*/
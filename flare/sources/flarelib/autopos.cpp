@@ -330,15 +330,18 @@ void convert_dots_mm_to_pixel(DOT *dots, int nd, double x_res, double y_res) {
 
 /*---------------------------------------------------------------------------*/
 
-static char *Done       = 0;
-static int Done_rowsize = 0;
-static int Done_colsize = 0;
+// The dots search state is per-thread, so that multiple frames can be
+// autocentered concurrently
+
+static thread_local char *Done       = 0;
+static thread_local int Done_rowsize = 0;
+static thread_local int Done_colsize = 0;
 #define DONE_MASK(I, J) (1 << (((I) + (J)*Done_rowsize) & 7))
 #define DONE_BYTE(I, J) (((I) + (J)*Done_rowsize) >> 3)
 #define SET_DONE(I, J) (Done[DONE_BYTE(I, J)] |= DONE_MASK(I, J))
 #define NOT_DONE(I, J) (!(Done[DONE_BYTE(I, J)] & DONE_MASK(I, J)))
 
-static int Pix_ystep = 0;
+static thread_local int Pix_ystep = 0;
 
 typedef struct big { unsigned lo, hi; } BIG;
 #define CLEARBIG(B) ((B).lo = 0, (B).hi = 0, (B))
@@ -359,16 +362,16 @@ typedef struct big { unsigned lo, hi; } BIG;
 #define IS_VERY_BLACK_RGB(PIX) (RGBVAL(PIX) < 30 * 7)
 #define BLACK_WEIGHT_RGB(PIX) ((256 * 7 - RGBVAL(PIX)) >> 3)
 
-static BIG Xsum, Ysum, Weightsum;
-static int Xmin, Xmax, Ymin, Ymax, Npix;
+static thread_local BIG Xsum, Ysum, Weightsum;
+static thread_local int Xmin, Xmax, Ymin, Ymax, Npix;
 #ifdef RECURSIVE_VERSION
-static int Level, Max_level;
+static thread_local int Level, Max_level;
 #endif
-static bool Very_black_found;
+static thread_local bool Very_black_found;
 
 #ifdef DAFARE
 #ifdef RECURSIVE_VERSION
-static int Black_pixel = 0;
+static thread_local int Black_pixel = 0;
 #endif
 #endif
 
@@ -414,9 +417,9 @@ typedef struct {
   void *ptr;
 } STACK_INFO;
 
-static STACK_INFO *Stack    = 0;
-static int Stack_alloc_size = 0;
-static int Stack_size       = 0;
+static thread_local STACK_INFO *Stack    = 0;
+static thread_local int Stack_alloc_size = 0;
+static thread_local int Stack_size       = 0;
 
 #define CREATE_STACK                                                           \
   {                                                                            \
@@ -0,0 +1,198 @@
+
+
+#include "flare/batchcleanupper.h"
+
+// TnzLib includes
+#include "flare/tcleanupper.h"
+#include "flare/cleanupparameters.h"
+
+// TnzCore includes
+#include "tmsgcore.h"
+
+// Qt includes
+#include <QThread>
+#include <QRunnable>
+
+#include <deque>
+
+//*****************************************************************************
+//    Job  definition
+//*****************************************************************************
+
+struct BatchCleanupper::Job {
+  Frame m_frame;
+  Result m_result;
+
+  std::unique_ptr<CleanupParameters> m_parameters;
+  TPointD m_sourceDpi;
+  QStringList m_warnings;
+
+  bool m_done,   //!< Guarded by BatchCleanupper::m_mutex
+      m_inline;  //!< Whether the job is processed on the calling thread
+
+  Job() : m_done(false), m_inline(false) {}
+};
+
+//=============================================================================
+
+class BatchCleanupper::JobTask final : public QRunnable {
+  BatchCleanupper *m_cleanupper;
+  std::shared_ptr<Job> m_job;
+
+public:
+  JobTask(BatchCleanupper *cleanupper, const std::shared_ptr<Job> &job)
+      : m_cleanupper(cleanupper), m_job(job) {}
+
+  void run() override { m_cleanupper->process(*m_job); }
+};
+
+//*****************************************************************************
+//    BatchCleanupper  implementation
+//*****************************************************************************
+
+BatchCleanupper::BatchCleanupper(int threadCount)
+    : m_threadCount(threadCount)
+    , m_maxFramesInFlight(0)
+    , m_isCleanupper(false)
+    , m_canceled(false) {}
+
+//-----------------------------------------------------------------------------
+
+BatchCleanupper::~BatchCleanupper() { m_pool.waitForDone(); }
+
+//-----------------------------------------------------------------------------
+
+int BatchCleanupper::getThreadCount() const {
+  return (m_threadCount > 0) ? m_threadCount
+                             : std::max(QThread::idealThreadCount(), 1);
+}
+
+//-----------------------------------------------------------------------------
+
+int BatchCleanupper::getMaxFramesInFlight() const {
+  return (m_maxFramesInFlight > 0) ? m_maxFramesInFlight
+                                   : 2 * getThreadCount();
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchCleanupper::process(Job &job) {
+  TCleanupper cl;
+  cl.setParameters(job.m_parameters.get());
+  cl.setSourceDpi(job.m_sourceDpi);
+  cl.m_warnings = &job.m_warnings;
+
+  Result &result = job.m_result;
+  result.m_fid   = job.m_frame.m_fid;
+
+  TRasterImageP original(job.m_frame.m_image);
+  job.m_frame.m_image = TRasterImageP();  // process() releases it asap
+
+  if (job.m_parameters->m_lineProcessingMode == lpNone) {
+    TRasterImageP ri(original);
+    cl.process(original, false, ri, false, true, true, nullptr,
+               ri->getRaster());
+
+    result.m_rasterImage = ri;
+  } else {
+    CleanupPreprocessedImage *cpi;
+    {
+      TRasterImageP resampledImage;
+      cpi = cl.process(original, job.m_frame.m_first, resampledImage);
+    }
+
+    if (cpi) {
+      result.m_toonzImage   = cl.finalize(cpi, m_isCleanupper);
+      result.m_autocentered = cpi->m_autocentered;
+
+      delete cpi;
+    }
+  }
+
+  QMutexLocker locker(&m_mutex);
+
+  job.m_done = true;
+  m_jobDone.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+int BatchCleanupper::run(const Source &source, const Sink &sink) {
+  int threadCount = getThreadCount(), maxInFlight = getMaxFramesInFlight();
+  m_pool.setMaxThreadCount(threadCount);
+  m_canceled = false;
+
+  std::deque<std::shared_ptr<Job>> jobs;
+  int count = 0;
+  bool sourceEnded = false,
+       barrier     = false;  // No frame can be read after an inline one
+
+  for (;;) {
+    // Fill in the pipeline
+    while (!sourceEnded && !barrier && !m_canceled &&
+           (int)jobs.size() < maxInFlight) {
+      std::shared_ptr<Job> job(new Job);
+      if (!source(job->m_frame)) {
+        sourceEnded = true;
+        break;
+      }
+
+      jobs.push_back(job);
+
+      if (!job->m_frame.m_image) {
+        job->m_result.m_fid = job->m_frame.m_fid;
+        job->m_done         = true;
+        continue;
+      }
+
+      // The source may have updated the cleanupper for this frame
+      TCleanupper *cl = TCleanupper::instance();
+      job->m_parameters.reset(new CleanupParameters(*cl->getParameters()));
+      job->m_sourceDpi = cl->getSourceDpi();
+
+      // Auto-adjust keeps the first frame's histogram, and its scratch
+      // buffers, in statics (autoadjust.cpp, and ref_cum in
+      // TCleanupper::process()): they are not thread_local like the autopos
+      // ones, since the reference must reach the following frames. So these
+      // frames run here, one at a time, while the pool is idle.
+      bool autoAdjusted =
+          (job->m_parameters->m_lineProcessingMode == lpGrey &&
+           job->m_parameters->m_autoAdjustMode != CleanupTypes::AUTO_ADJ_NONE);
+
+      job->m_inline = (threadCount == 1) || job->m_frame.m_first ||
+                      autoAdjusted;
+
+      if (job->m_inline)
+        barrier = true;
+      else
+        m_pool.start(new JobTask(this, job));
+    }
+
+    if (jobs.empty()) break;
+
+    // Retrieve the oldest frame
+    std::shared_ptr<Job> job = jobs.front();
+    jobs.pop_front();
+
+    if (job->m_inline) {
+      // All preceding jobs were already written, so the pool is idle
+      barrier = false;
+      process(*job);
+    } else {
+      QMutexLocker locker(&m_mutex);
+      while (!job->m_done) m_jobDone.wait(&m_mutex);
+    }
+
+    for (const QString &msg : job->m_warnings) DVGui::warning(msg);
+
+    sink(job->m_result);
+    ++count;
+
+    if (m_canceled) break;
+  }
+
+  // The remaining frames are discarded
+  m_pool.waitForDone();
+
+  return count;
+}
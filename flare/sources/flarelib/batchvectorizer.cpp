@@ -0,0 +1,270 @@
+
+
+#include "flare/batchvectorizer.h"
+
+// TnzLib includes
+#include "flare/tcenterlinevectorizer.h"
+#include "flare/stage.h"
+
+// TnzCore includes
+#include "tpalette.h"
+#include "tcolorstyles.h"
+#include "trasterimage.h"
+#include "ttoonzimage.h"
+
+// Qt includes
+#include <QThread>
+#include <QRunnable>
+
+#include <deque>
+#include <map>
+
+//*****************************************************************************
+//    Job  definition
+//*****************************************************************************
+
+struct BatchVectorizer::Job {
+  Frame m_frame;
+  int m_index;
+  TPaletteP m_palette;  //!< The palette the frame is vectorized against
+
+  TVectorImageP m_result;
+  bool m_done,    //!< Guarded by BatchVectorizer::m_mutex
+      m_inline;   //!< Whether the job is processed on the calling thread
+
+  Job() : m_index(0), m_done(false), m_inline(false) {}
+};
+
+//=============================================================================
+
+class BatchVectorizer::JobTask final : public QRunnable {
+  BatchVectorizer *m_vectorizer;
+  std::shared_ptr<Job> m_job;
+
+public:
+  JobTask(BatchVectorizer *vectorizer, const std::shared_ptr<Job> &job)
+      : m_vectorizer(vectorizer), m_job(job) {}
+
+  void run() override { m_vectorizer->process(*m_job); }
+};
+
+//*****************************************************************************
+//    Local namespace
+//*****************************************************************************
+
+namespace {
+
+//! Adds to \b palette the styles that the vectorization of \b vi added to
+//! \b framePalette, a copy of \b snapshot, and remaps the styles of \b vi
+//! accordingly. Styles of the same color as one of \b palette are shared.
+void mergeStyles(const TVectorImageP &vi, TPalette *framePalette,
+                 const TPalette *snapshot, TPalette *palette) {
+  std::map<int, int> table;
+
+  int styleCount = framePalette->getStyleCount();
+  for (int styleId = 1; styleId < styleCount; ++styleId) {
+    // Added styles follow the snapshot's, or take the place of an unpaged one
+    if (styleId < snapshot->getStyleCount() &&
+        (snapshot->getStylePage(styleId) ||
+         !framePalette->getStylePage(styleId)))
+      continue;
+
+    TColorStyle *style = framePalette->getStyle(styleId);
+    TPixel32 color     = style->getMainColor();
+
+    int newStyleId = palette->getClosestStyle(color);
+    if (newStyleId < 0 || !palette->getStylePage(newStyleId) ||
+        palette->getStyle(newStyleId)->getMainColor() != color) {
+      TPalette::Page *page = palette->getPage(0);
+      newStyleId = page->getStyleId(page->addStyle(style->clone()));
+    }
+    if (newStyleId != styleId) table[styleId] = newStyleId;
+  }
+
+  if (!table.empty()) vi->reassignStyles(table);
+}
+
+}  // namespace
+
+//*****************************************************************************
+//    BatchVectorizer  implementation
+//*****************************************************************************
+
+BatchVectorizer::BatchVectorizer(int threadCount)
+    : m_threadCount(threadCount)
+    , m_maxFramesInFlight(0)
+    , m_canceled(false)
+    , m_frontIndex(0) {}
+
+//-----------------------------------------------------------------------------
+
+BatchVectorizer::~BatchVectorizer() { m_pool.waitForDone(); }
+
+//-----------------------------------------------------------------------------
+
+void BatchVectorizer::setThreadCount(int threadCount) {
+  m_threadCount = threadCount;
+}
+
+//-----------------------------------------------------------------------------
+
+int BatchVectorizer::getThreadCount() const {
+  return (m_threadCount > 0) ? m_threadCount
+                             : std::max(QThread::idealThreadCount(), 1);
+}
+
+//-----------------------------------------------------------------------------
+
+int BatchVectorizer::getMaxFramesInFlight() const {
+  return (m_maxFramesInFlight > 0) ? m_maxFramesInFlight
+                                   : 2 * getThreadCount();
+}
+
+//-----------------------------------------------------------------------------
+
+bool BatchVectorizer::setImageTransform(const TImageP &img,
+                                        VectorizerConfiguration &c) {
+  double factor = Stage::inch;
+  double dpix = factor / 72, dpiy = factor / 72;
+
+  TPointD center;
+  if (TRasterImageP ri = img) {
+    ri->getDpi(dpix, dpiy);
+    center = ri->getRaster()->getCenterD();
+  } else if (TToonzImageP ti = img) {
+    ti->getDpi(dpix, dpiy);
+    center = ti->getRaster()->getCenterD();
+  } else
+    return false;
+
+  TAffine dpiAff;
+  if (dpix != 0.0 && dpiy != 0.0) dpiAff = TScale(factor / dpix, factor / dpiy);
+
+  c.m_affine     = dpiAff * TTranslation(-center);
+  c.m_thickScale = norm(dpiAff * TPointD(1, 0));
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool BatchVectorizer::isPaletteReadOnly(const TImageP &img) {
+  // Toonz rasters only look up their styles, while full-color rasters (in
+  // both modes, and through EIR conversion) get their colors added
+  return TToonzImageP(img);
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchVectorizer::cancel() {
+  m_canceled = true;
+  emit transmitCancel();
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchVectorizer::process(Job &job) {
+  TVectorImageP vi;
+
+  if (!m_canceled) {
+    VectorizerCore vCore;
+
+    int index = job.m_index;
+    connect(&vCore, &VectorizerCore::partialDone,
+            [this, index](int partial, int total) {
+              if (m_frontIndex == index) emit partialDone(partial, total);
+            });
+    connect(this, SIGNAL(transmitCancel()), &vCore, SLOT(onCancel()),
+            Qt::DirectConnection);  // Direct connection *must* be
+                                    // established for child cancels
+
+    // A cancel may have been transmitted before the connection
+    if (!m_canceled)
+      vi = vCore.vectorize(job.m_frame.m_image, *job.m_frame.m_configuration,
+                           job.m_palette.getPointer());
+  }
+
+  QMutexLocker locker(&m_mutex);
+
+  job.m_frame.m_image = TImageP();  // Release the raster asap
+  job.m_result        = vi;
+  job.m_done          = true;
+
+  m_jobDone.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+int BatchVectorizer::run(TPalette *palette, const Source &source,
+                         const Sink &sink) {
+  // Keep the palette alive - vectorized images are assigned to it
+  TPaletteP paletteHolder(palette);
+
+  // Frames are vectorized against a copy of the palette as it is now, those
+  // adding styles against a copy of their own: the styles they add are
+  // merged in order, on this thread. So each frame sees none of the styles
+  // added by the others, and the result is the same for any thread count.
+  TPaletteP snapshot(palette->clone());
+
+  int threadCount = getThreadCount(), maxInFlight = getMaxFramesInFlight();
+  m_pool.setMaxThreadCount(threadCount);
+  m_canceled = false;
+
+  std::deque<std::shared_ptr<Job>> jobs;
+  int index = 0, count = 0;
+  bool sourceEnded = false;
+
+  for (;;) {
+    // Fill in the pipeline
+    while (!sourceEnded && !m_canceled && (int)jobs.size() < maxInFlight) {
+      std::shared_ptr<Job> job(new Job);
+      if (!source(job->m_frame)) {
+        sourceEnded = true;
+        break;
+      }
+
+      if (!job->m_frame.m_image || !job->m_frame.m_configuration) continue;
+
+      job->m_index   = index++;
+      job->m_inline  = (threadCount == 1);
+      job->m_palette = isPaletteReadOnly(job->m_frame.m_image)
+                           ? snapshot
+                           : TPaletteP(snapshot->clone());
+      jobs.push_back(job);
+
+      if (!job->m_inline) m_pool.start(new JobTask(this, job));
+    }
+
+    if (jobs.empty()) break;
+
+    // Retrieve the oldest frame
+    std::shared_ptr<Job> job = jobs.front();
+    jobs.pop_front();
+
+    m_frontIndex = job->m_index;
+    emit frameStarted(job->m_frame.m_fid);
+
+    if (job->m_inline)
+      process(*job);
+    else {
+      QMutexLocker locker(&m_mutex);
+      while (!job->m_done) m_jobDone.wait(&m_mutex);
+    }
+
+    // Canceled frames are discarded, failed ones delivered with no image
+    if (m_canceled) break;
+
+    if (job->m_result) {
+      if (job->m_palette != snapshot)
+        mergeStyles(job->m_result, job->m_palette.getPointer(),
+                    snapshot.getPointer(), palette);
+      ++count;
+    }
+    sink(job->m_frame.m_fid, job->m_result);
+  }
+
+  // Pending jobs quit early once canceled; their results are discarded
+  m_pool.waitForDone();
+
+  return count;
+}
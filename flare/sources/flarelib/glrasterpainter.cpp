@@ -1,6 +1,7 @@
 
 
 #include "flare/glrasterpainter.h"
+#include "flare/rastermipmaps.h"
 #include "tgl.h"
 #include "texturemanager.h"
 #include "tpalette.h"
@@ -136,6 +137,72 @@ void doDrawRaster(const TAffine &aff, UCHAR *buffer, int wrap, int bpp,
   glPopMatrix();
 }
 
+//----------------------------------------------------------------------------
+
+//! Retrieves the affine mapping \b aff's source to window coordinates, and
+//! the viewport. Returns false if the current OpenGL transform is not 2D.
+bool getWindowAffine(const TAffine &aff, TAffine &winAff, TRectD &viewport) {
+  GLdouble mv[16], pr[16];
+  GLint vp[4];
+  glGetDoublev(GL_MODELVIEW_MATRIX, mv);
+  glGetDoublev(GL_PROJECTION_MATRIX, pr);
+  glGetIntegerv(GL_VIEWPORT, vp);
+
+  // Compose the matrices (column-major) restricted to the z = 0 plane
+  double m[4][3];  // rows x, y, z, w of the columns x, y, translation
+  const int cols[3] = {0, 1, 3};
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 3; ++c) {
+      const GLdouble *col = mv + 4 * cols[c];
+      m[r][c] = pr[r] * col[0] + pr[4 + r] * col[1] + pr[8 + r] * col[2] +
+                pr[12 + r] * col[3];
+    }
+
+  // Perspective transforms can't be described by an affine
+  if (m[3][0] != 0.0 || m[3][1] != 0.0 || m[3][2] == 0.0) return false;
+
+  double w     = m[3][2];
+  TAffine ndc  = TAffine(m[0][0] / w, m[0][1] / w, m[0][2] / w, m[1][0] / w,
+                         m[1][1] / w, m[1][2] / w);
+  TAffine view = TAffine(0.5 * vp[2], 0, vp[0] + 0.5 * vp[2], 0, 0.5 * vp[3],
+                         vp[1] + 0.5 * vp[3]);
+
+  winAff   = view * ndc * aff;
+  viewport = TRectD(vp[0], vp[1], vp[0] + vp[2], vp[1] + vp[3]);
+  return winAff.det() != 0.0;
+}
+
+//----------------------------------------------------------------------------
+
+//! Draws the pyramid tiles of \b ras, if it has a level matching the view.
+//! Returns false if the raster must be drawn directly.
+bool drawMipmapTiles(const TAffine &aff, const TRasterP &ras,
+                     const TRectD &visibleRect, double scale,
+                     bool premultiplied) {
+  std::vector<RasterMipmaps::Tile> tiles;
+  int level = RasterMipmaps::instance()->getTiles(ras, scale, visibleRect,
+                                                  tiles);
+  if (level == 0) return false;
+
+  TDimension rasDim = ras->getSize();
+  TAffine levelAff  = aff * TTranslation(-0.5 * rasDim.lx, -0.5 * rasDim.ly) *
+                     TScale(1 << level);
+
+  for (int t = 0; t < (int)tiles.size(); ++t) {
+    const TRaster32P &tile = tiles[t].m_raster;
+    TPointD center(tiles[t].m_pos.x + 0.5 * tile->getLx(),
+                   tiles[t].m_pos.y + 0.5 * tile->getLy());
+
+    tile->lock();
+    doDrawRaster(levelAff * TTranslation(center), tile->getRawData(),
+                 tile->getWrap(), 4, tile->getSize(), tile->getBounds(), false,
+                 GL_LINEAR, GL_LINEAR, premultiplied);
+    tile->unlock();
+  }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void doDrawRaster(const TAffine &aff, const TRasterImageP &ri,
                   const TRectI &bbox, bool showBBox, GLenum magFilter,
@@ -167,8 +234,27 @@ void GLRasterPainter::drawRaster(const TAffine &aff, const TRasterImageP &ri,
                                  bool premultiplied) {
   if (!ri || !ri->getRaster()) return;
 
-  doDrawRaster(aff, ri, ri->getRaster()->getBounds(), false, GL_NEAREST,
-               GL_LINEAR, premultiplied);
+  TRasterP ras = ri->getRaster();
+  TRect bbox   = ras->getBounds();
+
+  TAffine winAff;
+  TRectD viewport;
+  if (getWindowAffine(aff, winAff, viewport)) {
+    // The raster is drawn centered in the origin
+    TDimension rasDim = ras->getSize();
+    winAff *= TTranslation(-0.5 * rasDim.lx, -0.5 * rasDim.ly);
+
+    TRectD visibleRect = winAff.inv() * viewport;
+    double scale       = sqrt(fabs(winAff.det()));
+
+    if (drawMipmapTiles(aff, ras, visibleRect, scale, premultiplied)) return;
+
+    // Upload just the visible part
+    bbox *= convert(visibleRect.enlarge(1.0));
+    if (bbox.isEmpty()) return;
+  }
+
+  doDrawRaster(aff, ri, bbox, false, GL_NEAREST, GL_LINEAR, premultiplied);
 }
 
 //----------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 
 #include "flare/imagemanager.h"
 #include "flare/txshsimplelevel.h"
+#include "flare/rastermipmaps.h"
 
 /* EXPLANATION (by Daniele):
 
@@ -270,6 +271,7 @@ void ImageManager::clear() {
   QWriteLocker locker(&m_imp->m_tableLock);
 
   TImageCache::instance()->clearSceneImages();
+  RasterMipmaps::instance()->clear();
   m_imp->clear();
 }
 
@@ -6,6 +6,7 @@
 // toonz/
 #include "flare/flipbooksettings.h"
 #include "flare/glrasterpainter.h"
+#include "flare/rastermipmaps.h"
 #include "trastercm.h"
 #include "tropcm.h"
 #include "tpalette.h"
@@ -485,8 +486,21 @@ void Painter::doFlushRasterImages(const TRasterP &rin, int bg,
       quickput(ras, app, m_palette, aff * TTranslation(offs),
                m_vSettings.m_useChecks);
     } else {
-      quickput(ras, _rin, m_palette, aff * TTranslation(offs),
-               m_vSettings.m_useChecks);
+      TAffine rinAff = aff * TTranslation(offs);
+
+      // When zoomed out, put the visible tiles of a smaller pyramid level
+      std::vector<RasterMipmaps::Tile> tiles;
+      int level = RasterMipmaps::instance()->getTiles(
+          _rin, sqrt(fabs(rinAff.det())),
+          rinAff.inv() * convert(ras->getBounds()), tiles);
+
+      if (level > 0) {
+        TAffine levelAff = rinAff * TScale(1 << level);
+        for (int t = 0; t < (int)tiles.size(); ++t)
+          quickput(ras, tiles[t].m_raster, m_palette,
+                   levelAff * TTranslation(convert(tiles[t].m_pos)), false);
+      } else
+        quickput(ras, _rin, m_palette, rinAff, m_vSettings.m_useChecks);
     }
 
     glDisable(GL_BLEND);
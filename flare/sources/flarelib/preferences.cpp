@@ -478,6 +478,9 @@ void Preferences::definePreferenceItems() {
          QMetaType::Int, 0);  // On Demand
   define(columnIconLoadingPolicy, "columnIconLoadingPolicy", QMetaType::Int,
          static_cast<int>(LoadAtOnce));
+  define(soundPeakFilesEnabled, "soundPeakFilesEnabled", QMetaType::Bool,
+         false);
+  define(lazyLevelLoading, "lazyLevelLoading", QMetaType::Bool, false);
   define(autoRemoveUnusedLevels, "autoRemoveUnusedLevels", QMetaType::Bool,
          false);
 
@@ -498,6 +501,7 @@ void Preferences::definePreferenceItems() {
          QColor(Qt::white));
   define(resetUndoOnSavingLevel, "resetUndoOnSavingLevel", QMetaType::Bool,
          true);
+  define(binarySceneFormat, "binarySceneFormat", QMetaType::Bool, false);
 
   setCallBack(rasterBackgroundColor, &Preferences::setRasterBackgroundColor);
   setCallBack(autosaveEnabled, &Preferences::enableAutosave);
@@ -0,0 +1,282 @@
+
+
+#include "flare/rastermipmaps.h"
+
+// TnzCore includes
+#include "timagecache.h"
+#include "trasterimage.h"
+#include "tthread.h"
+#include "tutil.h"
+
+// Qt includes
+#include <QMutex>
+#include <QMutexLocker>
+
+// STD includes
+#include <map>
+#include <cmath>
+
+//***************************************************************************************
+//    Local namespace
+//***************************************************************************************
+
+namespace {
+
+//! Rasters smaller than this (in pixels) are always drawn directly
+const int c_minPixelsCount = 2048 * 2048;
+
+//-----------------------------------------------------------------------------
+
+std::string tileId(const std::string &id, int level, int x, int y) {
+  return id + "_" + std::to_string(level) + "_" + std::to_string(x) + "_" +
+         std::to_string(y);
+}
+
+//-----------------------------------------------------------------------------
+
+TDimension levelSize(const TDimension &size, int level) {
+  return TDimension(((size.lx - 1) >> level) + 1, ((size.ly - 1) >> level) + 1);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the number of levels above the raster itself, so that the last
+//! one fits a single tile.
+int levelsCount(const TDimension &size) {
+  int count = 0;
+  while (std::max(levelSize(size, count).lx, levelSize(size, count).ly) >
+         RasterMipmaps::TileSize)
+    ++count;
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Halves \b ras, averaging each 2x2 block of pixels.
+TRaster32P halve(const TRaster32P &ras) {
+  int lx = ras->getLx(), ly = ras->getLy();
+  TRaster32P out((lx + 1) / 2, (ly + 1) / 2);
+
+  ras->lock();
+  out->lock();
+
+  for (int y = 0; y < out->getLy(); ++y) {
+    const TPixel32 *row0 = ras->pixels(2 * y),
+                   *row1 = ras->pixels(std::min(2 * y + 1, ly - 1));
+    TPixel32 *pix        = out->pixels(y);
+
+    for (int x = 0; x < out->getLx(); ++x, ++pix) {
+      int x0 = 2 * x, x1 = std::min(2 * x + 1, lx - 1);
+
+      pix->r = (row0[x0].r + row0[x1].r + row1[x0].r + row1[x1].r + 2) >> 2;
+      pix->g = (row0[x0].g + row0[x1].g + row1[x0].g + row1[x1].g + 2) >> 2;
+      pix->b = (row0[x0].b + row0[x1].b + row1[x0].b + row1[x1].b + 2) >> 2;
+      pix->m = (row0[x0].m + row0[x1].m + row1[x0].m + row1[x1].m + 2) >> 2;
+    }
+  }
+
+  out->unlock();
+  ras->unlock();
+
+  return out;
+}
+
+//-----------------------------------------------------------------------------
+
+void removeTiles(const std::string &id, const TDimension &size, int levels) {
+  TImageCache *cache = TImageCache::instance();
+
+  for (int level = 1; level <= levels; ++level) {
+    TDimension lSize = levelSize(size, level);
+    for (int y = 0; y * RasterMipmaps::TileSize < lSize.ly; ++y)
+      for (int x = 0; x * RasterMipmaps::TileSize < lSize.lx; ++x)
+        cache->remove(tileId(id, level, x, y));
+  }
+}
+
+}  // namespace
+
+//***************************************************************************************
+//    RasterMipmaps::Imp  definition
+//***************************************************************************************
+
+class RasterMipmaps::Imp {
+public:
+  struct Pyramid {
+    TRasterP m_raster;  //!< The source raster - the pyramid is released when
+                        //!  this is its last reference
+    std::string m_id;   //!< Prefix of the tiles' ids in TImageCache
+    int m_levels;       //!< Number of built levels, 0 while building
+  };
+
+  QMutex m_mutex;
+  std::map<TRaster *, Pyramid> m_pyramids;
+
+  TThread::Executor m_executor;
+
+public:
+  Imp() { m_executor.setMaxActiveTasks(1); }
+
+  //! Releases the pyramids of rasters nobody else refers to.
+  void releaseUnused() {
+    std::map<TRaster *, Pyramid>::iterator pt = m_pyramids.begin();
+    while (pt != m_pyramids.end()) {
+      if (pt->second.m_raster->getRefCount() == 1)
+        release(pt++);
+      else
+        ++pt;
+    }
+  }
+
+  void release(std::map<TRaster *, Pyramid>::iterator pt) {
+    // Pyramids still being built are removed by their task
+    const Pyramid &pyramid = pt->second;
+    if (pyramid.m_levels > 0)
+      removeTiles(pyramid.m_id, pyramid.m_raster->getSize(), pyramid.m_levels);
+
+    m_pyramids.erase(pt);
+  }
+};
+
+//***************************************************************************************
+//    RasterMipmaps::BuildTask  definition
+//***************************************************************************************
+
+class RasterMipmaps::BuildTask final : public TThread::Runnable {
+  TRaster32P m_raster;
+  std::string m_id;
+
+public:
+  BuildTask(const TRaster32P &raster, const std::string &id)
+      : m_raster(raster), m_id(id) {}
+
+  void run() override {
+    TImageCache *cache = TImageCache::instance();
+
+    int levels = levelsCount(m_raster->getSize());
+
+    TRaster32P level = m_raster;
+    for (int l = 1; l <= levels; ++l) {
+      level = halve(level);
+
+      for (int y = 0; y * TileSize < level->getLy(); ++y)
+        for (int x = 0; x * TileSize < level->getLx(); ++x) {
+          TRect tileRect(x * TileSize, y * TileSize, (x + 1) * TileSize - 1,
+                         (y + 1) * TileSize - 1);
+          TRasterP tile = level->extract(tileRect)->clone();
+
+          cache->add(tileId(m_id, l, x, y), TRasterImageP(tile));
+        }
+    }
+
+    // Publish the pyramid, unless it was invalidated in the meantime
+    RasterMipmaps::Imp *imp = RasterMipmaps::instance()->m_imp.get();
+    QMutexLocker locker(&imp->m_mutex);
+
+    std::map<TRaster *, Imp::Pyramid>::iterator pt =
+        imp->m_pyramids.find(m_raster.getPointer());
+    if (pt != imp->m_pyramids.end() && pt->second.m_id == m_id)
+      pt->second.m_levels = levels;
+    else
+      removeTiles(m_id, m_raster->getSize(), levels);
+  }
+};
+
+//***************************************************************************************
+//    RasterMipmaps  implementation
+//***************************************************************************************
+
+RasterMipmaps::RasterMipmaps() : m_imp(new Imp) {}
+
+//-----------------------------------------------------------------------------
+
+RasterMipmaps::~RasterMipmaps() {}
+
+//-----------------------------------------------------------------------------
+
+RasterMipmaps *RasterMipmaps::instance() {
+  static RasterMipmaps theInstance;
+  return &theInstance;
+}
+
+//-----------------------------------------------------------------------------
+
+int RasterMipmaps::getTiles(const TRasterP &ras, double scale,
+                            const TRectD &rect, std::vector<Tile> &tiles) {
+  tiles.clear();
+
+  QMutexLocker locker(&m_imp->m_mutex);
+
+  // Release first: the rasters drawn at full size would keep the pyramids of
+  // those no longer displayed alive
+  m_imp->releaseUnused();
+
+  // Sub-rasters are rebuilt at each use, so they can't be keyed
+  TRaster32P ras32 = ras;
+  if (!ras32 || ras32->getParent() || scale > 0.5 ||
+      ras32->getLx() * ras32->getLy() < c_minPixelsCount)
+    return 0;
+
+  std::map<TRaster *, Imp::Pyramid>::iterator pt =
+      m_imp->m_pyramids.find(ras32.getPointer());
+  if (pt == m_imp->m_pyramids.end()) {
+    Imp::Pyramid pyramid = {ras32, TImageCache::instance()->getUniqueId(), 0};
+    m_imp->m_pyramids[ras32.getPointer()] = pyramid;
+
+    m_imp->m_executor.addTask(new BuildTask(ras32, pyramid.m_id));
+    return 0;
+  }
+
+  const Imp::Pyramid &pyramid = pt->second;
+  if (pyramid.m_levels == 0) return 0;
+
+  int level = std::min(tfloor(-std::log2(scale)), pyramid.m_levels);
+
+  // Collect the tiles intersecting rect
+  double factor    = 1.0 / (1 << level) / TileSize;
+  TDimension lSize = levelSize(ras32->getSize(), level);
+
+  int x0 = std::max(tfloor(rect.x0 * factor), 0),
+      y0 = std::max(tfloor(rect.y0 * factor), 0),
+      x1 = std::min(tfloor(rect.x1 * factor), (lSize.lx - 1) / TileSize),
+      y1 = std::min(tfloor(rect.y1 * factor), (lSize.ly - 1) / TileSize);
+
+  for (int y = y0; y <= y1; ++y)
+    for (int x = x0; x <= x1; ++x) {
+      TRasterImageP ri =
+          TImageCache::instance()->get(tileId(pyramid.m_id, level, x, y),
+                                       false);
+      if (!ri) {
+        tiles.clear();
+        return 0;
+      }
+
+      Tile tile = {ri->getRaster(), TPoint(x * TileSize, y * TileSize)};
+      tiles.push_back(tile);
+    }
+
+  return level;
+}
+
+//-----------------------------------------------------------------------------
+
+void RasterMipmaps::invalidate(const TRasterP &ras) {
+  QMutexLocker locker(&m_imp->m_mutex);
+
+  std::map<TRaster *, Imp::Pyramid>::iterator pt =
+      m_imp->m_pyramids.find(ras.getPointer());
+  if (pt != m_imp->m_pyramids.end()) m_imp->release(pt);
+
+  m_imp->releaseUnused();
+}
+
+//-----------------------------------------------------------------------------
+
+void RasterMipmaps::clear() {
+  // Queued builds hold their raster too
+  m_imp->m_executor.cancelAll();
+
+  QMutexLocker locker(&m_imp->m_mutex);
+  while (!m_imp->m_pyramids.empty())
+    m_imp->release(m_imp->m_pyramids.begin());
+}
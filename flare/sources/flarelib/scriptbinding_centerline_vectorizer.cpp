@@ -4,14 +4,14 @@
 #include "flare/scriptbinding_level.h"
 #include <QScriptEngine>
 #include "flare/tcenterlinevectorizer.h"
-#include "flare/stage.h"
+#include "flare/batchvectorizer.h"
 #include "flare/Naa2TlvConverter.h"
 #include "tpalette.h"
 #include "ttoonzimage.h"
 
 namespace TScriptBinding {
 
-CenterlineVectorizer::CenterlineVectorizer() {
+CenterlineVectorizer::CenterlineVectorizer() : m_threadCount(0) {
   m_parameters = new CenterlineConfiguration();
 }
 
@@ -29,24 +29,8 @@ QScriptValue CenterlineVectorizer::ctor(QScriptContext *context,
 QScriptValue CenterlineVectorizer::vectorizeImage(const TImageP &src,
                                                   TPalette *palette) {
   VectorizerCore vc;
-  TAffine dpiAff;
-  double factor = Stage::inch;
-  double dpix = factor / 72, dpiy = factor / 72;
-  TPointD center;
-  if (TRasterImageP ri = src) {
-    ri->getDpi(dpix, dpiy);
-    center = ri->getRaster()->getCenterD();
-  } else if (TToonzImageP ti = src) {
-    ti->getDpi(dpix, dpiy);
-    center = ti->getRaster()->getCenterD();
-  } else {
+  if (!BatchVectorizer::setImageTransform(src, *m_parameters))
     return context()->throwError(QObject::tr("Vectorization failed"));
-  }
-  if (dpix != 0.0 && dpiy != 0.0) dpiAff = TScale(factor / dpix, factor / dpiy);
-  factor                                 = norm(dpiAff * TPointD(1, 0));
-
-  m_parameters->m_affine     = dpiAff * TTranslation(-center);
-  m_parameters->m_thickScale = factor;
 
   palette->addRef();  // if there are no other references the vectorize() method
                       // below can destroy the palette
@@ -90,19 +74,48 @@ QScriptValue CenterlineVectorizer::vectorize(QScriptValue arg) {
     QScriptValue newLevel = create(engine(), new Level());
     QList<TFrameId> fids;
     level->getFrameIds(fids);
-    for (const TFrameId &fid : fids) {
-      TImageP srcImg = level->getImg(fid);
+
+    // Frames are vectorized concurrently, and added in order
+    BatchVectorizer batch(m_threadCount);
+    bool failed = false;
+
+    QList<TFrameId>::const_iterator ft = fids.constBegin();
+    auto source = [&](BatchVectorizer::Frame &frame) -> bool {
+      if (ft == fids.constEnd()) return false;
+
+      frame.m_fid    = *ft++;
+      TImageP srcImg = level->getImg(frame.m_fid);
       if (srcImg && (srcImg->getType() == TImage::RASTER ||
                      srcImg->getType() == TImage::TOONZ_RASTER)) {
-        QScriptValue newFrame = vectorizeImage(srcImg, palette);
-        if (newFrame.isError()) {
-          return newFrame;
+        frame.m_configuration.reset(
+            new CenterlineConfiguration(*m_parameters));
+        if (!BatchVectorizer::setImageTransform(srcImg,
+                                                *frame.m_configuration)) {
+          failed = true;
+          return false;
         }
-        QScriptValueList args;
-        args << QString::fromStdString(fid.expand()) << newFrame;
-        newLevel.property("setFrame").call(newLevel, args);
+        frame.m_image = srcImg;
       }
-    }
+      return true;
+    };
+    auto sink = [&](const TFrameId &fid, const TVectorImageP &vi) {
+      if (!vi) {
+        failed = true;
+        batch.cancel();
+        return;
+      }
+      vi->setPalette(palette);
+
+      QScriptValueList args;
+      args << QString::fromStdString(fid.expand())
+           << engine()->newQObject(new Image(vi), QScriptEngine::AutoOwnership);
+      newLevel.property("setFrame").call(newLevel, args);
+    };
+
+    batch.run(palette, source, sink);
+    if (failed)
+      return context()->throwError(QObject::tr("Vectorization failed"));
+
     return newLevel;
   } else {
     // should never happen
@@ -170,5 +183,9 @@ bool CenterlineVectorizer::getEir() const { return m_parameters->m_naaSource; }
 
 void CenterlineVectorizer::setEir(bool v) { m_parameters->m_naaSource = v; }
 
+int CenterlineVectorizer::getThreads() const { return m_threadCount; }
+
+void CenterlineVectorizer::setThreads(int v) { m_threadCount = std::max(v, 0); }
+
 }  // namespace TScriptBinding
 
@@ -3,13 +3,13 @@
 #include "flare/scriptbinding_outline_vectorizer.h"
 #include "flare/scriptbinding_level.h"
 #include "flare/tcenterlinevectorizer.h"
-#include "flare/stage.h"
+#include "flare/batchvectorizer.h"
 #include "ttoonzimage.h"
 #include "tpalette.h"
 
 namespace TScriptBinding {
 
-OutlineVectorizer::OutlineVectorizer() {
+OutlineVectorizer::OutlineVectorizer() : m_threadCount(0) {
   m_parameters = new NewOutlineConfiguration();
 }
 
@@ -27,24 +27,8 @@ static QScriptValue vectorizeImage(QScriptContext *context,
                                    TPalette *palette,
                                    NewOutlineConfiguration *parameters) {
   VectorizerCore vc;
-  TAffine dpiAff;
-  double factor = Stage::inch;
-  double dpix = factor / 72, dpiy = factor / 72;
-  TPointD center;
-  if (TRasterImageP ri = src) {
-    ri->getDpi(dpix, dpiy);
-    center = ri->getRaster()->getCenterD();
-  } else if (TToonzImageP ti = src) {
-    ti->getDpi(dpix, dpiy);
-    center = ti->getRaster()->getCenterD();
-  } else {
+  if (!BatchVectorizer::setImageTransform(src, *parameters))
     return context->throwError(QObject::tr("Vectorization failed"));
-  }
-  if (dpix != 0.0 && dpiy != 0.0) dpiAff = TScale(factor / dpix, factor / dpiy);
-  factor                                 = norm(dpiAff * TPointD(1, 0));
-
-  parameters->m_affine     = dpiAff * TTranslation(-center);
-  parameters->m_thickScale = factor;
 
   TVectorImageP vi = vc.vectorize(src, *parameters, palette);
   vi->setPalette(palette);
@@ -84,20 +68,48 @@ QScriptValue OutlineVectorizer::vectorize(QScriptValue arg) {
     QScriptValue newLevel = create(engine(), new Level());
     QList<TFrameId> fids;
     level->getFrameIds(fids);
-    for (const TFrameId &fid : fids) {
-      TImageP srcImg = level->getImg(fid);
+
+    // Frames are vectorized concurrently, and added in order
+    BatchVectorizer batch(m_threadCount);
+    bool failed = false;
+
+    QList<TFrameId>::const_iterator ft = fids.constBegin();
+    auto source = [&](BatchVectorizer::Frame &frame) -> bool {
+      if (ft == fids.constEnd()) return false;
+
+      frame.m_fid    = *ft++;
+      TImageP srcImg = level->getImg(frame.m_fid);
       if (srcImg && (srcImg->getType() == TImage::RASTER ||
                      srcImg->getType() == TImage::TOONZ_RASTER)) {
-        QScriptValue newFrame =
-            vectorizeImage(context(), engine(), srcImg, palette, m_parameters);
-        if (newFrame.isError()) {
-          return newFrame;
+        frame.m_configuration.reset(
+            new NewOutlineConfiguration(*m_parameters));
+        if (!BatchVectorizer::setImageTransform(srcImg,
+                                                *frame.m_configuration)) {
+          failed = true;
+          return false;
         }
-        QScriptValueList args;
-        args << QString::fromStdString(fid.expand()) << newFrame;
-        newLevel.property("setFrame").call(newLevel, args);
+        frame.m_image = srcImg;
       }
-    }
+      return true;
+    };
+    auto sink = [&](const TFrameId &fid, const TVectorImageP &vi) {
+      if (!vi) {
+        failed = true;
+        batch.cancel();
+        return;
+      }
+      vi->setPalette(palette);
+
+      QScriptValueList args;
+      args << QString::fromStdString(fid.expand())
+           << engine()->newQObject(new Image(vi), QScriptEngine::AutoOwnership);
+      newLevel.property("setFrame").call(newLevel, args);
+    };
+
+    batch.run(palette, source, sink);
+    if (failed)
+      return context()->throwError(QObject::tr("Vectorization failed"));
+
     return newLevel;
   } else {
     // should never happen
@@ -182,5 +194,9 @@ int OutlineVectorizer::getToneThreshold() const {
 
 void OutlineVectorizer::setToneThreshold(int v) { m_parameters->m_toneTol = v; }
 
+int OutlineVectorizer::getThreads() const { return m_threadCount; }
+
+void OutlineVectorizer::setThreads(int v) { m_threadCount = std::max(v, 0); }
+
 }  // namespace TScriptBinding
 
@@ -56,6 +56,7 @@
 #include <QPainter>
 #include <QPolygon>
 #include <QThreadStorage>
+#include <QElapsedTimer>
 #include <QTransform>
 #include <QThread>
 #include <QGuiApplication>
@@ -376,6 +377,57 @@ int Picker::getRow() const {
     return m_rows.back();
 }
 
+//**********************************************************************************************
+//    RasterLayerCache  implementation
+//**********************************************************************************************
+
+namespace {
+
+//! The node data affecting the way it is stacked.
+struct LayerKey {
+  TRasterP m_raster;  // keeps the raster alive - its address can't be reused
+  TPalette *m_palette;
+  TAffine m_aff;
+  int m_alpha, m_onionMode, m_frame, m_flags;
+  TPixel32 m_filterColor;
+
+  bool operator==(const LayerKey &other) const {
+    return m_raster.getPointer() == other.m_raster.getPointer() &&
+           m_palette == other.m_palette && m_aff == other.m_aff &&
+           m_alpha == other.m_alpha && m_onionMode == other.m_onionMode &&
+           m_frame == other.m_frame && m_flags == other.m_flags &&
+           m_filterColor == other.m_filterColor;
+  }
+  bool operator!=(const LayerKey &other) const { return !operator==(other); }
+};
+
+}  // namespace
+
+//=============================================================================
+
+struct RasterLayerCache::Layers {
+  std::vector<LayerKey> m_keys;  //!< The nodes of the flush
+  int m_begin, m_end;            //!< Nodes range composited at each repaint
+  int m_checks;                  //!< ToonzCheck flags in use
+  TPixel32 m_frontOnionColor, m_backOnionColor;
+  bool m_onionInksOnly;
+
+  TRaster32P m_below,  //!< Nodes before m_begin, on the whole viewer
+      m_above;         //!< Nodes from m_end on, on the whole viewer
+};
+
+//-----------------------------------------------------------------------------
+
+RasterLayerCache::RasterLayerCache() {}
+
+//-----------------------------------------------------------------------------
+
+RasterLayerCache::~RasterLayerCache() {}
+
+//-----------------------------------------------------------------------------
+
+void RasterLayerCache::clear() { m_layers.clear(); }
+
 //**********************************************************************************************
 //    RasterPainter  implementation
 //**********************************************************************************************
@@ -391,7 +443,10 @@ RasterPainter::RasterPainter(const TDimension &dim, const TAffine &viewAff,
     , m_maskLevel(0)
     , m_singleColumnEnabled(false)
     , m_checkFlags(checkFlags)
-    , m_doRasterDarkenBlendedView(false) {}
+    , m_doRasterDarkenBlendedView(false)
+    , m_layerCache(0)
+    , m_flushCount(0)
+    , m_compositeTime(0.0) {}
 
 //-----------------------------------------------------------------------------
 
@@ -453,77 +508,16 @@ TRasterP RasterPainter::getRaster(int index, QTransform &matrix) {
 
 //-----------------------------------------------------------------------------
 
-/*! Make frame visualization.
-\n	If onion-skin is active, create a new raster with dimension containing
-all
-                frame with onion-skin; recall \b TRop::quickPut with argument
-each frame
-                with onion-skin and new raster. If onion-skin is not active
-recall
-                \b TRop::quickPut with argument current frame and new raster.
-*/
-
 namespace {
 QThreadStorage<std::vector<char> *> threadBuffers;
 }
 
-void RasterPainter::flushRasterImages() {
-  if (m_nodes.empty()) return;
-
-  // Build nodes bbox union
-  double delta = sqrt(fabs(m_nodes[0].m_aff.det()));
-  TRectD bbox  = m_nodes[0].m_bbox.enlarge(delta);
-
-  int i, nodesCount = m_nodes.size();
-  for (i = 1; i < nodesCount; ++i) {
-    delta = sqrt(fabs(m_nodes[i].m_aff.det()));
-    bbox += m_nodes[i].m_bbox.enlarge(delta);
-  }
-
-  TRect rect(tfloor(bbox.x0), tfloor(bbox.y0), tceil(bbox.x1), tceil(bbox.y1));
-  rect = rect * TRect(0, 0, m_dim.lx - 1, m_dim.ly - 1);
-
-  int lx = rect.getLx(), ly = rect.getLy();
-  TDimension dim(lx, ly);
-
-  // this is needed since a stop motion live view
-  // doesn't register as a node correctly
-  // there is probably a better way to do this.
-  if (rect.getLx() == 0 && lx == 0) {
-    rect = m_clipRect;
-    dim  = m_dim;
-  }
-
-  // Build a raster buffer of sufficient size to hold said union.
-  // The buffer is per-thread cached in order to improve the rendering speed.
-  if (!threadBuffers.hasLocalData())
-    threadBuffers.setLocalData(new std::vector<char>());
-
-  int size = dim.lx * dim.ly * sizeof(TPixel32);
-
-  std::vector<char> *vbuff = (std::vector<char> *)threadBuffers.localData();
-  if (size > (int)vbuff->size()) vbuff->resize(size);
-
-  TRaster32P ras(dim.lx, dim.ly, dim.lx, (TPixel32 *)&(*vbuff)[0]);
-  TRaster32P ras2;
-
-  if (m_vs.m_colorMask != 0) {
-    ras2 = TRaster32P(ras->getSize());
-    ras->clear();
-  } else
-    ras2 = ras;
-
-  // Clear the buffer - it will hold all the stacked nodes content to be overed
-  // on top of the OpenGL buffer through a glDrawPixel()
-  ras->lock();
-
-  ras->clear();  // ras is typically reused - and we need it transparent first
-
-  TRect r                 = rect - rect.getP00();
-  TRaster32P viewedRaster = ras->extract(r);
-
-  int current = -1;
+//-----------------------------------------------------------------------------
 
+//! Stacks the nodes in [begin, end) on top of \b out, whose bottom-left corner
+//! lies at \b origin on the viewer.
+void RasterPainter::putNodes(const TRaster32P &out, const TPoint &origin,
+                             int begin, int end) {
   // Retrieve preferences-related data
   int tc    = m_checkFlags ? ToonzCheck::instance()->getChecks() : 0;
   int index = ToonzCheck::instance()->getColorIndex();
@@ -534,11 +528,8 @@ void RasterPainter::flushRasterImages() {
   Preferences::instance()->getOnionData(frontOnionColor, backOnionColor,
                                         onionInksOnly);
 
-  // Stack every node on top of the raster buffer
-  for (i = 0; i < nodesCount; ++i) {
-    if (m_nodes[i].m_isCurrentColumn) current = i;
-
-    TAffine aff         = TTranslation(-rect.x0, -rect.y0) * m_nodes[i].m_aff;
+  for (int i = begin; i < end; ++i) {
+    TAffine aff         = TTranslation(-origin.x, -origin.y) * m_nodes[i].m_aff;
     TDimension imageDim = m_nodes[i].m_raster->getSize();
     TPointD offset(0.5, 0.5);
     aff *= TTranslation(offset);  // very quick and very dirty fix: in
@@ -568,11 +559,11 @@ void RasterPainter::flushRasterImages() {
     }
 
     if (TRaster32P src32 = m_nodes[i].m_raster)
-      TRop::quickPut(viewedRaster, src32, aff, colorscale,
-                     m_nodes[i].m_doPremultiply, m_nodes[i].m_whiteTransp,
-                     m_nodes[i].m_isFirstColumn, m_doRasterDarkenBlendedView);
+      TRop::quickPut(out, src32, aff, colorscale, m_nodes[i].m_doPremultiply,
+                     m_nodes[i].m_whiteTransp, m_nodes[i].m_isFirstColumn,
+                     m_doRasterDarkenBlendedView);
     else if (TRasterGR8P srcGr8 = m_nodes[i].m_raster)
-      TRop::quickPut(viewedRaster, srcGr8, aff, colorscale);
+      TRop::quickPut(out, srcGr8, aff, colorscale);
     else if (TRasterCM32P srcCm = m_nodes[i].m_raster) {
       assert(m_nodes[i].m_palette);
       int oldframe = m_nodes[i].m_palette->getFrame();
@@ -616,7 +607,7 @@ void RasterPainter::flushRasterImages() {
 
       if (tc == 0 || tc == ToonzCheck::eBlackBg ||
           !m_nodes[i].m_isCurrentColumn)
-        TRop::quickPut(viewedRaster, srcCm, plt, aff, colorscale, inksOnly);
+        TRop::quickPut(out, srcCm, plt, aff, colorscale, inksOnly);
       else {
         TRop::CmappedQuickputSettings settings;
 
@@ -660,7 +651,7 @@ void RasterPainter::flushRasterImages() {
         }
 
         // Final render using original Flare quickPut behavior
-        TRop::quickPut(viewedRaster, rasterToUse, plt, aff, settings);
+        TRop::quickPut(out, rasterToUse, plt, aff, settings);
         // Temporary clone automatically destroyed when leaving scope
       }
 
@@ -671,12 +662,199 @@ void RasterPainter::flushRasterImages() {
     } else
       assert(!"Cannot use quickput with this raster combination!");
   }
+}
+
+//-----------------------------------------------------------------------------
+
+/*! Stacks the nodes on \b out, covering the \b rect region of the viewer,
+    through the layers cache. Only the current column's nodes are quickput,
+    between the cached composition of the nodes below and above them.
+    Returns false if the cache can't be used, in which case \b out is left
+    untouched.
+*/
+bool RasterPainter::putCachedNodes(const TRaster32P &out, const TRect &rect) {
+  std::vector<std::shared_ptr<RasterLayerCache::Layers>> &cachedLayers =
+      m_layerCache->m_layers;
+
+  // Images may have changed anywhere when the whole viewer is repainted
+  if (m_clipRect.contains(TRect(m_dim))) {
+    cachedLayers.clear();
+    return false;
+  }
+
+  // Darken blending is not associative, the above layers can't be merged
+  if (m_doRasterDarkenBlendedView || !TRect(m_dim).contains(rect))
+    return false;
+
+  int i, nodesCount = m_nodes.size();
+
+  int begin = nodesCount, end = nodesCount;
+  for (i = 0; i < nodesCount; ++i) {
+    if (m_nodes[i].m_isCurrentColumn) {
+      if (begin == nodesCount) begin = i;
+      end = i + 1;
+    }
+  }
+
+  if (begin + nodesCount - end < 2) return false;  // Not worth it
+
+  // The cached layers must not share rasters with the current column, since
+  // these are the ones being edited
+  for (i = 0; i < nodesCount; ++i) {
+    if (i == begin) i = end;
+    if (i == nodesCount) break;
+
+    for (int j = begin; j < end; ++j)
+      if (m_nodes[i].m_raster.getPointer() == m_nodes[j].m_raster.getPointer())
+        return false;
+  }
+
+  // Build the key of the current layers
+  std::shared_ptr<RasterLayerCache::Layers> layers(
+      new RasterLayerCache::Layers);
+
+  layers->m_keys.reserve(nodesCount);
+  for (i = 0; i < nodesCount; ++i) {
+    const Node &node = m_nodes[i];
+
+    LayerKey key = {node.m_raster,
+                    node.m_palette,
+                    node.m_aff,
+                    node.m_alpha,
+                    node.m_onionMode,
+                    node.m_frame,
+                    node.m_doPremultiply | node.m_whiteTransp << 1 |
+                        node.m_isFirstColumn << 2 | node.m_isCurrentColumn << 3,
+                    node.m_filterColor};
+    layers->m_keys.push_back(key);
+  }
+
+  layers->m_begin  = begin;
+  layers->m_end    = end;
+  layers->m_checks = m_checkFlags ? ToonzCheck::instance()->getChecks() : 0;
+  Preferences::instance()->getOnionData(layers->m_frontOnionColor,
+                                        layers->m_backOnionColor,
+                                        layers->m_onionInksOnly);
+
+  int flush = m_flushCount;
+  if (flush >= (int)cachedLayers.size()) cachedLayers.resize(flush + 1);
+
+  const std::shared_ptr<RasterLayerCache::Layers> &cached = cachedLayers[flush];
+  if (cached && cached->m_keys == layers->m_keys &&
+      cached->m_begin == begin && cached->m_end == end &&
+      cached->m_checks == layers->m_checks &&
+      cached->m_frontOnionColor == layers->m_frontOnionColor &&
+      cached->m_backOnionColor == layers->m_backOnionColor &&
+      cached->m_onionInksOnly == layers->m_onionInksOnly &&
+      cached->m_below->getSize() == m_dim)
+    layers = cached;
+  else {
+    // Composite the layers on the whole viewer, for the next repaints
+    layers->m_below = TRaster32P(m_dim);
+    layers->m_below->clear();
+    putNodes(layers->m_below, TPoint(), 0, begin);
+
+    if (end < nodesCount) {
+      layers->m_above = TRaster32P(m_dim);
+      layers->m_above->clear();
+      putNodes(layers->m_above, TPoint(), end, nodesCount);
+    }
+
+    cachedLayers[flush] = layers;
+  }
+
+  TRop::copy(out, layers->m_below->extract(rect));
+  putNodes(out, rect.getP00(), begin, end);
+  if (layers->m_above) TRop::over(out, layers->m_above->extract(rect));
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+/*! Make frame visualization.
+\n	If onion-skin is active, create a new raster with dimension containing
+all
+                frame with onion-skin; recall \b TRop::quickPut with argument
+each frame
+                with onion-skin and new raster. If onion-skin is not active
+recall
+                \b TRop::quickPut with argument current frame and new raster.
+*/
+void RasterPainter::flushRasterImages() {
+  if (m_nodes.empty()) return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Build nodes bbox union
+  double delta = sqrt(fabs(m_nodes[0].m_aff.det()));
+  TRectD bbox  = m_nodes[0].m_bbox.enlarge(delta);
+
+  int i, nodesCount = m_nodes.size();
+  for (i = 1; i < nodesCount; ++i) {
+    delta = sqrt(fabs(m_nodes[i].m_aff.det()));
+    bbox += m_nodes[i].m_bbox.enlarge(delta);
+  }
+
+  TRect rect(tfloor(bbox.x0), tfloor(bbox.y0), tceil(bbox.x1), tceil(bbox.y1));
+  rect = rect * TRect(0, 0, m_dim.lx - 1, m_dim.ly - 1);
+
+  int lx = rect.getLx(), ly = rect.getLy();
+  TDimension dim(lx, ly);
+
+  // this is needed since a stop motion live view
+  // doesn't register as a node correctly
+  // there is probably a better way to do this.
+  if (rect.getLx() == 0 && lx == 0) {
+    rect = m_clipRect;
+    dim  = m_dim;
+  }
+
+  // Build a raster buffer of sufficient size to hold said union.
+  // The buffer is per-thread cached in order to improve the rendering speed.
+  if (!threadBuffers.hasLocalData())
+    threadBuffers.setLocalData(new std::vector<char>());
+
+  int size = dim.lx * dim.ly * sizeof(TPixel32);
+
+  std::vector<char> *vbuff = (std::vector<char> *)threadBuffers.localData();
+  if (size > (int)vbuff->size()) vbuff->resize(size);
+
+  TRaster32P ras(dim.lx, dim.ly, dim.lx, (TPixel32 *)&(*vbuff)[0]);
+  TRaster32P ras2;
+
+  if (m_vs.m_colorMask != 0) {
+    ras2 = TRaster32P(ras->getSize());
+    ras->clear();
+  } else
+    ras2 = ras;
+
+  // Clear the buffer - it will hold all the stacked nodes content to be overed
+  // on top of the OpenGL buffer through a glDrawPixel()
+  ras->lock();
+
+  ras->clear();  // ras is typically reused - and we need it transparent first
+
+  TRect r                 = rect - rect.getP00();
+  TRaster32P viewedRaster = ras->extract(r);
+
+  int current = -1;
+  for (i = 0; i < nodesCount; ++i)
+    if (m_nodes[i].m_isCurrentColumn) current = i;
+
+  // Stack every node on top of the raster buffer
+  if (!m_layerCache || !putCachedNodes(viewedRaster, rect))
+    putNodes(viewedRaster, rect.getP00(), 0, nodesCount);
+  ++m_flushCount;
 
   if (m_vs.m_colorMask != 0) {
     TRop::setChannel(ras, ras, m_vs.m_colorMask, false);
     TRop::quickPut(ras2, ras, TAffine());
   }
 
+  m_compositeTime += timer.nsecsElapsed() * 1e-6;
+
   // Now, output the raster buffer on top of the OpenGL buffer
   glPushAttrib(GL_COLOR_BUFFER_BIT);  // Preserve blending and stuff
 
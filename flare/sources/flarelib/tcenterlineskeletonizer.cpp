@@ -1,6 +1,7 @@
 
 
 #include "tcenterlinevectP.h"
+#include "trandom.h"
 
 //#define _SSDEBUG                                              // Uncomment to
 // enable the debug viewer
@@ -609,7 +610,8 @@ public:
   int m_number;
 
   RandomizedNode() {}
-  RandomizedNode(ContourNode *node) : m_node(node), m_number(rand()) {}
+  RandomizedNode(ContourNode *node, TRandom &random)
+      : m_node(node), m_number(random.getInt(0, RAND_MAX)) {}
 
   inline ContourNode *operator->(void) { return m_node; }
 };
@@ -631,14 +633,21 @@ void Timeline::build(ContourFamily &polygons, VectorizationContext &context,
   std::vector<RandomizedNode> nodesToBeTreated(context.m_totalNodes);
   T3DPointD momentum, ray;
 
+  // Seeded locally rather than using rand(), so that the order (and hence
+  // the result) does not depend on other frames vectorized concurrently.
+  // Note that this changes the centerline output of versions using rand():
+  // the strokes of a frame may differ slightly from those saved before.
+  TRandom random;
+
   // Build casual ordered node-array
   for (i = 0, current = 0; i < polygons.size(); ++i)
-    for (j                        = 0; j < polygons[i].size(); ++j)
-      nodesToBeTreated[current++] = RandomizedNode(&polygons[i][j]);
+    for (j = 0; j < polygons[i].size(); ++j)
+      nodesToBeTreated[current++] = RandomizedNode(&polygons[i][j], random);
 
   // Same for linear-added nodes
-  for (i                        = 0; i < context.m_linearNodesHeapCount; ++i)
-    nodesToBeTreated[current++] = RandomizedNode(&context.m_linearNodesHeap[i]);
+  for (i = 0; i < context.m_linearNodesHeapCount; ++i)
+    nodesToBeTreated[current++] =
+        RandomizedNode(&context.m_linearNodesHeap[i], random);
 
   double maxThickness = context.m_globals->currConfig->m_maxThickness;
 
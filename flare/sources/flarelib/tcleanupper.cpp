@@ -330,6 +330,15 @@ void TCleanupper::setParameters(CleanupParameters *parameters) {
 
 //------------------------------------------------------------------------------------
 
+void TCleanupper::warning(const QString &msg) {
+  if (m_warnings)
+    m_warnings->push_back(msg);
+  else
+    DVGui::warning(msg);
+}
+
+//------------------------------------------------------------------------------------
+
 TPalette *TCleanupper::createToonzPaletteFromCleanupPalette() {
   TPalette *cleanupPalette = m_parameters->m_cleanupPalette.getPointer();
   return createToonzPalette(cleanupPalette, 1);
@@ -579,8 +588,7 @@ CleanupPreprocessedImage *TCleanupper::process(
   bool autocentered = getResampleValues(image, aff, blur, outDim, outDpi,
                                         isCameraTest, isSameDpi);
   if (m_parameters->m_autocenterType != AUTOCENTER_NONE && !autocentered)
-    DVGui::warning(
-        QObject::tr("The autocentering failed on the current drawing."));
+    warning(QObject::tr("The autocentering failed on the current drawing."));
 
   bool fromGr8 = (bool)TRasterGR8P(image->getRaster());
   bool toGr8   = (m_parameters->m_lineProcessingMode == lpGrey);
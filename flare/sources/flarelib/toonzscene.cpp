@@ -249,6 +249,22 @@ void fixBiancoProblem(ToonzScene *scene, TXsheet *xsh) {
   }
 }
 
+//-----------------------------------------------------------------------------
+
+//! Reads the version attribute of the scene's root tag.
+VersionNumber readVersionNumber(TIStream &is) {
+  std::string v = is.getTagAttribute("version");
+  VersionNumber versionNumber(0, 0);
+  int k = v.find(".");
+  if (k != (int)std::string::npos && 0 < k && k < (int)v.length()) {
+    versionNumber.first  = std::stoi(v.substr(0, k));
+    versionNumber.second = std::stoi(v.substr(k + 1));
+  }
+  if (versionNumber == VersionNumber(0, 0))
+    throw TException("Bad version number :" + v);
+  return versionNumber;
+}
+
 //-----------------------------------------------------------------------------
 }  // namespace
 //-----------------------------------------------------------------------------
@@ -339,11 +355,12 @@ bool ToonzScene::isUntitled() const {
 
 //-----------------------------------------------------------------------------
 
-void ToonzScene::load(const TFilePath &path, bool withProgressDialog) {
+void ToonzScene::load(const TFilePath &path, bool withProgressDialog,
+                      bool lazily) {
   setIsLoading(true);
   try {
     loadNoResources(path);
-    loadResources(withProgressDialog);
+    loadResources(withProgressDialog, lazily);
   } catch (...) {
     setIsLoading(false);
     throw;
@@ -382,6 +399,45 @@ int ToonzScene::loadFrameCount(const TFilePath &fp) {
 
 //-----------------------------------------------------------------------------
 
+void ToonzScene::loadProperties(const TFilePath &fp) {
+  clear();
+
+  TProjectManager *pm = TProjectManager::instance();
+  auto sceneProject   = pm->loadSceneProject(fp, &m_standAlone);
+
+  TIStream is(fp);
+  if (!is) throw TException(fp.getWideString() + L": Can't open file");
+  try {
+    std::string tagName = "";
+    if (!is.matchTag(tagName) || (tagName != "tab" && tagName != "tnz"))
+      throw TException("Bad file format");
+
+    VersionNumber versionNumber = readVersionNumber(is);
+    setVersionNumber(versionNumber);
+    is.setVersion(versionNumber);
+
+    // Binary scenes jump straight to the section, XML ones skip what precedes
+    is.seekSection("properties");
+    while (is.matchTag(tagName)) {
+      if (tagName == "properties") {
+        m_properties->loadData(is, false);
+        break;
+      }
+      is.skipCurrentTag();
+    }
+  } catch (TException &e) {
+    throw TIStreamException(is, e);
+  } catch (...) {
+    throw TIStreamException(is);
+  }
+
+  setScenePath(fp);
+  if (sceneProject) setProject(sceneProject);
+  m_properties->cloneCamerasTo(getXsheet()->getStageObjectTree());
+}
+
+//-----------------------------------------------------------------------------
+
 void ToonzScene::loadNoResources(const TFilePath &fp) {
   clear();
 
@@ -399,10 +455,10 @@ void ToonzScene::loadNoResources(const TFilePath &fp) {
 /*--
  * プログレスダイアログをGUIからの実行時でのみ表示させる。tcomposerから実行の場合は表示させない
  * --*/
-void ToonzScene::loadResources(bool withProgressDialog) {
+void ToonzScene::loadResources(bool withProgressDialog, bool lazily) {
   /*--- m_levelSet->getLevelCount()が10個以上のとき表示させる　---*/
   QProgressDialog *progressDialog = 0;
-  if (withProgressDialog && m_levelSet->getLevelCount() >= 10) {
+  if (withProgressDialog && !lazily && m_levelSet->getLevelCount() >= 10) {
     progressDialog = new QProgressDialog("Loading Scene Resources", "", 0,
                                          m_levelSet->getLevelCount());
     progressDialog->setModal(true);
@@ -422,7 +478,12 @@ void ToonzScene::loadResources(bool withProgressDialog) {
 
     TXshLevel *level = m_levelSet->getLevel(i);
     try {
-      level->load();
+      // Image levels read their frames and headers in background
+      TXshSimpleLevel *sl = level->getSimpleLevel();
+      if (lazily && sl)
+        sl->loadLazily();
+      else
+        level->load();
     } catch (...) {
     }
   }
@@ -440,16 +501,8 @@ void ToonzScene::loadTnzFile(const TFilePath &fp) {
     if (!is.matchTag(tagName)) throw TException("Bad file format");
 
     if (tagName == "tab" || tagName == "tnz") {
-      std::string rootTagName = tagName;
-      std::string v           = is.getTagAttribute("version");
-      VersionNumber versionNumber(0, 0);
-      int k = v.find(".");
-      if (k != (int)std::string::npos && 0 < k && k < (int)v.length()) {
-        versionNumber.first  = std::stoi(v.substr(0, k));
-        versionNumber.second = std::stoi(v.substr(k + 1));
-      }
-      if (versionNumber == VersionNumber(0, 0))
-        throw TException("Bad version number :" + v);
+      std::string rootTagName     = tagName;
+      VersionNumber versionNumber = readVersionNumber(is);
       setVersionNumber(versionNumber);
       is.setVersion(versionNumber);
       while (is.matchTag(tagName)) {
@@ -617,7 +670,9 @@ void ToonzScene::save(const TFilePath &fp, TXsheet *subxsh) {
   // TOStream os(scenePath, compressionEnabled);
   //  TOStream os(scenePath, false);
   {
-    TOStream os(scenePathTemp, false);
+    // Binary scenes keep the .tnz extension: TIStream recognizes them
+    TOStream os(scenePathTemp, false,
+                Preferences::instance()->isBinarySceneFormatEnabled());
     if (!os.checkStatus())
       throw TException("Could not open temporary save file");
 
@@ -28,6 +28,7 @@
 
 // Qt includes
 #include <QMetaObject>
+#include <QReadWriteLock>
 
 // STD includes
 #include <fstream>
@@ -509,10 +510,11 @@ void TStageObject::onChange(const class TParamChange &c) {
   // Thus, we're just SCHEDULING for a data refresh. The actual refresh happens
   // whenever the scheduled data is accessed.
 
+  // Cached placements are dropped at once, since they are read without
+  // accessing the lazy data
+  invalidate();
   if (c.m_keyframeChanged)
-    m_lazyData.invalidate();  // Both invalidate placement AND keyframes
-  else
-    invalidate();  // Invalidate placement only
+    m_lazyData.invalidate();  // Invalidate keyframes too
 }
 
 //-----------------------------------------------------------------------------
@@ -1252,7 +1254,11 @@ bool TStageObject::isCycleEnabled() const { return m_cycleEnabled; }
 
 //-----------------------------------------------------------------------------
 
-void TStageObject::enableCycle(bool on) { m_cycleEnabled = on; }
+void TStageObject::enableCycle(bool on) {
+  if (m_cycleEnabled == on) return;
+  m_cycleEnabled = on;
+  invalidate();
+}
 
 //-----------------------------------------------------------------------------
 
@@ -1395,15 +1401,49 @@ TAffine TStageObject::computeLocalPlacement(double frame) {
 
 //-----------------------------------------------------------------------------
 
+bool TStageObject::isPlacementCacheable(double frame) const {
+  // hooks, splines and IK depend on data whose changes don't invalidate the
+  // object
+  if ((m_status & STATUS_MASK) != XY || m_ikflag > 0) return false;
+  if (m_handle.length() > 1 && m_handle[0] == 'H') return false;
+  if (m_parentHandle.length() > 1 && m_parentHandle[0] == 'H') return false;
+
+  // ...and so do expressions referring to columns
+  const TDoubleParamP params[] = {m_x,      m_y,      m_rot,
+                                  m_scale,  m_scalex, m_scaley,
+                                  m_shearx, m_sheary};
+  for (const TDoubleParamP &param : params)
+    if (param->hasReferences()) return false;
+
+  // the parent placement has just been computed - and cached, if possible
+  return !m_parent ||
+         m_parent->m_placements.find(frame) != m_parent->m_placements.end();
+}
+
+//-----------------------------------------------------------------------------
+
 TAffine TStageObject::getPlacement(double t) {
+  // cached placements can be read concurrently, while computing them is
+  // exclusive: computations recurse to the parents, and IK invalidates the
+  // objects along the way
+  QReadWriteLock *lock = m_tree->getPlacementLock();
+  {
+    QReadLocker locker(lock);
+
+    std::map<double, TAffine>::const_iterator it = m_placements.find(t);
+    if (it != m_placements.end()) return it->second;
+  }
+
+  QWriteLocker locker(lock);
+
   double &time = lazyData().m_time;
 
   if (time == t) return m_absPlacement;
   if (time != -1) {
     if (!m_parent)
-      invalidate();
+      resetTime();
     else
-      findRoot(t)->invalidate();
+      findRoot(t)->resetTime();
   }
 
   double tt = paramsTime(t);
@@ -1415,6 +1455,13 @@ TAffine TStageObject::getPlacement(double t) {
     place = computeLocalPlacement(tt);
   m_absPlacement = place;
   time           = t;
+
+  if (isPlacementCacheable(t)) {
+    // bound the cache size, as objects may be queried at fractional frames
+    if (m_placements.size() >= 4096) m_placements.clear();
+    m_placements[t] = place;
+  }
+
   return place;
 }
 
@@ -1459,10 +1506,13 @@ void TStageObject::setNoScaleZ(double noScaleZ) {
 //-----------------------------------------------------------------------------
 
 void TStageObject::invalidate(LazyData &ld) const {
+  QWriteLocker locker(m_tree->getPlacementLock());
+
   // Since this is an invalidation function, access to the invalidable data
   // should
   // not trigger a data update
   ld.m_time = -1;
+  m_placements.clear();
 
   std::list<TStageObject *>::const_iterator cit = m_children.begin();
   for (; cit != m_children.end(); ++cit) (*cit)->invalidate();
@@ -1474,6 +1524,15 @@ void TStageObject::invalidate() { invalidate(m_lazyData(tcg::direct_access)); }
 
 //-----------------------------------------------------------------------------
 
+void TStageObject::resetTime() {
+  m_lazyData(tcg::direct_access).m_time = -1;
+
+  std::list<TStageObject *>::const_iterator cit = m_children.begin();
+  for (; cit != m_children.end(); ++cit) (*cit)->resetTime();
+}
+
+//-----------------------------------------------------------------------------
+
 TAffine TStageObject::getParentPlacement(double t) const {
   return m_parent ? m_parent->getPlacement(t) : TAffine();
 }
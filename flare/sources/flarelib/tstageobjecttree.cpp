@@ -16,6 +16,8 @@
 #include "flare/columnfan.h"
 #include "../include/orientation.h"
 
+#include <QReadWriteLock>
+
 using namespace TSyntax;
 
 //=============================================================================
@@ -45,6 +47,9 @@ struct TStageObjectTree::TStageObjectTreeImp {
 
   Grammar *m_grammar;
 
+  //! Guards the placement caches of the stage objects.
+  mutable QReadWriteLock m_placementLock;
+
   /*!
 Constructs a TStageObjectTreeImp with default value.
 */
@@ -69,7 +74,8 @@ TStageObjectTree::TStageObjectTreeImp::TStageObjectTreeImp()
     , m_groupIdCount(0)
     , m_splineCount(0)
     , m_grammar(0)
-    , m_dagGridDimension(eSmall) {}
+    , m_dagGridDimension(eSmall)
+    , m_placementLock(QReadWriteLock::Recursive) {}
 
 //-----------------------------------------------------------------------------
 
@@ -547,6 +553,12 @@ void TStageObjectTree::setHandleManager(HandleManager *hm) {
 
 //-----------------------------------------------------------------------------
 
+QReadWriteLock *TStageObjectTree::getPlacementLock() const {
+  return &m_imp->m_placementLock;
+}
+
+//-----------------------------------------------------------------------------
+
 TPointD TStageObjectTree::getHandlePos(const TStageObjectId &id,
                                        std::string handle, int row) const {
   if (m_imp->m_handleManager)
@@ -5,16 +5,79 @@
 #include "timagecache.h"
 #include "ttoonzimage.h"
 #include "trasterimage.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
 //------------------------------------------------------------------------------------------
 
-TTileSet::Tile::Tile() : m_rasterBounds(TRect()), m_dim(), m_pixelSize(0) {}
+namespace {
+
+// Xors the pixels of ras with those of ref, as raw bytes. Returns a checksum
+// of the pixels of ref, hashed a word at a time along the xor: the reference
+// of a delta is verified without a pass of its own.
+TUINT64 xorRaster(const TRasterP &ras, const TRasterP &ref) {
+  assert(ras->getSize() == ref->getSize() &&
+         ras->getPixelSize() == ref->getPixelSize());
+
+  const TUINT64 prime = 1099511628211ULL;
+  int rowSize         = ras->getLx() * ras->getPixelSize();
+  TUINT64 sum         = 14695981039346656037ULL;
+
+  ras->lock(), ref->lock();
+  for (int y = 0; y < ras->getLy(); ++y) {
+    UCHAR *pix          = ras->getRawData(0, y);
+    const UCHAR *refPix = ref->getRawData(0, y);
+
+    int x = 0;
+    for (; x + (int)sizeof(TUINT64) <= rowSize; x += sizeof(TUINT64)) {
+      TUINT64 a, b;
+      memcpy(&a, pix + x, sizeof(a));
+      memcpy(&b, refPix + x, sizeof(b));
+      sum = (sum ^ b) * prime;
+      a ^= b;
+      memcpy(pix + x, &a, sizeof(a));
+    }
+    for (; x < rowSize; ++x) {
+      sum = (sum ^ refPix[x]) * prime;
+      pix[x] ^= refPix[x];
+    }
+  }
+  ras->unlock(), ref->unlock();
+  return sum;
+}
+
+//------------------------------------------------------------------------------------------
+
+// Tile sets delta-packed against each image, in the order they were packed
+QMutex deltaSetsMutex;
+std::map<std::string, std::vector<TTileSet *>> deltaSets;
+
+}  // namespace
+
+//------------------------------------------------------------------------------------------
+
+TTileSet::Tile::Tile()
+    : m_rasterBounds(TRect())
+    , m_dim()
+    , m_pixelSize(0)
+    , m_packing(UNPACKED)
+    , m_packedSize(0)
+    , m_referenceSum(0) {}
 
 //------------------------------------------------------------------------------------------
 
 TTileSet::Tile::Tile(const TRasterP &ras, const TPoint &p)
     : m_rasterBounds(ras->getBounds() + p)
     , m_dim(ras->getSize())
-    , m_pixelSize(ras->getPixelSize()) {}
+    , m_pixelSize(ras->getPixelSize())
+    , m_packing(UNPACKED)
+    , m_packedSize(0)
+    , m_referenceSum(0) {}
 
 //------------------------------------------------------------------------------------------
 
@@ -22,7 +85,149 @@ TTileSet::Tile::~Tile() {}
 
 //------------------------------------------------------------------------------------------
 
-TTileSet::~TTileSet() { clearPointerContainer(m_tiles); }
+void TTileSet::Tile::pack(const TRasterP &reference) {
+  if (m_packing != UNPACKED) return;
+
+  TImageP img = TImageCache::instance()->get(id(), false);
+  if (!img) return;
+
+  TRasterP ras;
+  if (TToonzImageP ti = img)
+    ras = ti->getRaster();
+  else if (TRasterImageP ri = img)
+    ras = ri->getRaster();
+  if (!ras || ras->getLx() != ras->getWrap()) return;
+
+  // Only the raster types known to the codec
+  if (!TRaster32P(ras) && !TRaster64P(ras) && !TRasterCM32P(ras) &&
+      !TRasterGR8P(ras) && !TRasterGR16P(ras))
+    return;
+
+  bool delta = reference && reference->getPixelSize() == m_pixelSize &&
+               reference->getBounds().contains(m_rasterBounds);
+  TUINT64 referenceSum = 0;
+  if (delta) {
+    TRect bounds = m_rasterBounds;
+    ras          = ras->clone();
+    referenceSum = xorRaster(ras, reference->extract(bounds));
+  }
+
+  TINT32 packedSize = 0;
+  TRasterP packed;
+  try {
+    TRasterCodecLz4 codec("LZ4", false);
+    packed = codec.compress(ras, 1, packedSize);
+  } catch (...) {
+  }
+  if (!packed) return;  // keep the plain raster
+
+  TImageCache::instance()->add(id(), TRasterImageP(packed), true);
+  m_packing      = delta ? LZ4_DELTA : LZ4;
+  m_packedSize   = packedSize;
+  m_referenceSum = referenceSum;
+}
+
+//------------------------------------------------------------------------------------------
+
+bool TTileSet::Tile::unpack(const TRasterP &reference) {
+  if (m_packing == UNPACKED) return true;
+
+  TRasterP ras = (m_packing == LZ4) ? getUnpackedRaster()
+                                    : getDeltaRaster(reference);
+  if (!ras) return false;
+
+  m_packing    = UNPACKED;
+  m_packedSize = 0;
+  setRaster(ras);
+  return true;
+}
+
+//------------------------------------------------------------------------------------------
+
+TRasterP TTileSet::Tile::getUnpackedRaster() const {
+  if (m_packing != LZ4) return TRasterP();
+
+  TRasterImageP ri = TImageCache::instance()->get(id(), false);
+  if (!ri) return TRasterP();
+
+  TRasterP ras;
+  TRasterCodecLz4 codec("LZ4", false);
+  codec.decompress(ri->getRaster(), ras);
+  return ras;
+}
+
+//------------------------------------------------------------------------------------------
+
+TRasterP TTileSet::Tile::getDeltaRaster(const TRasterP &reference) const {
+  if (m_packing != LZ4_DELTA || !reference ||
+      reference->getPixelSize() != m_pixelSize ||
+      !reference->getBounds().contains(m_rasterBounds))
+    return TRasterP();
+
+  TRasterImageP ri = TImageCache::instance()->get(id(), false);
+  if (!ri) return TRasterP();
+
+  TRasterP ras;
+  TRasterCodecLz4 codec("LZ4", false);
+  codec.decompress(ri->getRaster(), ras);
+  if (!ras) return TRasterP();
+
+  // The reference must not have been modified since the tile was packed:
+  // the xor would yield garbage
+  TRect bounds = m_rasterBounds;
+  if (xorRaster(ras, reference->extract(bounds)) != m_referenceSum)
+    return TRasterP();
+  return ras;
+}
+
+//------------------------------------------------------------------------------------------
+
+TRasterP TTileSet::Tile::dropDelta(const TRasterP &reference) {
+  TRasterP ras = getDeltaRaster(reference);
+  if (!ras) return TRasterP();
+
+  m_packing    = UNPACKED;
+  m_packedSize = 0;
+  setRaster(ras);
+  pack(TRasterP());
+  return ras;
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::Tile::copyStorage(Tile *dst) const {
+  dst->m_rasterBounds = m_rasterBounds;
+  dst->m_dim          = m_dim;
+  dst->m_pixelSize    = m_pixelSize;
+  dst->m_packing      = m_packing;
+  dst->m_packedSize   = m_packedSize;
+  dst->m_referenceSum = m_referenceSum;
+
+  TImageP img = TImageCache::instance()->get(id(), false);
+  if (img) TImageCache::instance()->add(dst->id(), img->cloneImage());
+}
+
+//------------------------------------------------------------------------------------------
+
+TTileSet::~TTileSet() {
+  unregisterDeltas();
+  clearPointerContainer(m_tiles);
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::unregisterDeltas() {
+  if (m_referenceId.empty()) return;
+
+  QMutexLocker locker(&deltaSetsMutex);
+  auto it = deltaSets.find(m_referenceId);
+  if (it != deltaSets.end()) {
+    std::vector<TTileSet *> &sets = it->second;
+    sets.erase(std::remove(sets.begin(), sets.end(), this), sets.end());
+    if (sets.empty()) deltaSets.erase(it);
+  }
+  m_referenceId.clear();
+}
 
 //------------------------------------------------------------------------------------------
 
@@ -57,6 +262,128 @@ int TTileSet::getMemorySize() const {
   return size;
 }
 
+//------------------------------------------------------------------------------------------
+
+void TTileSet::pack(const TRasterP &reference, const std::string &imageId) {
+  // Tiles overlapping others (eg saved again by a redo) may be pasted over
+  // pixels that differ from the reference: they are packed without delta
+  std::vector<bool> overlaps(m_tiles.size(), false);
+  if (reference) {
+    std::vector<int> order(m_tiles.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+      return m_tiles[a]->m_rasterBounds.x0 < m_tiles[b]->m_rasterBounds.x0;
+    });
+
+    for (int i = 0; i < (int)order.size(); ++i) {
+      const TRect &bounds = m_tiles[order[i]]->m_rasterBounds;
+      for (int j = i + 1; j < (int)order.size(); ++j) {
+        const TRect &other = m_tiles[order[j]]->m_rasterBounds;
+        if (other.x0 > bounds.x1) break;
+        if (bounds.overlaps(other)) overlaps[order[i]] = overlaps[order[j]] = true;
+      }
+    }
+  }
+
+  bool delta = false;
+  for (int i = 0; i < (int)m_tiles.size(); ++i) {
+    m_tiles[i]->pack(overlaps[i] ? TRasterP() : reference);
+    delta = delta || m_tiles[i]->m_packing == Tile::LZ4_DELTA;
+  }
+
+  if (delta && !imageId.empty() && m_referenceId.empty()) {
+    QMutexLocker locker(&deltaSetsMutex);
+    m_referenceId = imageId;
+    deltaSets[imageId].push_back(this);
+  }
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::unpack(const TRasterP &reference) {
+  for (Tiles::iterator it = m_tiles.begin(); it != m_tiles.end();) {
+    if ((*it)->unpack(reference)) {
+      ++it;
+      continue;
+    }
+    // Pasting the tile would corrupt the image
+    qWarning("TTileSet: the tile reference has changed, cannot restore it");
+    delete *it;
+    it = m_tiles.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::dropDeltas(const TRasterP &reference) {
+  bool delta = false;
+  for (Tile *tile : m_tiles)
+    if (tile->m_packing == Tile::LZ4_DELTA)
+      delta = !tile->dropDelta(reference) || delta;
+
+  if (!delta) unregisterDeltas();
+}
+
+//------------------------------------------------------------------------------------------
+
+bool TTileSet::hasDeltas(const std::string &imageId) {
+  QMutexLocker locker(&deltaSetsMutex);
+  return deltaSets.count(imageId) > 0;
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::rebaseDeltas(const std::string &imageId,
+                            const TRasterP &raster) {
+  QMutexLocker locker(&deltaSetsMutex);
+  auto it = deltaSets.find(imageId);
+  if (it == deltaSets.end()) return;
+
+  std::vector<TTileSet *> sets;
+  sets.swap(it->second);
+  deltaSets.erase(it);
+
+  // Each set is the reference of the previous one, once its tiles are pasted
+  // over it: walk them back from the newest, on a copy of the image
+  TRasterP work = raster ? raster->clone() : TRasterP();
+  for (auto st = sets.rbegin(); st != sets.rend(); ++st) {
+    (*st)->m_referenceId.clear();
+    (*st)->rebase(work);
+  }
+}
+
+//------------------------------------------------------------------------------------------
+
+void TTileSet::rebase(const TRasterP &raster) {
+  std::vector<TRasterP> rasters(m_tiles.size());
+  bool matched = false;
+
+  for (int i = 0; i < (int)m_tiles.size(); ++i) {
+    Tile *tile = m_tiles[i];
+    if (tile->m_packing == Tile::LZ4_DELTA) {
+      // Undone sets are plain copies already (see dropDeltas()): a tile
+      // whose reference doesn't match was edited outside of the undos
+      rasters[i] = tile->dropDelta(raster);
+      if (rasters[i]) matched = true;
+    } else if (tile->m_packing == Tile::LZ4)
+      rasters[i] = tile->getUnpackedRaster();
+    else if (TImageP img = TImageCache::instance()->get(tile->id(), false)) {
+      if (TToonzImageP ti = img)
+        rasters[i] = ti->getRaster();
+      else if (TRasterImageP ri = img)
+        rasters[i] = ri->getRaster();
+    }
+  }
+
+  // Bring the image back to the state preceding this set, the reference of
+  // the older ones. The first saved tile holds the original pixels where
+  // tiles overlap.
+  if (!matched) return;
+  for (int i = (int)m_tiles.size() - 1; i >= 0; --i)
+    if (rasters[i])
+      raster->copy(rasters[i], m_tiles[i]->m_rasterBounds.getP00());
+}
+
 //******************************************************************************************
 
 TTileSetCM32::Tile::Tile() : TTileSet::Tile() {}
@@ -79,6 +406,11 @@ TTileSetCM32::~TTileSetCM32() {}
 //------------------------------------------------------------------------------------------
 
 void TTileSetCM32::Tile::getRaster(TRasterCM32P &ras) const {
+  if (m_packing != UNPACKED) {
+    ras = getUnpackedRaster();
+    assert(ras);
+    return;
+  }
   TToonzImageP timg = (TToonzImageP)TImageCache::instance()->get(id(), true);
   if (!timg) return;
   ras = timg->getRaster();
@@ -87,12 +419,18 @@ void TTileSetCM32::Tile::getRaster(TRasterCM32P &ras) const {
 
 //------------------------------------------------------------------------------------------
 
+void TTileSetCM32::Tile::setRaster(const TRasterP &ras) {
+  TRasterCM32P rasCM32(ras);
+  assert(rasCM32);
+  TImageCache::instance()->add(id(),
+                               TToonzImageP(rasCM32, rasCM32->getBounds()));
+}
+
+//------------------------------------------------------------------------------------------
+
 TTileSetCM32::Tile *TTileSetCM32::Tile::clone() const {
-  Tile *tile           = new Tile();
-  tile->m_rasterBounds = m_rasterBounds;
-  TToonzImageP timg    = (TToonzImageP)TImageCache::instance()->get(id(), true);
-  if (!timg) return tile;
-  TImageCache::instance()->add(tile->id(), timg->clone());
+  Tile *tile = new Tile();
+  copyStorage(tile);
   return tile;
 }
 
@@ -156,6 +494,11 @@ TTileSetFullColor::~TTileSetFullColor() {}
 //------------------------------------------------------------------------------------------
 
 void TTileSetFullColor::Tile::getRaster(TRasterP &ras) const {
+  if (m_packing != UNPACKED) {
+    ras = getUnpackedRaster();
+    assert(!!ras);
+    return;
+  }
   TRasterImageP img = (TRasterImageP)TImageCache::instance()->get(id(), true);
   if (!img) return;
   ras = img->getRaster();
@@ -164,13 +507,15 @@ void TTileSetFullColor::Tile::getRaster(TRasterP &ras) const {
 
 //------------------------------------------------------------------------------------------
 
+void TTileSetFullColor::Tile::setRaster(const TRasterP &ras) {
+  TImageCache::instance()->add(id(), TRasterImageP(ras));
+}
+
+//------------------------------------------------------------------------------------------
+
 TTileSetFullColor::Tile *TTileSetFullColor::Tile::clone() const {
-  Tile *tile           = new Tile();
-  tile->m_rasterBounds = m_rasterBounds;
-  TRasterImageP img = (TRasterImageP)TImageCache::instance()->get(id(), true);
-  if (!img) return tile;
-  TRasterImageP clonedImage(img->getRaster()->clone());
-  TImageCache::instance()->add(tile->id(), clonedImage);
+  Tile *tile = new Tile();
+  copyStorage(tile);
   return tile;
 }
 
@@ -18,6 +18,8 @@
 #include "flare/levelset.h"
 #include "flare/tcamera.h"
 #include "flare/sceneproperties.h"
+#include "flare/rastermipmaps.h"
+#include "flare/ttileset.h"
 
 // TnzBase includes
 #include "tenv.h"
@@ -39,6 +41,7 @@
 #include "tsystem.h"
 #include "tcontenthistory.h"
 #include "tfilepath.h"
+#include "tfunctorinvoker.h"
 
 // Qt includes
 #include <QDir>
@@ -152,6 +155,25 @@ void getIndexesRangefromFids(TXshSimpleLevel* level,
   }
 }
 
+//-----------------------------------------------------------------------------
+
+//! Turns the undo tiles delta-packed against an image into plain copies,
+//! before the image is replaced or reloaded.
+void rebaseUndoTiles(const std::string& imageId) {
+  if (!TTileSet::hasDeltas(imageId)) return;
+
+  TRasterP ras;
+  ImageManager* im = ImageManager::instance();
+  if (im->isCached(imageId)) {
+    TImageP img = im->getImage(imageId, ImageManager::dontPutInCache, 0);
+    if (TToonzImageP ti = img)
+      ras = ti->getRaster();
+    else if (TRasterImageP ri = img)
+      ras = ri->getRaster();
+  }
+  TTileSet::rebaseDeltas(imageId, ras);
+}
+
 }  // namespace
 
 //******************************************************************************************
@@ -173,11 +195,14 @@ TXshSimpleLevel::TXshSimpleLevel(const std::wstring& name)
     , m_16BitChannelLevel(false)
     , m_floatChannelLevel(false)
     , m_isReadOnly(false)
-    , m_temporaryHookMerged(false) {}
+    , m_temporaryHookMerged(false)
+    , m_pendingLoad(false)
+    , m_completingLoad(false) {}
 
 //-----------------------------------------------------------------------------
 
 TXshSimpleLevel::~TXshSimpleLevel() {
+  m_pendingLoad = false;  // No need to complete lazy loads
   clearFrames();
 
   if (m_palette) {
@@ -190,6 +215,7 @@ TXshSimpleLevel::~TXshSimpleLevel() {
 
 void TXshSimpleLevel::setEditableRange(unsigned int from, unsigned int to,
                                        const std::wstring& userName) {
+  resolveLoad();
   assert(from <= to && to < static_cast<unsigned int>(getFrameCount()));
 
   for (unsigned int i = from; i <= to; i++) {
@@ -288,6 +314,7 @@ std::wstring TXshSimpleLevel::getEditableFileName() {
 //-----------------------------------------------------------------------------
 
 std::set<TFrameId> TXshSimpleLevel::getEditableRange() {
+  resolveLoad();
   return m_editableRange;
 }
 
@@ -308,12 +335,14 @@ void TXshSimpleLevel::setDirtyFlag(bool on) { m_properties->setDirtyFlag(on); }
 //-----------------------------------------------------------------------------
 
 bool TXshSimpleLevel::getDirtyFlag() const {
+  resolveLoad();
   return m_properties->getDirtyFlag();
 }
 
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::touchFrame(const TFrameId& fid) {
+  resolveLoad();
   m_properties->setDirtyFlag(true);
   TContentHistory* ch = getContentHistory();
   if (!ch) {
@@ -329,6 +358,10 @@ void TXshSimpleLevel::touchFrame(const TFrameId& fid) {
   if (getType() & FULLCOLOR_TYPE) {
     std::string id = filled(getImageId(fid));
     ImageManager::instance()->invalidate(id);
+
+    // The raster was modified in place: its mipmaps are stale
+    TRasterImageP ri = TImageCache::instance()->get(getImageId(fid), false);
+    if (ri) RasterMipmaps::instance()->invalidate(ri->getRaster());
   }
 }
 
@@ -352,12 +385,14 @@ void TXshSimpleLevel::onPaletteChanged() {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::setScannedPath(const TFilePath& fp) {
+  resolveLoad();
   m_scannedPath = fp;
 }
 
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::setPath(const TFilePath& fp, bool keepFrames) {
+  resolveLoad();
   m_path = fp;
   if (!keepFrames) {
     clearFrames();
@@ -402,7 +437,10 @@ void TXshSimpleLevel::clonePropertiesFrom(const TXshSimpleLevel* oldSl) {
 
 //-----------------------------------------------------------------------------
 
-TPalette* TXshSimpleLevel::getPalette() const { return m_palette; }
+TPalette* TXshSimpleLevel::getPalette() const {
+  resolveLoad();
+  return m_palette;
+}
 
 //-----------------------------------------------------------------------------
 
@@ -425,24 +463,28 @@ void TXshSimpleLevel::setPalette(TPalette* palette) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::getFids(std::vector<TFrameId>& fids) const {
+  resolveLoad();
   fids.assign(m_frames.begin(), m_frames.end());
 }
 
 //-----------------------------------------------------------------------------
 
 std::vector<TFrameId> TXshSimpleLevel::getFids() const {
+  resolveLoad();
   return std::vector<TFrameId>(m_frames.begin(), m_frames.end());
 }
 
 //-----------------------------------------------------------------------------
 
 bool TXshSimpleLevel::isFid(const TFrameId& fid) const {
+  resolveLoad();
   return m_frames.count(fid) > 0;
 }
 
 //-----------------------------------------------------------------------------
 
 const TFrameId& TXshSimpleLevel::getFrameId(int index) const {
+  resolveLoad();
   static const TFrameId emptyFrameId(TFrameId::NO_FRAME);
   if (index < 0 || index >= static_cast<int>(m_frames.size())) {
     return emptyFrameId;
@@ -455,18 +497,21 @@ const TFrameId& TXshSimpleLevel::getFrameId(int index) const {
 //-----------------------------------------------------------------------------
 
 TFrameId TXshSimpleLevel::getFirstFid() const {
+  resolveLoad();
   return !isEmpty() ? *m_frames.begin() : TFrameId(TFrameId::NO_FRAME);
 }
 
 //-----------------------------------------------------------------------------
 
 TFrameId TXshSimpleLevel::getLastFid() const {
+  resolveLoad();
   return !isEmpty() ? *m_frames.rbegin() : TFrameId(TFrameId::NO_FRAME);
 }
 
 //-----------------------------------------------------------------------------
 
 int TXshSimpleLevel::guessStep() const {
+  resolveLoad();
   int frameCount = static_cast<int>(m_frames.size());
   if (frameCount < 2) {
     return 1;  // a level with zero or one frame has step=1 by definition
@@ -503,6 +548,7 @@ int TXshSimpleLevel::guessStep() const {
 //-----------------------------------------------------------------------------
 
 int TXshSimpleLevel::fid2index(const TFrameId& fid) const {
+  resolveLoad();
   auto ft = m_frames.find(fid);
   return (ft != m_frames.end())
              ? static_cast<int>(std::distance(m_frames.begin(), ft))
@@ -512,6 +558,7 @@ int TXshSimpleLevel::fid2index(const TFrameId& fid) const {
 //-----------------------------------------------------------------------------
 
 int TXshSimpleLevel::guessIndex(const TFrameId& fid) const {
+  resolveLoad();
   if (m_frames.empty()) return 0;  // no frames, return 0 (by definition)
 
   auto ft = m_frames.lower_bound(fid);
@@ -531,6 +578,7 @@ int TXshSimpleLevel::guessIndex(const TFrameId& fid) const {
 //-----------------------------------------------------------------------------
 
 TFrameId TXshSimpleLevel::index2fid(int index) const {
+  resolveLoad();
   if (index < 0) return TFrameId(-2);
 
   int frameCount = static_cast<int>(m_frames.size());
@@ -552,6 +600,7 @@ TFrameId TXshSimpleLevel::index2fid(int index) const {
 
 TImageP TXshSimpleLevel::getFrame(const TFrameId& fid, UCHAR imFlags,
                                   int subsampling) const {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   // If the required frame is not in range, quit
@@ -573,6 +622,7 @@ TImageP TXshSimpleLevel::getFrame(const TFrameId& fid, UCHAR imFlags,
 
 TImageInfo* TXshSimpleLevel::getFrameInfo(const TFrameId& fid,
                                           bool toBeModified) {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   // If the required frame is not in range, quit
@@ -589,6 +639,7 @@ TImageInfo* TXshSimpleLevel::getFrameInfo(const TFrameId& fid,
 //-----------------------------------------------------------------------------
 
 TImageP TXshSimpleLevel::getFrameIcon(const TFrameId& fid) const {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   if (m_frames.count(fid) == 0) return TImageP();
@@ -631,6 +682,7 @@ void TXshSimpleLevel::loadAllIconsAndPutInCache(bool cacheImagesAsWell) {
 
 TRasterImageP TXshSimpleLevel::getFrameToCleanup(const TFrameId& fid,
                                                  bool toBeLineProcessed) const {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   auto ft = m_frames.find(fid);
@@ -662,6 +714,7 @@ TRasterImageP TXshSimpleLevel::getFrameToCleanup(const TFrameId& fid,
 
 TImageP TXshSimpleLevel::getFullsampledFrame(const TFrameId& fid,
                                              UCHAR imFlags) const {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   auto it = m_frames.find(fid);
@@ -683,6 +736,7 @@ TImageP TXshSimpleLevel::getFullsampledFrame(const TFrameId& fid,
 
 TRasterImageP TXshSimpleLevel::getFrameRasterized(const TFrameId& fid,
                                                   TPointD dpi) const {
+  resolveLoad();
   assert(m_type == PLI_XSHLEVEL);
 
   auto it = m_frames.find(fid);
@@ -795,6 +849,7 @@ void TXshSimpleLevel::formatFId(TFrameId& fid, TFrameId _tmplFId) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::setFrame(const TFrameId& fid, const TImageP& img) {
+  resolveLoad();
   assert(m_type != UNKNOWN_XSHLEVEL);
 
   if (img) {
@@ -818,6 +873,7 @@ void TXshSimpleLevel::setFrame(const TFrameId& fid, const TImageP& img) {
     ImageManager::instance()->bind(imageId, new ImageLoader(decodedPath, fid));
   }
 
+  rebaseUndoTiles(imageId);
   ImageManager::instance()->setImage(imageId, img);
 
   if (frameStatus == Normal) {
@@ -844,6 +900,7 @@ void TXshSimpleLevel::setFrame(const TFrameId& fid, const TImageP& img) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::eraseFrame(const TFrameId& fid) {
+  resolveLoad();
   auto ft = m_frames.find(fid);
   if (ft == m_frames.end()) return;
 
@@ -861,6 +918,7 @@ void TXshSimpleLevel::eraseFrame(const TFrameId& fid) {
   ImageManager* im = ImageManager::instance();
   TImageCache* ic  = TImageCache::instance();
 
+  rebaseUndoTiles(getImageId(fid, Normal));
   im->unbind(getImageId(fid, Normal));
   im->unbind(getImageId(fid, Scanned));
   im->unbind(getImageId(fid, CleanupPreview));
@@ -883,6 +941,7 @@ void TXshSimpleLevel::eraseFrame(const TFrameId& fid) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::clearFrames() {
+  resolveLoad();
   ImageManager* im = ImageManager::instance();
   TImageCache* ic  = TImageCache::instance();
 
@@ -1043,8 +1102,154 @@ public:
   }
 } loadingLevelRange;
 
+//-----------------------------------------------------------------------------
+
+//! The data a level load reads from the level files.
+struct LevelInfo {
+  TLevelP m_level;
+  QString m_creator;
+  std::unique_ptr<TImageInfo> m_imageInfo;  //!< The first frame's, if any
+  std::unique_ptr<TContentHistory> m_contentHistory;
+
+  //! The first frame's info as ImageManager reads it - only read in
+  //! background, by lazy loads
+  TImageInfo m_frameInfo;
+  bool m_hasFrameInfo = false;
+};
+
+//-----------------------------------------------------------------------------
+
+void readLevelInfo(const TFilePath& path, LevelInfo& info,
+                   bool readFrameInfo) {
+  TLevelReaderP lr(path);
+  assert(lr);
+
+  info.m_level = lr->loadInfo();
+  if (info.m_level->getFrameCount() > 0) {
+    const TFrameId& firstFid = info.m_level->begin()->first;
+    if (const TImageInfo* imageInfo = lr->getImageInfo(firstFid))
+      info.m_imageInfo.reset(new TImageInfo(*imageInfo));
+
+    if (readFrameInfo) {
+      try {
+        TImageReaderP ir = lr->getFrameReader(firstFid);
+        info.m_hasFrameInfo =
+            ir && ImageBuilder::setImageInfo(info.m_frameInfo, ir.getPointer());
+      } catch (...) {
+      }
+    }
+  }
+
+  info.m_creator = lr->getCreator();
+  if (lr->getContentHistory())
+    info.m_contentHistory.reset(lr->getContentHistory()->clone());
+}
+
+//-----------------------------------------------------------------------------
+
+//! Shows a level load warning. Lazy loads may complete anywhere - even in
+//! render threads - so their warnings are posted to the main event loop.
+void showLoadWarning(const QString& title, const QString& msg, bool deferred) {
+  if (deferred)
+    QTimer::singleShot(0, qApp, [title, msg]() {
+      QMessageBox::warning(nullptr, title, msg);
+    });
+  else
+    QMessageBox::warning(nullptr, title, msg);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Links the colors of a palette to the studio palettes, in the main thread.
+class LinkedColorsUpdater final : public TFunctorInvoker::BaseFunctor {
+  TPaletteP m_palette;
+
+public:
+  LinkedColorsUpdater(TPalette* palette) : m_palette(palette) {}
+
+  void operator()() override {
+    StudioPalette::instance()->updateLinkedColors(m_palette.getPointer());
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+class LazyLoads {
+public:
+  //! Runs the reads of lazy loads. They mostly wait on storage, so more of
+  //! them than cores run at once.
+  TThread::Executor m_executor;
+
+  //! Serializes completions, which may be requested by render threads too.
+  QMutex m_mutex;
+
+public:
+  LazyLoads() : m_mutex(QMutex::Recursive) { m_executor.setMaxActiveTasks(8); }
+
+  static LazyLoads& instance() {
+    static LazyLoads theInstance;
+    return theInstance;
+  }
+};
+
 }  // namespace
 
+//******************************************************************************************
+//    TXshSimpleLevel::InfoReader  definition
+//******************************************************************************************
+
+class TXshSimpleLevel::InfoReader final : public TThread::Runnable {
+  TFilePath m_path;
+  bool m_readFrameInfo;
+
+  QMutex m_mutex;
+  bool m_done, m_ok;
+
+  std::atomic<bool> m_started, m_prioritized;
+
+public:
+  LevelInfo m_info;
+
+public:
+  InfoReader(const TFilePath& path, bool readFrameInfo)
+      : m_path(path)
+      , m_readFrameInfo(readFrameInfo)
+      , m_done(false)
+      , m_ok(false)
+      , m_started(false)
+      , m_prioritized(false) {}
+
+  //! Raises the scheduling priority of a read that has not started yet.
+  //! Returns whether the priority changed.
+  bool prioritize() {
+    if (m_started || m_prioritized) return false;
+    m_prioritized = true;
+    return true;
+  }
+
+  //! Reads the level info once, waiting for the read in progress if any.
+  //! Returns whether the read succeeded.
+  bool read() {
+    QMutexLocker locker(&m_mutex);
+    if (!m_done) {
+      try {
+        readLevelInfo(m_path, m_info, m_readFrameInfo);
+        m_ok = true;
+      } catch (...) {
+      }
+      m_done = true;
+    }
+    return m_ok;
+  }
+
+  int schedulingPriority() override { return m_prioritized ? 10 : 5; }
+
+  void run() override {
+    m_started = true;
+    read();
+  }
+};
+
 //-----------------------------------------------------------------------------
 
 void setLoadingLevelRange(const TFrameId& fromFid, const TFrameId& toFid) {
@@ -1102,13 +1307,29 @@ static TFilePath getLevelPathAndSetNameWithPsdLevelName(
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::load() {
+  if (m_pendingLoad) {
+    // Only the completing thread may get past a pending load, and it holds
+    // the lock
+    QMutexLocker locker(&LazyLoads::instance().m_mutex);
+    if (m_pendingLoad && !m_completingLoad) {
+      completeLoad();
+      return;
+    }
+  }
+
+  // Level ranges apply to the current load only, never to completions - which
+  // may run in other threads, while the main thread sets a range
+  LoadingLevelRange range;
+  if (!m_completingLoad) range = loadingLevelRange;
+
   getProperties()->setCreator("");
   QString creator;
+  LevelInfo levelInfo;
 
   assert(getScene());
   if (!getScene()) return;
 
-  m_isSubsequence = loadingLevelRange.isEnabled();
+  m_isSubsequence = range.isEnabled();
 
   TFilePath checkpath = getScene()->decodeFilePath(m_path);
   std::string type    = checkpath.getType();
@@ -1127,7 +1348,7 @@ void TXshSimpleLevel::load() {
       } else {
         for (TLevel::Iterator it = level->begin(); it != level->end(); ++it) {
           TFrameId fid = it->first;
-          if (!loadingLevelRange.match(fid)) continue;
+          if (!range.match(fid)) continue;
           setFrameStatus(
               fid, (getFrameStatus(fid) & ~ScannedCleanuppedMask) | Scanned);
           setFrame(fid, TImageP());
@@ -1150,7 +1371,7 @@ void TXshSimpleLevel::load() {
       } else {
         for (TLevel::Iterator it = level->begin(); it != level->end(); ++it) {
           TFrameId fid = it->first;
-          if (!loadingLevelRange.match(fid)) continue;
+          if (!range.match(fid)) continue;
           setFrameStatus(fid, getFrameStatus(fid) | Cleanupped);
           setFrame(fid, TImageP());
         }
@@ -1166,10 +1387,14 @@ void TXshSimpleLevel::load() {
     TFilePath path = getScene()->decodeFilePath(m_path);
     getProperties()->setDirtyFlag(false);
 
-    TLevelReaderP lr(path);
-    assert(lr);
+    // Lazy loads have the level info read in background
+    InfoReader* reader = static_cast<InfoReader*>(m_infoReader.getPointer());
+    if (reader && reader->read())
+      std::swap(levelInfo, reader->m_info);
+    else
+      readLevelInfo(path, levelInfo, false);
 
-    TLevelP level = lr->loadInfo();
+    TLevelP level = levelInfo.m_level;
     if (level->isPartialLoad()) {
       QString msg =
           QString(
@@ -1177,18 +1402,18 @@ void TXshSimpleLevel::load() {
               "Possible file corruption. Loaded what could be found.\n"
               "Recommend replacing any bad frames in Level Strip and saving.")
               .arg(QString::fromStdWString(m_path.getWideString()));
-      QMessageBox::warning(nullptr, "File load warning", msg);
+      showLoadWarning("File load warning", msg, m_completingLoad);
       setDirtyFlag(true);
     }
 
     if (level->getFrameCount() > 0) {
-      const TImageInfo* info = lr->getImageInfo(level->begin()->first);
+      const TImageInfo* info = levelInfo.m_imageInfo.get();
       if (info && info->m_samplePerPixel >= 5) {
         QString msg = QString(
                           "Failed to open %1.\nSamples per pixel is more than "
                           "4. It may contain more than one alpha channel.")
                           .arg(QString::fromStdWString(m_path.getWideString()));
-        QMessageBox::warning(nullptr, "Image format not supported", msg);
+        showLoadWarning("Image format not supported", msg, m_completingLoad);
         return;
       }
 
@@ -1204,22 +1429,21 @@ void TXshSimpleLevel::load() {
       setPalette(level->getPalette());
     }
 
-    if (!checkCreatorString(creator = lr->getCreator())) {
+    if (!checkCreatorString(creator = levelInfo.m_creator)) {
       getProperties()->setIsForbidden(true);
     } else {
       for (TLevel::Iterator it = level->begin(); it != level->end(); ++it) {
         m_renumberTable[it->first] = it->first;
-        if (!loadingLevelRange.match(it->first)) continue;
+        if (!range.match(it->first)) continue;
         setFrame(it->first, TImageP());
       }
     }
 
-    setContentHistory(lr->getContentHistory() ? lr->getContentHistory()->clone()
-                                              : nullptr);
+    setContentHistory(levelInfo.m_contentHistory.release());
   }
 
   getProperties()->setCreator(creator.toStdString());
-  loadingLevelRange.reset();
+  if (!m_completingLoad) loadingLevelRange.reset();
 
   if (getType() != PLI_XSHLEVEL) {
     if (m_properties->getImageDpi() == TPointD() && !m_frames.empty()) {
@@ -1230,7 +1454,10 @@ void TXshSimpleLevel::load() {
       std::string imageId      = getImageId(firstFid);
 
       const TImageInfo* imageInfo =
-          ImageManager::instance()->getInfo(imageId, ImageManager::none, 0);
+          levelInfo.m_hasFrameInfo
+              ? &levelInfo.m_frameInfo
+              : ImageManager::instance()->getInfo(imageId, ImageManager::none,
+                                                  0);
       if (imageInfo) {
         imageRes.lx = imageInfo->m_lx;
         imageRes.ly = imageInfo->m_ly;
@@ -1246,7 +1473,13 @@ void TXshSimpleLevel::load() {
   }
 
   if (getPalette() && StudioPalette::isEnabled()) {
-    StudioPalette::instance()->updateLinkedColors(getPalette());
+    // The studio palettes table is the main thread's
+    if (QThread::currentThread() == qApp->thread())
+      StudioPalette::instance()->updateLinkedColors(getPalette());
+    else
+      QMetaObject::invokeMethod(
+          TFunctorInvoker::instance(), "invoke", Qt::QueuedConnection,
+          Q_ARG(void*, new LinkedColorsUpdater(getPalette())));
   }
 
   TFilePath refImgName;
@@ -1368,6 +1601,92 @@ void TXshSimpleLevel::load(const std::vector<TFrameId>& fIds) {
 
 //-----------------------------------------------------------------------------
 
+void TXshSimpleLevel::loadLazily() {
+  assert(getScene());
+
+  // Psd levels depend on the scene loading state, scanned ones are read
+  // twice - and level ranges apply to the current load only
+  if (!getScene() || m_scannedPath != TFilePath() ||
+      m_path.getType() == "psd" || loadingLevelRange.isEnabled()) {
+    load();
+    return;
+  }
+
+  bool readFrameInfo = getType() != PLI_XSHLEVEL &&
+                       m_properties->getImageDpi() == TPointD();
+
+  InfoReader* reader =
+      new InfoReader(getScene()->decodeFilePath(m_path), readFrameInfo);
+  connect(reader, SIGNAL(finished(TThread::RunnableP)), this,
+          SLOT(onInfoRead()));
+
+  // The full-color palette is built, unguarded, at its first use: build it
+  // here rather than in a completion running in another thread
+  if (getType() & FULLCOLOR_TYPE)
+    FullColorPalette::instance()->getPalette(getScene());
+
+  m_infoReader  = reader;
+  m_pendingLoad = true;
+
+  // The read-only state is checked right after scenes are loaded, and costs
+  // little
+  updateReadOnly();
+
+  LazyLoads::instance().m_executor.addTask(reader);
+}
+
+//-----------------------------------------------------------------------------
+
+void TXshSimpleLevel::completeLoad() {
+  QMutexLocker locker(&LazyLoads::instance().m_mutex);
+  if (!m_pendingLoad || m_completingLoad) return;
+
+  m_completingLoad = true;
+
+  try {
+    load();
+  } catch (...) {
+  }
+
+  m_infoReader     = TThread::RunnableP();
+  m_completingLoad = false;
+  m_pendingLoad    = false;
+
+  emit loadCompleted();
+
+  if (m_properties->isForbidden())
+    showLoadWarning("File load warning",
+                    QString("Level '%1' has not been loaded because its "
+                            "version is not supported.")
+                        .arg(QString::fromStdWString(m_path.getWideString())),
+                    true);
+}
+
+//-----------------------------------------------------------------------------
+
+void TXshSimpleLevel::prioritizeLoad() {
+  // Don't wait for a completion in progress
+  QMutex& mutex = LazyLoads::instance().m_mutex;
+  if (!mutex.tryLock()) return;
+
+  InfoReader* reader = static_cast<InfoReader*>(m_infoReader.getPointer());
+  if (m_pendingLoad && reader && reader->prioritize()) {
+    // Requeue the read ahead of the others. Should it start meanwhile, it
+    // just runs twice: reads and completions happen once.
+    TThread::Executor& executor = LazyLoads::instance().m_executor;
+    executor.removeTask(reader);
+    executor.addTask(reader);
+  }
+
+  mutex.unlock();
+}
+
+//-----------------------------------------------------------------------------
+
+void TXshSimpleLevel::onInfoRead() { completeLoad(); }
+
+//-----------------------------------------------------------------------------
+
 void TXshSimpleLevel::updateReadOnly() {
   TFilePath path = getScene()->decodeFilePath(m_path);
   m_isReadOnly   = isAreadOnlyLevel(path);
@@ -1376,6 +1695,7 @@ void TXshSimpleLevel::updateReadOnly() {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::saveData(TOStream& os) {
+  resolveLoad();
   os << m_name;
 
   std::map<std::string, std::string> attr;
@@ -1420,6 +1740,7 @@ void TXshSimpleLevel::saveData(TOStream& os) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::save() {
+  resolveLoad();
   assert(getScene());
   TFilePath path = getScene()->decodeFilePath(m_path);
   TSystem::outputDebug("save() : " + ::to_string(m_path) + " = " +
@@ -1813,6 +2134,7 @@ void TXshSimpleLevel::saveSimpleLevel(const TFilePath& decodedFp,
 
 std::string TXshSimpleLevel::getImageId(const TFrameId& fid,
                                         int frameStatus) const {
+  resolveLoad();
   if (frameStatus < 0) frameStatus = getFrameStatus(fid);
   std::string prefix = "L";
   if (frameStatus & CleanupPreview)
@@ -1826,6 +2148,8 @@ std::string TXshSimpleLevel::getImageId(const TFrameId& fid,
 //-----------------------------------------------------------------------------
 
 int TXshSimpleLevel::getFrameStatus(const TFrameId& fid) const {
+  // No need to complete lazy loads: statuses come from the scene, and only
+  // scanned levels - never loaded lazily - set them on load
   auto it = m_framesStatus.find(fid);
   return (it != m_framesStatus.end()) ? it->second : Normal;
 }
@@ -1833,6 +2157,7 @@ int TXshSimpleLevel::getFrameStatus(const TFrameId& fid) const {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::setFrameStatus(const TFrameId& fid, int status) {
+  resolveLoad();
   assert((status & ~(Scanned | Cleanupped | CleanupPreview)) == 0);
   m_framesStatus[fid] = status;
 }
@@ -1840,6 +2165,7 @@ void TXshSimpleLevel::setFrameStatus(const TFrameId& fid, int status) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::makeTlv(const TFilePath& tlvPath) {
+  resolveLoad();
   int ltype = getType();
 
   if (!(ltype & FULLCOLOR_TYPE)) {
@@ -1864,7 +2190,9 @@ void TXshSimpleLevel::makeTlv(const TFilePath& tlvPath) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::invalidateFrames() {
+  resolveLoad();
   for (const auto& fid : m_frames) {
+    rebaseUndoTiles(getImageId(fid));
     ImageManager::instance()->invalidate(getImageId(fid));
   }
 }
@@ -1872,7 +2200,9 @@ void TXshSimpleLevel::invalidateFrames() {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::invalidateFrame(const TFrameId& fid) {
+  resolveLoad();
   std::string id = getImageId(fid);
+  rebaseUndoTiles(id);
   ImageManager::instance()->invalidate(id);
 }
 
@@ -2072,6 +2402,7 @@ TImageP TXshSimpleLevel::createEmptyFrame() {
 //-----------------------------------------------------------------------------
 
 TDimension TXshSimpleLevel::getResolution() {
+  resolveLoad();
   if (isEmpty() || getType() == PLI_XSHLEVEL) return TDimension();
   return m_properties->getImageRes();
 }
@@ -2118,6 +2449,7 @@ TPointD TXshSimpleLevel::getDpi(const TFrameId& fid, int frameStatus) {
 //-----------------------------------------------------------------------------
 
 void TXshSimpleLevel::renumber(const std::vector<TFrameId>& fids) {
+  resolveLoad();
   assert(fids.size() == m_frames.size());
   int n = static_cast<int>(fids.size());
 
@@ -2367,6 +2699,7 @@ TFilePath TXshSimpleLevel::getExistingHookFile(
 //-----------------------------------------------------------------------------
 
 TRectD TXshSimpleLevel::getBBox(const TFrameId& fid) const {
+  resolveLoad();
   TRectD bbox;
   double dpiX = Stage::inch, dpiY = dpiX;
 
@@ -2407,6 +2740,7 @@ TRectD TXshSimpleLevel::getBBox(const TFrameId& fid) const {
 //-----------------------------------------------------------------------------
 
 bool TXshSimpleLevel::isFrameReadOnly(TFrameId fid) {
+  resolveLoad();
   if (getType() == OVL_XSHLEVEL || getType() == TZI_XSHLEVEL ||
       getType() == MESH_XSHLEVEL) {
     if (getProperties()->isStopMotionLevel()) return true;
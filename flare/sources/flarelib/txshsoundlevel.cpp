@@ -5,10 +5,14 @@
 #include "flare/toonzscene.h"
 #include "flare/sceneproperties.h"
 #include "flare/txshleveltypes.h"
+#include "flare/preferences.h"
 
 #include "tstream.h"
 #include "toutputproperties.h"
 #include "tconvert.h"
+#include "tsoundpeaks.h"
+
+#include <QObject>
 
 //-----------------------------------------------------------------------------
 
@@ -18,6 +22,75 @@ PERSIST_IDENTIFIER(TXshSoundLevel, "soundLevel")
 
 //=============================================================================
 
+namespace {
+
+TThread::Executor &peaksExecutor() {
+  static TThread::Executor executor;
+  static bool initialized = false;
+  if (!initialized) {
+    executor.setMaxActiveTasks(2);
+    initialized = true;
+  }
+  return executor;
+}
+
+}  // namespace
+
+//=============================================================================
+//    TXshSoundLevel::PeaksTask
+//-----------------------------------------------------------------------------
+
+/*! Builds the peak index of a soundtrack out of the main thread, reusing
+    (or writing) its sidecar file when a path is specified.*/
+class TXshSoundLevel::PeaksTask final : public TThread::Runnable {
+  TXshSoundLevel *m_level;  // reset when the level dies before completion
+  TSoundTrackP m_soundTrack;
+  TFilePath m_soundPath, m_peaksPath;
+  std::shared_ptr<TSoundPeaks> m_peaks;
+  std::atomic<bool> m_canceled;
+
+public:
+  PeaksTask(TXshSoundLevel *level, const TFilePath &soundPath)
+      : m_level(level)
+      , m_soundTrack(level->m_soundTrack)
+      , m_soundPath(soundPath)
+      , m_peaks(new TSoundPeaks)
+      , m_canceled(false) {
+    if (!m_soundPath.isEmpty())
+      m_peaksPath = TSoundPeaks::getPeaksPath(m_soundPath);
+
+    connect(this, SIGNAL(finished(TThread::RunnableP)), this,
+            SLOT(onFinished(TThread::RunnableP)));
+  }
+
+  void detach() {
+    m_level    = 0;
+    m_canceled = true;
+  }
+
+  void run() override {
+    TINT32 sampleCount = m_soundTrack->getSampleCount();
+    if (!m_peaksPath.isEmpty() &&
+        m_peaks->load(m_peaksPath, m_soundPath, sampleCount))
+      return;
+
+    if (!m_peaks->build(m_soundTrack, &m_canceled)) return;
+
+    if (!m_peaksPath.isEmpty()) m_peaks->save(m_peaksPath, m_soundPath);
+  }
+
+  void onFinished(TThread::RunnableP sender) override {
+    // On the main thread...
+    if (!m_level || m_level->m_peaksTask.getPointer() != this) return;
+
+    m_level->m_peaks     = m_peaks;
+    m_level->m_peaksTask = TThread::RunnableP();
+    emit m_level->peaksReady();
+  }
+};
+
+//=============================================================================
+
 TXshSoundLevel::TXshSoundLevel(std::wstring name, int startOffset,
                                int endOffset)
     : TXshLevel(m_classCode, name)
@@ -30,7 +103,12 @@ TXshSoundLevel::TXshSoundLevel(std::wstring name, int startOffset,
 
 //-----------------------------------------------------------------------------
 
-TXshSoundLevel::~TXshSoundLevel() {}
+TXshSoundLevel::~TXshSoundLevel() {
+  if (m_peaksTask) {
+    static_cast<PeaksTask *>(m_peaksTask.getPointer())->detach();
+    peaksExecutor().removeTask(m_peaksTask);
+  }
+}
 
 //-----------------------------------------------------------------------------
 
@@ -145,84 +223,81 @@ void TXshSoundLevel::saveData(TOStream &os) {
 
 //-----------------------------------------------------------------------------
 
-void TXshSoundLevel::computeValuesFor(const Orientation *o) {
-  int frameHeight = o->dimension(PredefinedDimension::FRAME);  // time axis
-  int index       = o->dimension(PredefinedDimension::INDEX);
-  std::map<int, DoublePair> &values = m_values[index];
-
-  if (frameHeight == 0) frameHeight = 1;
-  values.clear();
-  if (!m_soundTrack) {
+void TXshSoundLevel::computeValues() {
+  if (!m_soundTrack || m_fps <= 0) {
     m_frameSoundCount = 0;
     m_samplePerFrame  = 0;
     return;
   }
 
-  m_samplePerFrame      = m_soundTrack->getSampleRate() / m_fps;
-  double samplePerPixel = m_samplePerFrame / frameHeight;
+  m_samplePerFrame = m_soundTrack->getSampleRate() / m_fps;
 
-  int sampleCount = m_soundTrack->getSampleCount();
-  if (sampleCount <= 0)  // This was if(!sampleCount)  :(
-    return;              //
+  int sampleCount   = m_soundTrack->getSampleCount();
+  m_frameSoundCount = (sampleCount > 0 && m_samplePerFrame > 0)
+                          ? tceil(sampleCount / m_samplePerFrame)
+                          : 0;
+}
 
-  m_frameSoundCount = tceil(sampleCount / m_samplePerFrame);
+//-----------------------------------------------------------------------------
 
-  double maxPressure = 0.0;
-  double minPressure = 0.0;
+void TXshSoundLevel::buildPeaks(bool async) {
+  if (m_peaksTask) {
+    static_cast<PeaksTask *>(m_peaksTask.getPointer())->detach();
+    peaksExecutor().removeTask(m_peaksTask);
+    m_peaksTask = TThread::RunnableP();
+  }
 
-  m_soundTrack->getMinMaxPressure(TINT32(0), (TINT32)sampleCount, TSound::LEFT,
-                                  minPressure, maxPressure);
+  m_peaks.reset();
+  if (!m_soundTrack) return;
+
+  // Peak files are stored next to the audio file, if allowed
+  TFilePath soundPath;
+  if (Preferences::instance()->isSoundPeakFilesEnabled() &&
+      !m_path.isEmpty())
+    soundPath = getScene() ? getScene()->decodeFilePath(m_path) : m_path;
+
+  m_peaksTask = new PeaksTask(this, soundPath);
+  if (async)
+    peaksExecutor().addTask(m_peaksTask);
+  else {
+    TThread::RunnableP task = m_peaksTask;
+    task->run();
+    static_cast<PeaksTask *>(task.getPointer())->onFinished(task);
+  }
+}
 
-  double absMaxPressure = std::max(fabs(minPressure), fabs(maxPressure));
+//-----------------------------------------------------------------------------
 
-  if (absMaxPressure <= 0) return;
+void TXshSoundLevel::getValueAtPixel(const Orientation *o, int pixel,
+                                     DoublePair &values) const {
+  if (!m_peaks || m_peaks->isEmpty() || pixel < 0) return;
 
-  // Adjusting using a fixed scaleFactor
-  int desiredAmplitude = o->dimension(PredefinedDimension::SOUND_AMPLITUDE);
-  // results will be in range -desiredAmplitude .. +desiredAmplitude
-  double weightA = desiredAmplitude / absMaxPressure;
+  double absMaxPressure = m_peaks->getAbsMaxPressure();
+  if (absMaxPressure <= 0) return;
 
-  long i = 0, j;
-  long p = 0;  // se p parte da zero notazione per pixel,
-  // se parte da 1 notazione per frame
-  while (i < m_frameSoundCount) {
-    for (j = 0; j < frameHeight - 1; ++j) {
-      double min = 0.0;
-      double max = 0.0;
-      m_soundTrack->getMinMaxPressure(
-          (TINT32)(i * m_samplePerFrame + j * samplePerPixel),
-          (TINT32)(i * m_samplePerFrame + (j + 1) * samplePerPixel - 1),
-          TSound::MONO, min, max);
-      values.insert(std::pair<int, std::pair<double, double>>(
-          p + j, std::pair<double, double>(min * weightA, max * weightA)));
-    }
+  int frameHeight = o->dimension(PredefinedDimension::FRAME);  // time axis
+  if (frameHeight == 0) frameHeight = 1;
 
-    double min = 0.0;
-    double max = 0.0;
-    m_soundTrack->getMinMaxPressure(
-        (TINT32)(i * m_samplePerFrame + j * samplePerPixel),
-        (TINT32)((i + 1) * m_samplePerFrame - 1), TSound::MONO, min, max);
-    values.insert(std::pair<int, std::pair<double, double>>(
-        p + j, std::pair<double, double>(min * weightA, max * weightA)));
+  // pixel p = i * frameHeight + j, i being the sound frame
+  int i = pixel / frameHeight, j = pixel % frameHeight;
+  if (i >= m_frameSoundCount) return;
 
-    ++i;
-    p += frameHeight;
-  }
-}
+  double samplePerPixel = m_samplePerFrame / frameHeight;
 
-//-----------------------------------------------------------------------------
+  TINT32 s0 = (TINT32)(i * m_samplePerFrame + j * samplePerPixel);
+  TINT32 s1 = (j < frameHeight - 1)
+                  ? (TINT32)(i * m_samplePerFrame + (j + 1) * samplePerPixel - 1)
+                  : (TINT32)((i + 1) * m_samplePerFrame - 1);
 
-void TXshSoundLevel::computeValues() {
-  for (auto o : Orientations::all()) computeValuesFor(o);
-}
+  double min = 0.0, max = 0.0;
+  m_peaks->getMinMaxPressure(s0, std::max(s0, s1), min, max);
 
-//-----------------------------------------------------------------------------
+  // Adjusting using a fixed scaleFactor
+  int desiredAmplitude = o->dimension(PredefinedDimension::SOUND_AMPLITUDE);
+  // results will be in range -desiredAmplitude .. +desiredAmplitude
+  double weightA = desiredAmplitude / absMaxPressure;
 
-void TXshSoundLevel::getValueAtPixel(const Orientation *o, int pixel,
-                                     DoublePair &values) const {
-  int index = o->dimension(PredefinedDimension::INDEX);
-  std::map<int, DoublePair>::const_iterator it = m_values[index].find(pixel);
-  if (it != m_values[index].end()) values = it->second;
+  values = DoublePair(min * weightA, max * weightA);
 }
 
 //-----------------------------------------------------------------------------
@@ -818,9 +818,12 @@ void FlipConsole::onNextFrame(int fps, QElapsedTimer *timer,
     playNextFrame(timer, targetInstant);
 
   if (fps == -1) return;
-  if (m_fpsLabel)
-    m_fpsLabel->setText(tr(" FPS ") + QString::number(fps * tsign(m_fps)) +
-                        "/");
+  if (m_fpsLabel) {
+    QString text = tr(" FPS ") + QString::number(fps * tsign(m_fps)) + "/";
+    if (m_compositeTime > 0)
+      text = tr(" Composite %1 ms").arg(m_compositeTime, 0, 'f', 1) + text;
+    m_fpsLabel->setText(text);
+  }
   if (m_fpsField) {
     if (fps == abs(m_fps))
       m_fpsField->setLineEditBackgroundColor(Qt::green);
@@ -2111,6 +2114,10 @@ void FlipConsole::onPreferenceChanged(const QString &prefName) {
 
 //--------------------------------------------------------------------
 
+void FlipConsole::setCompositeTime(double msecs) { m_compositeTime = msecs; }
+
+//--------------------------------------------------------------------
+
 void FlipConsole::adjustGain(bool increase) {
   if (increase && m_settings.m_gainStep < 12)
     m_settings.m_gainStep++;
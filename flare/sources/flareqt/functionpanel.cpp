@@ -507,12 +507,14 @@ QPainterPath FunctionPanel::getSegmentPainterPath(TDoubleParam *curve,
     path.lineTo(getWinPos(curve, frame1, vValue));
     path.lineTo(getWinPos(curve, frame1, curve->getValue(frame1, true)));
   } else {
-    // step = 1
-    path.moveTo(getWinPos(curve, frame));
-    while (frame + df < frame1) {
-      frame += df;
-      path.lineTo(getWinPos(curve, frame));
-    }
+    // step = 1: sample the frames before frame1 at once
+    int count = std::max(1, tceil((frame1 - frame) / df));
+    std::vector<double> values(count);
+    curve->evaluateRange(frame, df, count, values.data());
+
+    path.moveTo(getWinPos(curve, frame, values[0]));
+    for (int i = 1; i < count; ++i)
+      path.lineTo(getWinPos(curve, frame + i * df, values[i]));
     path.lineTo(getWinPos(curve, frame1, curve->getValue(frame1, true)));
   }
   return path;
@@ -1509,10 +1511,11 @@ void FunctionPanel::fitGraphToWindow(bool currentCurveOnly) {
       double v = curve->getValue(fa);
       if (unit) v = unit->convertTo(v);
       if (v0 > v1) v0 = v1 = v;
-      int m = 50;
+      const int m = 50;
+      double values[m];
+      curve->evaluateRange(fa, (fb - fa) / (m - 1), m, values);
       for (int j = 0; j < m; j++) {
-        double t = (double)j / (double)(m - 1);
-        double v = curve->getValue((1 - t) * fa + t * fb);
+        double v = values[j];
         if (unit) v = unit->convertTo(v);
         v0 = std::min(v0, v);
         v1 = std::max(v1, v);
@@ -727,6 +727,14 @@ void FunctionSheetCellViewer::drawCells(QPainter &painter, int r0, int c0,
 
     bool isRefMngIgnored = xsh->isReferenceManagementIgnored(curve);
 
+    // evaluate the visible rows at once
+    std::vector<double> values(r1 - r0 + 1);
+    if (isStageObjectCycled) {
+      for (int row = r0; row <= r1; row++)
+        values[row - r0] = curve->getValue(obj->paramsTime((double)row));
+    } else if (!values.empty())
+      curve->evaluateRange(r0, r1, values.data());
+
     // draw each cell
     for (int row = r0; row <= r1; row++) {
       int ya = m_sheet->rowToY(row);
@@ -734,9 +742,7 @@ void FunctionSheetCellViewer::drawCells(QPainter &painter, int r0, int c0,
 
       bool isSelected = getViewer()->isSelectedCell(row, c);
 
-      double value = (isStageObjectCycled)
-                         ? curve->getValue(obj->paramsTime((double)row))
-                         : curve->getValue(row);
+      double value = values[row - r0];
       if (unit) value = unit->convertTo(value);
       enum { None, Key, Inbetween, CycleRange } drawValue = None;
 
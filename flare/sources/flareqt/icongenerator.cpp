@@ -38,12 +38,22 @@
 #include "flare/preferences.h"
 #include "flare/sceneresources.h"
 #include "flare/stage2.h"
+#include "flare/toonzfolders.h"
 
 // TnzQt includes
 #include "flareqt/gutil.h"
 
 #include "flareqt/icongenerator.h"
 
+// Qt includes
+#include <QDir>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+
+// STD includes
+#include <limits>
+
 //=============================================================================
 
 //===================================
@@ -194,6 +204,115 @@ void makeChessBackground(const TRaster32P &ras) {
   ras->unlock();
 }
 
+//-----------------------------------------------------------------------------
+
+//! File icons not requested again for this many request windows are no longer
+//! shown, and are not decoded
+const int c_staleWindows = 30;
+
+//! Maximum number of file icons stored on disk
+const int c_maxDiskIcons = 20000;
+
+//-----------------------------------------------------------------------------
+
+//! Returns the current request window. File icons are prioritized by the
+//! 100 msecs window of their last request, as views request the icons they
+//! show at each repaint.
+int requestWindow() {
+  static const QElapsedTimer timer = []() {
+    QElapsedTimer t;
+    t.start();
+    return t;
+  }();
+  return int(timer.elapsed() / 100);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the folder of the file icons stored on disk, pruned of the oldest
+//! ones at first use. Returns an empty string if it can't be created.
+const QString &diskIconsFolder() {
+  static const QString folder = []() {
+    QDir dir((FlareFolder::getCacheRootFolder() + "thumbnails").getQString());
+    if (!dir.mkpath(".")) return QString();
+
+    QFileInfoList icons =
+        dir.entryInfoList(QStringList("*.png"), QDir::Files, QDir::Time);
+    for (int i = c_maxDiskIcons; i < icons.size(); ++i)
+      QFile::remove(icons[i].absoluteFilePath());
+
+    return dir.absolutePath();
+  }();
+  return folder;
+}
+
+//-----------------------------------------------------------------------------
+
+//! The icon of a file frame, stored on disk across sessions. Its file name
+//! hashes the path, frame and icon size together with the modification time
+//! and size of the file holding the frame, so edited files get new icons.
+class DiskIcon {
+  QString m_path;
+
+public:
+  DiskIcon(const TFilePath &path, const TFrameId &fid,
+           const TDimension &iconSize) {
+    const QString &folder = diskIconsFolder();
+    if (folder.isEmpty()) return;
+
+    TFilePath source = path;
+    if (path.isLevelName()) {
+      if (fid != TFrameId::NO_FRAME)
+        source = path.withFrame(fid);
+      else {
+        TFilePathSet frames;
+        try {
+          TSystem::readDirectory_LevelFrames(frames, path);
+        } catch (...) {
+        }
+        if (frames.empty()) return;
+        source = frames.front();
+      }
+    }
+
+    QFileInfo info(source.getQString());
+    if (!info.isFile()) return;
+
+    QString key = QString("%1|%2|%3x%4|%5|%6")
+                      .arg(path.getQString())
+                      .arg(QString::fromStdString(fid.expand()))
+                      .arg(iconSize.lx)
+                      .arg(iconSize.ly)
+                      .arg(info.lastModified().toMSecsSinceEpoch())
+                      .arg(info.size());
+    m_path = folder + "/" +
+             QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5)
+                 .toHex() +
+             ".png";
+  }
+
+  TRaster32P load() const {
+    QImage image;
+    if (m_path.isEmpty() || !image.load(m_path, "PNG")) return TRaster32P();
+
+    return rasterFromQImage(
+        image.convertToFormat(QImage::Format_ARGB32_Premultiplied), false);
+  }
+
+  void save(const TRaster32P &icon) const {
+    if (m_path.isEmpty()) return;
+
+    // Written aside first, so that concurrent sessions never read partial
+    // files
+    QString tempPath = m_path + ".part";
+    if (rasterToQImage(icon).save(tempPath, "PNG")) {
+      QFile::remove(m_path);
+      QFile::rename(tempPath, m_path);
+    } else
+      QFile::remove(tempPath);
+  }
+};
+
 }  // namespace
 
 //=============================================================================
@@ -937,13 +1056,30 @@ class FileIconRenderer final : public IconRenderer {
   TFilePath m_path;
   TFrameId m_fid;
 
+  int m_requestWindow;  //!< Request window this renderer was added in
+  bool m_skipped;       //!< Whether decoding was skipped, the icon being no
+                        //!  longer requested
+
 public:
   FileIconRenderer(const TDimension &iconSize, const TFilePath &path,
                    const TFrameId &fid)
-      : IconRenderer(getId(path, fid), iconSize), m_path(path), m_fid(fid) {}
+      : IconRenderer(getId(path, fid), iconSize)
+      , m_path(path)
+      , m_fid(fid)
+      , m_requestWindow(requestWindow())
+      , m_skipped(false) {}
 
   static std::string getId(const TFilePath &path, const TFrameId &fid);
 
+  //! File icons come after the other icons - the most recently requested
+  //! first.
+  int schedulingPriority() override {
+    return m_requestWindow - (std::numeric_limits<int>::max)() / 2;
+  }
+
+  int getRequestWindow() const { return m_requestWindow; }
+  bool wasSkipped() const { return m_skipped; }
+
   void run() override;
 };
 
@@ -1174,6 +1310,18 @@ void FileIconRenderer::run() {
     TRaster32P iconRaster;
     std::string type(m_path.getType());
 
+    DiskIcon diskIcon(m_path, m_fid, iconSize);
+    if ((iconRaster = diskIcon.load())) {
+      setIcon(iconRaster);
+      return;
+    }
+
+    // Icons not requested recently were scrolled away from
+    if (requestWindow() - m_requestWindow > c_staleWindows) {
+      m_skipped = true;
+      return;
+    }
+
     if (type == "tnz" || type == "tab")
       iconRaster = IconGenerator::generateSceneFileIcon(m_path, iconSize,
                                                         m_fid.getNumber() - 1);
@@ -1257,6 +1405,7 @@ void FileIconRenderer::run() {
       setIcon(rasterFromQImage(broken));
       return;
     }
+    diskIcon.save(iconRaster);
     setIcon(iconRaster);
   } catch (const TImageVersionException &) {
     QImage unknown(getIconPath("unknown_icon"));
@@ -1360,6 +1509,32 @@ void IconGenerator::addTask(const std::string &id,
 
 //-----------------------------------------------------------------------------
 
+void IconGenerator::addFileTask(const std::string &id, const TFilePath &path,
+                                const TFrameId &fid) {
+  TThread::RunnableP iconRenderer(
+      new FileIconRenderer(TDimension(80, 60), path, fid));
+
+  m_fileIconRenderers[id] = iconRenderer;
+  addTask(id, iconRenderer);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Forgets the file icon request \b iconRenderer, returning whether it was
+//! still the current one for \b id.
+bool IconGenerator::releaseFileTask(const std::string &id,
+                                    const TThread::RunnableP &iconRenderer) {
+  std::map<std::string, TThread::RunnableP>::iterator rt =
+      m_fileIconRenderers.find(id);
+  if (rt == m_fileIconRenderers.end() || rt->second != iconRenderer)
+    return false;
+
+  m_fileIconRenderers.erase(rt);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
 QPixmap IconGenerator::getIcon(TXshLevel *xl, const TFrameId &fid,
                                bool filmStrip, bool onDemand) {
   if (!xl) return QPixmap();
@@ -1675,9 +1850,22 @@ QPixmap IconGenerator::getIcon(const TFilePath &path, const TFrameId &fid) {
   TDimension fileIconSize(80, 60);
   // Here the fileIconSize is input in order to check if the icon is obtained
   // with high-dpi (i.e. devPixRatio > 1.0).
-  if (::getIcon(id, pix, 0, fileIconSize)) return pix;
+  if (::getIcon(id, pix, 0, fileIconSize)) {
+    // Pending icons requested again are moved ahead of the older requests
+    std::map<std::string, TThread::RunnableP>::iterator rt =
+        m_fileIconRenderers.find(id);
+    if (pix.isNull() && rt != m_fileIconRenderers.end()) {
+      FileIconRenderer *fir =
+          static_cast<FileIconRenderer *>(rt->second.getPointer());
+      if (!fir->hasStarted() && fir->getRequestWindow() < requestWindow()) {
+        m_executor.removeTask(rt->second);
+        addFileTask(id, path, fid);
+      }
+    }
+    return pix;
+  }
 
-  addTask(id, new FileIconRenderer(fileIconSize, path, fid));
+  addFileTask(id, path, fid);
 
   return QPixmap();
 }
@@ -1687,7 +1875,7 @@ QPixmap IconGenerator::getIcon(const TFilePath &path, const TFrameId &fid) {
 void IconGenerator::invalidate(const TFilePath &path, const TFrameId &fid) {
   std::string id = FileIconRenderer::getId(path, fid);
   removeIcon(id);
-  addTask(id, new FileIconRenderer(TDimension(80, 60), path, fid));
+  addFileTask(id, path, fid);
 }
 
 //-----------------------------------------------------------------------------
@@ -1764,6 +1952,11 @@ void IconGenerator::onStarted(TThread::RunnableP iconRenderer) {
 void IconGenerator::onCanceled(TThread::RunnableP iconRenderer) {
   IconRenderer *ir = static_cast<IconRenderer *>(iconRenderer.getPointer());
 
+  // Superseded file icon requests leave the icon to their replacement
+  if (dynamic_cast<FileIconRenderer *>(ir) &&
+      !releaseFileTask(ir->getId(), iconRenderer))
+    return;
+
   if (!ir->hasStarted()) {
     removeIcon(ir->getId());
   }
@@ -1786,6 +1979,20 @@ void IconGenerator::onFinished(TThread::RunnableP iconRenderer) {
     }
   }
 
+  FileIconRenderer *fir = dynamic_cast<FileIconRenderer *>(ir);
+  if (fir) {
+    bool current = releaseFileTask(ir->getId(), iconRenderer);
+    if (!current || fir->wasSkipped()) {
+      // Skipped icons are requested again by the views still showing them
+      if (current) {
+        removeIcon(ir->getId());
+        emit iconGenerated();
+      }
+      if (ir->wasTerminated()) m_iconsTerminationLoop.quit();
+      return;
+    }
+  }
+
   // Update the icons map
   if (ir->getIcon()) {
     ::setIcon(ir->getId(), ir->getIcon());
@@ -1,6 +1,11 @@
 #define TINYEXR_USE_MINIZ 0
 #include "zlib.h"
 
+// Compress and decompress line blocks and tiles in parallel, on the threads
+// of TThread::parallelFor() (see tinyexr_otmod.h)
+#define TINYEXR_USE_THREAD 1
+#define TINYEXR_CUSTOM_WORKERS
+
 #define TINYEXR_OTMOD_IMPLEMENTATION
 #include "tinyexr_otmod.h"
 
@@ -10,6 +15,8 @@
 #include <QMap>
 #include <QString>
 
+#include <memory>
+
 namespace {
 inline unsigned char ftouc(float f, float gamma = 2.2f) {
   int i = static_cast<int>(255.0f * powf(f, 1.0f / gamma));
@@ -52,6 +59,128 @@ const QMap<int, std::wstring> ExrCompTypeStr = {
 
 const std::wstring EXR_STORAGETYPE_SCANLINE = L"Store Image as Scanlines";
 const std::wstring EXR_STORAGETYPE_TILE     = L"Store Image as Tiles";
+const std::wstring EXR_STORAGETYPE_MIPMAP   = L"Store Image as Mipmapped Tiles";
+
+const int EXR_TILE_SIZE = 128;
+
+// Number of lines decoded at once by ExrReader
+const int EXR_READ_BAND_HEIGHT = 256;
+
+//--------------------------------------------------------------------------
+
+//! Tiled (and possibly mipmapped) layout of a planar float image, as
+//! expected by SaveEXRImageToFileHandle().
+class ExrTiledImage {
+  std::vector<EXRImage> m_levels;
+  std::vector<std::vector<EXRTile>> m_tiles;
+  std::vector<std::vector<float>> m_tileData;
+  std::vector<std::vector<unsigned char*>> m_tileChannels;
+
+public:
+  ExrTiledImage(const std::vector<const float*>& channels, int lx, int ly,
+                int tileLx, int tileLy, bool mipmap);
+
+  EXRImage* getImage() { return &m_levels[0]; }
+
+private:
+  void addLevel(const std::vector<const float*>& channels, int lx, int ly,
+                int tileLx, int tileLy);
+};
+
+//--------------------------------------------------------------------------
+
+ExrTiledImage::ExrTiledImage(const std::vector<const float*>& channels,
+                             int lx, int ly, int tileLx, int tileLy,
+                             bool mipmap) {
+  // Levels are rounded down, down to 1 pixel along the longest side
+  int levelCount = 1;
+  if (mipmap)
+    while ((std::max(lx, ly) >> levelCount) > 0) ++levelCount;
+
+  m_levels.reserve(levelCount);
+  addLevel(channels, lx, ly, tileLx, tileLy);
+
+  std::vector<std::vector<float>> prev, level;
+  std::vector<const float*> levelChannels(channels);
+
+  for (int l = 1; l < levelCount; ++l) {
+    int plx = lx, ply = ly;
+    lx = std::max(lx / 2, 1), ly = std::max(ly / 2, 1);
+
+    // Box filter the previous level
+    level.assign(channels.size(), std::vector<float>(lx * ly));
+    for (size_t c = 0; c < channels.size(); ++c) {
+      const float* src = levelChannels[c];
+      float* dst       = level[c].data();
+
+      for (int y = 0; y < ly; ++y) {
+        const float* row0 = src + std::min(2 * y, ply - 1) * plx;
+        const float* row1 = src + std::min(2 * y + 1, ply - 1) * plx;
+
+        for (int x = 0; x < lx; ++x, ++dst) {
+          int x0 = std::min(2 * x, plx - 1), x1 = std::min(2 * x + 1, plx - 1);
+          *dst = 0.25f * (row0[x0] + row0[x1] + row1[x0] + row1[x1]);
+        }
+      }
+
+      levelChannels[c] = level[c].data();
+    }
+
+    addLevel(levelChannels, lx, ly, tileLx, tileLy);
+    m_levels[l - 1].next_level = &m_levels[l];  // Storage was reserved
+
+    prev.swap(level);  // Keeps levelChannels valid
+  }
+}
+
+//--------------------------------------------------------------------------
+
+void ExrTiledImage::addLevel(const std::vector<const float*>& channels,
+                             int lx, int ly, int tileLx, int tileLy) {
+  int channelCount = (int)channels.size();
+  int xTiles = (lx + tileLx - 1) / tileLx, yTiles = (ly + tileLy - 1) / tileLy;
+  int tileCount = xTiles * yTiles, tileSize = tileLx * tileLy;
+
+  m_tiles.emplace_back(tileCount);
+  m_tileData.emplace_back(size_t(tileCount) * channelCount * tileSize, 0.0f);
+  m_tileChannels.emplace_back(size_t(tileCount) * channelCount);
+
+  std::vector<EXRTile>& tiles        = m_tiles.back();
+  float* data                        = m_tileData.back().data();
+  std::vector<unsigned char*>& ptrs = m_tileChannels.back();
+
+  for (int t = 0; t < tileCount; ++t) {
+    EXRTile& tile = tiles[t];
+    tile.offset_x = t % xTiles, tile.offset_y = t / xTiles;
+    tile.level_x = tile.level_y = (int)m_levels.size();
+
+    int x0 = tile.offset_x * tileLx, y0 = tile.offset_y * tileLy;
+    tile.width  = std::min(tileLx, lx - x0);
+    tile.height = std::min(tileLy, ly - y0);
+
+    for (int c = 0; c < channelCount; ++c) {
+      float* dst = data + (size_t(t) * channelCount + c) * tileSize;
+      ptrs[t * channelCount + c] = (unsigned char*)dst;
+
+      for (int y = 0; y < tile.height; ++y)
+        memcpy(dst + y * tileLx, channels[c] + (y0 + y) * lx + x0,
+               tile.width * sizeof(float));
+    }
+
+    tile.images = &ptrs[t * channelCount];
+  }
+
+  EXRImage image;
+  InitEXRImage(&image);
+  image.level_x = image.level_y = (int)m_levels.size();
+  image.tiles        = tiles.data();
+  image.num_tiles    = tileCount;
+  image.width        = lx;
+  image.height       = ly;
+  image.num_channels = channelCount;
+
+  m_levels.push_back(image);
+}
 }  // namespace
 
 //**************************************************************************
@@ -66,6 +195,13 @@ class ExrReader final : public Tiio::Reader {
 
   float m_colorSpaceGamma;
 
+  // Partial decoding. Pixels are decoded by bands of lines, restricted to the
+  // requested columns and read from the coarsest suitable mipmap level.
+  int m_levelCount;
+  std::vector<float> m_band;
+  EXRBox2i m_bandBox;
+  int m_bandLevel;
+
 public:
   ExrReader();
   ~ExrReader();
@@ -83,17 +219,27 @@ public:
     assert(gamma > 0);
     m_colorSpaceGamma = static_cast<float>(gamma);
   }
+
+private:
+  const float* getPixels(int x0, int x1, int shrink, int& step, int& count);
+  bool loadBand(int level, int x0, int x1, int y);
 };
 
 ExrReader::ExrReader()
     : m_rgbaBuf(nullptr)
     , m_row(0)
     , m_exr_header(nullptr)
-    , m_colorSpaceGamma(2.2f) {}
+    , m_colorSpaceGamma(2.2f)
+    , m_levelCount(1)
+    , m_bandBox()
+    , m_bandLevel(-1) {}
 
 ExrReader::~ExrReader() {
   if (m_rgbaBuf) free(m_rgbaBuf);
-  if (m_exr_header) FreeEXRHeader(m_exr_header);
+  if (m_exr_header) {
+    FreeEXRHeader(m_exr_header);
+    delete m_exr_header;
+  }
 }
 
 void ExrReader::open(FILE* file) {
@@ -103,6 +249,7 @@ void ExrReader::open(FILE* file) {
   {
     int ret = LoadEXRHeaderFromFileHandle(*m_exr_header, file, &err);
     if (ret != 0) {
+      delete m_exr_header;
       m_exr_header = nullptr;
       throw(std::string(err));
     }
@@ -126,6 +273,8 @@ void ExrReader::open(FILE* file) {
     break;
   }
   m_info.m_bitsPerSample = bps;
+
+  m_levelCount = GetEXRNumLevels(m_exr_header);
 }
 
 Tiio::RowOrder ExrReader::getRowOrder() const { return Tiio::TOP2BOTTOM; }
@@ -144,14 +293,111 @@ void ExrReader::loadImage() {
     int ret =
         LoadEXRImageBufFromFileHandle(&m_rgbaBuf, *m_exr_header, m_fp, &err);
     if (ret != 0) {
+      delete m_exr_header;
       m_exr_header = nullptr;
       throw(std::string(err));
     }
   }
   // header memory is freed after loading image
+  delete m_exr_header;
   m_exr_header = nullptr;
 }
 
+//--------------------------------------------------------------------------
+
+bool ExrReader::loadBand(int level, int x0, int x1, int y) {
+  int levelLx, levelLy;
+  if (GetEXRLevelSize(m_exr_header, level, &levelLx, &levelLy) !=
+      TINYEXR_SUCCESS)
+    return false;
+
+  // Bands start at chunk boundaries, so that no chunk is decoded twice
+  int chunkLy    = std::max(GetEXRChunkHeight(m_exr_header), 1);
+  int bandHeight = std::max(
+      (EXR_READ_BAND_HEIGHT + chunkLy - 1) / chunkLy * chunkLy, chunkLy);
+
+  EXRBox2i box;
+  box.min_x = std::max(x0, 0);
+  box.max_x = std::min(x1, levelLx - 1);
+  box.min_y = y / chunkLy * chunkLy;
+  box.max_y = std::min(box.min_y + bandHeight, levelLy) - 1;
+
+  if (box.max_x < box.min_x || y > box.max_y) return false;
+
+  m_band.resize(size_t(box.max_x - box.min_x + 1) *
+                (box.max_y - box.min_y + 1) * 4);
+
+  const char* err;
+  if (LoadEXRRegionFromFileHandle(m_band.data(), m_exr_header, m_fp, level,
+                                  &box, &err) != TINYEXR_SUCCESS) {
+    FreeEXRErrorMessage(err);
+    m_band.clear();
+    return false;
+  }
+
+  m_bandBox   = box;
+  m_bandLevel = level;
+  return true;
+}
+
+//--------------------------------------------------------------------------
+
+//! Returns the rgba values of the pixel at x0 in the current row, the
+//! distance (in pixels) to the next one to be read and the number of pixels
+//! that can be read. Past them, the last one stands for the sampled pixels.
+const float* ExrReader::getPixels(int x0, int x1, int shrink, int& step,
+                                  int& count) {
+  if (x1 < x0) x1 = m_info.m_lx - 1;
+
+  if (!m_rgbaBuf && m_exr_header) {
+    // Pick the coarsest level whose pixels match the sampled ones. Mipmap
+    // pixels are box-filtered, so a shrunk load gets averages of the pixels
+    // it skips instead of point samples - the smoother reduced image that
+    // viewers and flipbooks want.
+    int level = 0;
+    while (level + 1 < m_levelCount && shrink % (2 << level) == 0) ++level;
+
+    // Levels are rounded down, so the last column and row of an odd sized
+    // image have no level pixel of their own: read the last ones instead
+    int levelLx, levelLy;
+    if (GetEXRLevelSize(m_exr_header, level, &levelLx, &levelLy) !=
+        TINYEXR_SUCCESS)
+      levelLx = levelLy = 0;
+    int lx0 = std::min(x0 >> level, levelLx - 1),
+        lx1 = std::min(x1 >> level, levelLx - 1),
+        ly  = std::min(m_row >> level, levelLy - 1);
+
+    bool loaded =
+        (m_bandLevel == level && m_bandBox.min_x <= lx0 &&
+         lx1 <= m_bandBox.max_x && m_bandBox.min_y <= ly &&
+         ly <= m_bandBox.max_y) ||
+        loadBand(level, lx0, lx1, ly);
+
+    if (loaded) {
+      step  = shrink >> level;
+      count = (lx1 - lx0) / step + 1;
+
+      int bandLx = m_bandBox.max_x - m_bandBox.min_x + 1;
+      return m_band.data() +
+             (size_t(ly - m_bandBox.min_y) * bandLx + (lx0 - m_bandBox.min_x)) *
+                 4;
+    }
+
+    // Fall back to loading the whole image
+    m_levelCount = 1;
+    m_band.clear();
+    m_bandLevel = -1;
+  }
+
+  if (!m_rgbaBuf) loadImage();
+
+  step  = shrink;
+  count = (x1 - x0) / shrink + 1;
+  return m_rgbaBuf + (size_t(m_row) * m_info.m_lx + x0) * 4;
+}
+
+//--------------------------------------------------------------------------
+
 void ExrReader::readLine(char* buffer, int x0, int x1, int shrink) {
   const int pixelSize = 4;
   if (m_row < 0 || m_row >= m_info.m_ly) {
@@ -160,13 +406,11 @@ void ExrReader::readLine(char* buffer, int x0, int x1, int shrink) {
     return;
   }
 
-  if (!m_rgbaBuf) loadImage();
-
-  TPixel32* pix = (TPixel32*)buffer;
-  float* v      = m_rgbaBuf + m_row * m_info.m_lx * 4;
+  int step, count;
+  const float* v = getPixels(x0, x1, shrink, step, count);
+  TPixel32* pix  = (TPixel32*)buffer;
 
   pix += x0;
-  v += x0 * 4;
 
   int width =
       (x1 < x0) ? (m_info.m_lx - 1) / shrink + 1 : (x1 - x0) / shrink + 1;
@@ -177,7 +421,7 @@ void ExrReader::readLine(char* buffer, int x0, int x1, int shrink) {
     pix->b = ftouc(v[2], m_colorSpaceGamma);
     pix->m = ftouc(v[3], 1.0f);
 
-    v += shrink * 4;
+    if (i + 1 < count) v += step * 4;
     pix += shrink;
   }
 
@@ -192,13 +436,11 @@ void ExrReader::readLine(short* buffer, int x0, int x1, int shrink) {
     return;
   }
 
-  if (!m_rgbaBuf) loadImage();
-
-  TPixel64* pix = (TPixel64*)buffer;
-  float* v      = m_rgbaBuf + m_row * m_info.m_lx * 4;
+  int step, count;
+  const float* v = getPixels(x0, x1, shrink, step, count);
+  TPixel64* pix  = (TPixel64*)buffer;
 
   pix += x0;
-  v += x0 * 4;
 
   int width =
       (x1 < x0) ? (m_info.m_lx - 1) / shrink + 1 : (x1 - x0) / shrink + 1;
@@ -209,7 +451,7 @@ void ExrReader::readLine(short* buffer, int x0, int x1, int shrink) {
     pix->b = ftous(v[2], m_colorSpaceGamma);
     pix->m = ftous(v[3], 1.0f);
 
-    v += shrink * 4;
+    if (i + 1 < count) v += step * 4;
     pix += shrink;
   }
 
@@ -224,13 +466,11 @@ void ExrReader::readLine(float* buffer, int x0, int x1, int shrink) {
     return;
   }
 
-  if (!m_rgbaBuf) loadImage();
-
-  TPixelF* pix = (TPixelF*)buffer;
-  float* v     = m_rgbaBuf + m_row * m_info.m_lx * 4;
+  int step, count;
+  const float* v = getPixels(x0, x1, shrink, step, count);
+  TPixelF* pix   = (TPixelF*)buffer;
 
   pix += x0;
-  v += x0 * 4;
 
   int width =
       (x1 < x0) ? (m_info.m_lx - 1) / shrink + 1 : (x1 - x0) / shrink + 1;
@@ -241,7 +481,7 @@ void ExrReader::readLine(float* buffer, int x0, int x1, int shrink) {
     pix->b = toNonlinear(v[2], m_colorSpaceGamma);
     pix->m = toNonlinear(v[3], 1.0f);
 
-    v += shrink * 4;
+    if (i + 1 < count) v += step * 4;
     pix += shrink;
   }
 
@@ -278,6 +518,7 @@ Tiio::ExrWriterProperties::ExrWriterProperties()
 
   m_storageType.addValue(EXR_STORAGETYPE_SCANLINE);
   m_storageType.addValue(EXR_STORAGETYPE_TILE);
+  m_storageType.addValue(EXR_STORAGETYPE_MIPMAP);
   m_storageType.setValue(EXR_STORAGETYPE_SCANLINE);
 
   bind(m_bitsPerPixel);
@@ -315,6 +556,8 @@ void Tiio::ExrWriterProperties::updateTranslation() {
   m_storageType.setQStringName(tr("Storage Type"));
   m_storageType.setItemUIName(EXR_STORAGETYPE_SCANLINE, tr("Scan-line based"));
   m_storageType.setItemUIName(EXR_STORAGETYPE_TILE, tr("Tile based"));
+  m_storageType.setItemUIName(EXR_STORAGETYPE_MIPMAP,
+                              tr("Tile based with mipmaps"));
 
   m_colorSpaceGamma.setQStringName(tr("Color Space Gamma"));
 }
@@ -375,11 +618,16 @@ void ExrWriter::open(FILE* file, const TImageInfo& info) {
 
   std::wstring storageType =
       ((TEnumProperty*)(m_properties->getProperty("Storage Type")))->getValue();
-  if (storageType == EXR_STORAGETYPE_TILE) {
-    m_header.tiled           = 1;
-    m_header.tile_size_x     = 128;
-    m_header.tile_size_y     = 128;
-    m_header.tile_level_mode = TINYEXR_TILE_ONE_LEVEL;
+  if (storageType == EXR_STORAGETYPE_TILE ||
+      storageType == EXR_STORAGETYPE_MIPMAP) {
+    // Tiles may not be larger than the image
+    m_header.tiled              = 1;
+    m_header.tile_size_x        = std::min(EXR_TILE_SIZE, m_info.m_lx);
+    m_header.tile_size_y        = std::min(EXR_TILE_SIZE, m_info.m_ly);
+    m_header.tile_level_mode    = (storageType == EXR_STORAGETYPE_MIPMAP)
+                                      ? TINYEXR_TILE_MIPMAP_LEVELS
+                                      : TINYEXR_TILE_ONE_LEVEL;
+    m_header.tile_rounding_mode = TINYEXR_TILE_ROUND_DOWN;
   } else
     m_header.tiled = 0;
 
@@ -391,6 +639,11 @@ void ExrWriter::open(FILE* file, const TImageInfo& info) {
   m_image.width  = m_info.m_lx;
   m_image.height = m_info.m_ly;
 
+  // Used to lay out tiles - the written window comes from the image size
+  m_header.data_window.min_x = m_header.data_window.min_y = 0;
+  m_header.data_window.max_x = m_info.m_lx - 1;
+  m_header.data_window.max_y = m_info.m_ly - 1;
+
   m_header.num_channels = m_image.num_channels;
   m_header.channels =
       (EXRChannelInfo*)malloc(sizeof(EXRChannelInfo) * m_header.num_channels);
@@ -495,29 +748,32 @@ void ExrWriter::writeLine(float* buffer) {
 }
 
 void ExrWriter::flush() {
-  if (m_bpp == 128) {
-    float* image_ptr[4];
-    image_ptr[0]   = &(m_imageBuf[2].at(0));  // B
-    image_ptr[1]   = &(m_imageBuf[1].at(0));  // G
-    image_ptr[2]   = &(m_imageBuf[0].at(0));  // R
-    image_ptr[3]   = &(m_imageBuf[3].at(0));  // A
-    m_image.images = (unsigned char**)image_ptr;
-    const char* err;
-    int ret = SaveEXRImageToFileHandle(&m_image, &m_header, m_fp, &err);
-    if (ret != TINYEXR_SUCCESS) {
-      throw(std::string(err));
-    }
-  } else {
-    float* image_ptr[3];
-    image_ptr[0]   = &(m_imageBuf[2].at(0));  // B
-    image_ptr[1]   = &(m_imageBuf[1].at(0));  // G
-    image_ptr[2]   = &(m_imageBuf[0].at(0));  // R
-    m_image.images = (unsigned char**)image_ptr;
-    const char* err;
-    int ret = SaveEXRImageToFileHandle(&m_image, &m_header, m_fp, &err);
-    if (ret != TINYEXR_SUCCESS) {
-      throw(std::string(err));
-    }
+  // Must be BGR(A) order, see open()
+  std::vector<const float*> channels = {m_imageBuf[2].data(),
+                                        m_imageBuf[1].data(),
+                                        m_imageBuf[0].data()};
+  if (m_bpp == 128) channels.push_back(m_imageBuf[3].data());
+
+  std::unique_ptr<ExrTiledImage> tiledImage;
+  EXRImage* image = &m_image;
+
+  if (m_header.tiled) {
+    tiledImage.reset(new ExrTiledImage(
+        channels, m_info.m_lx, m_info.m_ly, m_header.tile_size_x,
+        m_header.tile_size_y,
+        m_header.tile_level_mode == TINYEXR_TILE_MIPMAP_LEVELS));
+    image = tiledImage->getImage();
+  } else
+    m_image.images = (unsigned char**)channels.data();
+
+  const char* err;
+  int ret = SaveEXRImageToFileHandle(image, &m_header, m_fp, &err);
+  m_image.images = nullptr;
+
+  if (ret != TINYEXR_SUCCESS) {
+    std::string msg(err);
+    FreeEXRErrorMessage(err);
+    throw(msg);
   }
 }
 
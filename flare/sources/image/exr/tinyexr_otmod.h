@@ -3,6 +3,8 @@
 
 #define TINYEXR_IMPLEMENTATION
 #include "tinyexr.h"
+#include "tthread.h"
+#include <atomic>
 #include <cassert>
 
 /*
@@ -102,6 +104,30 @@ extern int SaveEXRImageToFileHandle(const EXRImage *exr_image,
                                     const EXRHeader *exr_header, FILE *fp,
                                     const char **err);
 
+// Returns the number of resolution levels stored in the image (1 unless the
+// image is tiled with mipmaps or ripmaps, of which only the diagonal levels
+// are counted).
+extern int GetEXRNumLevels(const EXRHeader *exr_header);
+
+// Returns the size of the specified resolution level.
+extern int GetEXRLevelSize(const EXRHeader *exr_header, int level, int *width,
+                           int *height);
+
+// Returns the number of lines stored in each chunk of the image.
+extern int GetEXRChunkHeight(const EXRHeader *exr_header);
+
+// Loads the specified region of a resolution level as RGBA floats, as in
+// LoadEXRImageBufFromFileHandle(). The region is expressed in level pixel
+// coordinates, with origin at the top-left corner of the data window, and
+// out_rgba must hold 4 floats per region pixel.
+// Only the line blocks or tiles intersecting the region are read from the
+// file and decoded, in parallel through TThread::parallelFor().
+// The header is left untouched.
+extern int LoadEXRRegionFromFileHandle(float *out_rgba,
+                                       const EXRHeader *exr_header, FILE *fp,
+                                       int level, const EXRBox2i *region,
+                                       const char **err);
+
 #ifdef __cplusplus
 }
 #endif
@@ -112,6 +138,19 @@ extern int SaveEXRImageToFileHandle(const EXRImage *exr_image,
 #ifndef TINYEXR_OTMOD_IMPLEMENTATION_DEFINED
 #define TINYEXR_OTMOD_IMPLEMENTATION_DEFINED
 
+#if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0) && \
+    defined(TINYEXR_CUSTOM_WORKERS)
+// The chunks are coded by workers pulling them from a shared counter, so
+// the ones run on the calling thread go on until all chunks are done even
+// when no pooled thread is free to help.
+void tinyexr::RunWorkers(int num_threads,
+                         const std::function<void()> &worker) {
+  TThread::parallelFor(num_threads, [&](int begin, int end) {
+    for (int t = begin; t < end; t++) worker();
+  });
+}
+#endif
+
 int ParseEXRVersionFromFileHandle(EXRVersion *version, FILE *fp) {
   if (!fp) {
     return TINYEXR_ERROR_CANT_OPEN_FILE;
@@ -493,5 +532,386 @@ int SaveEXRImageToFileHandle(const EXRImage *exr_image,
   return TINYEXR_SUCCESS;
 }
 
+int GetEXRNumLevels(const EXRHeader *exr_header) {
+  if (!exr_header->tiled ||
+      exr_header->tile_level_mode == TINYEXR_TILE_ONE_LEVEL)
+    return 1;
+
+  int num_x_levels = tinyexr::CalculateNumXLevels(exr_header);
+  int num_y_levels = tinyexr::CalculateNumYLevels(exr_header);
+
+  return std::max(1, std::min(num_x_levels, num_y_levels));
+}
+
+int GetEXRLevelSize(const EXRHeader *exr_header, int level, int *width,
+                    int *height) {
+  if (level < 0 || level >= GetEXRNumLevels(exr_header))
+    return TINYEXR_ERROR_INVALID_ARGUMENT;
+
+  const EXRBox2i &dw = exr_header->data_window;
+  *width  = tinyexr::LevelSize(dw.max_x - dw.min_x + 1, level,
+                              exr_header->tile_rounding_mode);
+  *height = tinyexr::LevelSize(dw.max_y - dw.min_y + 1, level,
+                               exr_header->tile_rounding_mode);
+
+  return (*width > 0 && *height > 0) ? TINYEXR_SUCCESS
+                                     : TINYEXR_ERROR_INVALID_DATA;
+}
+
+int GetEXRChunkHeight(const EXRHeader *exr_header) {
+  if (exr_header->tiled) return exr_header->tile_size_y;
+
+  switch (exr_header->compression_type) {
+  case TINYEXR_COMPRESSIONTYPE_ZIP:
+  case TINYEXR_COMPRESSIONTYPE_ZFP:
+    return 16;
+  case TINYEXR_COMPRESSIONTYPE_PIZ:
+    return 32;
+  default:
+    return 1;
+  }
+}
+
+int LoadEXRRegionFromFileHandle(float *out_rgba, const EXRHeader *exr_header,
+                                FILE *fp, int level, const EXRBox2i *region,
+                                const char **err) {
+  if (out_rgba == NULL || exr_header == NULL || region == NULL ||
+      exr_header->header_len == 0) {
+    tinyexr::SetErrorMessage("Invalid argument for LoadEXRRegion()", err);
+    return TINYEXR_ERROR_INVALID_ARGUMENT;
+  }
+
+  if (!fp) {
+    tinyexr::SetErrorMessage("Cannot read file", err);
+    return TINYEXR_ERROR_CANT_OPEN_FILE;
+  }
+
+  if (exr_header->multipart || exr_header->non_image) {
+    tinyexr::SetErrorMessage(
+        "Loading multipart or DeepImage is not supported in LoadEXRRegion()",
+        err);
+    return TINYEXR_ERROR_UNSUPPORTED_FEATURE;
+  }
+
+  const EXRBox2i &dw     = exr_header->data_window;
+  const int data_width  = dw.max_x - dw.min_x + 1;
+  const int data_height = dw.max_y - dw.min_y + 1;
+  if (data_width <= 0 || data_height <= 0 ||
+      data_width > TINYEXR_DIMENSION_THRESHOLD ||
+      data_height > TINYEXR_DIMENSION_THRESHOLD) {
+    tinyexr::SetErrorMessage("Invalid data window", err);
+    return TINYEXR_ERROR_INVALID_DATA;
+  }
+
+  int level_width, level_height;
+  if (GetEXRLevelSize(exr_header, level, &level_width, &level_height) !=
+      TINYEXR_SUCCESS) {
+    tinyexr::SetErrorMessage("Invalid level for LoadEXRRegion()", err);
+    return TINYEXR_ERROR_INVALID_ARGUMENT;
+  }
+
+  if (region->min_x < 0 || region->min_y < 0 ||
+      region->max_x >= level_width || region->max_y >= level_height ||
+      region->max_x < region->min_x || region->max_y < region->min_y) {
+    tinyexr::SetErrorMessage("Invalid region for LoadEXRRegion()", err);
+    return TINYEXR_ERROR_INVALID_ARGUMENT;
+  }
+
+  const int num_channels = exr_header->num_channels;
+
+  std::vector<size_t> channel_offset_list;
+  int pixel_data_size   = 0;
+  size_t channel_offset = 0;
+  if (!tinyexr::ComputeChannelLayout(&channel_offset_list, &pixel_data_size,
+                                     &channel_offset, num_channels,
+                                     exr_header->channels)) {
+    tinyexr::SetErrorMessage("Failed to compute channel layout.", err);
+    return TINYEXR_ERROR_INVALID_DATA;
+  }
+
+  // RGBA channels, as in LoadEXRImageBufFromFileHandle()
+  std::vector<tinyexr::LayerChannel> layer_channels;
+  tinyexr::ChannelsInLayer(*exr_header, "", layer_channels);
+
+  if (layer_channels.size() < 1) {
+    tinyexr::SetErrorMessage("Layer Not Found", err);
+    return TINYEXR_ERROR_LAYER_NOT_FOUND;
+  }
+
+  int idx[4] = {-1, -1, -1, -1};
+  if (layer_channels.size() == 1) {
+    // Grayscale channel only.
+    idx[0] = idx[1] = idx[2] = idx[3] = int(layer_channels.front().index);
+  } else {
+    size_t ch_count = std::min(layer_channels.size(), size_t(4));
+    for (size_t c = 0; c < ch_count; c++) {
+      const tinyexr::LayerChannel &ch = layer_channels[c];
+
+      if (ch.name == "R")
+        idx[0] = int(ch.index);
+      else if (ch.name == "G")
+        idx[1] = int(ch.index);
+      else if (ch.name == "B")
+        idx[2] = int(ch.index);
+      else if (ch.name == "A")
+        idx[3] = int(ch.index);
+    }
+
+    if (idx[0] == -1 || idx[1] == -1 || idx[2] == -1) {
+      tinyexr::SetErrorMessage("RGB channels not found", err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+  }
+
+  // Read HALF channel as FLOAT.
+  std::vector<int> requested_pixel_types(static_cast<size_t>(num_channels));
+  for (int c = 0; c < num_channels; c++)
+    requested_pixel_types[size_t(c)] =
+        (exr_header->channels[c].pixel_type == TINYEXR_PIXELTYPE_UINT)
+            ? TINYEXR_PIXELTYPE_UINT
+            : TINYEXR_PIXELTYPE_FLOAT;
+
+  // Chunks layout. Each chunk is decoded into a chunk_width x chunk_height
+  // buffer, of which (width x height) pixels are valid.
+  struct Chunk {
+    size_t table_index;
+    int x, y;  // chunk coordinates (tiles) or first line (scanlines)
+    std::vector<unsigned char> data;
+  };
+
+  std::vector<Chunk> chunks;
+  size_t num_blocks = 0;
+  int chunk_width, chunk_height = GetEXRChunkHeight(exr_header);
+
+  if (exr_header->tiled) {
+    if (exr_header->tile_size_x <= 0 || exr_header->tile_size_y <= 0 ||
+        exr_header->tile_size_x > TINYEXR_DIMENSION_THRESHOLD ||
+        exr_header->tile_size_y > TINYEXR_DIMENSION_THRESHOLD) {
+      tinyexr::SetErrorMessage("Invalid tile size", err);
+      return TINYEXR_ERROR_INVALID_HEADER;
+    }
+
+    std::vector<int> num_x_tiles, num_y_tiles;
+    if (!tinyexr::PrecalculateTileInfo(num_x_tiles, num_y_tiles,
+                                       exr_header)) {
+      tinyexr::SetErrorMessage("Failed to precalculate tile info.", err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+
+    tinyexr::OffsetData offset_data;
+    num_blocks = size_t(tinyexr::InitTileOffsets(offset_data, exr_header,
+                                                 num_x_tiles, num_y_tiles));
+    if (num_blocks == 0 ||
+        (exr_header->chunk_count > 0 &&
+         exr_header->chunk_count != int(num_blocks))) {
+      tinyexr::SetErrorMessage("Invalid offset table size.", err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+
+    // Tiles are stored level by level, row by row
+    int level_index =
+        tinyexr::LevelIndex(level, level, exr_header->tile_level_mode,
+                            offset_data.num_x_levels);
+    size_t base_index = 0;
+    for (int l = 0; l < level_index; ++l)
+      for (size_t dy = 0; dy < offset_data.offsets[size_t(l)].size(); ++dy)
+        base_index += offset_data.offsets[size_t(l)][dy].size();
+
+    const std::vector<std::vector<tinyexr::tinyexr_uint64> > &level_offsets =
+        offset_data.offsets[size_t(level_index)];
+    size_t num_x = level_offsets[0].size();
+
+    chunk_width = exr_header->tile_size_x;
+    for (int ty = region->min_y / chunk_height;
+         ty <= region->max_y / chunk_height; ++ty)
+      for (int tx = region->min_x / chunk_width;
+           tx <= region->max_x / chunk_width; ++tx) {
+        Chunk chunk;
+        chunk.table_index = base_index + size_t(ty) * num_x + size_t(tx);
+        chunk.x = tx, chunk.y = ty;
+        chunks.push_back(chunk);
+      }
+  } else {
+    if (level != 0) {
+      tinyexr::SetErrorMessage("Invalid level for LoadEXRRegion()", err);
+      return TINYEXR_ERROR_INVALID_ARGUMENT;
+    }
+
+    num_blocks = (exr_header->chunk_count > 0)
+                     ? size_t(exr_header->chunk_count)
+                     : size_t((data_height + chunk_height - 1) / chunk_height);
+
+    chunk_width = data_width;
+    for (int b = region->min_y / chunk_height;
+         b <= region->max_y / chunk_height; ++b) {
+      Chunk chunk;
+      chunk.table_index = size_t(b);
+      chunk.x = 0, chunk.y = b * chunk_height;
+      chunks.push_back(chunk);
+    }
+  }
+
+  // Read the offset table and the needed chunks
+  fseek(fp, 0, SEEK_END);
+  const tinyexr::tinyexr_uint64 file_size =
+      static_cast<tinyexr::tinyexr_uint64>(ftell(fp));
+
+  std::vector<tinyexr::tinyexr_uint64> offsets(num_blocks);
+  fseek(fp, long(exr_header->header_len + 8), SEEK_SET);  // +8 for magic
+                                                          // number + version
+  if (fread(&offsets[0], sizeof(tinyexr::tinyexr_uint64), num_blocks, fp) !=
+      num_blocks) {
+    tinyexr::SetErrorMessage("Insufficient data size in offset table.", err);
+    return TINYEXR_ERROR_INVALID_DATA;
+  }
+
+  // 4 byte: scan line / 16 byte: tile coordinates
+  // 4 byte: data size
+  const size_t chunk_header_size = exr_header->tiled ? 20 : 8;
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    Chunk &chunk = chunks[i];
+    if (chunk.table_index >= num_blocks) {
+      tinyexr::SetErrorMessage("Invalid chunk index.", err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+
+    tinyexr::tinyexr_uint64 offset = offsets[chunk.table_index];
+    tinyexr::swap8(&offset);
+
+    // Incomplete offset tables would have to be reconstructed from the whole
+    // file - let the caller load it entirely.
+    if (offset == 0 || offset + chunk_header_size > file_size) {
+      tinyexr::SetErrorMessage("Invalid offset value in LoadEXRRegion().",
+                               err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+
+    int chunk_header[5];
+    fseek(fp, long(offset), SEEK_SET);
+    if (fread(chunk_header, 1, chunk_header_size, fp) != chunk_header_size) {
+      tinyexr::SetErrorMessage("fread() error", err);
+      return TINYEXR_ERROR_INVALID_FILE;
+    }
+
+    for (size_t h = 0; h < chunk_header_size / 4; ++h)
+      tinyexr::swap4(&chunk_header[h]);
+
+    int data_len = chunk_header[chunk_header_size / 4 - 1];
+    bool valid =
+        (data_len > 0) &&
+        (offset + chunk_header_size + tinyexr::tinyexr_uint64(data_len) <=
+         file_size);
+    if (exr_header->tiled)
+      valid = valid && chunk_header[0] == chunk.x &&
+              chunk_header[1] == chunk.y && chunk_header[2] == level &&
+              chunk_header[3] == level;
+    else
+      valid = valid && chunk_header[0] - dw.min_y == chunk.y;
+
+    if (!valid) {
+      tinyexr::SetErrorMessage("Invalid chunk data in LoadEXRRegion().", err);
+      return TINYEXR_ERROR_INVALID_DATA;
+    }
+
+    chunk.data.resize(size_t(data_len));
+    if (fread(&chunk.data[0], 1, size_t(data_len), fp) != size_t(data_len)) {
+      tinyexr::SetErrorMessage("fread() error", err);
+      return TINYEXR_ERROR_INVALID_FILE;
+    }
+  }
+
+  // Decode the chunks, and copy their pixels in the region
+  const int region_width = region->max_x - region->min_x + 1;
+
+  auto decode_chunk = [&](Chunk &chunk) -> bool {
+    bool alloc_success = false;
+    unsigned char **images = tinyexr::AllocateImage(
+        num_channels, exr_header->channels, &requested_pixel_types[0],
+        chunk_width, chunk_height, &alloc_success);
+
+    int x0 = chunk.x, y0 = chunk.y, width = 0, height = 0;
+    bool ret = alloc_success;
+
+    if (ret) {
+      if (exr_header->tiled) {
+        ret = tinyexr::DecodeTiledPixelData(
+            images, &width, &height, &requested_pixel_types[0], &chunk.data[0],
+            chunk.data.size(), exr_header->compression_type, level_width,
+            level_height, chunk.x, chunk.y, exr_header->tile_size_x,
+            exr_header->tile_size_y, static_cast<size_t>(pixel_data_size),
+            static_cast<size_t>(exr_header->num_custom_attributes),
+            exr_header->custom_attributes, static_cast<size_t>(num_channels),
+            exr_header->channels, channel_offset_list);
+
+        x0 = chunk.x * exr_header->tile_size_x;
+        y0 = chunk.y * exr_header->tile_size_y;
+      } else {
+        width  = data_width;
+        height = std::min(chunk_height, data_height - chunk.y);
+
+        ret = tinyexr::DecodePixelData(
+            images, &requested_pixel_types[0], &chunk.data[0],
+            chunk.data.size(), exr_header->compression_type,
+            /* line_order */ 0, width, chunk_height, chunk_width, /* y */ 0,
+            /* line_no */ 0, height, static_cast<size_t>(pixel_data_size),
+            static_cast<size_t>(exr_header->num_custom_attributes),
+            exr_header->custom_attributes, static_cast<size_t>(num_channels),
+            exr_header->channels, channel_offset_list);
+      }
+    }
+
+    if (ret) {
+      int xa = std::max(x0, region->min_x),
+          xb = std::min(x0 + width - 1, region->max_x);
+      int ya = std::max(y0, region->min_y),
+          yb = std::min(y0 + height - 1, region->max_y);
+
+      for (int y = ya; y <= yb; ++y) {
+        size_t src = size_t(y - y0) * size_t(chunk_width) + size_t(xa - x0);
+        float *dst = out_rgba + 4 * (size_t(y - region->min_y) *
+                                         size_t(region_width) +
+                                     size_t(xa - region->min_x));
+
+        for (int x = xa; x <= xb; ++x, ++src, dst += 4)
+          for (int c = 0; c < 4; ++c) {
+            int ch = idx[c];
+            if (ch < 0)
+              dst[c] = 1.0f;
+            else if (requested_pixel_types[size_t(ch)] ==
+                     TINYEXR_PIXELTYPE_UINT)
+              dst[c] = float(reinterpret_cast<unsigned int **>(images)[ch][src]);
+            else
+              dst[c] = reinterpret_cast<float **>(images)[ch][src];
+          }
+      }
+    }
+
+    if (images) {
+      for (int c = 0; c < num_channels; c++) free(images[c]);
+      free(images);
+    }
+
+    chunk.data.clear();
+    return ret;
+  };
+
+  const int num_chunks = int(chunks.size());
+
+  // Readers run inside render and preview tasks: share the cores with them
+  std::atomic<bool> invalid_data(false);
+  TThread::parallelFor(num_chunks, [&](int begin, int end) {
+    for (int i = begin; i < end; i++)
+      if (!decode_chunk(chunks[size_t(i)])) invalid_data = true;
+  });
+
+  if (invalid_data) {
+    tinyexr::SetErrorMessage("Failed to decode chunk data.", err);
+    return TINYEXR_ERROR_INVALID_DATA;
+  }
+
+  return TINYEXR_SUCCESS;
+}
+
 #endif  // TINYEXR_OTMOD_IMPLEMENTATION_DEFINED
 #endif  // TINYEXR_OTMOD_IMPLEMENTATION
@@ -81,6 +81,29 @@ public:
     return empty;
   }
 
+  //! Copies in \b segments the ones cached with \b id, if any.
+  static bool getSegmentCache(const std::string &id,
+                              std::vector<Segment> &segments) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_cache.find(id);
+    if (it == m_cache.end()) return false;
+    segments = it->second;
+    return true;
+  }
+
+  //! Returns the id of the segments computed on the image \b imageId with
+  //! \b settings; \b variant tells apart the ones computed on a part of it
+  //! or on the image mixed with others. invalidateSegmentCache(imageId)
+  //! drops them too.
+  static std::string getSegmentCacheId(const std::string &imageId,
+                                       const AutocloseSettings &settings,
+                                       const std::string &variant) {
+    return imageId + "|" + variant + "|" +
+           std::to_string(settings.m_closingDistance) + "|" +
+           std::to_string(settings.m_spotAngle) + "|" +
+           std::to_string(settings.m_opacity);
+  }
+
   static void setSegmentCache(const std::string &id,
                               const std::vector<Segment> &segments) {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -100,6 +123,15 @@ public:
   static void invalidateSegmentCache(const std::string &id) {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_cache.erase(id);
+
+    // The ones cached with getSegmentCacheId(id, ...)
+    std::string prefix = id + "|";
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+      if (it->first.compare(0, prefix.size(), prefix) == 0)
+        it = m_cache.erase(it);
+      else
+        ++it;
+    }
   }
 
   static void clearSegmentCache() {
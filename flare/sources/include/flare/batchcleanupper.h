@@ -0,0 +1,119 @@
+#pragma once
+
+#ifndef BATCHCLEANUPPER_H
+#define BATCHCLEANUPPER_H
+
+#include "trasterimage.h"
+#include "ttoonzimage.h"
+#include "tfilepath.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QStringList>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef FLARELIB_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//=============================
+//    Batch cleanupper class
+//=============================
+
+//! Cleans up a sequence of frames, processing several of them at once.
+/*!
+  BatchCleanupper is a read -> process -> write pipeline around TCleanupper.
+  Frames are pulled from a \a source callback, processed concurrently (each
+  one by a private TCleanupper built on a copy of the parameters and source
+  dpi that TCleanupper::instance() holds when the frame is read), and handed
+  to a \a sink callback \b in \b source \b order. Both callbacks are invoked
+  on the thread calling run(), so level reads and writes need no further
+  synchronization; warnings are shown there too.
+
+  At most getMaxFramesInFlight() frames are loaded at any time.
+
+  To produce the same output as frame-by-frame cleanup, some frames are
+  processed on the calling thread once all preceding ones have been written,
+  and before any following one is read:
+    \li the first frame of a level, whose output updates the level properties;
+    \li all frames, when grey auto-adjust is active, since it matches each
+        frame's histogram against the first one.
+*/
+class DVAPI BatchCleanupper {
+public:
+  struct Frame {
+    TFrameId m_fid;
+    TRasterImageP m_image;  //!< The frame to be cleaned up
+    bool m_first;           //!< Whether this is the first frame of its level
+
+    Frame() : m_first(false) {}
+  };
+
+  struct Result {
+    TFrameId m_fid;
+    TToonzImageP m_toonzImage;    //!< The output, with line processing
+    TRasterImageP m_rasterImage;  //!< The output, without line processing
+    bool m_autocentered;
+
+    Result() : m_autocentered(false) {}
+  };
+
+  //! Fills in the next frame to be cleaned up. Returns false at the end of
+  //! the sequence; frames with no image are passed to the sink with an empty
+  //! result.
+  typedef std::function<bool(Frame &)> Source;
+  //! Receives a cleaned up frame.
+  typedef std::function<void(Result &)> Sink;
+
+public:
+  BatchCleanupper(int threadCount = 0);
+  ~BatchCleanupper();
+
+  //! Sets the number of worker threads; 0 stands for the ideal thread count.
+  void setThreadCount(int threadCount) { m_threadCount = threadCount; }
+  int getThreadCount() const;
+
+  //! Sets the maximum number of frames loaded at the same time; 0 stands for
+  //! twice the thread count.
+  void setMaxFramesInFlight(int count) { m_maxFramesInFlight = count; }
+  int getMaxFramesInFlight() const;
+
+  //! Passed to TCleanupper::finalize(), see there.
+  void setIsCleanupper(bool isCleanupper) { m_isCleanupper = isCleanupper; }
+
+  //! Cleans up the frames returned by \b source, and returns the number of
+  //! frames passed to \b sink.
+  int run(const Source &source, const Sink &sink);
+
+  //! Stops run() after the frame being written. May be invoked by the sink.
+  void cancel() { m_canceled = true; }
+  bool isCanceled() const { return m_canceled; }
+
+private:
+  struct Job;
+  class JobTask;
+
+  QThreadPool m_pool;
+  QMutex m_mutex;
+  QWaitCondition m_jobDone;
+
+  int m_threadCount, m_maxFramesInFlight;
+  bool m_isCleanupper;
+
+  std::atomic<bool> m_canceled;
+
+private:
+  void process(Job &job);
+};
+
+#endif  // BATCHCLEANUPPER_H
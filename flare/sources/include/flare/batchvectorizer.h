@@ -0,0 +1,139 @@
+#pragma once
+
+#ifndef BATCHVECTORIZER_H
+#define BATCHVECTORIZER_H
+
+#include "flare/vectorizerparameters.h"
+#include "timage.h"
+#include "tvectorimage.h"
+#include "tfilepath.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef FLARELIB_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//  Forward declarations
+
+class TPalette;
+
+//==============================
+//    Batch vectorizer class
+//==============================
+
+//! Vectorizes a sequence of frames on multiple threads.
+/*!
+  BatchVectorizer pulls frames from a \a source callback, vectorizes them
+  concurrently through VectorizerCore, and hands the results to a \a sink
+  callback \b in \b source \b order. Both callbacks are invoked on the thread
+  calling run(), so level reads and writes need no further synchronization.
+
+  At most getMaxFramesInFlight() frames are loaded at any time, which keeps
+  memory usage bounded regardless of the sequence length.
+
+  Frames are vectorized against a copy of the palette taken when run() is
+  called. Frames whose vectorization adds styles (full-color rasters) get a
+  copy of their own, and the styles they add are merged into the palette in
+  source order, sharing those of the same color. So the output doesn't depend
+  on the thread count, but unlike a frame by frame vectorization, no frame
+  reuses the styles added by the preceding ones.
+
+  \sa VectorizerCore, VectorizerConfiguration classes.
+*/
+class DVAPI BatchVectorizer final : public QObject {
+  Q_OBJECT
+
+public:
+  struct Frame {
+    TFrameId m_fid;
+    TImageP m_image;
+    std::shared_ptr<VectorizerConfiguration>
+        m_configuration;  //!< Either a CenterlineConfiguration or a
+                          //!< NewOutlineConfiguration
+  };
+
+  //! Fills in the next frame to be vectorized. Returns false at the end of
+  //! the sequence; frames with no image are skipped.
+  typedef std::function<bool(Frame &)> Source;
+  //! Receives a vectorized frame, or a null image if the vectorization
+  //! failed.
+  typedef std::function<void(const TFrameId &, const TVectorImageP &)> Sink;
+
+public:
+  BatchVectorizer(int threadCount = 0);
+  ~BatchVectorizer();
+
+  //! Sets the number of worker threads; 0 stands for the ideal thread count.
+  void setThreadCount(int threadCount);
+  int getThreadCount() const;
+
+  //! Sets the maximum number of frames loaded at the same time; 0 stands for
+  //! twice the thread count.
+  void setMaxFramesInFlight(int count) { m_maxFramesInFlight = count; }
+  int getMaxFramesInFlight() const;
+
+  //! Vectorizes the frames returned by \b source against \b palette, and
+  //! returns the number of frames vectorized.
+  int run(TPalette *palette, const Source &source, const Sink &sink);
+
+  bool isCanceled() const { return m_canceled; }
+
+  //! Sets the affine and thickness scale of \b c mapping the pixels of \b img
+  //! to the stage, according to the image dpi. Returns false if \b img is not
+  //! a raster image.
+  static bool setImageTransform(const TImageP &img,
+                                VectorizerConfiguration &c);
+
+  //! Returns whether the vectorization of \b img leaves the palette untouched
+  //! (so that a copy can be shared among concurrent vectorizations).
+  static bool isPaletteReadOnly(const TImageP &img);
+
+signals:
+
+  //! Forwards the VectorizerCore::partialDone(int,int) signal of the oldest
+  //! frame in flight.
+  void partialDone(int, int);
+
+  //! Emitted on the thread calling run() when a frame becomes the oldest in
+  //! flight, i.e. the one partialDone() refers to.
+  void frameStarted(const TFrameId &fid);
+
+  //! Transmits a cancel downward to the running VectorizerCore instances.
+  void transmitCancel();
+
+public slots:
+
+  void cancel();
+
+private:
+  struct Job;
+  class JobTask;
+
+  QThreadPool m_pool;
+  QMutex m_mutex;
+  QWaitCondition m_jobDone;
+
+  int m_threadCount, m_maxFramesInFlight;
+
+  std::atomic<bool> m_canceled;
+  std::atomic<int> m_frontIndex;  //!< Index of the oldest frame in flight
+
+private:
+  void process(Job &job);
+};
+
+#endif  // BATCHVECTORIZER_H
@@ -176,6 +176,9 @@ public:
   }
   bool isBackupEnabled() const { return getBoolValue(backupEnabled); }
   int getBackupKeepCount() { return getIntValue(backupKeepCount); }
+  bool isBinarySceneFormatEnabled() const {
+    return getBoolValue(binarySceneFormat);
+  }
   bool isSceneNumberingEnabled() const {
     return getBoolValue(sceneNumberingEnabled);
   }
@@ -264,6 +267,12 @@ public:
   ColumnIconLoadingPolicy getColumnIconLoadingPolicy() const {
     return ColumnIconLoadingPolicy(getIntValue(columnIconLoadingPolicy));
   }
+  bool isSoundPeakFilesEnabled() const {
+    return getBoolValue(soundPeakFilesEnabled);
+  }
+  bool isLazyLevelLoadingEnabled() const {
+    return getBoolValue(lazyLevelLoading);
+  }
 
   int addLevelFormat(const LevelFormat &format);  //!< Inserts a new level
                                                   //! format.  \return  The
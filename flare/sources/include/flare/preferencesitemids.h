@@ -61,6 +61,8 @@ enum PreferencesItemId {
   rasterLevelCachingBehavior,
   // initialLoadTlvCachingBehavior, // deprecated
   columnIconLoadingPolicy,
+  soundPeakFilesEnabled,
+  lazyLevelLoading,
   levelFormats,  // need to be handle separately
   autoRemoveUnusedLevels,
 
@@ -75,6 +77,7 @@ enum PreferencesItemId {
   backupKeepCount,
   rasterBackgroundColor,
   resetUndoOnSavingLevel,
+  binarySceneFormat,
 
   //----------
   // Import / Export
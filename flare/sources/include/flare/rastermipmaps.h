@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef RASTERMIPMAPS_H
+#define RASTERMIPMAPS_H
+
+#include <memory>
+
+// TnzCore includes
+#include "traster.h"
+
+// STD includes
+#include <vector>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef FLARELIB_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//***************************************************************************************
+//    RasterMipmaps declaration
+//***************************************************************************************
+
+//! RasterMipmaps is a singleton storing, for large fullcolor rasters, a
+//! pyramid of progressively halved copies used to draw them zoomed out.
+/*!
+  Each level of a pyramid halves the previous one, and is split in square
+  tiles of TileSize pixels stored in the global TImageCache instance. Pyramids
+  are built in the background the first time a raster is drawn at half its
+  size or less; until then, painters draw the raster itself.
+
+  Painters ask for the tiles covering the visible part of a raster through
+  getTiles(), and draw them scaled by a factor 2^level.
+
+  Pyramids keep their raster alive: they are released when nothing else
+  refers to the raster at the next getTiles() or invalidate() call, and all
+  together by clear() (ImageManager::clear() calls it when switching scene).
+  Users modifying a raster in place must call invalidate()
+  (TXshSimpleLevel::touchFrame() does so for the frames of raster levels).
+*/
+
+class DVAPI RasterMipmaps {
+  class Imp;
+  std::unique_ptr<Imp> m_imp;
+
+  class BuildTask;
+
+public:
+  enum { TileSize = 512 };
+
+  struct Tile {
+    TRaster32P m_raster;  //!< The tile's content
+    TPoint m_pos;         //!< The tile's position in its level
+  };
+
+public:
+  static RasterMipmaps *instance();
+
+  //! Stores in \b tiles the tiles covering \b rect (in \b ras pixel
+  //! coordinates) from the pyramid level of \b ras best suited to draw it at
+  //! \b scale, and returns the level. Returns 0, and no tile, if \b ras must
+  //! be drawn directly.
+  int getTiles(const TRasterP &ras, double scale, const TRectD &rect,
+               std::vector<Tile> &tiles);
+
+  //! Discards the pyramid of \b ras, whose content has changed.
+  void invalidate(const TRasterP &ras);
+
+  //! Discards all the pyramids, releasing their rasters.
+  void clear();
+
+private:
+  RasterMipmaps();
+  ~RasterMipmaps();
+
+  // not copyable
+  RasterMipmaps(const RasterMipmaps &);
+  RasterMipmaps &operator=(const RasterMipmaps &);
+};
+
+#endif  // RASTERMIPMAPS_H
@@ -13,6 +13,7 @@ namespace TScriptBinding {
 class DVAPI CenterlineVectorizer final : public Wrapper {
   Q_OBJECT
   CenterlineConfiguration *m_parameters;
+  int m_threadCount;  //!< Threads used on levels, 0 for the ideal count
 
 public:
   CenterlineVectorizer();
@@ -57,6 +58,10 @@ public:
   bool getEir() const;
   void setEir(bool v);
 
+  Q_PROPERTY(int threads READ getThreads WRITE setThreads)
+  int getThreads() const;
+  void setThreads(int v);
+
 private:
   QScriptValue vectorizeImage(const TImageP &src1, TPalette *palette);
 };
@@ -13,6 +13,7 @@ namespace TScriptBinding {
 class DVAPI OutlineVectorizer final : public Wrapper {
   Q_OBJECT
   NewOutlineConfiguration *m_parameters;
+  int m_threadCount;  //!< Threads used on levels, 0 for the ideal count
 
 public:
   OutlineVectorizer();
@@ -62,6 +63,10 @@ public:
   Q_PROPERTY(int toneThreshold READ getToneThreshold WRITE setToneThreshold)
   int getToneThreshold() const;
   void setToneThreshold(int v);
+
+  Q_PROPERTY(int threads READ getThreads WRITE setThreads)
+  int getThreads() const;
+  void setThreads(int v);
 };
 
 }  // namespace TScriptBinding
@@ -8,6 +8,8 @@
 #include "trastercm.h"
 #include "tgl.h"
 #include <string>
+#include <memory>
+#include <vector>
 
 // TnzExt includes
 #include "ext/plasticvisualsettings.h"
@@ -185,6 +187,40 @@ DVAPI void visit(Visitor &visitor, TXshLevel *level, const TFrameId &fid,
 //    Specific Visitor  declarations
 //**********************************************************************************************
 
+//! Stage::RasterLayerCache stores the composition of the raster images
+//! found below and above the current column across the repaints of a viewer.
+/*!
+  A viewer passes its cache to each RasterPainter it creates (see
+  RasterPainter::setLayerCache()). When only a region of the viewer is
+  repainted - typically while drawing on the current column - the painter
+  re-composites just the current column's images in that region, between the
+  cached layers.
+
+  The layers are keyed by the images, their placement and the view affine.
+  Since images may also be changed in place, a repaint of the whole viewer
+  always discards the cache.
+*/
+
+class DVAPI RasterLayerCache {
+  struct Layers;
+  std::vector<std::shared_ptr<Layers>> m_layers;  //!< One per raster flush
+
+  friend class RasterPainter;
+
+public:
+  RasterLayerCache();
+  ~RasterLayerCache();
+
+  void clear();
+
+private:
+  // not copyable
+  RasterLayerCache(const RasterLayerCache &);
+  RasterLayerCache &operator=(const RasterLayerCache &);
+};
+
+//=============================================================================
+
 //! Stage::RasterPainter is the object responsible for drawing scene contents on
 //! a standard
 //! Toonz SceneViewer panel.
@@ -268,6 +304,10 @@ private:
 
   std::vector<TStroke *> m_guidedStrokes;
 
+  RasterLayerCache *m_layerCache;  //!< (not owned) Layers kept across repaints
+  int m_flushCount;                //!< Raster flushes performed so far
+  double m_compositeTime;  //!< Time spent compositing rasters, in msecs
+
 public:
   RasterPainter(const TDimension &dim, const TAffine &viewAff,
                 const TRect &rect, const ImagePainter::VisualSettings &vs,
@@ -297,6 +337,16 @@ public:
   void setRasterDarkenBlendedView(bool on) { m_doRasterDarkenBlendedView = on; }
   void setCurrentImageId(std::string id) { m_currentImageId = id; }
   std::vector<TStroke *> &getGuidedStrokes() { return m_guidedStrokes; }
+
+  void setLayerCache(RasterLayerCache *cache) { m_layerCache = cache; }
+
+  //! Returns the time spent compositing raster images, in milliseconds.
+  double getCompositeTime() const { return m_compositeTime; }
+
+private:
+  void putNodes(const TRaster32P &out, const TPoint &origin, int begin,
+                int end);
+  bool putCachedNodes(const TRaster32P &out, const TRect &rect);
 };
 
 //=============================================================================
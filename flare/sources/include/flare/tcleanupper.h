@@ -7,6 +7,8 @@
 #include "ttoonzimage.h"
 #include "flare/cleanupparameters.h"
 
+#include <QStringList>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef FLARELIB_EXPORTS
@@ -58,12 +60,16 @@ public:
 class DVAPI TCleanupper {
   CleanupParameters *m_parameters;
   TPointD m_sourceDpi;
+  QStringList *m_warnings;  //!< When not null, warnings are collected here
+                            //!  rather than shown
 
 private:
   TCleanupper()
-      : m_parameters(0) {
+      : m_parameters(0), m_warnings(0) {
   }  // singleton class - will not be externally constructed
 
+  friend class BatchCleanupper;  // Builds private instances for its workers
+
 public:
   static TCleanupper *instance();
 
@@ -115,6 +121,7 @@ private:
   void preprocessColors(const TRasterCM32P &outRas, const TRaster32P &raster32,
                         const TargetColors &colors);
   void removeSinglePoint(const TRasterCM32P &outRas);
+  void warning(const QString &msg);
 
   // post-processing phase
   TToonzImageP doPostProcessingGR8(const CleanupPreprocessedImage *img);
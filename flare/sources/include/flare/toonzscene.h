@@ -111,10 +111,15 @@ public:
                                //!  associated project and the scene resources.
   void loadNoResources(const TFilePath &path);  //!< Loads a scene \a without
                                                 //! loading its resources.
+  void loadProperties(
+      const TFilePath &path);  //!< Loads only the scene properties (cameras,
+                               //!  output settings) and project.
   void loadResources(
-      bool withProgressDialog = false);  //!< Loads the scene resources.
-  void load(const TFilePath &path,
-            bool withProgressDialog = false);  //!  Loads a scene from file.
+      bool withProgressDialog = false,
+      bool lazily = false);  //!< Loads the scene resources - lazily loaded
+                             //!  levels complete their load in background.
+  void load(const TFilePath &path, bool withProgressDialog = false,
+            bool lazily = false);  //!  Loads a scene from file.
 
   /*! \return   The \a coded path to be used for import. */
 
@@ -356,6 +356,12 @@ with the frame.
   bool getKeyframeSpan(int row, int &r0, double &ease0, int &r1,
                        double &ease1) const;
 
+  /*!
+Returns the object's placement at frame \b t. Placements are cached for each
+frame until the object or one of its ancestors is invalidated; objects whose
+placement depends on data not notified to them (hooks, splines, IK, expression
+references) are not cached. Can be called from several threads at once.
+*/
   TAffine getPlacement(double t);
   TAffine getParentPlacement(double t) const;
 
@@ -442,7 +448,7 @@ Doesn't delete \e this.
   void attachChildrenToParent(const TStageObjectId &parentId);
 
   //! Resets the area position setting internal time of the object and of all
-  //! his children to -1.
+  //! his children to -1, and clears their cached placements.
   void invalidate();
 
   /*!
@@ -520,6 +526,9 @@ private:
   TAffine m_localPlacement;
   TAffine m_absPlacement;
 
+  //! Placements by frame, guarded by m_tree->getPlacementLock()
+  mutable std::map<double, TAffine> m_placements;
+
   TStageObjectSpline *m_spline;
   Status m_status;
 
@@ -560,6 +569,7 @@ private:
   TPointD getHandlePos(std::string handle, int row) const;
   TAffine computeLocalPlacement(double frame);
   TStageObject *findRoot(double frame) const;
+  bool isPlacementCacheable(double frame) const;
   TStageObject *getPinnedDescendant(int frame);
 
 private:
@@ -573,6 +583,10 @@ private:
   void invalidate(LazyData &ld) const;
   void updateKeyframes(LazyData &ld) const;
 
+  //! Resets the internal time of the object and its children, keeping the
+  //! cached placements.
+  void resetTime();
+
   void onChange(const class TParamChange &c) override;
 };
 
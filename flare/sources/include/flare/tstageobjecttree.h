@@ -24,6 +24,7 @@ class TStageObjectSpline;
 class TCamera;
 
 class TXsheet;
+class QReadWriteLock;
 
 //=============================================================================
 // HandleManager
@@ -182,6 +183,12 @@ Returns the numbers of the objects in the tree.
 
   void invalidateAll();
 
+  /*!
+          Returns the lock guarding the placement caches of the objects in
+     the tree. It is recursive: see TStageObject::getPlacement().
+  */
+  QReadWriteLock *getPlacementLock() const;
+
   /*!
           Sets the handle manager to be \b \e hm.
           An Handle Manager is an object that implements a method to retrieve
@@ -6,6 +6,8 @@
 #include "trastercm.h"
 #include <QString>
 
+#include <string>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef FLARELIB_EXPORTS
@@ -26,6 +28,13 @@ public:
     int m_pixelSize;
 
   public:
+    //! Storage of the tile's pixels in the image cache; see TTileSet::pack()
+    enum Packing {
+      UNPACKED,  //!< Plain raster
+      LZ4,       //!< LZ4-compressed raster
+      LZ4_DELTA  //!< LZ4-compressed xor against the image's pixels
+    };
+
     TRect m_rasterBounds;
 
     Tile();
@@ -36,11 +45,46 @@ public:
     virtual Tile *clone() const = 0;
 
     // expressed in byte
-    int getSize() { return m_dim.lx * m_dim.ly * m_pixelSize; }
+    int getSize() {
+      return (m_packing == UNPACKED) ? m_dim.lx * m_dim.ly * m_pixelSize
+                                     : m_packedSize;
+    }
+
+    Packing getPacking() const { return m_packing; }
+
+    //! Compresses the tile, as a delta against the pixels of \b reference
+    //! under m_rasterBounds if \b reference is specified.
+    void pack(const TRasterP &reference);
+    //! Restores the plain raster; \b reference must have the same pixels
+    //! it had when the tile was packed as a delta. Returns false, leaving
+    //! the tile packed, if those pixels have changed in the meantime.
+    bool unpack(const TRasterP &reference);
+
+  protected:
+    Packing m_packing;
+    int m_packedSize;
+    TUINT64 m_referenceSum;  //!< Checksum of the pixels of a delta's reference
+
+    //! Returns the tile's raster, decompressing it if needed. Delta-packed
+    //! tiles cannot be decoded without their reference: they return a null
+    //! raster.
+    TRasterP getUnpackedRaster() const;
+    //! Decodes a delta-packed tile against \b reference, returning a null
+    //! raster if the reference doesn't match the one it was packed against.
+    TRasterP getDeltaRaster(const TRasterP &reference) const;
+    //! Repacks a delta-packed tile as a plain LZ4 copy, returning its
+    //! decoded raster; returns a null raster, leaving the delta, if
+    //! \b reference doesn't match.
+    TRasterP dropDelta(const TRasterP &reference);
+    void copyStorage(Tile *dst) const;
+
+    virtual void setRaster(const TRasterP &ras) = 0;
 
   private:
     Tile(const Tile &tile);
     Tile &operator=(const Tile &tile);
+
+    friend class TTileSet;
   };
 
 protected:
@@ -49,6 +93,9 @@ protected:
   typedef std::vector<Tile *> Tiles;
   Tiles m_tiles;
 
+  //! Id of the image the tiles are delta-packed against, if any
+  std::string m_referenceId;
+
 public:
   TTileSet(const TDimension &dim) : m_srcImageSize(dim) {}
   virtual ~TTileSet();
@@ -57,6 +104,30 @@ public:
 
   void add(Tile *tile);
 
+  //! Compresses all the tiles, storing them as deltas against \b reference
+  //! when possible. The tiles of a set storing the image before an edit
+  //! are best packed against the image after the edit, since they will be
+  //! read back (unpack()) only when the image is in that same state.
+  //! Sets packed against an image identified by \b imageId are tracked,
+  //! so that rebaseDeltas() can turn them into plain copies.
+  void pack(const TRasterP &reference,
+            const std::string &imageId = std::string());
+  //! Restores the plain rasters of the tiles packed by pack(). Tiles whose
+  //! reference pixels have changed since cannot be restored: they are
+  //! removed from the set.
+  void unpack(const TRasterP &reference);
+  //! Repacks the delta tiles as plain LZ4 copies. Undos call it when they
+  //! paste their tiles back: \b reference, the image after the edit, is
+  //! about to be lost, and a redo doesn't pack the tiles again.
+  void dropDeltas(const TRasterP &reference);
+
+  //! Returns whether some tile set is delta-packed against \b imageId.
+  static bool hasDeltas(const std::string &imageId);
+  //! Repacks as plain copies the tiles delta-packed against \b imageId,
+  //! whose current pixels are \b raster. Must be called before the image
+  //! is replaced or modified outside of an undo.
+  static void rebaseDeltas(const std::string &imageId, const TRasterP &raster);
+
   // crea un tile estraendo rect*ras->getBounds() da ras.
   // Nota: se rect e' completamente fuori non fa nulla
   // Nota: clona il raster!
@@ -69,6 +140,10 @@ public:
   TDimension getSrcImageSize() const { return m_srcImageSize; }
 
   virtual TTileSet *clone() const = 0;
+
+private:
+  void rebase(const TRasterP &raster);
+  void unregisterDeltas();
 };
 
 //********************************************************************************
@@ -91,6 +166,9 @@ public:
 
     void getRaster(TRasterCM32P &ras) const;
 
+  protected:
+    void setRaster(const TRasterP &ras) override;
+
   private:
     Tile(const Tile &tile);
     Tile &operator=(const Tile &tile);
@@ -131,6 +209,9 @@ public:
 
     void getRaster(TRasterP &ras) const;
 
+  protected:
+    void setRaster(const TRasterP &ras) override;
+
   private:
     Tile(const Tile &tile);
     Tile &operator=(const Tile &tile);
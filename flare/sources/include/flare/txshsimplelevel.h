@@ -3,6 +3,7 @@
 #ifndef TXSHSIMPLELEVEL_INCLUDED
 #define TXSHSIMPLELEVEL_INCLUDED
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -17,6 +18,7 @@
 // TnzCore includes
 #include "traster.h"
 #include "trasterimage.h"
+#include "tthread.h"
 
 // Qt includes
 #include <QObject>
@@ -124,7 +126,10 @@ public:
   void updateReadOnly();
 
   // Properties management
-  LevelProperties *getProperties() const { return m_properties.get(); }
+  LevelProperties *getProperties() const {
+    resolveLoad();
+    return m_properties.get();
+  }
   void clonePropertiesFrom(const TXshSimpleLevel *oldSl);
 
   // Palette management
@@ -145,11 +150,15 @@ public:
   TFrameId getFirstFid() const;
   TFrameId getLastFid() const;
 
-  bool isEmpty() const override { return m_frames.empty(); }
+  bool isEmpty() const override {
+    resolveLoad();
+    return m_frames.empty();
+  }
   bool isFid(const TFrameId &fid) const;
 
   const TFrameId &getFrameId(int index) const;
   int getFrameCount() const override {
+    resolveLoad();
     return static_cast<int>(m_frames.size());
   }
 
@@ -256,6 +265,20 @@ public:
   void load() override;
   void load(const std::vector<TFrameId> &fIds);
 
+  /*!
+    Loads the level lazily: its frames list and headers are read by a
+    background job, and the load is completed when the job is done - or at
+    the first access to the level's content, waiting for the job if needed.
+    Levels whose load depends on the current loading state are loaded at once.
+  */
+  void loadLazily();
+  bool isLoadPending() const { return m_pendingLoad; }
+  //! Completes a lazy load. Does nothing if no lazy load is pending.
+  void completeLoad();
+  //! Moves the background read of a pending lazy load ahead of the others,
+  //! e.g. when the level is displayed.
+  void prioritizeLoad();
+
   //! Saves the level to disk, with the same path deduction from load()
   void save() override;
 
@@ -268,9 +291,13 @@ public:
 
   // Content history management
   const TContentHistory *getContentHistory() const {
+    resolveLoad();
+    return m_contentHistory.get();
+  }
+  TContentHistory *getContentHistory() {
+    resolveLoad();
     return m_contentHistory.get();
   }
-  TContentHistory *getContentHistory() { return m_contentHistory.get(); }
 
   //! destroys the old contentHistory and replaces it with the new one. Gets
   //! ownership
@@ -279,6 +306,7 @@ public:
   // Frame renumbering
   void setRenumberTable();
   const std::map<TFrameId, TFrameId> &renumberTable() const {
+    resolveLoad();
     return m_renumberTable;
   }
 
@@ -338,9 +366,17 @@ public:
 public Q_SLOTS:
   void onPaletteChanged();  //!< Invoked when some colorstyle has been changed
 
+private Q_SLOTS:
+  void onInfoRead();  //!< Invoked when the read of a lazy load is done
+
+Q_SIGNALS:
+  void loadCompleted();  //!< Emitted when a lazy load completes
+
 private:
   using FramesSet = boost::container::flat_set<TFrameId>;
 
+  class InfoReader;
+
 private:
   std::unique_ptr<LevelProperties> m_properties;
   std::unique_ptr<TContentHistory> m_contentHistory;
@@ -373,7 +409,25 @@ private:
   bool m_temporaryHookMerged;  //!< Used only during hook merge (and hence
                                //!< during saving)
 
+  TThread::RunnableP m_infoReader;  //!< Background read of a lazy load
+  std::atomic<bool> m_pendingLoad;  //!< Whether a lazy load is pending
+  bool m_completingLoad;
+
 private:
+  /*!
+    Completes any pending lazy load before the level's content is accessed.
+    Const accessors reach it from render and worker threads too, so the
+    completion - a whole load() - may run outside the main thread. It is
+    serialized by a lock that also blocks the level's other accessors until
+    it is done, and load() leaves main thread state alone while completing:
+    it ignores the loading level range, defers the studio palette links and
+    its warnings to the main event loop, and finds the full-color palette
+    already built by loadLazily(). Keep it so when changing load().
+  */
+  void resolveLoad() const {
+    if (m_pendingLoad) const_cast<TXshSimpleLevel *>(this)->completeLoad();
+  }
+
   //! Save simple level in scene-decoded path \p decodedFp.
   void saveSimpleLevel(const TFilePath &decodedFp,
                        bool overwritePalette = true);
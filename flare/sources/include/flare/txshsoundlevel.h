@@ -5,12 +5,17 @@
 
 #include "flare/txshlevel.h"
 #include "tsound.h"
+#include "tthread.h"
 
 #include <QList>
 
+#include <memory>
+
 #include "tpersist.h"
 #include "orientation.h"
 
+class TSoundPeaks;
+
 #undef DVAPI
 #undef DVVAR
 #ifdef FLARELIB_EXPORTS
@@ -22,6 +27,8 @@
 #endif
 
 class DVAPI TXshSoundLevel final : public TXshLevel {
+  Q_OBJECT
+
   PERSIST_DECLARATION(TXshSoundLevel)
 
   TSoundTrackP m_soundTrack;
@@ -30,12 +37,12 @@ class DVAPI TXshSoundLevel final : public TXshLevel {
   double m_samplePerFrame;
   int m_frameSoundCount;
   double m_fps;
-  //! Values is a map of \b Integer and \b DoublePair.
-  /*! Two maps, one for vertical layout and one for horizontal.
-Integer is pixel number since start of sound.
-DoublePair is computed according to frameRate, frameCount
-and soundtrack pressure. Means sound min and max.*/
-  std::map<int, DoublePair> m_values[Orientations::COUNT];
+  //! Min/max pressure index of the soundtrack, built in background.
+  /*! The pixel values drawn in the xsheet are queried from it on demand,
+according to frameRate, frameCount and the orientation's dimensions.
+It is null until the build task has finished.*/
+  std::shared_ptr<const TSoundPeaks> m_peaks;
+  TThread::RunnableP m_peaksTask;
 
   TFilePath m_path;
 
@@ -62,12 +69,22 @@ public:
   void save() override;
   void save(const TFilePath &path);
 
-  void computeValuesFor(const Orientation *o);
   void computeValues();
 
+  //! Returns the sound min and max at the specified pixel since the start
+  //! of the sound; \b values is untouched if it is not available (yet).
   void getValueAtPixel(const Orientation *o, int pixel,
                        DoublePair &values) const;
 
+  //! Returns the soundtrack's peak index, or null while it is being built.
+  std::shared_ptr<const TSoundPeaks> getPeaks() const { return m_peaks; }
+  bool arePeaksReady() const { return m_peaks || !m_soundTrack; }
+  //! Builds the peak index on the calling thread if the background build
+  //! has not completed yet, for callers that cannot wait for peaksReady().
+  void waitForPeaks() {
+    if (!arePeaksReady()) buildPeaks(false);
+  }
+
   /*! Set frame rate to \b fps. \sa getSamplePerFrame() */
   void setFrameRate(double fps);
   double getFrameRate() const { return m_fps; }
@@ -78,6 +95,7 @@ public:
   void setSoundTrack(TSoundTrackP st) {
     m_soundTrack = st;
     computeValues();
+    buildPeaks();
   }
   TSoundTrackP getSoundTrack() { return m_soundTrack; }
 
@@ -90,7 +108,16 @@ public:
 
   void getFids(std::vector<TFrameId> &fids) const override;
 
+signals:
+  //! Emitted on the main thread once the background peak index is built.
+  void peaksReady();
+
 private:
+  void buildPeaks(bool async = true);
+
+  class PeaksTask;
+  friend class PeaksTask;
+
   // not implemented
   TXshSoundLevel(const TXshSoundLevel &);
   TXshSoundLevel &operator=(const TXshSoundLevel &);
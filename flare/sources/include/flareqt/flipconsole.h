@@ -365,6 +365,7 @@ private:
 
   bool m_isPlay;
   int m_fps, m_sceneFps;
+  double m_compositeTime = 0;  //!< Shown next to the fps while playing
   bool m_reverse;
   int m_markerFrom, m_markerTo;
   bool m_drawBlanksEnabled;
@@ -432,6 +433,8 @@ protected slots:
 
 public slots:
   void onPreferenceChanged(const QString &);
+  //! Shows \b msecs as the time spent compositing the viewed frame
+  void setCompositeTime(double msecs);
 
 private:
   friend class PlaybackExecutor;
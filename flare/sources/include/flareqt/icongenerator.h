@@ -166,8 +166,15 @@ private:
 
   Settings m_settings;
 
+  //! Pending file icon requests, by icon id
+  std::map<std::string, TThread::RunnableP> m_fileIconRenderers;
+
 private:
   void addTask(const std::string &id, TThread::RunnableP iconRenderer);
+  void addFileTask(const std::string &id, const TFilePath &path,
+                   const TFrameId &fid);
+  bool releaseFileTask(const std::string &id,
+                       const TThread::RunnableP &iconRenderer);
 };
 
 //**********************************************************************************
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef TBAKEDDOUBLEPARAM_H
+#define TBAKEDDOUBLEPARAM_H
+
+// TnzBase includes
+#include "tdoubleparam.h"
+
+// Qt includes
+#include <QMutex>
+
+// STD includes
+#include <memory>
+#include <vector>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TPARAM_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//*****************************************************************************
+//    TBakedDoubleParam  declaration
+//*****************************************************************************
+
+//! The TBakedDoubleParam stores the values of a TDoubleParam at the integer
+//! frames of a range, so that repeated queries become a table lookup.
+/*!
+  The table is built on the first query, through
+  TDoubleParam::evaluateRange(), and built again on the first query after
+  the param's change count (see TDoubleParam::getChangeCount()) moved on.
+  Frames that are not integer or lie outside the range are passed to
+  TDoubleParam::getValue().
+
+  Params with expressions referring to other objects (see
+  TDoubleParam::hasReferences()) are never baked, since the changes of the
+  referenced objects don't move the param's change count.
+
+  The param is not observed, so tables can be created, queried and
+  destroyed on render threads while the param is edited. getValue() can be
+  called from several threads at once.
+*/
+class DVAPI TBakedDoubleParam final {
+  struct Samples {
+    unsigned int m_changeCount;    //!< The param's change count when baked
+    std::vector<double> m_values;  //!< Empty if the param can't be baked
+  };
+
+  TDoubleParamP m_param;  //!< The baked param
+  int m_frame0,           //!< First frame in the table
+      m_frameCount;       //!< Number of frames in the table
+
+  std::shared_ptr<const Samples> m_samples;  //!< The table, or null if not
+                                             //!  built (atomic access)
+  QMutex m_mutex;                            //!< Serializes bake()
+
+public:
+  TBakedDoubleParam(const TDoubleParamP &param, int frame0, int frameCount);
+
+  const TDoubleParamP &getParam() const { return m_param; }
+  int getFirstFrame() const { return m_frame0; }
+  int getFrameCount() const { return m_frameCount; }
+
+  double getValue(double frame);
+
+private:
+  std::shared_ptr<const Samples> bake();
+
+  // not copyable
+  TBakedDoubleParam(const TBakedDoubleParam &);
+  TBakedDoubleParam &operator=(const TBakedDoubleParam &);
+};
+
+#endif  // TBAKEDDOUBLEPARAM_H
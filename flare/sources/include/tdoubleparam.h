@@ -82,6 +82,16 @@ public:
   // (e.g. expression and linear) then getValue(frame,true) can be !=
   // getValue(frame,false)
 
+  //! Fills \b values with the values at frame0, frame0 + 1, ..., up to
+  //! frame1 (included). Equivalent to calling getValue() on each frame, but
+  //! expression segments are evaluated in a single batch.
+  void evaluateRange(double frame0, double frame1, double *values) const;
+
+  //! Fills \b values with the values at \b count frames, from frame0 and
+  //! \b step frames apart.
+  void evaluateRange(double frame0, double step, int count,
+                     double *values) const;
+
   bool setValue(double frame, double value);
 
   // returns the incoming speed vector for keyframe kIndex. kIndex-1 must be
@@ -105,6 +115,10 @@ public:
 
   void accept(TSyntax::CalculatorNodeVisitor &visitor);
 
+  //! Returns whether some expression refers to other objects (see
+  //! TExpression::hasReference()).
+  bool hasReferences() const;
+
   //! cycle controls extrapolation after the last keyframe
   void enableCycle(bool enabled);
   bool isCycleEnabled() const;
@@ -146,6 +160,11 @@ public:
 
   const std::set<TParamObserver *> &observers() const;
 
+  //! Returns a counter that moves on whenever the values may have changed:
+  //! on each notified change, on copies and on grammar changes. Can be read
+  //! from any thread, unlike the observers.
+  unsigned int getChangeCount() const;
+
   //! no keyframes, default value not changed
   bool isDefault() const;
 
@@ -79,6 +79,10 @@ grammar syntax (i.e. it has at least one calculator node).
   */
   bool isValid();
 
+  //! Returns whether the expression refers to other objects, e.g. params or
+  //! columns.
+  bool hasReference();
+
   std::string getError() const;
   std::pair<int, int> getErrorPos() const;
 
@@ -31,6 +31,7 @@ class TUnit;
 namespace TSyntax {
 class Token;
 class Calculator;
+class Program;
 }  // namespace TSyntax
 
 //==============================================
@@ -65,6 +66,12 @@ public:
 
   virtual bool hasReference() const { return false; }
 
+  //! Appends the code computing the node to \b program, and returns the
+  //! register holding the result. The default implementation emits a call to
+  //! compute(), so that nodes defined outside the grammar (e.g. references to
+  //! other params) are evaluated as usual.
+  virtual int compile(Program &program) const;
+
 private:
   // Non-copyable
   CalculatorNode(const CalculatorNode &);
@@ -75,6 +82,8 @@ private:
 
 class DVAPI Calculator {
   CalculatorNode *m_rootNode;  //!< (owned) Root calculator node
+  Program *m_program;          //!< (owned) Compiled root node, only when
+                               //!  constant folding simplified the tree
 
   TDoubleParam *m_param;  //!< (not owned) Owner of the calculator object
   const TUnit *m_unit;    //!< (not owned)
@@ -88,8 +97,15 @@ public:
   double compute(double t, double frame, double rframe) {
     double vars[3];
     vars[0] = t, vars[1] = frame, vars[2] = rframe;
-    return m_rootNode->compute(vars);
+    return compute(vars);
   }
+  double compute(double vars[3]) const;
+
+  //! Computes the expression \b count times, storing the results in \b out.
+  //! The variables start from \b vars and are incremented by \b dvars at
+  //! each step.
+  void compute(const double vars[3], const double dvars[3], int count,
+               double *out) const;
 
   void accept(CalculatorNodeVisitor &visitor) { m_rootNode->accept(visitor); }
 
@@ -119,6 +135,8 @@ public:
   double compute(double vars[3]) const override { return m_value; }
 
   void accept(CalculatorNodeVisitor &visitor) override {}
+
+  int compile(Program &program) const override;
 };
 
 //-------------------------------------------------------------------
@@ -133,6 +151,8 @@ public:
   double compute(double vars[3]) const override { return vars[m_varIdx]; }
 
   void accept(CalculatorNodeVisitor &visitor) override {}
+
+  int compile(Program &program) const override;
 };
 
 //-------------------------------------------------------------------
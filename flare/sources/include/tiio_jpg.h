@@ -35,6 +35,12 @@ class DVAPI JpgReader final : public Tiio::Reader {
   JSAMPARRAY m_buffer;
   bool m_isOpen;
 
+  //! Decompression starts at the first line request, so that reduced reads
+  //! can be decoded at reduced DCT scale.
+  bool m_started;
+  int m_scale;  //!< Denominator of the DCT scale in use
+  int m_row;    //!< Next full-resolution line to be read
+
 public:
   JpgReader();
   ~JpgReader();
@@ -45,6 +51,10 @@ public:
 
   void readLine(char *buffer, int x0, int x1, int shrink) override;
   int skipLines(int lineCount) override;
+
+private:
+  void startDecompress(int shrink);
+  unsigned char *scanline();
 };
 
 DVAPI Tiio::ReaderMaker makeJpgReader;
@@ -212,6 +212,9 @@ public:
   int getSize() const override;
   void undo() const override;
 
+  //! Packs the tiles as compressed deltas against the edited image.
+  void onAdd() override;
+
   QString getToolName() override { return QString("Raster Tool"); }
 };
 
@@ -233,6 +236,9 @@ public:
   int getSize() const override;
   void undo() const override;
 
+  //! Packs the tiles as compressed deltas against the edited image.
+  void onAdd() override;
+
 private:
   std::vector<TRect> paste(const TRasterImageP &ti,
                            const TTileSetFullColor *tileSet) const;
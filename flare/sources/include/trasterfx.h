@@ -5,6 +5,7 @@
 
 // TnzCore includes
 #include "tnotanimatableparam.h"
+#include "tpixel.h"
 
 // TnzBase includes
 #include "tfx.h"
@@ -179,6 +180,34 @@ public:
   std::string toString() const;
 };
 
+//******************************************************************************
+//    TPixelKernel  declaration
+//******************************************************************************
+
+//! The per-pixel operation of a pointwise fx.
+/*!
+  A pointwise fx computes each output pixel from the input pixel at the same
+  position only, with parameters that are constant over the tile. Such fxs can
+  return their operation through TRasterFx::getPixelKernel(): chains of
+  pointwise fxs are then rendered in a single pass over the tile, applying all
+  the kernels to a small block of pixels before moving to the next one, instead
+  of running one full pass (and often one tile conversion) per fx.
+
+  Kernels work on float pixels whatever the tile type, so they must be
+  reentrant: the same kernel is applied by several threads at once.
+*/
+class DVAPI TPixelKernel {
+public:
+  virtual ~TPixelKernel() {}
+
+  //! Processes \b count premultiplied pixels in place. Channels are
+  //! normalized to [0, 1], but values out of that range can be found in
+  //! floating point renders.
+  virtual void process(TPixelF *pix, int count) const = 0;
+};
+
+typedef std::shared_ptr<TPixelKernel> TPixelKernelP;
+
 //******************************************************************************
 //    TRasterFx  declaration
 //******************************************************************************
@@ -303,6 +332,24 @@ public:
 
   virtual bool allowUserCacheOnPort(int port) { return true; }
 
+  //! Returns the per-pixel operation that the fx performs with the passed
+  //! frame and settings, or 0 if the fx is not pointwise (the default).
+  /*!
+    An fx returning a kernel must take its input from port 0, pass its render
+    settings unchanged to it, and have the same bounding box. doCompute() is
+    still invoked when the fx is not part of a chain of at least two pointwise
+    fxs, so the kernel must compute the same operation. The results are not
+    bit-identical on 8 and 16 bit tiles: a fused chain keeps float values
+    between its fxs, without rounding them to the tile's channel depth after
+    each one. A difference of one channel step per fx in the chain is
+    accepted.
+    \sa TPixelKernel
+  */
+  virtual TPixelKernelP getPixelKernel(double frame,
+                                       const TRenderSettings &info) {
+    return TPixelKernelP();
+  }
+
   virtual bool isPlugin() const { return false; };
 
 private:
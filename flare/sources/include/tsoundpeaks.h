@@ -0,0 +1,84 @@
+#pragma once
+
+#ifndef TSOUNDPEAKS_INCLUDED
+#define TSOUNDPEAKS_INCLUDED
+
+#include <atomic>
+#include <vector>
+
+#include "tsound.h"
+#include "tfilepath.h"
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TSOUND_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//==============================================================================
+/*!
+  TSoundPeaks is a multi-resolution (mip-mapped) index of the minimum and
+  maximum pressure of a soundtrack.
+
+  Level 0 stores one min/max pair per block of baseBlockSize() samples; each
+  following level merges levelRatio() blocks of the previous one. Queries
+  cover the requested sample range with the coarsest blocks lying inside it,
+  reading its edges from the finer levels, so the cost of a query does not
+  depend on the range length - which makes it suitable for redrawing
+  waveforms at any zoom.
+
+  The index can be saved to (and reloaded from) a small sidecar file, tagged
+  with the size and modification time of the audio file it was built from.
+*/
+class DVAPI TSoundPeaks {
+public:
+  struct Peak {
+    float m_min, m_max;
+  };
+
+private:
+  std::vector<std::vector<Peak>> m_levels;
+  TINT32 m_sampleCount;
+  TUINT32 m_sampleRate;
+  double m_absMaxPressure;
+
+public:
+  TSoundPeaks();
+
+  static int baseBlockSize() { return 64; }
+  static int levelRatio() { return 4; }
+
+  //! Builds the index from the whole track (MONO channel). Returns false if
+  //! the build was interrupted through \b canceled.
+  bool build(const TSoundTrackP &st,
+             const std::atomic<bool> *canceled = nullptr);
+  void clear();
+
+  bool isEmpty() const { return m_levels.empty(); }
+  int getLevelCount() const { return (int)m_levels.size(); }
+  TINT32 getSampleCount() const { return m_sampleCount; }
+  TUINT32 getSampleRate() const { return m_sampleRate; }
+
+  //! Returns the max absolute pressure of the whole track.
+  double getAbsMaxPressure() const { return m_absMaxPressure; }
+
+  //! Returns the pressure range in the samples interval [s0, s1]; the
+  //! samples before s0 and after s1 in their base blocks are included too.
+  void getMinMaxPressure(TINT32 s0, TINT32 s1, double &min,
+                         double &max) const;
+
+  //! Returns the sidecar path used to persist the index of \b soundPath.
+  static TFilePath getPeaksPath(const TFilePath &soundPath);
+
+  bool save(const TFilePath &peaksPath, const TFilePath &soundPath) const;
+  //! Loads the index, failing if it was built from a different version of
+  //! \b soundPath or from a track with a different sample count.
+  bool load(const TFilePath &peaksPath, const TFilePath &soundPath,
+            TINT32 sampleCount);
+};
+
+#endif  // TSOUNDPEAKS_INCLUDED
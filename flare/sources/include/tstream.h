@@ -31,6 +31,7 @@
 //    Forward declarations
 
 class TPersist;
+class TOStream;
 class TFilePath;
 
 // use using instead of typedef
@@ -46,6 +47,9 @@ using VersionNumber =
   This class is Toonz's standard \a input parser for simple XML files.
   It is specifically designed to interact with object types derived
   from the TPersist base class.
+
+  Documents written by TOStream in binary form are recognized and read
+  through the same interface.
 */
 
 class DVAPI TIStream {
@@ -166,6 +170,23 @@ reimplementation of the TPersist::loadData() function.
 
   std::string getCurrentTagName();
 
+  /*!
+\brief Positions the stream before the specified child of the root tag,
+     without parsing what precedes it.
+
+\note Only binary documents have the needed index: the function returns
+    false for XML documents, and if the root tag has not been matched yet.
+*/
+  bool seekSection(std::string tagName);
+
+  /*!
+\brief Copies the rest of the document to \b os, keeping tags, attributes
+     and values.
+
+Used to convert documents between the XML and binary forms.
+*/
+  void copyTo(TOStream &os);
+
 private:
   // Delete copy operations instead of declaring without implementation
   TIStream(const TIStream &)            = delete;
@@ -217,6 +238,10 @@ public:
   /*!
 \param fp           Output file path
 \param compressed   Enables compression of the whole file
+\param binary       Writes the document in binary form, with a string table
+                    and an index of the root tag's children. Binary documents
+                    are written to file once all tags are closed, and are
+                    never compressed.
 
 \note     Stream construction <I> does not throw </I>. However, the stream
         status could be invalid. Remember to check the stream validity using
@@ -225,8 +250,8 @@ public:
 \warning  Stream compression has been verified to be unsafe.
         Please consider it \a deprecated.
 */
-  TOStream(const TFilePath &fp,
-           bool compressed = false);  //!< Opens the specified file for write
+  TOStream(const TFilePath &fp, bool compressed = false,
+           bool binary = false);  //!< Opens the specified file for write
   ~TOStream();  //!< Closes the file and destroys the stream
 
   TOStream(TOStream &&other);
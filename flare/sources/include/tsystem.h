@@ -119,6 +119,10 @@ DVAPI void readDirectory_Dir_ReadExe(TFilePathSet &dst, const TFilePath &path);
 // return the folder item list which is readable and executable (only names)
 DVAPI void readDirectory_DirItems(QStringList &dst, const TFilePath &path);
 
+// return the files of the sequence levelPath in its folder
+DVAPI void readDirectory_LevelFrames(TFilePathSet &dst,
+                                     const TFilePath &levelPath);
+
 // create a new set
 DVAPI TFilePathSet readDirectory(const TFilePath &path, bool groupFrames = true,
                                  bool onlyFiles      = false,
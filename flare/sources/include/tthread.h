@@ -7,6 +7,8 @@
 
 #include <QThread>
 
+#include <functional>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TNZCORE_EXPORTS
@@ -238,6 +240,25 @@ private:
   Executor(const Executor &);
 };
 
+//------------------------------------------------------------------------------
+
+/*!
+  Splits the range [0, \b count) into chunks of at least \b grain elements and
+  invokes \b func(begin, end) on each of them, returning when all are done.
+  The first exception thrown by \b func is rethrown to the caller, once the
+  chunks being processed are done; the remaining ones are skipped.
+
+  This is meant for data-parallel work nested inside tasks, like fx
+  computations inside render tasks. The calling thread processes chunks too,
+  and it is helped by pooled threads only as long as there are cores that are
+  not busy with Executor tasks or with other parallelFor() calls. So the total
+  number of running threads tracks the number of processing cores, and on a
+  loaded machine the call just becomes a loop on the calling thread.
+  Nested calls are allowed.
+*/
+void DVAPI parallelFor(int count, const std::function<void(int, int)> &func,
+                       int grain = 1);
+
 }  // namespace TThread
 
 #endif  // TTHREAD_H
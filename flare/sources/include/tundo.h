@@ -32,6 +32,9 @@ public:
   bool m_isLastInBlock = true;
   // To be called in the last of the block when redo
   bool m_isLastInRedoBlock = true;
+  // Size in bytes evaluated by the undo manager when the undo was added
+  // to the history; keeps the history's memory accounting O(1)
+  int m_historySize = 0;
 
 public:
   TUndo() {}
@@ -4,6 +4,51 @@
 #include "tfxparam.h"
 #include "trop.h"
 
+#include <cmath>
+#include <vector>
+
+//===================================================================
+
+namespace {
+
+//! Same as TRop::gammaCorrect() on float rasters.
+class GammaKernel final : public TPixelKernel {
+  std::vector<float> m_table;
+  float m_invGamma;
+
+public:
+  GammaKernel(double gamma)
+      : m_table(TPixel64::maxChannelValue + 1), m_invGamma(1.0 / gamma) {
+    for (int i = 0; i <= TPixel64::maxChannelValue; ++i)
+      m_table[i] = std::pow(i / (float)TPixel64::maxChannelValue, m_invGamma);
+  }
+
+  void process(TPixelF *pix, int count) const override {
+    for (int i = 0; i < count; ++i) {
+      pix[i].r = correct(pix[i].r);
+      pix[i].g = correct(pix[i].g);
+      pix[i].b = correct(pix[i].b);
+    }
+  }
+
+private:
+  float correct(float val) const {
+    // negative values are kept unchanged
+    if (val < 0.f)
+      return val;
+    else if (val >= 1.f)
+      return std::pow(val, m_invGamma);
+    float v     = val * (float)TPixel64::maxChannelValue;
+    int id      = (int)v;
+    float ratio = v - (float)id;
+    return m_table[id] * (1.f - ratio) + m_table[id + 1] * ratio;
+  }
+};
+
+}  // namespace
+
+//===================================================================
+
 class GammaFx final : public TStandardRasterFx {
   FX_PLUGIN_DECLARATION(GammaFx)
 
@@ -34,6 +79,13 @@ public:
 
   void doCompute(TTile &tile, double frame, const TRenderSettings &) override;
 
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &info) override {
+    double gamma = m_gamma->getValue(frame);
+    if (gamma == 0.0) gamma = 0.01;
+    return TPixelKernelP(new GammaKernel(gamma));
+  }
+
   bool canHandle(const TRenderSettings &info, double frame) override {
     return true;
   }
@@ -766,9 +766,12 @@ public:
                 ) {
     /*--------------スレッド数の設定--------------------*/
     int thread_num = number_of_thread;
-    if ((thread_num < 1) || (height < thread_num)) {
+    if (thread_num < 1) {
+      thread_num = igs::resource::default_number_of_thread();
+    } /* ゼロ以下の場合はCPUのコア数で分割する */
+    if (height < thread_num) {
       thread_num = 1;
-    } /* ゼロ以下か、高さより多い */
+    } /* 高さより多い */
     /*--------------メモリ確保--------------------------*/
     int odd_diameter = 0;
     attenuation_distribution_(this->lens_matrix_, this->lens_offsets_,
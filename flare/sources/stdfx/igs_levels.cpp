@@ -233,53 +233,21 @@ void change_(float *image_array, const int height, const int width,
              const bool add_blend_sw) {
   /* 1 最大値、最小値から変換テーブルを求める */
   std::vector<std::vector<float>> tables;
-  const unsigned int table_size =
-      std::numeric_limits<unsigned short>::max() + 1;
-  const double div_val = static_cast<double>(table_size - 1);
-  // const double mul_val = div_val + 0.999999;
   {
     using namespace igs::image::rgba;
     tables.resize(siz);
-    tables[red].resize(table_size);
-    tables[gre].resize(table_size);
-    tables[blu].resize(table_size);
-    tables[alp].resize(table_size);
-    for (unsigned int yy = 0; yy < table_size; ++yy) {
-      double rr, gg, bb, aa;
-      rr = gg = bb = aa = yy / div_val;
-      levels_(rr, r_in_min, r_in_max, r_gamma, r_out_min, r_out_max,
-              false);  // クランプしない
-      levels_(gg, g_in_min, g_in_max, g_gamma, g_out_min, g_out_max,
-              false);  // クランプしない
-      levels_(bb, b_in_min, b_in_max, b_gamma, b_out_min, b_out_max,
-              false);  // クランプしない
-      levels_(aa, a_in_min, a_in_max, a_gamma, a_out_min, a_out_max, clamp_sw);
-      /* 0〜1.0 --> 0〜mul_maxスケール変換し、整数値化 */
-      tables[red][yy] = static_cast<float>(rr);
-      tables[gre][yy] = static_cast<float>(gg);
-      tables[blu][yy] = static_cast<float>(bb);
-      tables[alp][yy] = static_cast<float>(aa);
-    }
+    igs::levels::float_table(tables[red], r_in_min, r_in_max, r_gamma,
+                             r_out_min, r_out_max, false);  // クランプしない
+    igs::levels::float_table(tables[gre], g_in_min, g_in_max, g_gamma,
+                             g_out_min, g_out_max, false);  // クランプしない
+    igs::levels::float_table(tables[blu], b_in_min, b_in_max, b_gamma,
+                             b_out_min, b_out_max, false);  // クランプしない
+    igs::levels::float_table(tables[alp], a_in_min, a_in_max, a_gamma,
+                             a_out_min, a_out_max, clamp_sw);
   }
 
-  // テーブル値を返すラムダ式。Inが1より大きい場合はmaxの線を直線で延長
   auto getTableVal = [&](int channel, float in) {
-    if (in <= 0.f) {  // 先頭の値を返す
-      return tables[channel][0];
-    } else if (in <=
-               1.f) {  // テーブル範囲に収まっている場合、前後の値で線形補間
-      int index   = static_cast<int>(std::floor(in * div_val));
-      float ratio = in * div_val - static_cast<float>(index);
-      if (areAlmostEqual(ratio, 0.)) return tables[channel][index];
-      return tables[channel][index] * (1.f - ratio) +
-             tables[channel][index + 1] * ratio;
-    }
-    // inが1より大きい場合
-    // 傾き
-    float dv =
-        (tables[channel][table_size - 1] - tables[channel][table_size - 2]) *
-        div_val;
-    return tables[channel][table_size - 1] + dv * (in - 1.f);
+    return igs::levels::float_table_value(tables[channel], in);
   };
 
   /* 2 変換テーブルを使ってlevel変換する */
@@ -446,3 +414,36 @@ void igs::levels::change(
     throw std::domain_error("Bad bits,Not uchar/ushort");
   }
 }
+//------------------------------------------------------------
+void igs::levels::float_table(std::vector<float> &table, const double in_min,
+                              const double in_max, const double gamma,
+                              const double out_min, const double out_max,
+                              const bool clamp_sw) {
+  const unsigned int table_size =
+      std::numeric_limits<unsigned short>::max() + 1;
+  const double div_val = static_cast<double>(table_size - 1);
+  table.resize(table_size);
+  for (unsigned int yy = 0; yy < table_size; ++yy) {
+    double val = yy / div_val;
+    levels_(val, in_min, in_max, gamma, out_min, out_max, clamp_sw);
+    table[yy] = static_cast<float>(val);
+  }
+}
+/* Inが1より大きい場合はmaxの線を直線で延長 */
+float igs::levels::float_table_value(const std::vector<float> &table,
+                                     const float in) {
+  const int table_size = static_cast<int>(table.size());
+  const double div_val = static_cast<double>(table_size - 1);
+  if (in <= 0.f) {  // 先頭の値を返す
+    return table[0];
+  } else if (in <= 1.f) {  // テーブル範囲に収まっている場合、前後の値で線形補間
+    int index   = static_cast<int>(std::floor(in * div_val));
+    float ratio = in * div_val - static_cast<float>(index);
+    if (areAlmostEqual(ratio, 0.)) return table[index];
+    return table[index] * (1.f - ratio) + table[index + 1] * ratio;
+  }
+  // inが1より大きい場合
+  // 傾き
+  float dv = (table[table_size - 1] - table[table_size - 2]) * div_val;
+  return table[table_size - 1] + dv * (in - 1.f);
+}
@@ -3,6 +3,8 @@
 #ifndef igs_levels_h
 #define igs_levels_h
 
+#include <vector>
+
 #ifndef IGS_LEVELS_EXPORT
 #define IGS_LEVELS_EXPORT
 #endif
@@ -63,6 +65,16 @@ IGS_LEVELS_EXPORT void change(
                     の場合こちらを使う
             */
     );
+
+/* float画素用の変換テーブル(0...1を65536段階)。
+   change()とfx連結時のkernelで共通に使う */
+IGS_LEVELS_EXPORT void float_table(std::vector<float> &table,
+                                   const double in_min, const double in_max,
+                                   const double gamma, const double out_min,
+                                   const double out_max, const bool clamp_sw);
+/* テーブルを線形補間して引く。1より大きい値は最後の傾きで延長する */
+IGS_LEVELS_EXPORT float float_table_value(const std::vector<float> &table,
+                                          const float in);
 }
 }
 
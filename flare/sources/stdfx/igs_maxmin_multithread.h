@@ -231,9 +231,9 @@ public:
         this->lens_offsets_, this->lens_sizes_, this->lens_ratio_);
     /*-------スレッド毎の処理指定-----------------------*/
     int thread_num = number_of_thread;
-    /* ゼロ以下の場合強制変更。そもそもGUIでエラーにすべき */
+    /* ゼロ以下の場合はCPUのコア数で分割する */
     if (thread_num < 1) {
-      thread_num = 1;
+      thread_num = igs::resource::default_number_of_thread();
     }
     /* 高さより多い場合強制変更。そもそもGUIでエラーにすべき */
     if (height < thread_num) {
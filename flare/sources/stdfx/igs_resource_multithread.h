@@ -21,6 +21,8 @@ public:
 private:
   std::vector<void *> thre_exec_;
 };
+/* スレッド数の指定がゼロ以下の場合に使う分割数(CPUのコア数) */
+int default_number_of_thread(void);
 }
 }
 
@@ -148,7 +148,7 @@ void ino_fog::doCompute(TTile &tile, double frame,
   const double threshold_max =
       this->m_threshold_max->getValue(frame) / ino::param_range();
   const bool alp_rend_sw = this->m_alpha_rendering->getValue();
-  const int nthread      = 1;
+  const int nthread      = -1; /* CPUのコア数に分割 */
   /*------ fogがからないパラメータ値のときはfog処理しない ----*/
   if (!igs::fog::have_change(radius, power, threshold_min)) {
     this->m_input->compute(tile, frame, rend_sets);
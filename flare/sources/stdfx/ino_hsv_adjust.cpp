@@ -1,9 +1,54 @@
-#include <sstream> /* std::ostringstream */
+#include <sstream>  /* std::ostringstream */
+#include <algorithm> /* std::min */
 #include "tfxparam.h"
 #include "stdfx.h"
 
 #include "ino_common.h"
 #include "globalcontrollablefx.h"
+#include "igs_ifx_common.h" /* igs::image::rgba */
+#include "igs_hsv_adjust.h"
+//------------------------------------------------------------
+namespace {
+/* igs::hsv_adjust::change()を参照画像なしでfloat画素に行う */
+class hsv_adjust_kernel final : public TPixelKernel {
+  double params_[9]; /* hue,sat,valのpivot,scale,shift */
+  bool anti_alias_sw_;
+
+public:
+  hsv_adjust_kernel(const double params[9], const bool anti_alias_sw)
+      : anti_alias_sw_(anti_alias_sw) {
+    for (int ii = 0; ii < 9; ++ii) {
+      this->params_[ii] = params[ii];
+    }
+  }
+  void process(TPixelF *pix, int count) const override {
+    using namespace igs::image::rgba;
+    const int block_size = 64;
+    float arr[block_size * siz];
+
+    for (int start = 0; start < count; start += block_size) {
+      const int size = std::min(block_size, count - start);
+      TPixelF *block = pix + start;
+      for (int ii = 0; ii < size; ++ii) {
+        arr[ii * siz + red] = block[ii].r;
+        arr[ii * siz + gre] = block[ii].g;
+        arr[ii * siz + blu] = block[ii].b;
+        arr[ii * siz + alp] = block[ii].m;
+      }
+      igs::hsv_adjust::change(
+          arr, 1, size, siz, nullptr, this->params_[0], this->params_[1],
+          this->params_[2], this->params_[3], this->params_[4],
+          this->params_[5], this->params_[6], this->params_[7],
+          this->params_[8], this->anti_alias_sw_);
+      for (int ii = 0; ii < size; ++ii) {
+        block[ii].r = arr[ii * siz + red];
+        block[ii].g = arr[ii * siz + gre];
+        block[ii].b = arr[ii * siz + blu];
+      }
+    }
+  }
+};
+}  // namespace
 //------------------------------------------------------------
 class ino_hsv_adjust final : public GlobalControllableFx {
   FX_PLUGIN_DECLARATION(ino_hsv_adjust)
@@ -87,10 +132,29 @@ public:
   }
   void doCompute(TTile &tile, double frame,
                  const TRenderSettings &rend_sets) override;
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &rend_sets) override {
+    /* 参照画像を使う時は画素単位の処理にならない */
+    if (this->m_refer.isConnected() && (0 <= this->m_ref_mode->getValue())) {
+      return TPixelKernelP();
+    }
+
+    const double params[9] = {
+        this->m_hue_pivot->getValue(frame),
+        this->m_hue_scale->getValue(frame) / ino::param_range(),
+        this->m_hue_shift->getValue(frame),
+        this->m_sat_pivot->getValue(frame) / ino::param_range(),
+        this->m_sat_scale->getValue(frame) / ino::param_range(),
+        this->m_sat_shift->getValue(frame) / ino::param_range(),
+        this->m_val_pivot->getValue(frame) / ino::param_range(),
+        this->m_val_scale->getValue(frame) / ino::param_range(),
+        this->m_val_shift->getValue(frame) / ino::param_range()};
+    return TPixelKernelP(
+        new hsv_adjust_kernel(params, this->m_anti_alias->getValue()));
+  }
 };
 FX_PLUGIN_IDENTIFIER(ino_hsv_adjust, "inohsvAdjustFx");
 //------------------------------------------------------------
-#include "igs_hsv_adjust.h"
 namespace {
 void fx_(TRasterP in_ras, const TRasterP refer_ras, const int refer_mode,
          const double hue_pivot, const double hue_scale, const double hue_shift,
@@ -5,6 +5,52 @@
 
 #include "ino_common.h"
 #include "globalcontrollablefx.h"
+#include "igs_levels.h"
+//------------------------------------------------------------
+namespace {
+/* igs::levels::change()と同じ処理を参照画像なしでfloat画素に行う */
+class level_rgba_kernel final : public TPixelKernel {
+  std::vector<float> tables_[4]; /* red,green,blue,alpha */
+  bool anti_alias_sw_;
+
+public:
+  level_rgba_kernel(const DoublePair in[4], const double gamma[4],
+                    const DoublePair out[4], const bool clamp_sw,
+                    const bool anti_alias_sw)
+      : anti_alias_sw_(anti_alias_sw) {
+    for (int ii = 0; ii < 4; ++ii) {
+      /* Alphaは常にclampする */
+      igs::levels::float_table(this->tables_[ii], in[ii].first, in[ii].second,
+                               gamma[ii], out[ii].first, out[ii].second,
+                               clamp_sw || (3 == ii));
+    }
+  }
+  void process(TPixelF *pix, int count) const override {
+    for (int ii = 0; ii < count; ++ii, ++pix) {
+      pix->m = igs::levels::float_table_value(this->tables_[3], pix->m);
+
+      /* 加算合成で、Alpha値ゼロならRGB値を計算する必要はない */
+      if (this->anti_alias_sw_ && areAlmostEqual(pix->m, 0.)) {
+        continue;
+      }
+      /* 加算合成で、その値がMaxでなければ変化量に乗算 */
+      const float refv =
+          (this->anti_alias_sw_ && (pix->m < 1.f)) ? pix->m : 1.f;
+
+      pix->r = this->level_(0, pix->r, refv);
+      pix->g = this->level_(1, pix->g, refv);
+      pix->b = this->level_(2, pix->b, refv);
+    }
+  }
+
+private:
+  float level_(const int channel, const float src, const float refv) const {
+    const float tgt =
+        igs::levels::float_table_value(this->tables_[channel], src);
+    return tgt * refv + src * (1.f - refv);
+  }
+};
+}  // namespace
 //------------------------------------------------------------
 class ino_level_rgba final : public GlobalControllableFx {
   FX_PLUGIN_DECLARATION(ino_level_rgba)
@@ -130,10 +176,40 @@ public:
   }
   void doCompute(TTile &tile, double frame,
                  const TRenderSettings &rend_sets) override;
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &rend_sets) override {
+    /* 参照画像を使う時は画素単位の処理にならない */
+    if (this->m_refer.isConnected() && (0 <= this->m_ref_mode->getValue())) {
+      return TPixelKernelP();
+    }
+
+    const TRangeParamP in_params[4] = {this->m_red_in, this->m_gre_in,
+                                       this->m_blu_in, this->m_alp_in};
+    const TDoubleParamP gamma_params[4] = {
+        this->m_red_gamma, this->m_gre_gamma, this->m_blu_gamma,
+        this->m_alp_gamma};
+    const TRangeParamP out_params[4] = {this->m_red_out, this->m_gre_out,
+                                        this->m_blu_out, this->m_alp_out};
+    DoublePair in[4], out[4];
+    double gamma[4];
+    for (int ii = 0; ii < 4; ++ii) {
+      in[ii]  = in_params[ii]->getValue(frame);
+      out[ii] = out_params[ii]->getValue(frame);
+      in[ii].first /= ino::param_range();
+      in[ii].second /= ino::param_range();
+      out[ii].first /= ino::param_range();
+      out[ii].second /= ino::param_range();
+      gamma[ii] = gamma_params[ii]->getValue(frame) / ino::param_range();
+    }
+
+    /* 8/16bit画素はRGBもclampする(doCompute()と同じ) */
+    return TPixelKernelP(new level_rgba_kernel(in, gamma, out,
+                                               rend_sets.m_bpp != 128,
+                                               this->m_anti_alias->getValue()));
+  }
 };
 FX_PLUGIN_IDENTIFIER(ino_level_rgba, "inoLevelrgbaFx");
 //------------------------------------------------------------
-#include "igs_levels.h"
 void ino_level_rgba::doCompute(TTile &tile, double frame,
                                const TRenderSettings &rend_sets) {
   /* ------ 接続していなければ処理しない -------------------- */
@@ -5,6 +5,37 @@
 #include "globalcontrollablefx.h"
 #include "ino_common.h"
 //------------------------------------------------------------
+namespace {
+/* igs::negate::change()と同じ処理をfloat画素に行う */
+class negate_kernel final : public TPixelKernel {
+  bool sw_array_[4];
+
+public:
+  negate_kernel(const bool sw_array[4]) {
+    for (int ii = 0; ii < 4; ++ii) {
+      this->sw_array_[ii] = sw_array[ii];
+    }
+  }
+  void process(TPixelF *pix, int count) const override {
+    for (int ii = 0; ii < count; ++ii, ++pix) {
+      /* RGBは(Alphaを反転する前の)Alpha値で反転 */
+      if (this->sw_array_[0]) {
+        pix->r = (pix->m < pix->r) ? 0.f : pix->m - pix->r;
+      }
+      if (this->sw_array_[1]) {
+        pix->g = (pix->m < pix->g) ? 0.f : pix->m - pix->g;
+      }
+      if (this->sw_array_[2]) {
+        pix->b = (pix->m < pix->b) ? 0.f : pix->m - pix->b;
+      }
+      if (this->sw_array_[3]) {
+        pix->m = 1.f - pix->m;
+      }
+    }
+  }
+};
+}  // namespace
+//------------------------------------------------------------
 class ino_negate final : public GlobalControllableFx {
   FX_PLUGIN_DECLARATION(ino_negate)
   TRasterFxPort m_input;
@@ -20,6 +51,7 @@ public:
     bindParam(this, "green", this->m_green);
     bindParam(this, "blue", this->m_blue);
     bindParam(this, "alpha", this->m_alpha);
+    enableComputeInFloat(true);
   }
   bool doGetBBox(double frame, TRectD &bBox,
                  const TRenderSettings &info) override {
@@ -35,6 +67,15 @@ public:
   }
   void doCompute(TTile &tile, double frame,
                  const TRenderSettings &rend_sets) override;
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &rend_sets) override {
+    bool sw_array[4];
+    sw_array[0] = this->m_red->getValue();
+    sw_array[1] = this->m_green->getValue();
+    sw_array[2] = this->m_blue->getValue();
+    sw_array[3] = this->m_alpha->getValue();
+    return TPixelKernelP(new negate_kernel(sw_array));
+  }
 };
 FX_PLUGIN_IDENTIFIER(ino_negate, "inoNegateFx");
 //------------------------------------------------------------
@@ -69,6 +110,13 @@ void fx_(TRasterP in_ras, const bool sw_array[4]) {
   ino::arr_to_ras(in_gr8->getRawData(), ino::channels(), in_ras, 0);
   in_gr8->unlock();
 }
+/* float画素はfx連結時と同じkernelで処理する */
+void fx_float_(TRasterFP in_ras, const bool sw_array[4]) {
+  const negate_kernel kernel(sw_array);
+  for (int yy = 0; yy < in_ras->getLy(); ++yy) {
+    kernel.process(in_ras->pixels(yy), in_ras->getLx());
+  }
+}
 }  // namespace
 //------------------------------------------------------------
 void ino_negate::doCompute(TTile &tile, double frame,
@@ -80,7 +128,8 @@ void ino_negate::doCompute(TTile &tile, double frame,
   }
 
   /* ------ サポートしていないPixelタイプはエラーを投げる --- */
-  if (!((TRaster32P)tile.getRaster()) && !((TRaster64P)tile.getRaster())) {
+  if (!((TRaster32P)tile.getRaster()) && !((TRaster64P)tile.getRaster()) &&
+      !((TRasterFP)tile.getRaster())) {
     throw TRopException("unsupported input pixel type");
   }
 
@@ -109,7 +158,11 @@ void ino_negate::doCompute(TTile &tile, double frame,
   /* ------ fx処理 ------------------------------------------ */
   try {
     tile.getRaster()->lock();
-    fx_(tile.getRaster(), sw_array);
+    if ((TRasterFP)tile.getRaster()) {
+      fx_float_(tile.getRaster(), sw_array);
+    } else {
+      fx_(tile.getRaster(), sw_array);
+    }
     tile.getRaster()->unlock();
   }
   /* ------ error処理 --------------------------------------- */
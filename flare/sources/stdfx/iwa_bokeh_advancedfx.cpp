@@ -5,14 +5,12 @@
 #include "trasterimage.h"
 
 #include <QReadWriteLock>
-#include <QMutexLocker>
 #include <QVector>
 #include <QMap>
 #include <QSet>
 
 namespace {
 QReadWriteLock lock;
-QMutex fx_mutex;
 bool isFurtherLayer(const QPair<int, double> val1,
                     const QPair<int, double> val2) {
   // if the layers are at the same depth, then put the layer with smaller index
@@ -29,13 +27,6 @@ TRasterGR8P allocateRasterAndLock(T** buf, TDimensionI dim) {
   return ras;
 }
 
-// release all registered raster memories and free all fft plans
-void releaseAllRastersAndPlans(QList<TRasterGR8P>& rasterList,
-                               QList<kiss_fftnd_cfg>& planList) {
-  for (int r = 0; r < rasterList.size(); r++) rasterList.at(r)->unlock();
-  for (int p = 0; p < planList.size(); p++) kiss_fft_free(planList.at(p));
-}
-
 };  // namespace
 
 //--------------------------------------------
@@ -3,6 +3,7 @@
 
 #include "trop.h"
 #include "tparamcontainer.h"
+#include "tthread.h"
 
 #include <array>
 
@@ -12,7 +13,6 @@
 
 namespace {
 QReadWriteLock lock;
-QMutex mutex;
 
 // modify fft coordinate to normal
 inline int getCoord(int index, int lx, int ly) {
@@ -49,11 +49,9 @@ TRasterGR8P allocateRasterAndLock(T** buf, TDimensionI dim) {
   return ras;
 }
 
-// release all registered raster memories and free all fft plans
-void releaseAllRastersAndPlans(QList<TRasterGR8P>& rasterList,
-                               QList<kiss_fftnd_cfg>& planList) {
+// release all registered raster memories
+void releaseAllRasters(QList<TRasterGR8P>& rasterList) {
   for (int r = 0; r < rasterList.size(); r++) rasterList.at(r)->unlock();
-  for (int p = 0; p < planList.size(); p++) kiss_fft_free(planList.at(p));
 }
 }  // namespace
 
@@ -72,10 +70,9 @@ BokehUtils::MyThread::MyThread(Channel channel, TRasterP layerTileRas,
     , m_kissfft_comp_iris(kissfft_comp_iris)
     , m_layerGamma(layerGamma)
     , m_masterGamma(masterGamma)
-    , m_finished(false)
     , m_kissfft_comp_in(0)
     , m_kissfft_comp_out(0)
-    , m_isTerminated(false) {
+    , m_isCanceled(nullptr) {
   if (m_masterGamma == 0.0) m_masterGamma = m_layerGamma;
 }
 
@@ -94,7 +91,7 @@ bool BokehUtils::MyThread::init() {
   if (m_kissfft_comp_in == 0) return false;
 
   // cancel check
-  if (m_isTerminated) {
+  if (isCanceled()) {
     m_kissfft_comp_in_ras->unlock();
     return false;
   }
@@ -112,7 +109,7 @@ bool BokehUtils::MyThread::init() {
   }
 
   // cancel check
-  if (m_isTerminated) {
+  if (isCanceled()) {
     m_kissfft_comp_in_ras->unlock();
     m_kissfft_comp_in = 0;
     m_kissfft_comp_out_ras->unlock();
@@ -120,32 +117,6 @@ bool BokehUtils::MyThread::init() {
     return false;
   }
 
-  // create the forward FFT plan
-  int dims[2]        = {ly, lx};
-  int ndims          = 2;
-  m_kissfft_plan_fwd = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  // allocation and cancel check
-  if (m_kissfft_plan_fwd == NULL || m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
-    m_kissfft_comp_out_ras->unlock();
-    m_kissfft_comp_out = 0;
-    return false;
-  }
-
-  // create the backward FFT plan
-  m_kissfft_plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
-  // allocation and cancel check
-  if (m_kissfft_plan_bkwd == NULL || m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
-    m_kissfft_comp_out_ras->unlock();
-    m_kissfft_comp_out = 0;
-    kiss_fft_free(m_kissfft_plan_fwd);
-    m_kissfft_plan_fwd = NULL;
-    return false;
-  }
-
   // return true if all the initializations are done
   return true;
 }
@@ -214,9 +185,7 @@ void BokehUtils::MyThread::run() {
 
   if (checkTerminationAndCleanupThread()) return;
 
-  kiss_fftnd(m_kissfft_plan_fwd, m_kissfft_comp_in, m_kissfft_comp_out);
-  kiss_fft_free(m_kissfft_plan_fwd);  // we don't need this plan anymore
-  m_kissfft_plan_fwd = NULL;
+  FftUtils::forwardReal(dim, m_kissfft_comp_in, m_kissfft_comp_out);
 
   if (checkTerminationAndCleanupThread()) return;
 
@@ -235,10 +204,8 @@ void BokehUtils::MyThread::run() {
 
   if (checkTerminationAndCleanupThread()) return;
 
-  kiss_fftnd(m_kissfft_plan_bkwd, m_kissfft_comp_out,
-             m_kissfft_comp_in);       // Backward FFT
-  kiss_fft_free(m_kissfft_plan_bkwd);  // we don't need this plan anymore
-  m_kissfft_plan_bkwd = NULL;
+  FftUtils::backwardReal(dim, m_kissfft_comp_out,
+                         m_kissfft_comp_in);  // Backward FFT
 
   // In the backward FFT above, "m_kissfft_comp_out" is used as input and
   // "m_kissfft_comp_in" as output.
@@ -248,9 +215,9 @@ void BokehUtils::MyThread::run() {
 
   if (checkTerminationAndCleanupThread()) return;
 
+  // Each channel thread writes its own component of the result; only the red
+  // one composites the alpha.
   {
-    QMutexLocker locker(&mutex);
-
     double* alp_p  = m_alpha_bokeh;
     double4* res_p = m_result;
 
@@ -300,20 +267,19 @@ void BokehUtils::MyThread::run() {
 
   m_kissfft_comp_in_ras->unlock();
   m_kissfft_comp_in = 0;
-
-  m_finished = true;
 }
 
-bool BokehUtils::MyThread::checkTerminationAndCleanupThread() {
-  if (!m_isTerminated) return false;
-
+void BokehUtils::MyThread::releaseBuffers() {
   if (m_kissfft_comp_in) m_kissfft_comp_in_ras->unlock();
   if (m_kissfft_comp_out) m_kissfft_comp_out_ras->unlock();
+  m_kissfft_comp_in  = 0;
+  m_kissfft_comp_out = 0;
+}
 
-  if (m_kissfft_plan_fwd) kiss_fft_free(m_kissfft_plan_fwd);
-  if (m_kissfft_plan_bkwd) kiss_fft_free(m_kissfft_plan_bkwd);
+bool BokehUtils::MyThread::checkTerminationAndCleanupThread() {
+  if (!isCanceled()) return false;
 
-  m_finished = true;
+  releaseBuffers();
   return true;
 }
 
@@ -321,32 +287,25 @@ bool BokehUtils::MyThread::checkTerminationAndCleanupThread() {
 BokehUtils::BokehRefThread::BokehRefThread(
     int channel, kiss_fft_cpx* fftcpx_channel_before,
     kiss_fft_cpx* fftcpx_channel, kiss_fft_cpx* fftcpx_alpha,
-    kiss_fft_cpx* fftcpx_iris, double4* result_buff,
-    kiss_fftnd_cfg kissfft_plan_fwd, kiss_fftnd_cfg kissfft_plan_bkwd,
-    TDimensionI& dim)
+    kiss_fft_cpx* fftcpx_iris, double4* result_buff, TDimensionI& dim,
+    const int* isCanceled)
     : m_channel(channel)
     , m_fftcpx_channel_before(fftcpx_channel_before)
     , m_fftcpx_channel(fftcpx_channel)
     , m_fftcpx_alpha(fftcpx_alpha)
     , m_fftcpx_iris(fftcpx_iris)
     , m_result_buff(result_buff)
-    , m_kissfft_plan_fwd(kissfft_plan_fwd)
-    , m_kissfft_plan_bkwd(kissfft_plan_bkwd)
     , m_dim(dim)
-    , m_finished(false)
-    , m_isTerminated(false) {}
+    , m_isCanceled(isCanceled) {}
 
 //------------------------------------
 
 void BokehUtils::BokehRefThread::run() {
   // execute channel fft
-  kiss_fftnd(m_kissfft_plan_fwd, m_fftcpx_channel_before, m_fftcpx_channel);
+  FftUtils::forwardReal(m_dim, m_fftcpx_channel_before, m_fftcpx_channel);
 
   // cancel check
-  if (m_isTerminated) {
-    m_finished = true;
-    return;
-  }
+  if (isCanceled()) return;
 
   int size = m_dim.lx * m_dim.ly;
 
@@ -361,13 +320,10 @@ void BokehUtils::BokehRefThread::run() {
     m_fftcpx_channel[i].i = im;
   }
   // execute invert fft
-  kiss_fftnd(m_kissfft_plan_bkwd, m_fftcpx_channel, m_fftcpx_channel_before);
+  FftUtils::backwardReal(m_dim, m_fftcpx_channel, m_fftcpx_channel_before);
 
   // cancel check
-  if (m_isTerminated) {
-    m_finished = true;
-    return;
-  }
+  if (isCanceled()) return;
 
   // pixels with smaller index : normal composite exposure value
   // pixels with the same or larger index : replace exposure value
@@ -411,7 +367,6 @@ void BokehUtils::BokehRefThread::run() {
       }
     }
   }
-  m_finished = true;
 }
 
 //------------------------------------------------------------
@@ -1247,11 +1202,8 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
   } else
     return;
 
-  int dims[2]             = {ly, lx};
-  int ndims               = 2;
-  kiss_fftnd_cfg plan_fwd = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  kiss_fftnd(plan_fwd, kissfft_comp_in, kissfft_comp_out);
-  kiss_fft_free(plan_fwd);  // we don't need this plan anymore
+  TDimensionI dim(lx, ly);
+  FftUtils::forwardReal(dim, kissfft_comp_in, kissfft_comp_out);
 
   // Filtering. Multiply by the iris FFT data
   for (int i = 0; i < lx * ly; i++) {
@@ -1264,9 +1216,8 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
     kissfft_comp_out[i].i = im;
   }
 
-  kiss_fftnd_cfg plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
-  kiss_fftnd(plan_bkwd, kissfft_comp_out, kissfft_comp_in);  // Backward FFT
-  kiss_fft_free(plan_bkwd);  // we don't need this plan anymore
+  FftUtils::backwardReal(dim, kissfft_comp_out,
+                         kissfft_comp_in);  // Backward FFT
 
   // In the backward FFT above, "kissfft_comp_out" is used as input and
   // "kissfft_comp_in" as output.
@@ -1421,7 +1372,6 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
   // QMutexLocker fx_locker(&fx_mutex);
 
   QList<TRasterGR8P> rasterList;
-  QList<kiss_fftnd_cfg> planList;
 
   kiss_fft_cpx* kissfft_comp_iris;
   double* alpha_bokeh = nullptr;
@@ -1445,7 +1395,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
@@ -1453,7 +1403,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
   for (int i = 0; i < layerValues.size(); i++) {
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1511,22 +1461,13 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
 
-      // Create the FFT plan for the iris image.
-      kiss_fftnd_cfg iris_kissfft_plan;
-      while (1) {
-        int dims[2]       = {dimOut.ly, dimOut.lx};
-        int ndims         = 2;
-        iris_kissfft_plan = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-        if (iris_kissfft_plan != NULL) break;
-      }
       // Do FFT the iris image.
-      kiss_fftnd(iris_kissfft_plan, kissfft_comp_iris_before,
-                 kissfft_comp_iris);
-      kiss_fft_free(iris_kissfft_plan);
+      FftUtils::forwardReal(dimOut, kissfft_comp_iris_before,
+                            kissfft_comp_iris);
       // release the iris buffer
       rasterList.takeLast()->unlock();
     }
@@ -1535,7 +1476,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1553,7 +1494,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1578,108 +1519,44 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
     threadG.setConverter(conv);
     threadB.setConverter(conv);
 
-    // If you set this flag to true, the fx will be forced to compute in single
-    // thread.
-    // Under some specific condition (such as calling from single-threaded
-    // tcomposer)
-    // we may need to use this flag... For now, I'll keep this option unused.
-    // TODO: investigate this.
-    bool renderInSingleThread = false;
-
-    // Start the thread when the initialization is done.
-    // Red channel
-    int waitCount = 0;
-    while (1) {
-      // cancel check
-      if ((settings.m_isCanceled && *settings.m_isCanceled) ||
-          waitCount >= 20) {
-        releaseAllRastersAndPlans(rasterList, planList);
-        return;
-      }
-      if (threadR.init()) {
-        if (renderInSingleThread)
-          threadR.run();
-        else
-          threadR.start();
-        break;
-      }
-      QThread::msleep(500);
-      waitCount++;
-    }
-
-    waitCount = 0;
-    while (1) {
-      if ((settings.m_isCanceled && *settings.m_isCanceled) ||
-          waitCount >= 20)  // 10 seconds
-      {
-        if (!threadR.isFinished()) threadR.terminateThread();
-        while (!threadR.isFinished()) {
-        }
-        releaseAllRastersAndPlans(rasterList, planList);
-        return;
-      }
-      if (threadG.init()) {
-        if (renderInSingleThread)
-          threadG.run();
-        else
-          threadG.start();
-        break;
-      }
-      QThread::msleep(500);
-      waitCount++;
-    }
-
-    waitCount = 0;
-    while (1) {
-      if ((settings.m_isCanceled && *settings.m_isCanceled) ||
-          waitCount >= 20)  // 10 seconds
-      {
-        if (!threadR.isFinished()) threadR.terminateThread();
-        if (!threadG.isFinished()) threadG.terminateThread();
-        while (!threadR.isFinished() || !threadG.isFinished()) {
+    BokehUtils::MyThread* threads[3] = {&threadR, &threadG, &threadB};
+
+    // Allocate the buffers of each channel, retrying for a while if the
+    // memory is short
+    for (int c = 0; c < 3; c++) {
+      threads[c]->setCancelFlag(settings.m_isCanceled);
+
+      int waitCount = 0;
+      while (!threads[c]->init()) {
+        if ((settings.m_isCanceled && *settings.m_isCanceled) ||
+            ++waitCount >= 20)  // 10 seconds
+        {
+          for (int p = 0; p < c; p++) threads[p]->releaseBuffers();
+          releaseAllRasters(rasterList);
+          return;
         }
-        releaseAllRastersAndPlans(rasterList, planList);
-        return;
-      }
-      if (threadB.init()) {
-        if (renderInSingleThread)
-          threadB.run();
-        else
-          threadB.start();
-        break;
+        QThread::msleep(500);
       }
-      QThread::msleep(500);
-      waitCount++;
     }
 
     /*
-     * What is done in the thread for each RGB channel:
+     * What is done for each RGB channel:
      * - Convert channel value -> Exposure
      * - Multiply by alpha channel
      * - Forward FFT
      * - Multiply by the iris FFT data
      * - Backward FFT
      * - Convert Exposure -> channel value
+     * The channels run on the threads left free by the other render tasks.
      */
+    TThread::parallelFor(3, [&threads](int begin, int end) {
+      for (int c = begin; c < end; c++) threads[c]->run();
+    });
 
-    waitCount = 0;
-    while (1) {
-      if ((settings.m_isCanceled && *settings.m_isCanceled) ||
-          waitCount >= 2000)  // 100 second timeout
-      {
-        if (!threadR.isFinished()) threadR.terminateThread();
-        if (!threadG.isFinished()) threadG.terminateThread();
-        if (!threadB.isFinished()) threadB.terminateThread();
-        while (!threadR.isFinished() || !threadG.isFinished() ||
-               !threadB.isFinished()) {
-        }
-        releaseAllRastersAndPlans(rasterList, planList);
-        return;
-      }
-      if (threadR.isFinished() && threadG.isFinished() && threadB.isFinished())
-        break;
-      QThread::msleep(50);
-      waitCount++;
+    // cancel check
+    if (settings.m_isCanceled && *settings.m_isCanceled) {
+      releaseAllRasters(rasterList);
+      return;
     }
   }
 
@@ -1714,7 +1591,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
                                                     outMargin);
   lock.unlock();
 
-  releaseAllRastersAndPlans(rasterList, planList);
+  releaseAllRasters(rasterList);
 }
 
 void Iwa_BokehCommonFx::doBokehRef(
@@ -1723,7 +1600,6 @@ void Iwa_BokehCommonFx::doBokehRef(
     TTile& irisTile, kiss_fft_cpx* kissfft_comp_iris, LayerValue layer,
     unsigned char* ctrl, const bool isLinear) {
   QList<TRasterGR8P> rasterList;
-  QList<kiss_fftnd_cfg> planList;
   // source image
   double4* source_buff;
   rasterList.append(allocateRasterAndLock<double4>(&source_buff, dimOut));
@@ -1811,30 +1687,10 @@ void Iwa_BokehCommonFx::doBokehRef(
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
-  // fft plans
-  int dims[2]                      = {dimOut.ly, dimOut.lx};
-  kiss_fftnd_cfg kissfft_plan_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  planList.append(kissfft_plan_fwd);
-  planList.append(kissfft_plan_bkwd);
-
-  kiss_fftnd_cfg kissfft_plan_r_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_r_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_g_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_g_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_b_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_b_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  planList.append(kissfft_plan_r_fwd);
-  planList.append(kissfft_plan_r_bkwd);
-  planList.append(kissfft_plan_g_fwd);
-  planList.append(kissfft_plan_g_bkwd);
-  planList.append(kissfft_plan_b_fwd);
-  planList.append(kissfft_plan_b_bkwd);
-
   // initialize result memory
   memset(result_main_buff, 0, sizeof(double4) * size);
   memset(result_sub_buff, 0, sizeof(double4) * size);
@@ -1881,7 +1737,7 @@ void Iwa_BokehCommonFx::doBokehRef(
     for (int index = 0; index < segmentDepth_mainSub.size(); index++) {
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
 
@@ -1910,11 +1766,12 @@ void Iwa_BokehCommonFx::doBokehRef(
 
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       // Do FFT the iris image.
-      kiss_fftnd(kissfft_plan_fwd, kissfft_comp_iris_before, kissfft_comp_iris);
+      FftUtils::forwardReal(dimOut, kissfft_comp_iris_before,
+                            kissfft_comp_iris);
 
       // initialize alpha
       memset(fftcpx_alpha_before, 0, sizeof(kiss_fft_cpx) * size);
@@ -1932,7 +1789,7 @@ void Iwa_BokehCommonFx::doBokehRef(
                                   size);
 
       // forward fft of alpha channel
-      kiss_fftnd(kissfft_plan_fwd, fftcpx_alpha_before, fftcpx_alpha);
+      FftUtils::forwardReal(dimOut, fftcpx_alpha_before, fftcpx_alpha);
 
       // multiply filter on alpha
       BokehUtils::multiplyFilter(fftcpx_alpha,       // dst
@@ -1941,60 +1798,33 @@ void Iwa_BokehCommonFx::doBokehRef(
 
       // inverse fft the alpha channel
       // note that the result is multiplied by the image size
-      kiss_fftnd(kissfft_plan_bkwd, fftcpx_alpha, fftcpx_alpha_before);
+      FftUtils::backwardReal(dimOut, fftcpx_alpha, fftcpx_alpha_before);
 
       // over composite the alpha channel
       BokehUtils::compositeAlpha(result_buff_mainSub,  // dst
                                  fftcpx_alpha_before,  // alpha
                                  dimOut.lx, dimOut.ly);
 
-      // create worker threads
+      // compute each channel
       BokehUtils::BokehRefThread threadR(
           0, fftcpx_r_before, fftcpx_r, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_r_fwd, kissfft_plan_r_bkwd, dimOut);
+          result_buff_mainSub, dimOut, settings.m_isCanceled);
       BokehUtils::BokehRefThread threadG(
           1, fftcpx_g_before, fftcpx_g, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_g_fwd, kissfft_plan_g_bkwd, dimOut);
+          result_buff_mainSub, dimOut, settings.m_isCanceled);
       BokehUtils::BokehRefThread threadB(
           2, fftcpx_b_before, fftcpx_b, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_b_fwd, kissfft_plan_b_bkwd, dimOut);
-
-      // If you set this flag to true, the fx will be forced to compute in
-      // single thread.
-      // Under some specific condition (such as calling from single-threaded
-      // tcomposer)
-      // we may need to use this flag... For now, I'll keep this option unused.
-      // TODO: investigate this.
-      bool renderInSingleThread = false;
-
-      if (renderInSingleThread) {
-        threadR.run();
-        threadG.run();
-        threadB.run();
-      } else {
-        threadR.start();
-        threadG.start();
-        threadB.start();
-        int waitCount = 0;
-        while (1) {
-          if ((settings.m_isCanceled && *settings.m_isCanceled) ||
-              waitCount >= 2000)  // 100 second timeout
-          {
-            if (!threadR.isFinished()) threadR.terminateThread();
-            if (!threadG.isFinished()) threadG.terminateThread();
-            if (!threadB.isFinished()) threadB.terminateThread();
-            while (!threadR.isFinished() || !threadG.isFinished() ||
-                   !threadB.isFinished()) {
-            }
-            releaseAllRastersAndPlans(rasterList, planList);
-            return;
-          }
-          if (threadR.isFinished() && threadG.isFinished() &&
-              threadB.isFinished())
-            break;
-          QThread::msleep(50);
-          waitCount++;
-        }
+          result_buff_mainSub, dimOut, settings.m_isCanceled);
+      BokehUtils::BokehRefThread* threads[3] = {&threadR, &threadG, &threadB};
+
+      TThread::parallelFor(3, [&threads](int begin, int end) {
+        for (int c = begin; c < end; c++) threads[c]->run();
+      });
+
+      // cancel check
+      if (settings.m_isCanceled && *settings.m_isCanceled) {
+        releaseAllRasters(rasterList);
+        return;
       }
 
     }  // for each segment
@@ -2002,7 +1832,7 @@ void Iwa_BokehCommonFx::doBokehRef(
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
@@ -2016,6 +1846,6 @@ void Iwa_BokehCommonFx::doBokehRef(
                                                  result,              // dst
                                                  size, adjustFactor);
 
-  // release rasters and plans
-  releaseAllRastersAndPlans(rasterList, planList);
+  // release rasters
+  releaseAllRasters(rasterList);
 }
@@ -6,7 +6,7 @@
 #include "tgeometry.h"
 #include "traster.h"
 #include "kiss_fft.h"
-#include "kiss_fftnd.h"
+#include "iwa_fft_util.h"
 #include "ttile.h"
 #include "stdfx.h"
 #include "tfxparam.h"
@@ -79,16 +79,16 @@ public:
 namespace BokehUtils {
 
 //------------------------------------
+// Computes the bokeh of one channel. The three channels are run through
+// TThread::parallelFor().
 
-class MyThread : public QThread {
+class MyThread {
 public:
   enum Channel { Red = 0, Green, Blue };
 
 private:
   int m_channel;
 
-  volatile bool m_finished;
-
   TRasterP m_layerTileRas;
   double4* m_result;
   double* m_alpha_bokeh;
@@ -100,9 +100,8 @@ private:
 
   TRasterGR8P m_kissfft_comp_in_ras, m_kissfft_comp_out_ras;
   kiss_fft_cpx *m_kissfft_comp_in, *m_kissfft_comp_out;
-  kiss_fftnd_cfg m_kissfft_plan_fwd, m_kissfft_plan_bkwd;
 
-  bool m_isTerminated;
+  const int* m_isCanceled;
 
   std::shared_ptr<ExposureConverter> m_conv;
 
@@ -120,13 +119,15 @@ public:
 
   void run();
 
-  bool isFinished() { return m_finished; }
-
-  // ???????m??
+  // allocate the FFT buffers
   bool init();
 
-  void terminateThread() { m_isTerminated = true; }
+  // the render cancel flag
+  void setCancelFlag(const int* isCanceled) { m_isCanceled = isCanceled; }
+  bool isCanceled() const { return m_isCanceled && *m_isCanceled; }
 
+  void releaseBuffers();
+  // release the FFT buffers if the render is canceled
   bool checkTerminationAndCleanupThread();
 
   void setConverter(std::shared_ptr<ExposureConverter> conv) { m_conv = conv; }
@@ -135,9 +136,10 @@ public:
 
 //------------------------------------
 
-class BokehRefThread : public QThread {
+// Computes the bokeh of one channel of a segment layer, see MyThread.
+
+class BokehRefThread {
   int m_channel;
-  volatile bool m_finished;
 
   kiss_fft_cpx* m_fftcpx_channel_before;
   kiss_fft_cpx* m_fftcpx_channel;
@@ -145,22 +147,18 @@ class BokehRefThread : public QThread {
   kiss_fft_cpx* m_fftcpx_iris;
   double4* m_result_buff;
 
-  kiss_fftnd_cfg m_kissfft_plan_fwd, m_kissfft_plan_bkwd;
-
   TDimensionI m_dim;
-  bool m_isTerminated;
+  const int* m_isCanceled;
 
 public:
   BokehRefThread(int channel, kiss_fft_cpx* fftcpx_channel_before,
                  kiss_fft_cpx* fftcpx_channel, kiss_fft_cpx* fftcpx_alpha,
                  kiss_fft_cpx* fftcpx_iris, double4* result_buff,
-                 kiss_fftnd_cfg kissfft_plan_fwd,
-                 kiss_fftnd_cfg kissfft_plan_bkwd, TDimensionI& dim);
+                 TDimensionI& dim, const int* isCanceled);
 
-  void run() override;
+  void run();
 
-  bool isFinished() { return m_finished; }
-  void terminateThread() { m_isTerminated = true; }
+  bool isCanceled() const { return m_isCanceled && *m_isCanceled; }
 };
 
 //------------------------------------
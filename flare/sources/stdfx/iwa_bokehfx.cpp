@@ -10,12 +10,10 @@
 #include <QPair>
 #include <QVector>
 #include <QReadWriteLock>
-#include <QMutexLocker>
 #include <QMap>
 
 namespace {
 QReadWriteLock lock;
-QMutex fx_mutex;
 
 bool isFurtherLayer(const QPair<int, double> val1,
                     const QPair<int, double> val2) {
@@ -32,13 +30,6 @@ TRasterGR8P allocateRasterAndLock(T** buf, TDimensionI dim) {
   *buf = (T*)ras->getRawData();
   return ras;
 }
-// release all registered raster memories and free all fft plans
-void releaseAllRastersAndPlans(QList<TRasterGR8P>& rasterList,
-                               QList<kiss_fftnd_cfg>& planList) {
-  for (int r = 0; r < rasterList.size(); r++) rasterList.at(r)->unlock();
-  for (int p = 0; p < planList.size(); p++) kiss_fft_free(planList.at(p));
-}
-
 };  // namespace
 
 //--------------------------------------------
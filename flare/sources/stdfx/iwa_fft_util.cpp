@@ -0,0 +1,258 @@
+#include "iwa_fft_util.h"
+
+#include "tthread.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+typedef std::shared_ptr<kiss_fft_state> PlanP;
+
+// number of columns gathered together in the column passes
+const int ColumnBlock = 8;
+
+//------------------------------------
+// Cache of the 1D plans, keyed by size and direction.
+// kiss_fft plans are read-only during the transforms, so a plan can be used
+// by several threads at once.
+
+class PlanCache {
+  struct Entry {
+    PlanP m_plan;
+    unsigned int m_lastUse;
+  };
+
+  // plans are a few KB each; this is plenty for the sizes used in a render
+  static const int MaxPlanCount = 32;
+
+  QMutex m_mutex;
+  std::map<std::pair<int, bool>, Entry> m_plans;
+  unsigned int m_useCount;
+
+public:
+  PlanCache() : m_useCount(0) {}
+
+  static PlanCache *instance() {
+    static PlanCache theInstance;
+    return &theInstance;
+  }
+
+  PlanP getPlan(int nfft, bool inverse) {
+    QMutexLocker locker(&m_mutex);
+
+    Entry &entry = m_plans[std::make_pair(nfft, inverse)];
+    entry.m_lastUse = ++m_useCount;
+    if (entry.m_plan) return entry.m_plan;
+
+    entry.m_plan = PlanP(kiss_fft_alloc(nfft, inverse, 0, 0),
+                         [](kiss_fft_state *st) { kiss_fft_free(st); });
+
+    if ((int)m_plans.size() > MaxPlanCount) {
+      // release the least recently used plan. it is destroyed when the
+      // transforms still using it are done
+      auto lru = m_plans.begin();
+      for (auto it = m_plans.begin(); it != m_plans.end(); ++it)
+        if (it->second.m_lastUse < lru->second.m_lastUse) lru = it;
+      m_plans.erase(lru);
+    }
+    return entry.m_plan;
+  }
+};
+
+//------------------------------------
+// Runs func(begin, end, buf) over [0, count) in chunks, through
+// TThread::parallelFor(). Each chunk gets a scratch buffer of bufSize
+// elements.
+
+template <typename Func>
+void parallelFor(int count, int bufSize, Func func) {
+  int grain = std::max(count / (4 * QThread::idealThreadCount()), 1);
+  TThread::parallelFor(count,
+                       [&](int begin, int end) {
+                         std::vector<kiss_fft_cpx> buf(bufSize);
+                         func(begin, end, buf.data());
+                       },
+                       grain);
+}
+
+//------------------------------------
+// Transforms the columns from 0 to colCount - 1 of in into out.
+
+void columnPass(const TDimensionI &dim, int colCount, bool inverse,
+                const kiss_fft_cpx *in, kiss_fft_cpx *out) {
+  int lx = dim.lx, ly = dim.ly;
+  PlanP plan     = PlanCache::instance()->getPlan(ly, inverse);
+  int blockCount = (colCount + ColumnBlock - 1) / ColumnBlock;
+
+  parallelFor(blockCount, 2 * ColumnBlock * ly,
+              [&](int begin, int end, kiss_fft_cpx *buf) {
+                kiss_fft_cpx *tmp = buf + ColumnBlock * ly;
+                for (int b = begin; b < end; b++) {
+                  int x0 = b * ColumnBlock;
+                  int bx = std::min(ColumnBlock, colCount - x0);
+
+                  // gather the columns, reading the rows sequentially
+                  for (int y = 0; y < ly; y++) {
+                    const kiss_fft_cpx *in_p = in + y * lx + x0;
+                    for (int c = 0; c < bx; c++) buf[c * ly + y] = in_p[c];
+                  }
+                  for (int c = 0; c < bx; c++)
+                    kiss_fft(plan.get(), buf + c * ly, tmp + c * ly);
+                  for (int y = 0; y < ly; y++) {
+                    kiss_fft_cpx *out_p = out + y * lx + x0;
+                    for (int c = 0; c < bx; c++) out_p[c] = tmp[c * ly + y];
+                  }
+                }
+              });
+}
+
+//------------------------------------
+
+void complexTransform(const TDimensionI &dim, bool inverse,
+                      const kiss_fft_cpx *in, kiss_fft_cpx *out) {
+  int lx     = dim.lx;
+  PlanP plan = PlanCache::instance()->getPlan(lx, inverse);
+
+  parallelFor(dim.ly, lx, [&](int begin, int end, kiss_fft_cpx *buf) {
+    for (int y = begin; y < end; y++) {
+      std::copy(in + y * lx, in + (y + 1) * lx, buf);
+      kiss_fft(plan.get(), buf, out + y * lx);
+    }
+  });
+
+  columnPass(dim, lx, inverse, out, out);
+}
+
+}  // namespace
+
+//------------------------------------
+
+void FftUtils::forwardReal(const TDimensionI &dim, const kiss_fft_cpx *in,
+                           kiss_fft_cpx *out) {
+  int lx = dim.lx, ly = dim.ly;
+  if (lx <= 0 || ly <= 0) return;
+  // the non-redundant half of the spectrum
+  int hx     = lx / 2 + 1;
+  PlanP plan = PlanCache::instance()->getPlan(lx, false);
+
+  // transform the rows two at a time, as the real and imaginary parts of a
+  // complex row, then separate the two spectra by their symmetry
+  parallelFor((ly + 1) / 2, 2 * lx, [&](int begin, int end, kiss_fft_cpx *buf) {
+    kiss_fft_cpx *z = buf + lx;
+    for (int p = begin; p < end; p++) {
+      int ya = 2 * p, yb = 2 * p + 1;
+      const kiss_fft_cpx *in_a = in + ya * lx;
+      if (yb < ly) {
+        const kiss_fft_cpx *in_b = in + yb * lx;
+        for (int x = 0; x < lx; x++) {
+          buf[x].r = in_a[x].r;
+          buf[x].i = in_b[x].r;
+        }
+      } else {
+        for (int x = 0; x < lx; x++) {
+          buf[x].r = in_a[x].r;
+          buf[x].i = 0;
+        }
+      }
+      kiss_fft(plan.get(), buf, z);
+
+      kiss_fft_cpx *out_a = out + ya * lx;
+      kiss_fft_cpx *out_b = (yb < ly) ? out + yb * lx : nullptr;
+      for (int k = 0; k < hx; k++) {
+        kiss_fft_cpx zk = z[k], zn = z[(lx - k) % lx];
+        out_a[k].r      = (zk.r + zn.r) * 0.5f;
+        out_a[k].i      = (zk.i - zn.i) * 0.5f;
+        if (out_b) {
+          out_b[k].r = (zk.i + zn.i) * 0.5f;
+          out_b[k].i = (zn.r - zk.r) * 0.5f;
+        }
+      }
+    }
+  });
+
+  columnPass(dim, hx, false, out, out);
+
+  // fill the other half by the hermitian symmetry
+  if (hx < lx) {
+    parallelFor(ly, 0, [&](int begin, int end, kiss_fft_cpx *) {
+      for (int y = begin; y < end; y++) {
+        kiss_fft_cpx *out_p       = out + y * lx;
+        const kiss_fft_cpx *sym_p = out + ((ly - y) % ly) * lx;
+        for (int x = hx; x < lx; x++) {
+          out_p[x].r = sym_p[lx - x].r;
+          out_p[x].i = -sym_p[lx - x].i;
+        }
+      }
+    });
+  }
+}
+
+//------------------------------------
+
+void FftUtils::backwardReal(const TDimensionI &dim, const kiss_fft_cpx *in,
+                            kiss_fft_cpx *out) {
+  int lx = dim.lx, ly = dim.ly;
+  if (lx <= 0 || ly <= 0) return;
+  int hx = lx / 2 + 1;
+
+  // after the column pass, each row holds the half spectrum of a real row
+  columnPass(dim, hx, true, in, out);
+
+  PlanP plan = PlanCache::instance()->getPlan(lx, true);
+
+  // transform the rows two at a time: the first one goes to the real part
+  // and the second one to the imaginary part of the result
+  parallelFor((ly + 1) / 2, 2 * lx, [&](int begin, int end, kiss_fft_cpx *buf) {
+    kiss_fft_cpx *z = buf + lx;
+    for (int p = begin; p < end; p++) {
+      int ya = 2 * p, yb = 2 * p + 1;
+      kiss_fft_cpx *out_a = out + ya * lx;
+      kiss_fft_cpx *out_b = (yb < ly) ? out + yb * lx : nullptr;
+      for (int k = 0; k < hx; k++) {
+        kiss_fft_scalar ar = out_a[k].r, ai = out_a[k].i;
+        kiss_fft_scalar br = out_b ? out_b[k].r : 0,
+                        bi = out_b ? out_b[k].i : 0;
+        buf[k].r = ar - bi;
+        buf[k].i = ai + br;
+        if (k > 0 && lx - k >= hx) {
+          buf[lx - k].r = ar + bi;
+          buf[lx - k].i = br - ai;
+        }
+      }
+      kiss_fft(plan.get(), buf, z);
+
+      for (int x = 0; x < lx; x++) {
+        out_a[x].r = z[x].r;
+        out_a[x].i = 0;
+      }
+      if (out_b) {
+        for (int x = 0; x < lx; x++) {
+          out_b[x].r = z[x].i;
+          out_b[x].i = 0;
+        }
+      }
+    }
+  });
+}
+
+//------------------------------------
+
+void FftUtils::forward(const TDimensionI &dim, const kiss_fft_cpx *in,
+                       kiss_fft_cpx *out) {
+  if (dim.lx <= 0 || dim.ly <= 0) return;
+  complexTransform(dim, false, in, out);
+}
+
+//------------------------------------
+
+void FftUtils::backward(const TDimensionI &dim, const kiss_fft_cpx *in,
+                        kiss_fft_cpx *out) {
+  if (dim.lx <= 0 || dim.ly <= 0) return;
+  complexTransform(dim, true, in, out);
+}
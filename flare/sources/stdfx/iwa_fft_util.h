@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef IWA_FFT_UTIL_H
+#define IWA_FFT_UTIL_H
+
+#include "tgeometry.h"
+#include "kiss_fft.h"
+
+//------------------------------------
+// Shared 2D FFT service for the fx based on convolution (bokeh, glare).
+//
+// Images are stored row by row in kiss_fft_cpx arrays of dim.lx * dim.ly
+// elements, with the same layout and results as kiss_fftnd with
+// dims = {dim.ly, dim.lx}. The transforms of real images only take half the
+// work of the complex ones: two rows are transformed at once, and only the
+// non-redundant half of the columns is transformed.
+//
+// Rows and columns are processed through TThread::parallelFor(), and the 1D
+// plans are kept in a thread-safe cache keyed by size, so that they are built
+// once per size instead of once per transform. All functions can be called
+// from several threads at once; input and output may be the same buffer.
+//------------------------------------
+
+namespace FftUtils {
+
+// Forward transform of a real image, stored in the real part of \b in (the
+// imaginary part is ignored). \b out receives the whole spectrum.
+void forwardReal(const TDimensionI &dim, const kiss_fft_cpx *in,
+                 kiss_fft_cpx *out);
+
+// Backward transform of the spectrum of a real image, e.g. the product of
+// spectra computed by forwardReal(). The real result, not normalized, is
+// stored in the real part of \b out, and its imaginary part is zeroed.
+// Only the columns from 0 to dim.lx / 2 of \b in are read.
+void backwardReal(const TDimensionI &dim, const kiss_fft_cpx *in,
+                  kiss_fft_cpx *out);
+
+// Complex transforms.
+void forward(const TDimensionI &dim, const kiss_fft_cpx *in,
+             kiss_fft_cpx *out);
+void backward(const TDimensionI &dim, const kiss_fft_cpx *in,
+              kiss_fft_cpx *out);
+
+}  // namespace FftUtils
+
+#endif
@@ -7,7 +7,7 @@
 
 #include "tparamuiconcept.h"
 
-#include "kiss_fft.h"
+#include "iwa_fft_util.h"
 #include "iwa_cie_d65.h"
 #include "iwa_xyz.h"
 #include "iwa_simplexnoise.h"
@@ -347,17 +347,9 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
 
     convertIris(kissfft_comp_iris_before, dimIris, irisBBox, irisRas);
 
-    // Create the FFT plan for the iris image.
-    kiss_fftnd_cfg iris_kissfft_plan;
-    while (1) {
-      int dims[2]       = {dimIris, dimIris};
-      int ndims         = 2;
-      iris_kissfft_plan = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-      if (iris_kissfft_plan != NULL) break;
-    }
     // Do FFT the iris image.
-    kiss_fftnd(iris_kissfft_plan, kissfft_comp_iris_before, kissfft_comp_iris);
-    kiss_fft_free(iris_kissfft_plan);
+    FftUtils::forwardReal(TDimensionI(dimIris, dimIris),
+                          kissfft_comp_iris_before, kissfft_comp_iris);
     kissfft_comp_iris_before_ras->unlock();
   }
 
@@ -451,11 +443,6 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
   kissfft_comp_glare_ras->lock();
   kissfft_comp_source_ras->lock();
 
-  int dims[2]              = {dimOut.ly, dimOut.lx};
-  int ndims                = 2;
-  kiss_fftnd_cfg plan_fwd  = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  kiss_fftnd_cfg plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
-
   // obtain the source tile
   TTile sourceTile;
   m_source->allocateAndCompute(sourceTile, _rectOut.getP00(), dimOut,
@@ -476,7 +463,7 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
       setSourceTileToBuffer<TRasterFP, TPixelF>(sourceTile.getRaster(),
                                                 kissfft_comp_tmp);
     // FFT the source
-    kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_source);
+    FftUtils::forwardReal(dimOut, kissfft_comp_tmp, kissfft_comp_source);
   }
 
   // compute for each rgb channels
@@ -493,7 +480,7 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
         setSourceTileToBuffer<TRasterFP, TPixelF>(sourceTile.getRaster(),
                                                   kissfft_comp_tmp, ch);
       // FFT the source
-      kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_source);
+      FftUtils::forwardReal(dimOut, kissfft_comp_tmp, kissfft_comp_source);
     }
 
     kissfft_comp_tmp_ras->clear();
@@ -502,15 +489,15 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
                             dimOut);
 
     // FFT the glare pattern
-    kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_glare);
+    FftUtils::forwardReal(dimOut, kissfft_comp_tmp, kissfft_comp_glare);
 
     // multiply the glare and the source
     multiplyFilter(kissfft_comp_glare, kissfft_comp_source,
                    dimOut.lx * dimOut.ly);
 
     // Backward-FFT the glare pattern to tmp
-    kiss_fftnd(plan_bkwd, kissfft_comp_glare,
-               kissfft_comp_tmp);  // Backward FFT
+    FftUtils::backwardReal(dimOut, kissfft_comp_glare,
+                           kissfft_comp_tmp);  // Backward FFT
 
     // convert tmp to channel values, store it into the tile
     if (ras32)
@@ -529,9 +516,6 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
     TRop::tosRGB(tile.getRaster(), settings.m_colorSpaceGamma);
   }
 
-  kiss_fft_free(plan_fwd);
-  kiss_fft_free(plan_bkwd);
-
   kissfft_comp_source_ras->unlock();
   kissfft_comp_glare_ras->unlock();
 }
@@ -15,7 +15,7 @@ Iwa_GlareFx
 #include <QList>
 #include <QThread>
 
-#include "kiss_fftnd.h"
+#include "kiss_fft.h"
 
 const int LAYER_NUM = 5;
 
@@ -59,79 +59,85 @@ for(i=0; i<myParticles.size();i++)
 
 void Particles_Engine::fill_value_struct(struct particles_values &myvalues,
                                          double frame) {
+  // The engine replays all the frames since the start at each render: the
+  // animated params are read from the tables the fx keeps
+  auto baked = [this, frame](const auto &param) {
+    return m_parent->getBakedValue(param, frame);
+  };
+
   myvalues.source_ctrl_val  = m_parent->source_ctrl_val->getValue();
   myvalues.bright_thres_val = m_parent->bright_thres_val->getValue();
   myvalues.multi_source_val = m_parent->multi_source_val->getValue();
   myvalues.x_pos_val        = m_parent->center_val->getValue(frame).x;
   myvalues.y_pos_val        = m_parent->center_val->getValue(frame).y;
   //  myvalues.unit_val=m_parent->unit_val->getValue(frame);
-  myvalues.length_val          = m_parent->length_val->getValue(frame);
-  myvalues.height_val          = m_parent->height_val->getValue(frame);
-  myvalues.maxnum_val          = m_parent->maxnum_val->getValue(frame);
-  myvalues.lifetime_val        = m_parent->lifetime_val->getValue(frame);
+  myvalues.length_val          = baked(m_parent->length_val);
+  myvalues.height_val          = baked(m_parent->height_val);
+  myvalues.maxnum_val          = baked(m_parent->maxnum_val);
+  myvalues.lifetime_val        = baked(m_parent->lifetime_val);
   myvalues.lifetime_ctrl_val   = m_parent->lifetime_ctrl_val->getValue();
   myvalues.column_lifetime_val = m_parent->column_lifetime_val->getValue();
   myvalues.startpos_val        = m_parent->startpos_val->getValue();
   myvalues.randseed_val        = m_parent->randseed_val->getValue();
-  myvalues.gravity_val         = m_parent->gravity_val->getValue(frame);
-  myvalues.g_angle_val         = m_parent->g_angle_val->getValue(frame);
+  myvalues.gravity_val         = baked(m_parent->gravity_val);
+  myvalues.g_angle_val         = baked(m_parent->g_angle_val);
   myvalues.gravity_ctrl_val    = m_parent->gravity_ctrl_val->getValue();
-  myvalues.friction_val        = m_parent->friction_val->getValue(frame);
+  myvalues.friction_val        = baked(m_parent->friction_val);
   myvalues.friction_ctrl_val   = m_parent->friction_ctrl_val->getValue();
-  myvalues.windint_val         = m_parent->windint_val->getValue(frame);
-  myvalues.windangle_val       = m_parent->windangle_val->getValue(frame);
+  myvalues.windint_val         = baked(m_parent->windint_val);
+  myvalues.windangle_val       = baked(m_parent->windangle_val);
   myvalues.swingmode_val       = m_parent->swingmode_val->getValue();
-  myvalues.randomx_val         = m_parent->randomx_val->getValue(frame);
-  myvalues.randomy_val         = m_parent->randomy_val->getValue(frame);
+  myvalues.randomx_val         = baked(m_parent->randomx_val);
+  myvalues.randomy_val         = baked(m_parent->randomy_val);
   myvalues.randomx_ctrl_val    = m_parent->randomx_ctrl_val->getValue();
   myvalues.randomy_ctrl_val    = m_parent->randomy_ctrl_val->getValue();
-  myvalues.swing_val           = m_parent->swing_val->getValue(frame);
-  myvalues.speed_val           = m_parent->speed_val->getValue(frame);
+  myvalues.swing_val           = baked(m_parent->swing_val);
+  myvalues.speed_val           = baked(m_parent->speed_val);
   myvalues.speed_ctrl_val      = m_parent->speed_ctrl_val->getValue();
-  myvalues.speeda_val          = m_parent->speeda_val->getValue(frame);
+  myvalues.speeda_val          = baked(m_parent->speeda_val);
   myvalues.speeda_ctrl_val     = m_parent->speeda_ctrl_val->getValue();
   myvalues.speeda_use_gradient_val =
       m_parent->speeda_use_gradient_val->getValue();
   myvalues.speedscale_val     = m_parent->speedscale_val->getValue();
   myvalues.toplayer_val       = m_parent->toplayer_val->getValue();
-  myvalues.mass_val           = m_parent->mass_val->getValue(frame);
-  myvalues.scale_val          = m_parent->scale_val->getValue(frame);
+  myvalues.mass_val           = baked(m_parent->mass_val);
+  myvalues.scale_val          = baked(m_parent->scale_val);
   myvalues.scale_ctrl_val     = m_parent->scale_ctrl_val->getValue();
   myvalues.scale_ctrl_all_val = m_parent->scale_ctrl_all_val->getValue();
-  myvalues.rot_val            = m_parent->rot_val->getValue(frame);
+  myvalues.rot_val            = baked(m_parent->rot_val);
   myvalues.rot_ctrl_val       = m_parent->rot_ctrl_val->getValue();
-  myvalues.trail_val          = m_parent->trail_val->getValue(frame);
-  myvalues.trailstep_val      = m_parent->trailstep_val->getValue(frame);
+  myvalues.trail_val          = baked(m_parent->trail_val);
+  myvalues.trailstep_val      = baked(m_parent->trailstep_val);
   myvalues.rotswingmode_val   = m_parent->rotswingmode_val->getValue();
-  myvalues.rotspeed_val       = m_parent->rotspeed_val->getValue(frame);
-  myvalues.rotsca_val         = m_parent->rotsca_val->getValue(frame);
-  myvalues.rotswing_val       = m_parent->rotswing_val->getValue(frame);
+  myvalues.rotspeed_val       = baked(m_parent->rotspeed_val);
+  myvalues.rotsca_val         = baked(m_parent->rotsca_val);
+  myvalues.rotswing_val       = baked(m_parent->rotswing_val);
   myvalues.pathaim_val        = m_parent->pathaim_val->getValue();
-  myvalues.opacity_val        = m_parent->opacity_val->getValue(frame);
+  myvalues.opacity_val        = baked(m_parent->opacity_val);
   myvalues.opacity_ctrl_val   = m_parent->opacity_ctrl_val->getValue();
-  myvalues.trailopacity_val   = m_parent->trailopacity_val->getValue(frame);
+  myvalues.trailopacity_val   = baked(m_parent->trailopacity_val);
   //  myvalues.mblur_val=m_parent->mblur_val->getValue(frame);
-  myvalues.scalestep_val      = m_parent->scalestep_val->getValue(frame);
+  myvalues.scalestep_val      = baked(m_parent->scalestep_val);
   myvalues.scalestep_ctrl_val = m_parent->scalestep_ctrl_val->getValue();
-  myvalues.fadein_val         = m_parent->fadein_val->getValue(frame);
-  myvalues.fadeout_val        = m_parent->fadeout_val->getValue(frame);
+  myvalues.fadein_val         = baked(m_parent->fadein_val);
+  myvalues.fadeout_val        = baked(m_parent->fadeout_val);
   myvalues.animation_val      = m_parent->animation_val->getValue();
   myvalues.step_val           = m_parent->step_val->getValue();
 
   myvalues.gencol_val         = m_parent->gencol_val->getValue(frame);
   myvalues.gencol_ctrl_val    = m_parent->gencol_ctrl_val->getValue();
-  myvalues.gencol_spread_val  = m_parent->gencol_spread_val->getValue(frame);
-  myvalues.genfadecol_val     = m_parent->genfadecol_val->getValue(frame);
+  myvalues.gencol_spread_val  = baked(m_parent->gencol_spread_val);
+  myvalues.genfadecol_val     = baked(m_parent->genfadecol_val);
   myvalues.fincol_val         = m_parent->fincol_val->getValue(frame);
   myvalues.fincol_ctrl_val    = m_parent->fincol_ctrl_val->getValue();
-  myvalues.fincol_spread_val  = m_parent->fincol_spread_val->getValue(frame);
-  myvalues.finrangecol_val    = m_parent->finrangecol_val->getValue(frame);
-  myvalues.finfadecol_val     = m_parent->finfadecol_val->getValue(frame);
+  myvalues.fincol_spread_val  = baked(m_parent->fincol_spread_val);
+  myvalues.finrangecol_val    = baked(m_parent->finrangecol_val);
+  myvalues.finfadecol_val     = baked(m_parent->finfadecol_val);
   myvalues.foutcol_val        = m_parent->foutcol_val->getValue(frame);
   myvalues.foutcol_ctrl_val   = m_parent->foutcol_ctrl_val->getValue();
-  myvalues.foutcol_spread_val = m_parent->foutcol_spread_val->getValue(frame);
-  myvalues.foutrangecol_val   = m_parent->foutrangecol_val->getValue(frame);
-  myvalues.foutfadecol_val    = m_parent->foutfadecol_val->getValue(frame);
+  myvalues.foutcol_spread_val = baked(m_parent->foutcol_spread_val);
+  myvalues.foutrangecol_val   = baked(m_parent->foutrangecol_val);
+  myvalues.foutfadecol_val    = baked(m_parent->foutfadecol_val);
 
   myvalues.source_gradation_val = m_parent->source_gradation_val->getValue();
   myvalues.pick_color_for_every_frame_val =
@@ -140,7 +146,7 @@ void Particles_Engine::fill_value_struct(struct particles_values &myvalues,
       m_parent->perspective_distribution_val->getValue();
   myvalues.motion_blur_val = m_parent->motion_blur_val->getValue();
   myvalues.motion_blur_gamma_adjust_val =
-      m_parent->motion_blur_gamma_adjust_val->getValue(frame);
+      baked(m_parent->motion_blur_gamma_adjust_val);
 }
 
 /*-----------------------------------------------------------------*/
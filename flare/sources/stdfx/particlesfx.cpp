@@ -277,6 +277,28 @@ ParticlesFx::~ParticlesFx() {}
 
 //------------------------------------------------------------------
 
+double ParticlesFx::getBakedValue(const TDoubleParamP &param, double frame) {
+  // Tables start at frame 0, and grow by blocks as later frames are rendered.
+  // They don't observe the params, so render threads may replace them.
+  const int blockSize = 256, maxFrame = 1 << 16;
+
+  std::shared_ptr<TBakedDoubleParam> baked;
+  if (0 <= frame && frame < maxFrame) {
+    QMutexLocker locker(&m_bakedMutex);
+
+    std::shared_ptr<TBakedDoubleParam> &entry =
+        m_bakedParams[param.getPointer()];
+    if (!entry || frame >= entry->getFrameCount())
+      entry.reset(new TBakedDoubleParam(
+          param, 0, (tfloor(frame) / blockSize + 1) * blockSize));
+    baked = entry;
+  }
+
+  return baked ? baked->getValue(frame) : param->getValue(frame);
+}
+
+//------------------------------------------------------------------
+
 void ParticlesFx::getParamUIs(TParamUIConcept *&concepts, int &length) {
   concepts = new TParamUIConcept[length = 2];
 
@@ -6,6 +6,12 @@
 #include "stdfx.h"
 #include "tfxparam.h"
 #include "tspectrumparam.h"
+#include "tbakeddoubleparam.h"
+
+#include <QMutex>
+
+#include <map>
+#include <memory>
 
 //******************************************************************
 //    Particles Fx  class
@@ -93,6 +99,11 @@ public:
   TBoolParamP motion_blur_val;
   TDoubleParamP motion_blur_gamma_adjust_val;
 
+private:
+  //! Values of the animated params at the frames replayed by the engine
+  std::map<TDoubleParam *, std::shared_ptr<TBakedDoubleParam>> m_bakedParams;
+  QMutex m_bakedMutex;
+
 public:
   enum { UNIT_SMALL_INCH, UNIT_INCH };
   enum { MATTE_REF, GRAY_REF, H_REF };
@@ -139,6 +150,13 @@ public:
 
   void compatibilityTranslatePort(int majorVersion, int minorVersion,
                                   std::string &portName) override;
+
+  //! Returns the value of \b param, one of the fx params, at \b frame.
+  double getBakedValue(const TDoubleParamP &param, double frame);
+  DoublePair getBakedValue(const TRangeParamP &param, double frame) {
+    return DoublePair(getBakedValue(param->getMin(), frame),
+                      getBakedValue(param->getMax(), frame));
+  }
 };
 
 #endif  // PARTICLESFX_H
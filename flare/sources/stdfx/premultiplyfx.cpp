@@ -3,6 +3,20 @@
 #include "stdfx.h"
 // #include "tfxparam.h"
 #include "trop.h"
+#include "tpixelutils.h"
+//===================================================================
+
+namespace {
+
+class PremultiplyKernel final : public TPixelKernel {
+public:
+  void process(TPixelF *pix, int count) const override {
+    for (int i = 0; i < count; ++i) premult(pix[i]);
+  }
+};
+
+}  // namespace
+
 //===================================================================
 
 class PremultiplyFx final : public TStandardRasterFx {
@@ -27,6 +41,12 @@ public:
   }
 
   void doCompute(TTile &tile, double frame, const TRenderSettings &ri) override;
+
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &info) override {
+    return TPixelKernelP(new PremultiplyKernel);
+  }
+
   bool canHandle(const TRenderSettings &info, double frame) override {
     return true;
   }
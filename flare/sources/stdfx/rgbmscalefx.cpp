@@ -8,6 +8,37 @@
 
 //===================================================================
 
+namespace {
+
+//! Same as TRop::rgbmScale() on float rasters.
+class RGBMScaleKernel final : public TPixelKernel {
+  float m_k[4];
+
+public:
+  RGBMScaleKernel(double red, double green, double blue, double matte) {
+    m_k[0] = red, m_k[1] = green, m_k[2] = blue, m_k[3] = matte;
+  }
+
+  void process(TPixelF *pix, int count) const override {
+    for (int i = 0; i < count; ++i) {
+      float m = tcrop(m_k[3] * pix[i].m, 0.f, 1.f);
+      if (pix[i].m <= 0.f) {
+        pix[i].r = pix[i].g = pix[i].b = 0.f;
+      } else {
+        float fac = 1.f / pix[i].m;
+        pix[i].r  = m * tcrop(m_k[0] * pix[i].r * fac, 0.f, 1.f);
+        pix[i].g  = m * tcrop(m_k[1] * pix[i].g * fac, 0.f, 1.f);
+        pix[i].b  = m * tcrop(m_k[2] * pix[i].b * fac, 0.f, 1.f);
+      }
+      pix[i].m = m;
+    }
+  }
+};
+
+}  // namespace
+
+//===================================================================
+
 class RGBMScaleFx final : public GlobalControllableFx {
   FX_PLUGIN_DECLARATION(RGBMScaleFx)
   TRasterFxPort m_input;
@@ -41,6 +72,14 @@ public:
   }
 
   void doCompute(TTile &tile, double frame, const TRenderSettings &ri) override;
+
+  TPixelKernelP getPixelKernel(double frame,
+                               const TRenderSettings &info) override {
+    return TPixelKernelP(new RGBMScaleKernel(
+        m_red->getValue(frame) / 100, m_green->getValue(frame) / 100,
+        m_blue->getValue(frame) / 100, m_matte->getValue(frame) / 100));
+  }
+
   bool canHandle(const TRenderSettings &info, double frame) override {
     return true;
   }
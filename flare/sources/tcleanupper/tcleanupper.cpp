@@ -17,6 +17,7 @@
 #include "flare/txshchildlevel.h"
 #include "flare/tproject.h"
 #include "flare/tcleanupper.h"
+#include "flare/batchcleanupper.h"
 #include "flare/txsheet.h"
 #include "flare/txshcell.h"
 #include "flare/txshcolumn.h"
@@ -399,69 +400,74 @@ static void cleanupLevel(TXshSimpleLevel *xl, std::set<TFrameId> fidsInXsheet,
   LevelUpdater updater(xl);
   m_userLog.info(info);
   DVGui::info(QString::fromStdString(info));
+  CleanupParameters *params = scene->getProperties()->getCleanupParameters();
+  // if lines are not processed, obtain the original sampled image
+  bool toBeLineProcessed = params->m_lineProcessingMode != lpNone;
+
   bool firstImage = true;
-  for (auto const &fid : fidsInXsheet) {
-    cout << "  " << fid << endl;
-    info = "  " + fid.expand();
-    m_userLog.info(info);
-    int status = xl->getFrameStatus(fid);
-
-    if (0 != (status & TXshSimpleLevel::Cleanupped) && !overwrite) {
-      cout << "  skipped" << endl;
-      m_userLog.info("  skipped");
-      DVGui::info(QString("--skipped frame ") +
-                  QString::fromStdString(fid.expand()));
-      continue;
-    }
-    CleanupParameters *params = scene->getProperties()->getCleanupParameters();
-    // if lines are not processed, obtain the original sampled image
-    bool toBeLineProcessed = params->m_lineProcessingMode != lpNone;
-    TRasterImageP original = xl->getFrameToCleanup(fid, toBeLineProcessed);
-    if (!original) {
-      string err = "    *error* missed frame";
-      m_userLog.error(err);
-      cout << err << endl;
-      continue;
+  auto ft         = fidsInXsheet.begin();
+
+  // Frames are read and written here, while their cleanup runs in parallel
+  auto readFrame = [&](BatchCleanupper::Frame &frame) {
+    for (; ft != fidsInXsheet.end(); ++ft) {
+      const TFrameId &fid = *ft;
+
+      cout << "  " << fid << endl;
+      info = "  " + fid.expand();
+      m_userLog.info(info);
+      int status = xl->getFrameStatus(fid);
+
+      if (0 != (status & TXshSimpleLevel::Cleanupped) && !overwrite) {
+        cout << "  skipped" << endl;
+        m_userLog.info("  skipped");
+        DVGui::info(QString("--skipped frame ") +
+                    QString::fromStdString(fid.expand()));
+        continue;
+      }
+      TRasterImageP original = xl->getFrameToCleanup(fid, toBeLineProcessed);
+      if (!original) {
+        string err = "    *error* missed frame";
+        m_userLog.error(err);
+        cout << err << endl;
+        continue;
+      }
+
+      // Obtain the source dpi. Changed it to be done once at the first frame
+      // of each level in order to avoid the following problem:
+      // If the original raster level has no dpi (such as TGA images),
+      // obtaining dpi in every frame causes dpi mismatch between the first
+      // frame and the following frames, since the value
+      // TXshSimpleLevel::m_properties->getDpi() will be changed to the
+      // dpi of cleanup camera (= TLV's dpi) after finishing the first frame.
+      if (toBeLineProcessed && firstImage) {
+        TPointD dpi;
+        original->getDpi(dpi.x, dpi.y);
+        if (dpi.x == 0 && dpi.y == 0) dpi = xl->getProperties()->getDpi();
+        cl->setSourceDpi(dpi);
+      }
+
+      frame.m_fid   = fid;
+      frame.m_image = original;
+      frame.m_first = toBeLineProcessed && firstImage;
+
+      ++ft;
+      return true;
     }
 
-    if (params->m_lineProcessingMode == lpNone) {
-      TRasterImageP ri(original);
-      /*if (params->m_autocenterType == CleanupTypes::AUTOCENTER_NONE)
-        ri = original;
-      else {
-        bool autocentered;
-        ri = cl->autocenterOnly(original, false, autocentered);
-        if (!autocentered) {
-          m_userLog.error("The autocentering failed on the current drawing.");
-          cout << "The autocentering failed on the current drawing." << endl;
-        }
-      }*/
-      cl->process(original, false, ri, false, true, true, nullptr,
-                  ri->getRaster());
+    return false;
+  };
+
+  auto writeFrame = [&](BatchCleanupper::Result &result) {
+    const TFrameId &fid = result.m_fid;
+
+    if (TRasterImageP ri = result.m_rasterImage) {
       updater.update(fid, ri);
-      continue;
-    }
-    // Obtain the source dpi. Changed it to be done once at the first frame of
-    // each level in order to avoid the following problem:
-    // If the original raster level has no dpi (such as TGA images), obtaining
-    // dpi in every frame causes dpi mismatch between the first frame and the
-    // following frames, since the value
-    // TXshSimpleLevel::m_properties->getDpi() will be changed to the
-    // dpi of cleanup camera (= TLV's dpi) after finishing the first frame.
-    if (firstImage) {
-      TPointD dpi;
-      original->getDpi(dpi.x, dpi.y);
-      if (dpi.x == 0 && dpi.y == 0) dpi = xl->getProperties()->getDpi();
-      cl->setSourceDpi(dpi);
+      return;
     }
 
-    CleanupPreprocessedImage *cpi;
-    {
-      TRasterImageP resampledImage;
-      cpi = cl->process(original, firstImage, resampledImage);
-    }
+    TToonzImageP timage = result.m_toonzImage;
+    if (!timage) return;
 
-    TToonzImageP timage = cl->finalize(cpi, true);
     TPointD dpi(0, 0);
     timage->getDpi(dpi.x, dpi.y);
     if (dpi.x != 0 && dpi.y != 0) xl->getProperties()->setDpi(dpi);
@@ -470,16 +476,19 @@ static void cleanupLevel(TXshSimpleLevel *xl, std::set<TFrameId> fidsInXsheet,
     firstImage = false;
 
     timage->setPalette(xl->getPalette());
-    xl->setFrameStatus(fid, status | TXshSimpleLevel::Cleanupped);
+    xl->setFrameStatus(fid,
+                       xl->getFrameStatus(fid) | TXshSimpleLevel::Cleanupped);
     xl->setFrame(fid, timage);
 
     updater.update(fid, timage);
 
     /*- 1フレーム終わったら、そのフレームのキャッシュは消す -*/
     xl->invalidateFrame(fid);
+  };
 
-    delete cpi;
-  }
+  BatchCleanupper batch;
+  batch.setIsCleanupper(true);
+  batch.run(readFrame, writeFrame);
 }
 
 //========================================================================
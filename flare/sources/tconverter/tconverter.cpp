@@ -4,6 +4,8 @@
 #include "flare/toonzscene.h"
 #include "flare/preferences.h"
 #include "flare/sceneproperties.h"
+#include "flare/vectorizerparameters.h"
+#include "flare/batchvectorizer.h"
 #include "toutputproperties.h"
 
 // TnzBase includes
@@ -354,6 +356,105 @@ void convert(const TFilePath &source, const TFilePath &dest,
                   width.getValue());
 }
 
+//-----------------------------------------------------------------------
+
+void convertToVector(const TFilePath &source, const TFilePath &dest,
+                     const RangeQualifier &range,
+                     const VectorizerParameters &params, int threadCount) {
+  string msg;
+  TLevelReaderP lr(source);
+  TLevelP level = lr->loadInfo();
+
+  vector<TFrameId> frames = getFrameIds(range, level);
+  if (frames.empty()) return;
+
+  doesExist(dest);
+
+  msg = "Level loaded";
+  cout << msg << endl;
+  msg = "Conversion in progress: wait please...";
+  cout << msg << endl;
+
+  // Toonz rasters are vectorized against (a copy of) their palette, which
+  // stays untouched. Full-color ones add their colors to a new palette, so
+  // their frames can be saved only once the palette is complete.
+  bool fixedPalette = (source.getType() == "tlv" && level->getPalette());
+  TPaletteP palette =
+      fixedPalette ? level->getPalette()->clone() : new TPalette;
+
+  double frameRange[2] = {static_cast<double>(frames.front().getNumber()) - 1,
+                          static_cast<double>(frames.back().getNumber()) - 1};
+
+  vector<TFrameId>::const_iterator ft = frames.begin();
+  auto readFrame = [&](BatchVectorizer::Frame &frame) -> bool {
+    if (ft == frames.end()) return false;
+
+    frame.m_fid = *ft++;
+    try {
+      TImageReaderP ir = lr->getFrameReader(frame.m_fid);
+      TImageP img      = ir->load();
+
+      double weight = (frame.m_fid.getNumber() - 1 - frameRange[0]) /
+                      std::max(frameRange[1] - frameRange[0], 1.0);
+      weight = tcrop(weight, 0.0, 1.0);
+
+      frame.m_configuration.reset(params.getCurrentConfiguration(weight));
+      if (BatchVectorizer::setImageTransform(img, *frame.m_configuration))
+        frame.m_image = img;
+    } catch (...) {
+    }
+
+    if (!frame.m_image) {
+      string msg = "Frame " + frame.m_fid.expand() + ": conversion failed!";
+      cout << msg << endl;
+    }
+    return true;
+  };
+
+  TLevelWriterP lw(dest);
+  vector<pair<TFrameId, TVectorImageP>> pendingFrames;
+
+  auto save = [&](const TFrameId &fid, const TVectorImageP &vi) {
+    try {
+      vi->setPalette(palette.getPointer());
+      TImageWriterP iw = lw->getFrameWriter(fid);
+      iw->save(vi);
+    } catch (...) {
+      string msg = "Frame " + fid.expand() + ": conversion failed!";
+      cout << msg << endl;
+    }
+  };
+
+  auto writeFrame = [&](const TFrameId &fid, const TVectorImageP &vi) {
+    if (!vi) {
+      string msg = "Frame " + fid.expand() + ": conversion failed!";
+      cout << msg << endl;
+    } else if (fixedPalette)
+      save(fid, vi);
+    else
+      pendingFrames.push_back(std::make_pair(fid, vi));
+  };
+
+  BatchVectorizer batch(threadCount);
+  batch.run(palette.getPointer(), readFrame, writeFrame);
+
+  for (const auto &frame : pendingFrames) save(frame.first, frame.second);
+}
+
+//------------------------------------------------------------------------
+
+//! Rewrites the scene \b source as \b dest, in binary or XML form.
+void convertScene(const TFilePath &source, const TFilePath &dest,
+                  bool binary) {
+  TIStream is(source);
+  if (!is) throw TException(source.getWideString() + L": Can't open file");
+
+  TOStream os(dest, false, binary);
+  if (!os) throw TException(dest.getWideString() + L": Can't write file");
+
+  is.copyTo(os);
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------
@@ -375,9 +476,14 @@ int main(int argc, char *argv[]) {
   FilePathQualifier tnzName("-s sceneName", "Scene file");
   RangeQualifier range;
   IntQualifier width("-w width", "Image width");
+  SimpleQualifier outline("-outline", "Vectorize in outline mode (.pli only)");
+  IntQualifier threads("-threads n", "Vectorization threads (.pli only)");
+  SimpleQualifier binary("-binary",
+                         "Write the scene in binary form (.tnz to .tnz only)");
 
   Usage usage(argv[0]);
-  usage.add(srcName + dstName + width + tnzName + range);
+  usage.add(srcName + dstName + width + tnzName + range + outline + threads +
+            binary);
   if (!usage.parse(argc, argv)) exit(1);
 
   try {
@@ -389,6 +495,7 @@ int main(int argc, char *argv[]) {
     initImageIo();
     TRenderSettings::ResampleQuality resQuality =
         TRenderSettings::StandardResampleQuality;
+    VectorizerParameters vParams;
 
     TFilePath dstFilePath = dstName.getValue();
     TFilePath srcFilePath = srcName.getValue();
@@ -414,6 +521,18 @@ int main(int argc, char *argv[]) {
             .isEmpty())  // ho specificato solo l'estensione
       dstFilePath =
           srcFilePath.getParentDir() + (srcFilePath.getName() + "." + ext);
+    if (srcFilePath.getType() == "tnz" && ext == "tnz") {
+      // Scene format conversion: binary scenes keep the .tnz extension
+      if (dstFilePath == srcFilePath) {
+        msg = "The target scene must differ from the source one.";
+        cout << msg << endl;
+        exit(1);
+      }
+      convertScene(srcFilePath, dstFilePath, binary.isSelected());
+      msg = "Conversion terminated!";
+      cout << endl << msg << endl;
+      return 0;
+    }
     if (tnzName.isSelected()) {
       // Devo prendermi i settaggi degli "output setting" dalla scena!
       TFilePath tnzFilePath = tnzName.getValue();
@@ -426,7 +545,7 @@ int main(int argc, char *argv[]) {
       if (!TSystem::doesExistFileOrLevel(tnzFilePath)) return -1;
       ToonzScene *scene = new ToonzScene();
       try {
-        scene->loadTnzFile(tnzFilePath);
+        scene->loadProperties(tnzFilePath);
       } catch (...) {
         string msg;
         msg = "There were problems loading the scene " +
@@ -443,13 +562,19 @@ int main(int argc, char *argv[]) {
         prop = scene->getProperties()
                    ->getOutputProperties()
                    ->getFileFormatProperties(ext);
+        vParams = *scene->getProperties()->getVectorizerParameters();
       } else {
         msg = "Invalid scene file: conversion terminated!";
         cout << msg << endl;
         exit(1);
       }
     }
-    if (ext != "3gp" && ext != "pli") {
+    if (ext == "pli" && srcFilePath.getType() != "pli") {
+      // Vectorize with the scene's settings, if any
+      if (outline.isSelected()) vParams.m_isOutline = true;
+      convertToVector(srcFilePath, dstFilePath, range, vParams,
+                      threads.isSelected() ? threads.getValue() : 0);
+    } else if (ext != "3gp" && ext != "pli") {
       // assert(ext!="3gp" && ext!="pli" && ext!="tlv");
       convert(srcFilePath, dstFilePath, range, width, prop, resQuality);
     } else {
@@ -4,6 +4,7 @@
 
 // Core-system includes
 #include "tsystem.h"
+#include "tthread.h"
 #include "tthreadmessage.h"
 
 // Fx basics
@@ -357,6 +358,182 @@ private:
 
 FX_IDENTIFIER_IS_HIDDEN(TrFx, "trFx")
 
+//==============================================================================
+//
+// PixelChain
+//
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Pixels per block in a fused pass. The block is converted to float once, and
+// stays in the L1 cache while all the kernels of the chain are applied to it.
+const int KernelBlockSize = 256;
+
+//------------------------------------------------------------------------------
+
+inline void loadBlock(const TPixelF *pix, TPixelF *buf, int count) {
+  std::copy(pix, pix + count, buf);
+}
+
+template <typename PIXEL>
+inline void loadBlock(const PIXEL *pix, TPixelF *buf, int count) {
+  const float fac = 1.f / (float)PIXEL::maxChannelValue;
+  for (int i = 0; i < count; ++i) {
+    buf[i].r = (float)pix[i].r * fac;
+    buf[i].g = (float)pix[i].g * fac;
+    buf[i].b = (float)pix[i].b * fac;
+    buf[i].m = (float)pix[i].m * fac;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+inline void storeBlock(const TPixelF *buf, TPixelF *pix, int count) {
+  std::copy(buf, buf + count, pix);
+}
+
+template <typename PIXEL>
+inline void storeBlock(const TPixelF *buf, PIXEL *pix, int count) {
+  typedef typename PIXEL::Channel Channel;
+  const float maxValue = (float)PIXEL::maxChannelValue;
+  auto toChannel       = [maxValue](float val) {
+    return (Channel)(((val < 0.f) ? 0.f : (val > 1.f) ? 1.f : val) * maxValue +
+                     0.5f);
+  };
+  for (int i = 0; i < count; ++i) {
+    pix[i].r = toChannel(buf[i].r);
+    pix[i].g = toChannel(buf[i].g);
+    pix[i].b = toChannel(buf[i].b);
+    pix[i].m = toChannel(buf[i].m);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+//! Whether the output of fx can be computed by its downstream fx kernel, in
+//! the same pass, instead of going through its own compute().
+bool isFusible(TRasterFx *fx, TRasterFx *lastFx, double frame,
+               const TRenderSettings &info) {
+  if (fx->checkActiveTimeRegion() && !fx->getActiveTimeRegion().contains(frame))
+    return false;
+
+  // Intermediate results used elsewhere or kept in the interactive cache
+  // must still be rendered by their own node
+  if (!fx->getAttributes()->isEnabled() ||
+      fx->getOutputConnectionCount() != 1 || fx->isCacheEnabled())
+    return false;
+
+  // The settings are passed unchanged along the chain, so no fx can require
+  // an affine transformer
+  if (!info.m_affine.isIdentity() && !fx->canHandle(info, frame)) return false;
+
+  // The tile must be in the same color space for all the kernels
+  for (int tileIsLinear = 0; tileIsLinear < 2; ++tileIsLinear) {
+    if (fx->toBeComputedInLinearColorSpace(info.m_linearColorSpace,
+                                           tileIsLinear) !=
+        lastFx->toBeComputedInLinearColorSpace(info.m_linearColorSpace,
+                                               tileIsLinear))
+      return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+//! Whether the input of fx can be fused with it.
+bool hasFusibleInput(TRasterFx *fx, double frame, const TRenderSettings &info) {
+  if (fx->getInputPortCount() == 0) return false;
+
+  TRasterFxP inputFx = fx->getInputPort(0)->getFx();
+  return inputFx && isFusible(inputFx.getPointer(), fx, frame, info);
+}
+
+//------------------------------------------------------------------------------
+
+//! The chain of pointwise fxs ending with a given fx, to be computed in a
+//! single pass over the source tile.
+class PixelChain {
+  std::vector<TPixelKernelP> m_kernels;  //!< Kernels, from the last fx
+  TRasterFxP m_source;  //!< The input of the first fx in the chain
+
+public:
+  PixelChain(TRasterFx *fx, double frame, const TRenderSettings &info) {
+    // Kernels can be costly to build: a lone fx is left to its compute()
+    if (!hasFusibleInput(fx, frame, info)) return;
+
+    TRasterFx *currFx = fx;
+    for (;;) {
+      if (currFx->getInputPortCount() == 0) break;
+
+      TFxPort *port = currFx->getInputPort(0);
+      if (!port->isConnected()) break;
+
+      TPixelKernelP kernel = currFx->getPixelKernel(frame, info);
+      if (!kernel) break;
+
+      m_kernels.push_back(kernel);
+      m_source = port->getFx();
+
+      TRasterFx *inputFx = m_source.getPointer();
+      if (!inputFx || !isFusible(inputFx, fx, frame, info)) break;
+
+      currFx = inputFx;
+    }
+  }
+
+  //! Whether the chain is worth a fused pass, i.e. it is made of more than
+  //! a single fx.
+  bool isFused() const { return m_source && m_kernels.size() > 1; }
+
+  void dryCompute(TRectD &rect, double frame, const TRenderSettings &info) {
+    m_source->dryCompute(rect, frame, info);
+  }
+
+  void compute(TTile &tile, double frame, const TRenderSettings &info) {
+    m_source->compute(tile, frame, info);
+
+    TRasterP ras = tile.getRaster();
+    ras->lock();
+    if (TRaster32P ras32 = ras)
+      process(ras32);
+    else if (TRaster64P ras64 = ras)
+      process(ras64);
+    else if (TRasterFP rasF = ras)
+      process(rasF);
+    else
+      assert(false);
+    ras->unlock();
+  }
+
+private:
+  template <typename PIXEL>
+  void process(const TRasterPT<PIXEL> &ras) {
+    int lx = ras->getLx(), ly = ras->getLy();
+    int grain = std::max(KernelBlockSize * 16 / std::max(lx, 1), 1);
+
+    TThread::parallelFor(ly,
+                         [&](int begin, int end) {
+                           TPixelF buf[KernelBlockSize];
+                           for (int y = begin; y < end; ++y) {
+                             PIXEL *pix = ras->pixels(y);
+                             for (int x = 0; x < lx; x += KernelBlockSize) {
+                               int count = std::min(KernelBlockSize, lx - x);
+                               loadBlock(pix + x, buf, count);
+                               for (auto it = m_kernels.rbegin();
+                                    it != m_kernels.rend(); ++it)
+                                 (*it)->process(buf, count);
+                               storeBlock(buf, pix + x, count);
+                             }
+                           }
+                         },
+                         grain);
+  }
+};
+
+}  // namespace
+
 //==============================================================================
 //
 // FxResourceBuilder
@@ -393,7 +570,11 @@ protected:
   void simCompute(const TRectD &rect) override {
     TRectD rectCpy(
         rect);  // Why the hell dryCompute(..) has non-const TRectD& input ????
-    m_rfx->doDryCompute(rectCpy, m_frame, *m_rs);
+    PixelChain chain(m_rfx.getPointer(), m_frame, *m_rs);
+    if (chain.isFused())
+      chain.dryCompute(rectCpy, m_frame, *m_rs);
+    else
+      m_rfx->doDryCompute(rectCpy, m_frame, *m_rs);
   }
 
   void buildTileToCalculate(const TRectD &tileRect);
@@ -456,7 +637,13 @@ void FxResourceBuilder::compute(const TRectD &tileRect) {
 #endif
 
   buildTileToCalculate(tileRect);
-  m_rfx->doCompute(*m_currTile, m_frame, *m_rs);
+
+  // Chains of pointwise fxs are computed in a single pass
+  PixelChain chain(m_rfx.getPointer(), m_frame, *m_rs);
+  if (chain.isFused())
+    chain.compute(*m_currTile, m_frame, *m_rs);
+  else
+    m_rfx->doCompute(*m_currTile, m_frame, *m_rs);
 
 #ifdef DIAGNOSTICS
   sw.stop();
@@ -721,7 +908,11 @@ void TRasterFx::dryCompute(TRectD &rect, double frame,
     // Declare the tile to the tiles manager
     ResourceBuilder::declareResource(alias, this, interestingRect, frame, info);
 
-    doDryCompute(interestingRect, frame, info);
+    PixelChain chain(this, frame, info);
+    if (chain.isFused())
+      chain.dryCompute(interestingRect, frame, info);
+    else
+      doDryCompute(interestingRect, frame, info);
   } else {
     TRectD bbox;
     getBBox(frame, bbox, info);
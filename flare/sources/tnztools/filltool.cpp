@@ -31,6 +31,7 @@
 #include "tstroke.h"
 #include "drawutil.h"
 #include "tsystem.h"
+#include "tthread.h"
 #include "tinbetween.h"
 #include "tregion.h"
 #include "tgl.h"
@@ -46,6 +47,7 @@
 #include "flare/imagemanager.h"
 #include "flare/txshcell.h"
 #include "flareqt/imageutils.h"
+#include "flareqt/dvdialog.h"
 #include "autofill.h"
 #include "flare/fill.h"
 #include "flare/autoclose.h"
@@ -55,9 +57,14 @@
 #include <stack>
 #include <algorithm>
 #include <vector>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <memory>
 
 // For Qt translation support
 #include <QCoreApplication>
+#include <QScopedValueRollback>
 
 using namespace ToolUtils;
 
@@ -87,6 +94,17 @@ TEnv::IntVar FillExtend("InknpaintFillExtend", 0);
 
 namespace {
 
+//! Maximum number of frames whose refer fill data is kept by the fill tool
+const size_t c_maxReferCacheCount = 64;
+
+//-----------------------------------------------------------------------------
+
+std::string referImageCacheId(const std::string &cacheId) {
+  return "FillToolReferImage_" + cacheId;
+}
+
+//-----------------------------------------------------------------------------
+
 inline int vectorFill(const TVectorImageP &img, const std::wstring &type,
                       const TPointD &point, int style, bool emptyOnly = false) {
   if (type == ALL || type == LINES) {
@@ -834,6 +852,32 @@ void doStrokeAutofill(const TImageP &img, TStroke *selectingStroke,
   }
 }
 
+//=============================================================================
+// DeferredFill
+//-----------------------------------------------------------------------------
+
+//! What the fills run by SequencePainter on worker threads leave to the main
+//! thread: building their undos, which read the current frame, and updating
+//! the savebox.
+struct DeferredFill {
+  std::vector<std::function<TUndo *()>> m_undos;
+  bool m_updateSavebox = false;
+};
+
+//! Set while a worker thread fills a frame for SequencePainter
+thread_local DeferredFill *deferredFill = nullptr;
+
+//-----------------------------------------------------------------------------
+
+//! Adds the undo built by \b makeUndo - at once, or back on the main thread
+//! for fills run by SequencePainter on worker threads.
+void addFillUndo(const std::function<TUndo *()> &makeUndo) {
+  if (deferredFill)
+    deferredFill->m_undos.push_back(makeUndo);
+  else
+    TUndoManager::manager()->add(makeUndo());
+}
+
 //=============================================================================
 // fillRectWithUndo
 //-----------------------------------------------------------------------------
@@ -898,9 +942,13 @@ void fillAreaWithUndo(const TImageP &img, const TRaster32P &ref,
         delete rasTileSet;
         return;
       }
-      TUndoManager::manager()->add(new RasterRectFillUndo(
-          rasTileSet, stroke, rasSaveBox, auxFillArea, cs, sl, colorType,
-          onlyUnfilled, fid, ref.getPointer(), plt, fillAllautoPaintLines));
+      bool refFill = ref.getPointer();
+      addFillUndo([=] {
+        return new RasterRectFillUndo(rasTileSet, stroke, rasSaveBox,
+                                      auxFillArea, cs, sl, colorType,
+                                      onlyUnfilled, fid, refFill, plt,
+                                      fillAllautoPaintLines);
+      });
     } else {
       TPointD total = convert(ras->getCenter()) - convert(offs) -
                       TPointD(auxFillArea.x0, auxFillArea.y0);
@@ -909,6 +957,8 @@ void fillAreaWithUndo(const TImageP &img, const TRaster32P &ref,
                         colorType != LINES, colorType != AREAS,
                         fillAllautoPaintLines);
 
+      // The undo copies the stroke as it is now
+      assert(!deferredFill);
       TUndoManager::manager()->add(new RasterRectFillUndo(
           rasTileSet, stroke, rasSaveBox, auxFillArea, cs, sl, colorType,
           onlyUnfilled, fid, ref.getPointer(), plt, fillAllautoPaintLines));
@@ -965,7 +1015,7 @@ inline void applyStageToPixel(TAffine &aff, const TPointD &dpi) {
 }
 
 void drawReferImage(TRaster32P &ras, TXsheet *xsh, int col, int row,
-                    TPointD saveboxoffset) {
+                    TPointD saveboxoffset, std::set<std::string> &sourceIds) {
   assert(col >= 0);
 
   TStageObject *curPegbar = xsh->getStageObject(TStageObjectId::ColumnId(col));
@@ -1009,6 +1059,7 @@ void drawReferImage(TRaster32P &ras, TXsheet *xsh, int col, int row,
         r = ri->getRaster();
       }
       if (!r.getPointer()) continue;
+      sourceIds.insert(sl->getImageId(cell.m_frameId, 0));
 
       // Compute offset to align refer image center to fill image center
       TPointD offset = ras->getCenterD() - r->getCenterD();
@@ -1038,8 +1089,12 @@ void drawReferImage(TRaster32P &ras, TXsheet *xsh, int col, int row,
   }
 };
 
+//! Closes the gaps of \b raux, mixed with the refer image \b ras when
+//! \b referFill, and puts the closing lines on \b ras. The segments are
+//! cached for \b imageId, separately for each \b variant of \b raux.
 void gapClose(TRaster32P &ras, TRasterCM32P &raux, TXshSimpleLevel *sl,
-              bool referFill) {
+              bool referFill, const std::string &imageId,
+              const std::string &variant, ReferFillCache &cache) {
   AutocloseSettings closeStting =
       ToonzCheck::instance()->getAutocloseSettings();
   TRasterCM32P tnzRas = raux->clone();
@@ -1054,8 +1109,29 @@ void gapClose(TRaster32P &ras, TRasterCM32P &raux, TXshSimpleLevel *sl,
   }
   if (DEF_REGION_WITH_PAINT)
     closeStting.m_opacity = TPixelCM32::getMaxTone() - 2;
-  TAutocloser ac(tnzRas, TPixelCM32::getMaxInk(), closeStting, autoPaintInks);
-  ac.exec();
+  TAutocloser ac(tnzRas, TPixelCM32::getMaxInk(), closeStting);
+
+  // Fills don't change the lines, so the segments found by the previous
+  // fill can be reused until TTool::notifyImageChanged() invalidates them
+  std::string segmentCacheId =
+      TAutocloser::getSegmentCacheId(imageId, closeStting, variant);
+  std::vector<TAutocloser::Segment> allSegments;
+  if (!TAutocloser::getSegmentCache(segmentCacheId, allSegments)) {
+    ac.compute(allSegments);
+    TAutocloser::setSegmentCache(segmentCacheId, allSegments);
+  }
+  cache.m_segmentCacheId = segmentCacheId;
+
+  // Autopaint inks may have been changed by line fills: filter them here
+  std::vector<TAutocloser::Segment> segments;
+  for (const TAutocloser::Segment &seg : allSegments) {
+    int ink0 = tnzRas->pixels(seg.first.y)[seg.first.x].getInk(),
+        ink1 = tnzRas->pixels(seg.second.y)[seg.second.x].getInk();
+    if (!autoPaintInks.count(ink0) && !autoPaintInks.count(ink1))
+      segments.push_back(seg);
+  }
+  ac.draw(segments);
+
   TRop::CmappedQuickputSettings putSetting;
   putSetting.m_inksOnly = true;
   TRop::quickPut(ras, tnzRas, sl->getPalette(), TAffine(), putSetting);
@@ -1125,20 +1201,29 @@ void doRefFill(const TImageP &img, const TRaster32P &refImg, const TPointD &pos,
     }
 
     if (tileSaver.getTileSet()->getTileCount() != 0) {
-      static int count = 0;
+      static std::atomic<int> count(0);
       TSystem::outputDebug("FILL" + std::to_string(count++) + "\n");
       if (offs != TPoint())
         for (int i = 0; i < tileSet->getTileCount(); i++) {
           TTileSet::Tile *t = tileSet->editTile(i);
           t->m_rasterBounds = t->m_rasterBounds + offs;
         }
-      TUndoManager::manager()->add(new RasterFillUndo(
-          tileSet, params, sl, fid,
-          Preferences::instance()->getFillOnlySavebox(), refImg.getPointer()));
+      bool saveboxOnly = Preferences::instance()->getFillOnlySavebox();
+      bool refGapFill  = refImg.getPointer();
+      addFillUndo([=] {
+        return new RasterFillUndo(tileSet, params, sl, fid, saveboxOnly,
+                                  refGapFill);
+      });
     }
 
     // al posto di updateFrame:
 
+    if (deferredFill) {
+      deferredFill->m_updateSavebox = recomputeSavebox;
+      ras->unlock();
+      return;
+    }
+
     TXshLevel *xl = app->getCurrentLevel()->getLevel();
     if (!xl) return;
 
@@ -1203,6 +1288,15 @@ public:
   int getSize() const override { return sizeof(*this); }
 };
 
+//-----------------------------------------------------------------------------
+
+//! Returns the refer image of \b imgId in \b table, without inserting into it
+//! as painters may be processing frames in parallel.
+TRaster32P getRefImg(const RefImgTable &table, const std::string &imgId) {
+  RefImgTable::const_iterator it = table.find(imgId);
+  return it != table.end() ? it->second : TRaster32P();
+}
+
 //=============================================================================
 // SequencePainter
 // da spostare in toolutils?
@@ -1211,9 +1305,17 @@ public:
 class SequencePainter {
   FillToolSelectionUndo *m_selectionUndo = nullptr;
 
+  void processInParallel(const SlFidsPairs &slFidsPairs);
+  void notifyImageChanged(TXshSimpleLevel *sl, const TFrameId &fid);
+
 public:
   virtual void process(TImageP img /*, TImageLocation &imgloc*/, double t,
                        TXshSimpleLevel *sl, const TFrameId &fid) = 0;
+
+  //! Returns true if process() may be invoked on worker threads for toonz
+  //! raster frames, each with its own image.
+  virtual bool canProcessInParallel() const { return false; }
+
   void processSequence(const SlFidsPairs &SlFidsPairs);
   virtual ~SequencePainter() {}
   void setSelectionUndo(FillToolSelectionUndo *undo) { m_selectionUndo = undo; }
@@ -1224,22 +1326,115 @@ public:
 void SequencePainter::processSequence(const SlFidsPairs &slFidsPairs) {
   TUndoManager::manager()->beginBlock();
   if (m_selectionUndo) TUndoManager::manager()->add(m_selectionUndo);
-  int m = slFidsPairs.size();
-  int i = 0;
-  for (auto &[sl, fid] : slFidsPairs) {
-    TImageP img = sl->getFrame(fid, true);
-    double t    = m > 1 ? (double)i / (double)(m - 1) : 0.5;
-    process(img, t, sl, fid);
-    TTool::Application *app = TTool::getApplication();
-    if (app) {
-      TTool *tool = app->getCurrentTool()->getTool();
-      if (tool) tool->notifyImageChanged(fid, sl);
+
+  bool parallel = canProcessInParallel() && slFidsPairs.size() > 1;
+  for (auto &[sl, fid] : slFidsPairs)
+    parallel = parallel && sl->getType() == TZP_XSHLEVEL;
+
+  if (parallel)
+    processInParallel(slFidsPairs);
+  else {
+    int m = slFidsPairs.size();
+    int i = 0;
+    for (auto &[sl, fid] : slFidsPairs) {
+      TImageP img = sl->getFrame(fid, true);
+      double t    = m > 1 ? (double)i / (double)(m - 1) : 0.5;
+      process(img, t, sl, fid);
+      notifyImageChanged(sl, fid);
+      ++i;
     }
-    ++i;
   }
   TUndoManager::manager()->endBlock();
 }
 
+//-----------------------------------------------------------------------------
+
+/*!
+  Loads and fills the frames on worker threads, a batch at a time. Between
+  batches, the main thread adds the undos of the filled frames in frame order
+  and shows the progress. Canceling stops the fill after the current batch;
+  the frames filled so far stay in the undo block.
+*/
+void SequencePainter::processInParallel(const SlFidsPairs &slFidsPairs) {
+  int m         = slFidsPairs.size();
+  int batchSize = std::max(TSystem::getProcessorCount(), 2);
+
+  std::unique_ptr<DVGui::ProgressDialog> progress;
+  if (m > batchSize) {
+    progress.reset(new DVGui::ProgressDialog(
+        QObject::tr("Filling frames..."), QObject::tr("Cancel"), 0, m));
+    progress->setWindowModality(Qt::ApplicationModal);
+    progress->show();
+  }
+
+  std::vector<DeferredFill> fills(m);
+  std::vector<char> filled(m, false);
+  std::exception_ptr exception;
+
+  int begin = 0;
+  while (begin < m && !exception) {
+    int end = std::min(begin + batchSize, m);
+
+    try {
+      TThread::parallelFor(end - begin, [&](int b, int e) {
+        for (int i = begin + b; i != begin + e; ++i) {
+          TXshSimpleLevel *sl = slFidsPairs[i].first;
+          const TFrameId &fid = slFidsPairs[i].second;
+
+          deferredFill = &fills[i];
+          try {
+            TImageP img = sl->getFrame(fid, true);
+            process(img, (double)i / (double)(m - 1), sl, fid);
+          } catch (...) {
+            deferredFill = nullptr;
+            throw;
+          }
+          deferredFill = nullptr;
+          filled[i]    = true;
+        }
+      });
+    } catch (...) {
+      exception = std::current_exception();
+    }
+
+    for (int i = begin; i != end; ++i) {
+      if (!filled[i]) continue;
+
+      TXshSimpleLevel *sl = slFidsPairs[i].first;
+      const TFrameId &fid = slFidsPairs[i].second;
+      for (const std::function<TUndo *()> &makeUndo : fills[i].m_undos)
+        TUndoManager::manager()->add(makeUndo());
+      fills[i].m_undos.clear();
+
+      sl->getProperties()->setDirtyFlag(true);
+      if (fills[i].m_updateSavebox) ToolUtils::updateSaveBox(sl, fid);
+      notifyImageChanged(sl, fid);
+    }
+    begin = end;
+
+    if (progress) {
+      progress->setValue(begin);
+      if (progress->wasCanceled()) break;
+    }
+  }
+
+  if (exception) {
+    TUndoManager::manager()->endBlock();
+    std::rethrow_exception(exception);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void SequencePainter::notifyImageChanged(TXshSimpleLevel *sl,
+                                         const TFrameId &fid) {
+  TTool::Application *app = TTool::getApplication();
+  if (app) {
+    TTool *tool = app->getCurrentTool()->getTool();
+    if (tool) tool->notifyImageChanged(fid, sl);
+  }
+}
+
 //=============================================================================
 // MultiAreaFiller : SequencePainter
 //-----------------------------------------------------------------------------
@@ -1293,6 +1488,9 @@ public:
     m_lastImage->addStroke(lastStroke);
   }
 
+  // Strokes are shared by the frames, and tweened
+  bool canProcessInParallel() const override { return !m_firstImage; }
+
   void process(TImageP img, double t, TXshSimpleLevel *sl,
                const TFrameId &fid) override {
     std::string imgId = sl->getImageId(fid, 0);
@@ -1300,9 +1498,9 @@ public:
       TPointD p0 = m_firstRect.getP00() * (1 - t) + m_lastRect.getP00() * t;
       TPointD p1 = m_firstRect.getP11() * (1 - t) + m_lastRect.getP11() * t;
       TRectD rect(p0.x, p0.y, p1.x, p1.y);
-      fillAreaWithUndo(img, m_refImgTable[imgId], rect, 0, m_unfilledOnly,
-                       m_colorType, sl, fid, m_styleIndex, m_autopaintLines,
-                       m_fillAllautoPaintLines);
+      fillAreaWithUndo(img, getRefImg(m_refImgTable, imgId), rect, 0,
+                       m_unfilledOnly, m_colorType, sl, fid, m_styleIndex,
+                       m_autopaintLines, m_fillAllautoPaintLines);
     } else {
       if (t == 0)
         fillAreaWithUndo(img, m_refImgTable[imgId], TRectD(),
@@ -1359,14 +1557,18 @@ public:
       , m_lastPoint(lastPoint)
       , m_params(params)
       , m_autopaintLines(autopaintLines) {}
+  bool canProcessInParallel() const override { return true; }
+
   void process(TImageP img, double t, TXshSimpleLevel *sl,
                const TFrameId &fid) override {
     TPointD p = m_firstPoint * (1 - t) + m_lastPoint * t;
+    // The fill functions write in the parameters
+    FillParameters params = m_params;
     if (m_refImgTable.empty())
-      doFill(img, p, m_params, false, sl, fid, m_autopaintLines);
+      doFill(img, p, params, false, sl, fid, m_autopaintLines);
     else
-      doRefFill(img, m_refImgTable[sl->getImageId(fid, 0)], p, m_params, false,
-                sl, fid, m_autopaintLines);
+      doRefFill(img, getRefImg(m_refImgTable, sl->getImageId(fid, 0)), p,
+                params, false, sl, fid, m_autopaintLines);
   }
 };
 
@@ -2153,10 +2355,14 @@ void FillTool::computeRefImgsIfNeeded(const FillParameters &params) {
     }
   }
 
+  if (m_referCache.size() + m_slFidsPairs.size() > c_maxReferCacheCount)
+    clearReferCache();
+
   // Calculate every refImg
   bool fillOnlySavebox = Preferences::instance()->getFillOnlySavebox();
   TPointD cameraDpi =
       app->getCurrentScene()->getScene()->getCurrentCamera()->getDpi();
+  TImageCache *imageCache = TImageCache::instance();
   for (auto [sl, fid] : m_slFidsPairs) {
     if (sl->getType() != TXshLevelType::TZP_XSHLEVEL) continue;
 
@@ -2168,6 +2374,7 @@ void FillTool::computeRefImgsIfNeeded(const FillParameters &params) {
     raux->lock();
     auto imgId            = sl->getImageId(fid, 0);
     TPointD saveboxOffset = TPointD(0, 0);
+    TRect rect            = raux->getBounds();
     if (fillOnlySavebox) {
       TRectD bbox    = ti->getBBox();
       TRect ibbox    = convert(bbox);
@@ -2175,16 +2382,56 @@ void FillTool::computeRefImgsIfNeeded(const FillParameters &params) {
       saveboxOffset  = TPointD(res.lx / 2, res.ly / 2) - bbox.getP11() / 2 -
                       bbox.getP00() / 2;
       raux = ti->getRaster()->extract(ibbox);
+      rect = ibbox;
+    }
+
+    // The refer image depends on the other columns at the frame's row
+    std::string cacheId = imgId;
+    int row             = 0;
+    if (referFill) {
+      row     = slFidToRow[{sl, fid}];
+      cacheId = imgId + "_" + std::to_string(m_beginCell.col) + "_" +
+                std::to_string(row);
+    }
+    std::string referImageId = referImageCacheId(cacheId);
+
+    ReferFillCache &cache = m_referCache[cacheId];
+    if (cache.m_rect != rect) {
+      if (cache.m_hasReferImage) imageCache->remove(referImageId);
+      if (!cache.m_segmentCacheId.empty())
+        TAutocloser::invalidateSegmentCache(cache.m_segmentCacheId);
+      cache           = ReferFillCache();
+      cache.m_rect    = rect;
+      cache.m_imageId = imgId;
+    }
+
+    TRaster32P ras;
+    if (referFill && cache.m_hasReferImage) {
+      TRasterImageP ri = imageCache->get(referImageId, false);
+      if (ri) ras = ri->getRaster()->clone();
+    }
+    if (!ras) {
+      ras = TRaster32P(raux->getSize());
+      ras->clear();
+
+      if (referFill) {
+        drawReferImage(ras, xsh, m_beginCell.col, row, saveboxOffset,
+                       cache.m_sourceIds);
+        imageCache->add(referImageId, TRasterImageP(ras->clone()));
+        cache.m_hasReferImage = true;
+      }
     }
-    TRaster32P ras(raux->getSize());
-    ras->clear();
 
     m_refImgTable[imgId] = ras;
 
-    if (referFill)
-      drawReferImage(ras, xsh, m_beginCell.col, slFidToRow[{sl, fid}],
-                     saveboxOffset);
-    if (closeGap) gapClose(ras, raux, sl, referFill);
+    if (closeGap) {
+      std::string variant = std::to_string(rect.x0) + "," +
+                            std::to_string(rect.y0) + "," +
+                            std::to_string(rect.x1) + "," +
+                            std::to_string(rect.y1);
+      if (referFill) variant += "|" + cacheId;
+      gapClose(ras, raux, sl, referFill, imgId, variant, cache);
+    }
 
     raux->unlock();
   }
@@ -2192,6 +2439,52 @@ void FillTool::computeRefImgsIfNeeded(const FillParameters &params) {
 
 //-----------------------------------------------------------------------------
 
+void FillTool::clearReferCache() {
+  // The closing segments of refer fills depend on the refer image too
+  for (const auto &entry : m_referCache) {
+    if (!entry.second.m_hasReferImage) continue;
+    TImageCache::instance()->remove(referImageCacheId(entry.first));
+    if (!entry.second.m_segmentCacheId.empty())
+      TAutocloser::invalidateSegmentCache(entry.second.m_segmentCacheId);
+  }
+
+  m_referCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+//! Any edit may change an image drawn in the refer images, e.g. undoing a
+//! stroke on another column. Our own fills only change the filled frames:
+//! then just the refer images that show them are dropped.
+void FillTool::onLevelChanged() {
+  if (!m_filling) {
+    clearReferCache();
+    return;
+  }
+
+  std::set<std::string> filledIds;
+  for (const auto &entry : m_referCache)
+    filledIds.insert(entry.second.m_imageId);
+
+  for (auto it = m_referCache.begin(); it != m_referCache.end();) {
+    const std::set<std::string> &sourceIds = it->second.m_sourceIds;
+    bool stale = std::any_of(
+        sourceIds.begin(), sourceIds.end(),
+        [&](const std::string &id) { return filledIds.count(id) > 0; });
+    if (!stale) {
+      ++it;
+      continue;
+    }
+    if (it->second.m_hasReferImage)
+      TImageCache::instance()->remove(referImageCacheId(it->first));
+    if (!it->second.m_segmentCacheId.empty())
+      TAutocloser::invalidateSegmentCache(it->second.m_segmentCacheId);
+    it = m_referCache.erase(it);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 void FillTool::updateTranslation() {
   m_frameRange.setQStringName(tr("Frame Range"));
 
@@ -2240,6 +2533,7 @@ FillParameters FillTool::getFillParameters() const {
 //-----------------------------------------------------------------------------
 
 void FillTool::leftButtonDown(const TPointD &pos, const TMouseEvent &e) {
+  QScopedValueRollback<bool> filling(m_filling, true);
   m_isAltPressed = e.isAltPressed();
   if (m_isAltPressed)
     Preferences::instance()->setValue(PreferencesItemId::DefRegionWithPaint,
@@ -2317,6 +2611,7 @@ void FillTool::leftButtonDown(const TPointD &pos, const TMouseEvent &e) {
 //-----------------------------------------------------------------------------
 
 void FillTool::leftButtonDoubleClick(const TPointD &pos, const TMouseEvent &e) {
+  QScopedValueRollback<bool> filling(m_filling, true);
   if (m_fillType.getValue() != NORMALFILL) {
     buildFillInfo(getFillParameters());
     m_areaFillTool->leftButtonDoubleClick(pos, e);
@@ -2327,6 +2622,7 @@ void FillTool::leftButtonDoubleClick(const TPointD &pos, const TMouseEvent &e) {
 //-----------------------------------------------------------------------------
 
 void FillTool::leftButtonDrag(const TPointD &pos, const TMouseEvent &e) {
+  QScopedValueRollback<bool> filling(m_filling, true);
   // Area mode
   if (m_fillType.getValue() != NORMALFILL) {
     m_areaFillTool->leftButtonDrag(pos, e);
@@ -2377,6 +2673,7 @@ void FillTool::leftButtonDrag(const TPointD &pos, const TMouseEvent &e) {
 //-----------------------------------------------------------------------------
 
 void FillTool::leftButtonUp(const TPointD &pos, const TMouseEvent &e) {
+  QScopedValueRollback<bool> filling(m_filling, true);
   FillParameters params = getFillParameters();
   // Area mode
   if (m_fillType.getValue() != NORMALFILL) {
@@ -2786,6 +3083,28 @@ void FillTool::onActivate() {
     }
   }
 
+  // Refer images depend on the other columns: forget them when the xsheet
+  // changes, or when an image is edited or an edit undone
+  bool ret = true;
+  ret      = ret && connect(TTool::m_application->getCurrentXsheet(),
+                            SIGNAL(xsheetChanged()), this,
+                            SLOT(clearReferCache()), Qt::UniqueConnection);
+  ret      = ret && connect(TTool::m_application->getCurrentXsheet(),
+                            SIGNAL(xsheetSwitched()), this,
+                            SLOT(clearReferCache()), Qt::UniqueConnection);
+  ret      = ret && connect(TTool::m_application->getCurrentObject(),
+                            SIGNAL(objectChanged(bool)), this,
+                            SLOT(clearReferCache()), Qt::UniqueConnection);
+  ret      = ret && connect(TTool::m_application->getCurrentScene(),
+                            SIGNAL(sceneSwitched()), this,
+                            SLOT(clearReferCache()), Qt::UniqueConnection);
+  ret      = ret && connect(TTool::m_application->getCurrentLevel(),
+                            SIGNAL(xshLevelChanged()), this,
+                            SLOT(onLevelChanged()), Qt::UniqueConnection);
+  ret      = ret && connect(TUndoManager::manager(), SIGNAL(historyChanged()),
+                            this, SLOT(onLevelChanged()), Qt::UniqueConnection);
+  assert(ret);
+
   if (m_fillType.getValue() != NORMALFILL) {
     m_areaFillTool->onActivate();
     return;
@@ -2809,7 +3128,6 @@ void FillTool::onActivate() {
       }
     }
   }
-  bool ret = true;
   ret      = ret && connect(TTool::m_application->getCurrentFrame(),
                             SIGNAL(frameSwitched()), this, SLOT(onFrameSwitched()));
   ret      = ret && connect(TTool::m_application->getCurrentScene(),
@@ -2829,6 +3147,21 @@ void FillTool::onDeactivate() {
              this, SLOT(onFrameSwitched()));
   disconnect(TTool::m_application->getCurrentColumn(),
              SIGNAL(columnIndexSwitched()), this, SLOT(onFrameSwitched()));
+
+  // Other tools may change the other columns
+  disconnect(TTool::m_application->getCurrentXsheet(), SIGNAL(xsheetChanged()),
+             this, SLOT(clearReferCache()));
+  disconnect(TTool::m_application->getCurrentXsheet(),
+             SIGNAL(xsheetSwitched()), this, SLOT(clearReferCache()));
+  disconnect(TTool::m_application->getCurrentObject(),
+             SIGNAL(objectChanged(bool)), this, SLOT(clearReferCache()));
+  disconnect(TTool::m_application->getCurrentScene(), SIGNAL(sceneSwitched()),
+             this, SLOT(clearReferCache()));
+  disconnect(TTool::m_application->getCurrentLevel(),
+             SIGNAL(xshLevelChanged()), this, SLOT(onLevelChanged()));
+  disconnect(TUndoManager::manager(), SIGNAL(historyChanged()), this,
+             SLOT(onLevelChanged()));
+  clearReferCache();
 }
 
 //-----------------------------------------------------------------------------
@@ -3,6 +3,7 @@
 #ifndef FILLTOOL_H
 #define FILLTOOL_H
 
+#include <set>
 #include <string>
 
 // TnzCore includes
@@ -15,6 +16,7 @@
 #include "tools/toolutils.h"
 #include "autofill.h"
 #include "flare/fill.h"
+#include "flare/autoclose.h"
 
 #include <QObject>
 #include <qevent.h>
@@ -27,6 +29,17 @@ class NormalLineFillTool;
 typedef std::vector<std::pair<TXshSimpleLevel *, TFrameId>> SlFidsPairs;
 typedef std::map<std::string, TRaster32P> RefImgTable;
 
+//! Refer image computed for a frame, reused by the following refer fills on
+//! it. Its closing segments are kept in the TAutocloser segment cache.
+struct ReferFillCache {
+  TRect m_rect;  //!< The part of the frame it was computed on
+  bool m_hasReferImage = false;  //!< The refer image is in TImageCache
+  std::string m_segmentCacheId;  //!< Id of the last closing segments
+  std::string m_imageId;         //!< The frame's image
+  std::set<std::string> m_sourceIds;  //!< Images drawn in the refer image
+};
+typedef std::map<std::string, ReferFillCache> ReferFillCacheTable;
+
 namespace {
 
 class AreaFillTool {
@@ -124,9 +137,11 @@ class FillTool final : public QObject, public TTool {
 
   SlFidsPairs m_slFidsPairs;
   RefImgTable m_refImgTable;  // imageId
+  ReferFillCacheTable m_referCache;
 
   bool m_isAltPressed = false;
   bool m_restoreEmptyOnly;
+  bool m_filling = false;  //!< Level changes come from our own fills
 
 public:
   FillTool(int targetType);
@@ -172,6 +187,8 @@ public:
 
 public slots:
   void onFrameSwitched() override;
+  void clearReferCache();
+  void onLevelChanged();
 };
 
 #endif  // FILLTOOL_H
@@ -267,11 +267,11 @@ void eraseStroke(const TRasterImageP &ri, TStroke *stroke,
   TTileSetFullColor *tileSet = new TTileSetFullColor(ras->getSize());
   tileSet->add(ras, area);
 
-  TUndoManager::manager()->add(
-      new RectFullColorUndo(tileSet, convert(area), *stroke, eraseType,
-                            level.getPointer(), invert, frameId));
-
+  TUndo *undo = new RectFullColorUndo(tileSet, convert(area), *stroke,
+                                      eraseType, level.getPointer(), invert,
+                                      frameId);
   eraseImage(ri, image, pos, invert);
+  TUndoManager::manager()->add(undo);
 }
 
 class MultiArcPrimitive {
@@ -1697,18 +1697,22 @@ void GeometricTool::addStroke() {
       double hardness = m_param.m_hardness.getValue() * 0.01;
       TRect savebox;
       if (hardness == 1 || m_param.m_pencil.getValue()) {
-        TUndoManager::manager()->add(new UndoRasterPencil(
+        // The undo saves the tiles when built, and is registered once the
+        // stroke is drawn
+        TUndo *undo = new UndoRasterPencil(
             sl, id, stroke, selective, filled, !m_param.m_pencil.getValue(),
-            m_isFrameCreated, m_isLevelCreated, m_primitive->getName()));
+            m_isFrameCreated, m_isLevelCreated, m_primitive->getName());
         savebox = ToonzImageUtils::addInkStroke(ti, stroke, styleId, selective,
                                                 filled, TConsts::infiniteRectD,
                                                 !m_param.m_pencil.getValue());
+        TUndoManager::manager()->add(undo);
       } else {
         int thickness = m_param.m_rasterToolSize.getValue();
-        TUndoManager::manager()->add(new CMBluredPrimitiveUndo(
+        TUndo *undo = new CMBluredPrimitiveUndo(
             sl, id, stroke, thickness, hardness, selective, false,
-            m_isFrameCreated, m_isLevelCreated, m_primitive->getName()));
+            m_isFrameCreated, m_isLevelCreated, m_primitive->getName());
         savebox = drawBluredBrush(ti, stroke, thickness, hardness, selective);
+        TUndoManager::manager()->add(undo);
       }
     }
     ToolUtils::updateSaveBox();
@@ -1792,15 +1796,17 @@ void GeometricTool::addStroke() {
       double hardness = m_param.m_hardness.getValue() * 0.01;
       TRect savebox;
       if (hardness == 1) {
-        TUndoManager::manager()->add(new UndoFullColorPencil(
-            sl, id, stroke, opacity, true, m_isFrameCreated, m_isLevelCreated));
+        TUndo *undo = new UndoFullColorPencil(
+            sl, id, stroke, opacity, true, m_isFrameCreated, m_isLevelCreated);
         savebox = TRasterImageUtils::addStroke(ri, stroke, TRectD(), opacity);
+        TUndoManager::manager()->add(undo);
       } else {
         int thickness = m_param.m_rasterToolSize.getValue();
-        TUndoManager::manager()->add(new FullColorBluredPrimitiveUndo(
+        TUndo *undo = new FullColorBluredPrimitiveUndo(
             sl, id, stroke, thickness, hardness, opacity, true,
-            m_isFrameCreated, m_isLevelCreated));
+            m_isFrameCreated, m_isLevelCreated);
         savebox = drawBluredBrush(ri, stroke, thickness, hardness, opacity);
+        TUndoManager::manager()->add(undo);
       }
     }
     ToolUtils::updateSaveBox();
@@ -1,9 +1,11 @@
 
 #include <algorithm>
+#include <cstring>
 
 #include "mypainttoonzbrush.h"
 #include "tropcm.h"
 #include "tpixelutils.h"
+#include "tthread.h"
 #include "flare/mypainthelpers.hpp"
 
 #include <QColor>
@@ -64,6 +66,82 @@ public:
                       owner.ras->getRowSize(), &owner) {}
 };
 
+//=======================================================
+//
+// Raster32PMyPaintSurface::Tile
+//
+//=======================================================
+
+struct Raster32PMyPaintSurface::Tile {
+  TRect rect;                      // in raster pixels
+  std::vector<float> pixels;       // premultiplied RGBA, TileSize per row
+  std::vector<TPixel32> resolved;  // the raster's pixels after resolve()
+  std::vector<int> dabs;           // queued dabs touching the tile
+
+  Tile(const TRect &rect) : rect(rect) {}
+
+  // Loads the raster's pixels, unless they are the last resolved ones
+  void load(const TRaster32P &ras) {
+    int lx = rect.getLx(), ly = rect.getLy();
+    if (!resolved.empty()) {
+      int y = 0;
+      for (; y < ly; ++y)
+        if (memcmp(ras->pixels(rect.y0 + y) + rect.x0, &resolved[y * lx],
+                   lx * sizeof(TPixel32)) != 0)
+          break;
+      if (y == ly) return;
+    }
+
+    pixels.resize(TileSize * TileSize * 4);
+    resolved.resize(lx * ly);
+    const float k = 1.f / TPixel32::maxChannelValue;
+    for (int y = 0; y < ly; ++y) {
+      const TPixel32 *pix = ras->pixels(rect.y0 + y) + rect.x0;
+      float *out          = &pixels[y * TileSize * 4];
+      for (int x = 0; x < lx; ++x, ++pix, out += 4) {
+        out[0] = pix->r * k;
+        out[1] = pix->g * k;
+        out[2] = pix->b * k;
+        out[3] = pix->m * k;
+      }
+      memcpy(&resolved[y * lx], ras->pixels(rect.y0 + y) + rect.x0,
+             lx * sizeof(TPixel32));
+    }
+  }
+
+  void resolve(const TRaster32P &ras) {
+    int lx = rect.getLx(), ly = rect.getLy();
+    const float k = TPixel32::maxChannelValue;
+    for (int y = 0; y < ly; ++y) {
+      const float *in = &pixels[y * TileSize * 4];
+      TPixel32 *pix   = &resolved[y * lx];
+      for (int x = 0; x < lx; ++x, ++pix, in += 4) {
+        pix->r = (TPixel32::Channel)roundf(in[0] * k);
+        pix->g = (TPixel32::Channel)roundf(in[1] * k);
+        pix->b = (TPixel32::Channel)roundf(in[2] * k);
+        pix->m = (TPixel32::Channel)roundf(in[3] * k);
+      }
+      memcpy(ras->pixels(rect.y0 + y) + rect.x0, &resolved[y * lx],
+             lx * sizeof(TPixel32));
+    }
+  }
+};
+
+//=======================================================
+//
+// Raster32PMyPaintSurface::TileSurface
+//
+//=======================================================
+
+class Raster32PMyPaintSurface::TileSurface
+    : public mypaint::helpers::SurfaceCustom<readFloatPixel, writeFloatPixel> {
+public:
+  TileSurface(Tile &tile, bool antialiasing)
+      : SurfaceCustom(tile.pixels.data(), tile.rect.getLx(),
+                      tile.rect.getLy(), 4 * sizeof(float),
+                      TileSize * 4 * sizeof(float), 0, antialiasing) {}
+};
+
 //=======================================================
 //
 // Raster32PMyPaintSurface
@@ -74,6 +152,9 @@ Raster32PMyPaintSurface::Raster32PMyPaintSurface(const TRaster32P &ras)
     : ras(ras), controller(), internal() {
   assert(ras);
   internal = new Internal(*this);
+  tileCols = (ras->getLx() - 1) / TileSize + 1;
+  tileRows = (ras->getLy() - 1) / TileSize + 1;
+  tiles.resize(tileCols * tileRows);
 }
 
 Raster32PMyPaintSurface::Raster32PMyPaintSurface(const TRaster32P &ras,
@@ -81,18 +162,93 @@ Raster32PMyPaintSurface::Raster32PMyPaintSurface(const TRaster32P &ras,
     : ras(ras), controller(&controller), internal() {
   assert(ras);
   internal = new Internal(*this);
+  tileCols = (ras->getLx() - 1) / TileSize + 1;
+  tileRows = (ras->getLy() - 1) / TileSize + 1;
+  tiles.resize(tileCols * tileRows);
 }
 
-Raster32PMyPaintSurface::~Raster32PMyPaintSurface() { delete internal; }
+Raster32PMyPaintSurface::~Raster32PMyPaintSurface() {
+  for (int i = 0; i < (int)tiles.size(); ++i) delete tiles[i];
+  delete internal;
+}
 
 bool Raster32PMyPaintSurface::getColor(float x, float y, float radius,
                                        float &colorR, float &colorG,
                                        float &colorB, float &colorA) {
+  flush();
   return internal->getColor(x, y, radius, colorR, colorG, colorB, colorA);
 }
 
 bool Raster32PMyPaintSurface::drawDab(const mypaint::Dab &dab) {
-  return internal->drawDab(dab);
+  // the dab's bounds, as in SurfaceCustom::drawDab() (radius is at least
+  // 0.66 after its corrections), aligned to the tiles: the controller must
+  // prepare whole tiles, since they are loaded whole
+  float radius = std::max(fabsf(dab.radius), 1.f) + 1.f;
+  int x0       = std::max(0, (int)floor(dab.x - radius));
+  int y0       = std::max(0, (int)floor(dab.y - radius));
+  int x1       = std::min(ras->getLx() - 1, (int)ceil(dab.x + radius));
+  int y1       = std::min(ras->getLy() - 1, (int)ceil(dab.y + radius));
+  if (x0 > x1 || y0 > y1) return false;
+
+  TRect rect(x0 / TileSize * TileSize, y0 / TileSize * TileSize,
+             (x1 / TileSize + 1) * TileSize - 1,
+             (y1 / TileSize + 1) * TileSize - 1);
+  rect *= ras->getBounds();
+  if (controller &&
+      !(controller->askRead(rect) && controller->askWrite(rect)))
+    return false;
+
+  dabs.push_back(dab);
+  return true;
+}
+
+void Raster32PMyPaintSurface::flush() {
+  if (dabs.empty()) return;
+
+  // assign the dabs to the tiles they touch, keeping their order
+  std::vector<Tile *> batch;
+  for (int i = 0; i < (int)dabs.size(); ++i) {
+    const mypaint::Dab &dab = dabs[i];
+    float radius            = std::max(fabsf(dab.radius), 1.f) + 1.f;
+    int tx0 = std::max(0, (int)floor(dab.x - radius)) / TileSize,
+        ty0 = std::max(0, (int)floor(dab.y - radius)) / TileSize,
+        tx1 = std::min(ras->getLx() - 1, (int)ceil(dab.x + radius)) / TileSize,
+        ty1 = std::min(ras->getLy() - 1, (int)ceil(dab.y + radius)) / TileSize;
+
+    for (int ty = ty0; ty <= ty1; ++ty)
+      for (int tx = tx0; tx <= tx1; ++tx) {
+        Tile *&tile = tiles[ty * tileCols + tx];
+        if (!tile)
+          tile = new Tile(TRect(tx * TileSize, ty * TileSize,
+                                (tx + 1) * TileSize - 1,
+                                (ty + 1) * TileSize - 1) *
+                          ras->getBounds());
+        if (tile->dabs.empty()) batch.push_back(tile);
+        tile->dabs.push_back(i);
+      }
+  }
+
+  // tiles are independent: render them in parallel
+  bool antialiasing = internal->antialiasing;
+  TThread::parallelFor((int)batch.size(), [&](int begin, int end) {
+    for (int t = begin; t < end; ++t) {
+      Tile &tile = *batch[t];
+      tile.load(ras);
+
+      TileSurface surface(tile, antialiasing);
+      for (int i = 0; i < (int)tile.dabs.size(); ++i) {
+        mypaint::Dab dab = dabs[tile.dabs[i]];
+        dab.x -= tile.rect.x0;
+        dab.y -= tile.rect.y0;
+        surface.drawDab(dab);
+      }
+      tile.dabs.clear();
+
+      tile.resolve(ras);
+    }
+  });
+
+  dabs.clear();
 }
 
 bool Raster32PMyPaintSurface::getAntialiasing() const {
@@ -208,6 +364,8 @@ void MyPaintToonzBrush::strokeTo(const TPointD &position, double pressure,
     m_brush.strokeTo(m_mypaintSurface, position.x, position.y, pressure, tilt.x,
                      tilt.y, dtime);
   }
+
+  m_mypaintSurface.flush();
 }
 
 //----------------------------------------------------------------------------------
@@ -20,20 +20,37 @@ public:
 #include <QPainter>
 #include <QImage>
 
+#include <vector>
+
 //=======================================================
 //
 // Raster32PMyPaintSurface
 //
 //=======================================================
 
+//! Dabs are queued by drawDab() and rendered by flush() in a batch, into
+//! tiles of premultiplied float pixels processed in parallel; then the tiles
+//! are resolved into the raster. Since the tiles keep the values between
+//! batches, strokes made of many faint dabs don't accumulate 8-bit rounding
+//! errors. A tile is reloaded if the raster changes under it (e.g. because of
+//! another surface on the same raster).
+
 class Raster32PMyPaintSurface : public mypaint::Surface {
 private:
   class Internal;
+  class TileSurface;
+  struct Tile;
+
+  enum { TileSize = 64 };
 
   TRaster32P ras;
   RasterController *controller;
   Internal *internal;
 
+  int tileCols, tileRows;
+  std::vector<Tile *> tiles;       // created on first use
+  std::vector<mypaint::Dab> dabs;  // queued, not rendered yet
+
   inline static void readPixel(const void *pixelPtr, float &colorR,
                                float &colorG, float &colorB, float &colorA) {
     const TPixel32 &pixel = *(const TPixel32 *)pixelPtr;
@@ -52,6 +69,26 @@ private:
     pixel.m = (TPixel32::Channel)roundf(colorA * TPixel32::maxChannelValue);
   }
 
+  inline static void readFloatPixel(const void *pixelPtr, float &colorR,
+                                    float &colorG, float &colorB,
+                                    float &colorA) {
+    const float *pixel = (const float *)pixelPtr;
+    colorR             = pixel[0];
+    colorG             = pixel[1];
+    colorB             = pixel[2];
+    colorA             = pixel[3];
+  }
+
+  inline static void writeFloatPixel(void *pixelPtr, float colorR,
+                                     float colorG, float colorB,
+                                     float colorA) {
+    float *pixel = (float *)pixelPtr;
+    pixel[0]     = colorR;
+    pixel[1]     = colorG;
+    pixel[2]     = colorB;
+    pixel[3]     = colorA;
+  }
+
   inline static bool askRead(void *surfaceController,
                              const void * /* surfacePointer */, int x0, int y0,
                              int x1, int y1) {
@@ -81,6 +118,9 @@ public:
 
   bool drawDab(const mypaint::Dab &dab) override;
 
+  //! Renders the queued dabs and resolves them into the raster.
+  void flush();
+
   bool getAntialiasing() const;
   void setAntialiasing(bool value);
 
@@ -287,13 +287,14 @@ void eraseStroke(const TToonzImageP &ti, TStroke *stroke,
     area                = ras->getBounds();
   TTileSetCM32 *tileSet = new TTileSetCM32(ras->getSize());
   tileSet->add(ras, area);
-  TUndoManager::manager()->add(new RectRasterUndo(
+  TUndo *undo = new RectRasterUndo(
       tileSet, convert(area), *stroke, selective ? styleId : -1, eraseType,
-      colorType, level.getPointer(), selective, invert, pencil, frameId));
+      colorType, level.getPointer(), selective, invert, pencil, frameId);
   bool eraseInk   = colorType == LINES || colorType == ALL;
   bool erasePaint = colorType == AREAS || colorType == ALL;
   ToonzImageUtils::eraseImage(ti, image, pos, invert, eraseInk, erasePaint,
                               selective, styleId);
+  TUndoManager::manager()->add(undo);
 }
 
 //-----------------------------------------------------------------------------
@@ -279,14 +279,15 @@ public:
       tileSet->add(raux, bbox.enlarge(2));
     }
 
-    TUndoManager::manager()->add(
-        new RasterAutocloseUndo(tileSet, params, filteredSegments, sl, fid));
-
     // DRAW
     TAutocloser drawAc(raux, params.m_closingDistance, params.m_spotAngle,
                        params.m_inkIndex, params.m_opacity);
     drawAc.draw(filteredSegments);
 
+    // The undo packs its tiles against the image as it is once registered
+    TUndoManager::manager()->add(
+        new RasterAutocloseUndo(tileSet, params, filteredSegments, sl, fid));
+
     ToolUtils::updateSaveBox();
     notifyImageChanged();
 
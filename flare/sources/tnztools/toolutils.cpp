@@ -51,6 +51,8 @@
 #include <QFont>
 #include <QFontMetrics>
 
+#include <memory>
+
 //****************************************************************************************
 //    Local namespace
 //****************************************************************************************
@@ -704,6 +706,19 @@ int ToolUtils::TRasterUndo::getSize() const {
 
 //------------------------------------------------------------------------------------------
 
+void ToolUtils::TRasterUndo::onAdd() {
+  TToolUndo::onAdd();
+
+  // The image is now in the state the tiles will be pasted over when undoing
+  if (m_tiles && m_level && m_level->isFid(m_frameId)) {
+    TToonzImageP image = m_level->getFrame(m_frameId, false);
+    if (image)
+      m_tiles->pack(image->getRaster(), m_level->getImageId(m_frameId));
+  }
+}
+
+//------------------------------------------------------------------------------------------
+
 void ToolUtils::TRasterUndo::undo() const {
   TTool::Application *app = TTool::getApplication();
   if (!app) return;
@@ -712,7 +727,12 @@ void ToolUtils::TRasterUndo::undo() const {
     TToonzImageP image = getImage();
     if (!image) return;
 
-    ToonzImageUtils::paste(image, m_tiles);
+    // The frame leaves the state the tiles are deltas against: keep them as
+    // plain LZ4, and decode a copy for a later redo/undo
+    m_tiles->dropDeltas(image->getRaster());
+    std::unique_ptr<TTileSetCM32> tiles(m_tiles->clone());
+    tiles->unpack(image->getRaster());
+    ToonzImageUtils::paste(image, tiles.get());
     if(m_updateSaveBox)
         ToolUtils::updateSaveBox(m_level, m_frameId);
   }
@@ -759,6 +779,18 @@ int ToolUtils::TFullColorRasterUndo::getSize() const {
 
 //-----------------------------------------------------------------------------
 
+void ToolUtils::TFullColorRasterUndo::onAdd() {
+  TToolUndo::onAdd();
+
+  if (m_tiles && m_level && m_level->isFid(m_frameId)) {
+    TRasterImageP image = m_level->getFrame(m_frameId, false);
+    if (image)
+      m_tiles->pack(image->getRaster(), m_level->getImageId(m_frameId));
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 void ToolUtils::TFullColorRasterUndo::undo() const {
   TTool::Application *app = TTool::getApplication();
   if (!app) return;
@@ -766,10 +798,10 @@ void ToolUtils::TFullColorRasterUndo::undo() const {
   if (m_tiles && m_tiles->getTileCount() > 0) {
     TRasterImageP image = getImage();
     if (!image) return;
-    std::vector<TRect> rects = paste(image, m_tiles);
-    int i;
-    TRect resRect = rects[0];
-    for (i = 1; i < (int)rects.size(); i++) resRect += rects[i];
+    m_tiles->dropDeltas(image->getRaster());
+    std::unique_ptr<TTileSetFullColor> tiles(m_tiles->clone());
+    tiles->unpack(image->getRaster());
+    paste(image, tiles.get());
   }
 
   removeLevelAndFrameIfNeeded();
@@ -686,6 +686,7 @@ extern int LoadEXRFromMemory(float **out_rgba, int *width, int *height,
 
 #if TINYEXR_USE_THREAD
 #include <atomic>
+#include <functional>
 #include <thread>
 #endif
 
@@ -777,6 +778,21 @@ typedef long long tinyexr_int64;
 #endif
 #endif
 
+#if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
+#ifdef TINYEXR_CUSTOM_WORKERS
+// Flare: supplied by the including code, so that the workers share the
+// cores with the application threads. Calls worker() on at most
+// num_threads threads and returns when all calls are done.
+void RunWorkers(int num_threads, const std::function<void()> &worker);
+#else
+static void RunWorkers(int num_threads, const std::function<void()> &worker) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; t++) workers.emplace_back(worker);
+  for (auto &t : workers) t.join();
+}
+#endif
+#endif
+
 // static bool IsBigEndian(void) {
 //  union {
 //    unsigned int i;
@@ -5001,7 +5017,6 @@ static int DecodeTiledLevel(EXRImage* exr_image, const EXRHeader* exr_header,
     calloc(static_cast<size_t>(num_tiles), sizeof(EXRTile)));
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
-  std::vector<std::thread> workers;
   std::atomic<int> tile_count(0);
 
   int num_threads = std::max(1, int(std::thread::hardware_concurrency()));
@@ -5011,8 +5026,7 @@ static int DecodeTiledLevel(EXRImage* exr_image, const EXRHeader* exr_header,
   if (num_threads > int(num_tiles)) {
     num_threads = int(num_tiles);
   }
-  for (int t = 0; t < num_threads; t++) {
-    workers.emplace_back(std::thread([&]()
+  RunWorkers(num_threads, [&]()
       {
         int tile_idx = 0;
         while ((tile_idx = tile_count++) < num_tiles) {
@@ -5109,12 +5123,7 @@ static int DecodeTiledLevel(EXRImage* exr_image, const EXRHeader* exr_header,
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
   }
-        }));
-    }  // num_thread loop
-
-    for (auto& t : workers) {
-      t.join();
-    }
+        });
 
 #else
   } // parallel for
@@ -5358,7 +5367,6 @@ static int DecodeChunk(EXRImage *exr_image, const EXRHeader *exr_header,
     }
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
-    std::vector<std::thread> workers;
     std::atomic<int> y_count(0);
 
     int num_threads = std::max(1, int(std::thread::hardware_concurrency()));
@@ -5368,8 +5376,7 @@ static int DecodeChunk(EXRImage *exr_image, const EXRHeader *exr_header,
     if (num_threads > int(num_blocks)) {
       num_threads = int(num_blocks);
     }
-    for (int t = 0; t < num_threads; t++) {
-      workers.emplace_back(std::thread([&]() {
+    RunWorkers(num_threads, [&]() {
         int y = 0;
         while ((y = y_count++) < int(num_blocks)) {
 
@@ -5463,12 +5470,7 @@ static int DecodeChunk(EXRImage *exr_image, const EXRHeader *exr_header,
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
         }
-      }));
-    }
-
-    for (auto &t : workers) {
-      t.join();
-    }
+      });
 #else
     }  // omp parallel
 #endif
@@ -7343,7 +7345,6 @@ static int EncodeTiledLevel(const EXRImage* level_image, const EXRHeader* exr_he
 #endif
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
-  std::vector<std::thread> workers;
   std::atomic<int> tile_count(0);
 
   int num_threads = std::max(1, int(std::thread::hardware_concurrency()));
@@ -7354,8 +7355,7 @@ static int EncodeTiledLevel(const EXRImage* level_image, const EXRHeader* exr_he
     num_threads = int(num_tiles);
   }
 
-  for (int t = 0; t < num_threads; t++) {
-    workers.emplace_back(std::thread([&]() {
+  RunWorkers(num_threads, [&]() {
       int i = 0;
       while ((i = tile_count++) < num_tiles) {
 
@@ -7419,12 +7419,7 @@ static int EncodeTiledLevel(const EXRImage* level_image, const EXRHeader* exr_he
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
   }
-}));
-    }
-
-    for (auto &t : workers) {
-      t.join();
-    }
+});
 #else
     }  // omp parallel
 #endif
@@ -7595,15 +7590,13 @@ static int EncodeChunk(const EXRImage* exr_image, const EXRHeader* exr_header,
 
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
     std::atomic<bool> invalid_data(false);
-    std::vector<std::thread> workers;
     std::atomic<int> block_count(0);
 
     int num_threads = std::min(std::max(1, int(std::thread::hardware_concurrency())), num_blocks);
 #if (TINYEXR_MAX_THREADS > 0)
     num_threads = std::min(num_threads,TINYEXR_MAX_THREADS);
 #endif
-    for (int t = 0; t < num_threads; t++) {
-      workers.emplace_back(std::thread([&]() {
+    RunWorkers(num_threads, [&]() {
         int i = 0;
         while ((i = block_count++) < num_blocks) {
 
@@ -7655,12 +7648,7 @@ static int EncodeChunk(const EXRImage* exr_image, const EXRHeader* exr_header,
       swap4(reinterpret_cast<int*>(&data_list[i][4]));
 #if TINYEXR_HAS_CXX11 && (TINYEXR_USE_THREAD > 0)
         }
-                                       }));
-    }
-
-    for (auto &t : workers) {
-      t.join();
-    }
+                                       });
 #else
     }  // omp parallel
 #endif